@@ -29,6 +29,39 @@
 
 namespace Settings { struct Window; }
 
+// e.g.: VQEngine.exe -WarmShaderCache
+//
+struct CommandLineOptions
+{
+	bool bWarmShaderCache = false;		// compile every known shader permutation into the shader cache and exit
+	bool bBenchmarkSceneParser = false;	// time the parsing of the bundled and generated scenes and exit
+	bool bCompileScenes = false;		// compile the scene files into CompiledScenes and exit
+	bool bTestVertexQuantization = false;	// check the round-trip error of the compact vertex encoding and exit
+	bool bTestPerfTimer = false;			// check the pause/resume semantics of the frame timer and exit
+	bool bTestTimingHistogram = false;		// check the frame time percentiles against known distributions and exit
+	bool bTestOcclusionCulling = false;		// check the occlusion depth buffer and visibility results against a reference and exit
+	bool bTestRenderGraph = false;			// check the schedule, visibility and aliasing of compiled render graphs and exit
+	bool bTestModelData = false;			// check that a Model keeps the meshes, materials and LODs of its ModelData and exit
+	bool bTestMeshOptimization = false;		// check the vertex cache/fetch optimizations and LODs of the bundled models and exit
+	bool bTestTextLayout = false;			// check the text quads against hand-computed positions and uvs and exit
+	int  numProfileCaptureFrames = 0;		// -CaptureProfile[=<frames>]: capture the CPU profiler timeline of the first frames
+	int  numHeadlessFrames = 0;				// -Headless[=<frames>]: render the frames on a null device w/o showing the window, log the CPU costs and exit
+	bool bValidateRenderState = false;		// log the draw calls made with an invalid pipeline state
+	bool bTrackAllocations = false;			// count the heap allocations per frame and per subsystem, always on in headless runs
+	int  metricsServerPort = 0;				// -MetricsServer[=<port>]: publish the frame metrics on a loopback port for the MetricsMonitor
+	std::string recordFilePath;				// -Record[=<file>]: record the input and the frame times into a replay file
+	std::string replayFilePath;				// -Replay=<file>: replay a recording with its frame times, check it against the recorded state and exit
+
+	static CommandLineOptions Parse(const char* pCommandLine);
+
+	// -Test* modes: CPU-only self-checks that run before the window and the device are created
+	inline bool HasSelfChecks() const
+	{
+		return bTestVertexQuantization || bTestPerfTimer || bTestTimingHistogram
+			|| bTestOcclusionCulling || bTestRenderGraph || bTestModelData || bTestMeshOptimization || bTestTextLayout;
+	}
+};
+
 class Application
 {
 public: 
@@ -39,10 +72,13 @@ public:
 	Application();
 	~Application();
 
-	bool Init();
+	bool Init(const char* pCommandLine);
 	void Run();
 	void Exit();
 
+	// 0 on success, non-zero if the initialization or any of the requested self-checks failed
+	inline int GetExitCode() const { return m_exitCode; }
+
 	LRESULT CALLBACK MessageHandler(HWND, UINT, WPARAM, LPARAM);
 	void UpdateWindowDimensions(int w, int h);
 
@@ -53,6 +89,9 @@ private:
 	
 	void CaptureMouse(bool bDoCapture);
 
+	// Runs the self-checks requested on the command line, returns false if any of them failed
+	bool RunSelfChecks();
+
 private:
 	LPCSTR		m_appName;
 	HINSTANCE	m_hInstance;
@@ -63,6 +102,9 @@ private:
 	bool		m_bMouseCaptured;
 	bool		m_bAppWantsExit;
 	POINT		m_capturePosition;
+	int			m_exitCode;
+
+	CommandLineOptions		m_commandLineOptions;
 
 	VQEngine::ThreadPool	m_threadPool;
 };
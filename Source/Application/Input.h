@@ -22,6 +22,7 @@
 #include <string>
 
 #define KEY_COUNT 256
+#define MOUSE_BUTTON_COUNT 17
 #define ENABLE_RAW_INPUT
 
 using KeyCode = unsigned int;
@@ -73,6 +74,19 @@ public:
 	void PostUpdate();
 	const long* GetDelta() const;
 
+	// everything the queries of a frame read, the FrameRecorder records and replays the state of each frame
+	struct State
+	{
+		bool  keys[KEY_COUNT];
+		bool  prevKeys[KEY_COUNT];
+		bool  buttons[MOUSE_BUTTON_COUNT];
+		long  mouseDelta[2];
+		short mouseScroll;
+		bool  bIgnoreInput;
+	};
+	State GetState() const;
+	void  SetState(const State& state);
+
 
 private:
 	// state
@@ -83,7 +97,7 @@ private:
 	bool m_prevKeys[KEY_COUNT];
 
 	// mouse
-	bool m_buttons[17];
+	bool m_buttons[MOUSE_BUTTON_COUNT];
 	long m_mouseDelta[2];
 	long m_mousePos[2];
 	short m_mouseScroll;
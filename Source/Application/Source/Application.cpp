@@ -23,15 +23,28 @@
 
 #include "Engine/Engine.h"
 #include "Engine/Settings.h"
+#include "Engine/CompiledScene.h"
+#include "Engine/Model.h"
+#include "Engine/OcclusionCulling.h"
+#include "Engine/RenderGraph.h"
+
+#include "Renderer/Renderer.h"
+#include "Renderer/VertexQuantization.h"
+#include "Renderer/TextRenderer.h"
 
 #include "Utilities/utils.h"
 #include "Utilities/CustomParser.h"
 #include "Utilities/Log.h"
 #include "Utilities/Profiler.h"
+#include "Utilities/MemoryTracker.h"
+#include "Utilities/PerfTimer.h"
+#include "Utilities/TimingHistogram.h"
+#include "Utilities/MetricsServer.h"
 
 #include <strsafe.h>
 #include <vector>
 #include <new>
+#include <cstdlib>
 
 #ifdef _DEBUG
 #include <cassert>
@@ -39,6 +52,9 @@
 
 #define xLOG_WINDOW_EVENTS
 
+constexpr int DEFAULT_PROFILE_CAPTURE_FRAME_COUNT = 300;
+constexpr int DEFAULT_HEADLESS_FRAME_COUNT = 1000;
+
 std::string Application::s_WorkspaceDirectory = "";
 std::string Application::s_ShaderCacheDirectory = "";
 
@@ -47,6 +63,8 @@ Application::Application()
 	m_appName("VQEngine Demo"),
 	m_bMouseCaptured(false),
 	m_bAppWantsExit(false),
+	m_hwnd(NULL),
+	m_exitCode(0),
 	m_threadPool(VQEngine::ThreadPool::sHardwareThreadCount - 2)
 {
 	m_hInstance		= GetModuleHandle(NULL);	// instance of this application
@@ -57,11 +75,60 @@ Application::~Application(){}
 
 void Application::Exit()
 {
+	if (!m_hwnd)
+	{	// the self-checks exit before the window and the engine are created
+		Log::Exit();
+		return;
+	}
 	ENGINE->Exit();
 	ShutdownWindows();
 }
 
-bool Application::Init()
+CommandLineOptions CommandLineOptions::Parse(const char* pCommandLine)
+{
+	CommandLineOptions options;
+	for (const std::string& arg : StrUtil::split(pCommandLine ? pCommandLine : "", ' '))
+	{
+		if (arg == "-WarmShaderCache") options.bWarmShaderCache = true;
+		else if (arg == "-BenchmarkSceneParser") options.bBenchmarkSceneParser = true;
+		else if (arg == "-CompileScenes") options.bCompileScenes = true;
+		else if (arg == "-TestVertexQuantization") options.bTestVertexQuantization = true;
+		else if (arg == "-TestPerfTimer") options.bTestPerfTimer = true;
+		else if (arg == "-TestTimingHistogram") options.bTestTimingHistogram = true;
+		else if (arg == "-TestOcclusionCulling") options.bTestOcclusionCulling = true;
+		else if (arg == "-TestRenderGraph") options.bTestRenderGraph = true;
+		else if (arg == "-TestModelData") options.bTestModelData = true;
+		else if (arg == "-TestMeshOptimization") options.bTestMeshOptimization = true;
+		else if (arg == "-TestTextLayout") options.bTestTextLayout = true;
+		else if (arg == "-CaptureProfile") options.numProfileCaptureFrames = DEFAULT_PROFILE_CAPTURE_FRAME_COUNT;
+		else if (arg.find("-CaptureProfile=") == 0)
+		{
+			const int numFrames = std::atoi(arg.c_str() + strlen("-CaptureProfile="));
+			options.numProfileCaptureFrames = numFrames > 0 ? numFrames : DEFAULT_PROFILE_CAPTURE_FRAME_COUNT;
+		}
+		else if (arg == "-Headless") options.numHeadlessFrames = DEFAULT_HEADLESS_FRAME_COUNT;
+		else if (arg.find("-Headless=") == 0)
+		{
+			const int numFrames = std::atoi(arg.c_str() + strlen("-Headless="));
+			options.numHeadlessFrames = numFrames > 0 ? numFrames : DEFAULT_HEADLESS_FRAME_COUNT;
+		}
+		else if (arg == "-ValidateRenderState") options.bValidateRenderState = true;
+		else if (arg == "-TrackAllocations") options.bTrackAllocations = true;
+		else if (arg == "-MetricsServer") options.metricsServerPort = MetricsServer::DEFAULT_PORT;
+		else if (arg.find("-MetricsServer=") == 0)
+		{
+			const int port = std::atoi(arg.c_str() + strlen("-MetricsServer="));
+			options.metricsServerPort = port > 0 && port <= 0xFFFF ? port : MetricsServer::DEFAULT_PORT;
+		}
+		else if (arg == "-Record") options.recordFilePath = Application::s_WorkspaceDirectory + "\\Recordings\\Recording_" + GetCurrentTimeAsString() + ".vqreplay";
+		else if (arg.find("-Record=") == 0) options.recordFilePath = arg.substr(strlen("-Record="));
+		else if (arg.find("-Replay=") == 0) options.replayFilePath = arg.substr(strlen("-Replay="));
+		else if (!arg.empty()) Log::Warning("Unknown command line argument: %s", arg.c_str());
+	}
+	return options;
+}
+
+bool Application::Init(const char* pCommandLine)
 {
 	// SETTINGS
 	//
@@ -71,12 +138,33 @@ bool Application::Init()
 	// LOG
 	//
 	Log::Initialize(settings.logger);
+	m_commandLineOptions = CommandLineOptions::Parse(pCommandLine);
+	const bool bHeadless = m_commandLineOptions.numHeadlessFrames > 0;
+	MemoryTracker::SetEnabled(m_commandLineOptions.bTrackAllocations || bHeadless);
+
+	// SELF-CHECKS
+	//
+	if (m_commandLineOptions.HasSelfChecks())
+	{
+		const bool bPassed = RunSelfChecks();
+		Log::Info("Self-checks %s. Exiting..", bPassed ? "passed" : "failed");
+		m_exitCode = bPassed ? 0 : 1;
+		return false;
+	}
 	
 	// WINDOW
 	//
+	// headless runs render on a null device, the window is only created for the message handling and stays hidden
+	if (bHeadless)
+	{
+		settings.window.fullscreen = 0;
+	}
 	InitWindow(settings.window);
-	ShowWindow(m_hwnd, SW_SHOW);
-	this->CaptureMouse(true);
+	if (!bHeadless)
+	{
+		ShowWindow(m_hwnd, SW_SHOW);
+		this->CaptureMouse(true);
+	}
 
 #ifdef ENABLE_RAW_INPUT
 	// INPUT
@@ -86,26 +174,124 @@ bool Application::Init()
 
 	// ENGINE
 	//
-	if (!ENGINE->Initialize(m_hwnd))
+	if (!ENGINE->Initialize(m_hwnd, &m_threadPool, bHeadless))
 	{
 		Log::Error("cannot initialize engine. Exiting..");
+		m_exitCode = 1;
+		return false;
+	}
+	ENGINE->mpRenderer->SetStateValidation(m_commandLineOptions.bValidateRenderState);
+
+	// the shader cache is warmed up while the engine initializes, nothing left to do in this mode
+	if (m_commandLineOptions.bWarmShaderCache)
+	{
+		Log::Info("Shader cache warm-up done. Exiting..");
+		return false;
+	}
+
+	// scenes are parsed without a renderer, i.e. without creating their textures
+	if (m_commandLineOptions.bBenchmarkSceneParser)
+	{
+		std::vector<std::string> sceneFilePaths;
+		for (const std::string& sceneName : settings.sceneNames)
+			sceneFilePaths.push_back(Parser::GetSceneFilePath(sceneName));
+		for (const int numObjects : { 1000, 10000, 100000 })
+		{
+			const std::string filePath = s_WorkspaceDirectory + "/Benchmark/SyntheticScene_" + std::to_string(numObjects) + ".scn";
+			if (Parser::WriteSyntheticScene(filePath, numObjects))
+				sceneFilePaths.push_back(filePath);
+		}
+		Parser::BenchmarkSceneParsing(sceneFilePaths);
+		Log::Info("Scene parser benchmark done. Exiting..");
+		return false;
+	}
+
+	if (m_commandLineOptions.bCompileScenes)
+	{
+		for (const std::string& sceneName : settings.sceneNames)
+		{
+			const std::string sceneFilePath = Parser::GetSceneFilePath(sceneName);
+			const SerializedScene scene = Parser::ReadSceneFile(nullptr, sceneFilePath);
+			const std::string compiledFilePath = CompiledScene::GetFilePath(sceneFilePath);
+			if (scene.loadSuccess == '1' && CompiledScene::Write(compiledFilePath, scene, CompiledScene::GetSourceKey(sceneFilePath)))
+				Log::Info("Compiled %s -> %s", sceneFilePath.c_str(), compiledFilePath.c_str());
+		}
+		Log::Info("Scene compilation done. Exiting..");
 		return false;
 	}
+
+	// the recording picks the scene to load and the seed of its random placements, before Load()
+	if (!m_commandLineOptions.replayFilePath.empty())
+	{
+		if (!m_commandLineOptions.recordFilePath.empty())
+			Log::Warning("-Record is ignored while replaying %s", m_commandLineOptions.replayFilePath.c_str());
+		if (!ENGINE->StartReplay(m_commandLineOptions.replayFilePath))
+		{
+			Log::Error("Couldn't replay %s. Exiting..", m_commandLineOptions.replayFilePath.c_str());
+			m_exitCode = 1;
+			return false;
+		}
+	}
+	else if (!m_commandLineOptions.recordFilePath.empty())
+	{
+		DirectoryUtil::CreateFolderIfItDoesntExist(DirectoryUtil::GetFolderPath(m_commandLineOptions.recordFilePath));
+		ENGINE->StartRecording(m_commandLineOptions.recordFilePath);
+	}
 	
 	if (!ENGINE->Load(&m_threadPool))
 	{
 		Log::Error("Exiting..");
+		m_exitCode = 1;
 		return false;
 	}
 
+	if (m_commandLineOptions.numProfileCaptureFrames > 0)
+	{
+		ENGINE->CaptureProfile(m_commandLineOptions.numProfileCaptureFrames);
+	}
+
+	if (m_commandLineOptions.metricsServerPort > 0)
+	{	// the engine runs without the metrics if the port is taken
+		ENGINE->StartMetricsServer(static_cast<unsigned short>(m_commandLineOptions.metricsServerPort));
+	}
+
 	Log::Info("Engine initialization and asset loading successful.\n");
 	return true;
 }	
 
+bool Application::RunSelfChecks()
+{
+	bool bAllPassed = true;
+	auto fnRun = [&](bool bRequested, const char* pName, auto fnTest)
+	{
+		if (!bRequested)
+			return;
+		const bool bPassed = fnTest();
+		Log::Info("%s tests %s.", pName, bPassed ? "passed" : "failed");
+		bAllPassed &= bPassed;
+	};
+	fnRun(m_commandLineOptions.bTestVertexQuantization, "Vertex quantization", [] { return VertexQuantization::RunRoundTripTests(); });
+	fnRun(m_commandLineOptions.bTestPerfTimer         , "PerfTimer"          , [] { return PerfTimer::RunPauseResumeTests(); });
+	fnRun(m_commandLineOptions.bTestTimingHistogram   , "TimingHistogram"    , [] { return TimingHistogram::RunTests(); });
+	fnRun(m_commandLineOptions.bTestOcclusionCulling  , "OcclusionCuller"    , [&] { return OcclusionCuller::RunTests(&m_threadPool); });
+	fnRun(m_commandLineOptions.bTestRenderGraph       , "RenderGraph"        , [] { return RenderGraph::RunCompileTests(); });
+	fnRun(m_commandLineOptions.bTestModelData         , "Model data"         , [] { return Model::RunModelDataTests(); });
+	fnRun(m_commandLineOptions.bTestMeshOptimization  , "MeshOptimizer"      , [] { return ModelLoader::RunMeshOptimizationTests(); });
+	fnRun(m_commandLineOptions.bTestTextLayout        , "Text layout"        , [] { return TextRenderer::RunLayoutTests(); });
+	return bAllPassed;
+}
+
 void Application::Run()
 {
 	ENGINE->mpTimer->Reset();
 	ENGINE->mpTimer->Start();
+
+	if (m_commandLineOptions.numHeadlessFrames > 0)
+	{	// headless replays run for the length of the recording
+		ENGINE->RunHeadless(m_commandLineOptions.numHeadlessFrames);
+		return;
+	}
+
 	MSG msg = { };
 	
 	while (!m_bAppWantsExit)
@@ -135,6 +321,12 @@ void Application::Run()
 		
 		ENGINE->SimulateAndRenderFrame();
 		const_cast<Input*>(ENGINE->INP())->PostUpdate();	// update previous state after frame;
+
+		if (ENGINE->IsReplayFinished())
+		{
+			Log::Info("Replay finished. Exiting..");
+			m_bAppWantsExit = true;
+		}
 	}
 }
 
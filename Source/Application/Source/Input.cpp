@@ -227,7 +227,31 @@ void Input::PostUpdate()
 	memcpy(m_prevKeys, m_keys, sizeof(bool) * KEY_COUNT);
 	m_mouseDelta[0] = m_mouseDelta[1] = 0;
 	m_mouseScroll = 0;
-	memset(m_buttons, false, sizeof(bool) * 17);
+	memset(m_buttons, false, sizeof(bool) * MOUSE_BUTTON_COUNT);
+}
+
+Input::State Input::GetState() const
+{
+	State state;
+	memcpy(state.keys, m_keys, sizeof(m_keys));
+	memcpy(state.prevKeys, m_prevKeys, sizeof(m_prevKeys));
+	memcpy(state.buttons, m_buttons, sizeof(m_buttons));
+	state.mouseDelta[0] = m_mouseDelta[0];
+	state.mouseDelta[1] = m_mouseDelta[1];
+	state.mouseScroll = m_mouseScroll;
+	state.bIgnoreInput = m_bIgnoreInput;
+	return state;
+}
+
+void Input::SetState(const State& state)
+{
+	memcpy(m_keys, state.keys, sizeof(m_keys));
+	memcpy(m_prevKeys, state.prevKeys, sizeof(m_prevKeys));
+	memcpy(m_buttons, state.buttons, sizeof(m_buttons));
+	m_mouseDelta[0] = state.mouseDelta[0];
+	m_mouseDelta[1] = state.mouseDelta[1];
+	m_mouseScroll = state.mouseScroll;
+	m_bIgnoreInput = state.bIgnoreInput;
 }
 
 const long * Input::GetDelta() const
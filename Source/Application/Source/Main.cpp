@@ -26,11 +26,11 @@ int WINAPI WinMain(HINSTANCE hInst, HINSTANCE hPrevInst, PSTR pScmdl, int iCmdSh
 	srand(static_cast<unsigned>(time(NULL)));
 	
 	Application VQDemo;
-	if (VQDemo.Init())
+	if (VQDemo.Init(pScmdl))
 	{
 		VQDemo.Run();
 	}
 	VQDemo.Exit();
 	
-	return 0;
+	return VQDemo.GetExitCode();
 }
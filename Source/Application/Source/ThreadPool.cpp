@@ -29,81 +29,8 @@ ThreadPool::ThreadPool(size_t numThreads)
 {
 	for (auto i = 0u; i < numThreads; ++i)
 	{
-		mThreads.emplace_back(std::thread(&ThreadPool::Execute, this));
+		mThreads.emplace_back(std::thread(&ThreadPool::Execute, this, i));
 	}
-
-	// Thread Pool Unit Test ------------------------------------------------
-	if (false)
-	{
-		constexpr long long sz = 40000000;
-		auto sumRnd = [&]()
-		{
-			std::vector<long long> nums(sz, 0);
-			for (int i = 0; i < sz; ++i)
-			{
-				nums[i] = RandI(0, 5000);
-			}
-			unsigned long long result = 0;
-			for (int i = 0; i < sz; ++i)
-			{
-				if (nums[i] > 3000)
-					result += nums[i];
-			}
-			return result;
-		};
-		auto sum = [&]()
-		{
-			std::vector<long long> nums(sz, 0);
-			for (int i = 0; i < sz; ++i)
-			{
-				nums[i] = RandI(0, 5000);
-			}
-			unsigned long long result = 0;
-			for (int i = 0; i < sz; ++i)
-			{
-				result += nums[i];
-			}
-			return result;
-		};
-
-		constexpr int threadCount = 16;
-		std::future<unsigned long long> futures[threadCount] =
-		{
-			this->AddTask(sumRnd),
-			this->AddTask(sumRnd),
-			this->AddTask(sumRnd),
-			this->AddTask(sumRnd),
-			this->AddTask(sumRnd),
-			this->AddTask(sumRnd),
-			this->AddTask(sumRnd),
-			this->AddTask(sumRnd),
-
-			this->AddTask(sum),
-			this->AddTask(sum),
-			this->AddTask(sum),
-			this->AddTask(sum),
-			this->AddTask(sum),
-			this->AddTask(sum),
-			this->AddTask(sum),
-			this->AddTask(sum),
-		};
-
-		std::vector<unsigned long long> results;
-		unsigned long long total = 0;
-		std::for_each(std::begin(futures), std::end(futures), [&](decltype(futures[0]) f)
-		{
-			results.push_back(f.get());
-			total += results.back();
-		});
-
-		std::string strResult = "total (" + std::to_string(total) + ") = ";
-		for (int i = 0; i < threadCount; ++i)
-		{
-			strResult += "(" + std::to_string(results[i]) + ") " + (i == threadCount - 1 ? "" : " + ");
-		}
-		Log::Info(strResult);
-	}
-	// Thread Pool Unit Test ------------------------------------------------
 }
 ThreadPool::~ThreadPool()
 {
@@ -120,8 +47,9 @@ ThreadPool::~ThreadPool()
 	}
 }
 
-void ThreadPool::Execute()
+void ThreadPool::Execute(size_t workerIndex)
 {
+	CPUProfiler::SetThreadName("Worker " + std::to_string(workerIndex));
 	while (true)
 	{
 		Task task;
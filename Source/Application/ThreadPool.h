@@ -26,6 +26,9 @@
 #include <future>
 #include <condition_variable>
 
+#include "Utilities/Profiler.h"
+#include "Utilities/MemoryTracker.h"
+
 // http://www.cplusplus.com/reference/thread/thread/
 // https://stackoverflow.com/a/32593825/2034041
 // todo: finish implementation for shader hotswapping
@@ -102,6 +105,8 @@ namespace VQEngine
 		ThreadPool(size_t numThreads);
 		~ThreadPool();
 
+		inline size_t GetThreadCount() const { return mThreads.size(); }
+
 
 		// Notes on C++11 Threading:
 		// ------------------------------------------------------------------------------------
@@ -145,11 +150,16 @@ namespace VQEngine
 			// as accesing its get_future() on the thread that calls this AddTask() function.
 			using typename task_return_t = decltype(task());
 			auto pTask = std::make_shared< std::packaged_task<task_return_t()>>(std::move(task));
+			const ProfileTaskLink profileLink = CPUProfiler::GetTaskLink();	// profiled as the scope it's submitted from
+			const EMemoryTag memoryTag = MemoryTracker::GetThreadTag();		// allocations are attributed to the submitter
 			{
 				std::unique_lock<std::mutex> lock(mMutex);
 				mTaskQueue.queue.emplace([=]
-				{					// Add a lambda function to the task queue which 
-					(*pTask)();		// calls the packaged_task<>'s callable object -> T task 
+				{								// Add a lambda function to the task queue which 
+					MemoryTracker::TagScope memoryTagScope(memoryTag);
+					CPUProfiler::BeginTask(profileLink);
+					(*pTask)();					// calls the packaged_task<>'s callable object -> T task 
+					CPUProfiler::EndTask();		// packaged_task<> catches the exceptions of the task
 				});
 			}
 
@@ -158,7 +168,7 @@ namespace VQEngine
 		}
 
 	private:
-		void Execute();
+		void Execute(size_t workerIndex);
 
 		std::vector<std::thread>	mThreads;
 		std::condition_variable		mSignal;
@@ -0,0 +1,82 @@
+//	VQEngine | DirectX11 Renderer
+//	Copyright(C) 2018  - Volkan Ilbeyli
+//
+//	This program is free software : you can redistribute it and / or modify
+//	it under the terms of the GNU General Public License as published by
+//	the Free Software Foundation, either version 3 of the License, or
+//	(at your option) any later version.
+//
+//	This program is distributed in the hope that it will be useful,
+//	but WITHOUT ANY WARRANTY; without even the implied warranty of
+//	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+//	GNU General Public License for more details.
+//
+//	You should have received a copy of the GNU General Public License
+//	along with this program.If not, see <http://www.gnu.org/licenses/>.
+//
+//	Contact: volkanilbeyli@gmail.com
+#pragma once
+
+#include <functional>
+#include <string>
+#include <vector>
+
+//----------------------------------------------------------------------------------------------------------------
+// BENCHMARK HARNESS
+//----------------------------------------------------------------------------------------------------------------
+// Times the CPU paths of the engine outside of the frame loop. Each benchmark function is run a few times to
+// warm up the caches, then repeated until both the minimum iteration count and the minimum time are reached.
+// The timings of the iterations are reduced to min/median/p95/mean, the median is what's compared against a
+// baseline: it's not skewed by the occasional context switch like the mean and it's more stable than the min.
+// The heap allocations of the timed iterations are counted too when the MemoryTracker is enabled: an extra
+// allocation in a hot path is a regression even if it doesn't show up in the timings of a benchmark machine.
+//
+struct BenchmarkResult
+{
+	std::string name;
+	int   problemSize = 0;	// objects, tasks, vertices... whatever the benchmark scales with
+	int   iterations = 0;
+	float minMs = 0.0f;
+	float medianMs = 0.0f;
+	float p95Ms = 0.0f;
+	float meanMs = 0.0f;
+	float allocationsPerIteration = -1.0f;	// -1: not measured
+	float bytesPerIteration = -1.0f;
+};
+
+struct BenchmarkSettings
+{
+	int   warmupIterations = 3;
+	int   minIterations = 10;
+	int   maxIterations = 10000;
+	float minDuration = 0.5f;	// seconds per benchmark
+	std::string filter;		// only run the benchmarks whose name contains this, runs all if empty
+};
+
+class BenchmarkRunner
+{
+public:
+	BenchmarkRunner(const BenchmarkSettings& settings);
+
+	// returns false if the benchmark is filtered out: the caller can skip the setup of the benchmark.
+	bool IsEnabled(const std::string& name) const;
+
+	// times @fnIteration, @problemSize is recorded to tell apart the runs of the same benchmark at different sizes.
+	void Run(const std::string& name, int problemSize, const std::function<void()>& fnIteration);
+
+	inline const std::vector<BenchmarkResult>& GetResults() const { return mResults; }
+
+	bool WriteJSON(const std::string& filePath) const;
+	
+	// reads the files written by WriteJSON(), it's not a general purpose JSON parser.
+	static bool ReadJSON(const std::string& filePath, std::vector<BenchmarkResult>& results);
+
+	// logs the median of each result against the baseline result with the same name and problem size.
+	// returns the number of regressions: the results slower than the baseline by more than @threshold (0.1=10%),
+	// or the results that allocate more than the baseline by the same ratio.
+	int CompareToBaseline(const std::vector<BenchmarkResult>& baseline, float threshold) const;
+
+private:
+	BenchmarkSettings mSettings;
+	std::vector<BenchmarkResult> mResults;
+};
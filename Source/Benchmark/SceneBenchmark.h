@@ -0,0 +1,70 @@
+//	VQEngine | DirectX11 Renderer
+//	Copyright(C) 2018  - Volkan Ilbeyli
+//
+//	This program is free software : you can redistribute it and / or modify
+//	it under the terms of the GNU General Public License as published by
+//	the Free Software Foundation, either version 3 of the License, or
+//	(at your option) any later version.
+//
+//	This program is distributed in the hope that it will be useful,
+//	but WITHOUT ANY WARRANTY; without even the implied warranty of
+//	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+//	GNU General Public License for more details.
+//
+//	You should have received a copy of the GNU General Public License
+//	along with this program.If not, see <http://www.gnu.org/licenses/>.
+//
+//	Contact: volkanilbeyli@gmail.com
+#pragma once
+
+#include "Engine/Scene.h"
+#include "Engine/DataStructures.h"
+
+#include "Utilities/Profiler.h"
+
+#include <string>
+#include <vector>
+
+// A scene without a Renderer: it loads the synthetic scenes written by the Parser and drives the parts of the
+// frame that don't need the GPU: the culling and sorting of PreRender(), GatherLightData() and the bounding
+// box calculation. Built-in meshes have no vertex buffers without a renderer, the bounding boxes are calculated
+// from synthetic CPU-side vertices with the same kernel Scene::CalculateSceneBoundingBox() uses.
+//
+class SceneBenchmark : public Scene
+{
+public:
+	static constexpr int NUM_VERTICES_PER_MESH = 1024;
+#ifdef _DEBUG
+	static constexpr int MAX_NUM_OBJECTS = 4096;	// object pool size of Scene::LoadScene()
+#else
+	static constexpr int MAX_NUM_OBJECTS = 4096 * 8;
+#endif
+	static constexpr int NUM_SHADOWING_SPOT_LIGHTS = NUM_SPOT_LIGHT_SHADOW;
+
+	SceneBenchmark(VQEngine::ThreadPool* pThreadPool);
+	~SceneBenchmark();
+
+	bool LoadSyntheticScene(const std::string& filePath);
+
+	// the benchmarked paths
+	//
+	void PreRenderFrame();
+	void GatherLights();
+	void CalculateBoundingBoxes();
+
+	inline int GetNumObjects() const { return static_cast<int>(mpObjects.size()); }
+	inline const FrameStats& GetFrameStats() const { return mFrameStats; }
+
+protected:
+	void Update(float dt) override {}
+	void Load(SerializedScene& scene) override;
+	void Unload() override {}
+	void RenderUI() const override {}
+
+private:
+	std::vector<DefaultVertexBufferData> mMeshVertices;	// NUM_VERTICES_PER_MESH vertices per built-in mesh
+	CPUProfiler                          mProfiler;
+	FrameStats                           mFrameStats = {};
+	SceneLightingData                    mLightingData;
+	bool                                 mbLoaded = false;
+};
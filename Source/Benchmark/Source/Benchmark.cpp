@@ -0,0 +1,218 @@
+//	VQEngine | DirectX11 Renderer
+//	Copyright(C) 2018  - Volkan Ilbeyli
+//
+//	This program is free software : you can redistribute it and / or modify
+//	it under the terms of the GNU General Public License as published by
+//	the Free Software Foundation, either version 3 of the License, or
+//	(at your option) any later version.
+//
+//	This program is distributed in the hope that it will be useful,
+//	but WITHOUT ANY WARRANTY; without even the implied warranty of
+//	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+//	GNU General Public License for more details.
+//
+//	You should have received a copy of the GNU General Public License
+//	along with this program.If not, see <http://www.gnu.org/licenses/>.
+//
+//	Contact: volkanilbeyli@gmail.com
+#define NOMINMAX
+
+#include "Benchmark.h"
+
+#include "Utilities/Log.h"
+#include "Utilities/utils.h"
+#include "Utilities/MemoryTracker.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <thread>
+
+using Clock = std::chrono::high_resolution_clock;
+static inline float GetElapsedMs(const Clock::time_point& start) { return std::chrono::duration<float, std::milli>(Clock::now() - start).count(); }
+
+BenchmarkRunner::BenchmarkRunner(const BenchmarkSettings& settings)
+	: mSettings(settings)
+{}
+
+bool BenchmarkRunner::IsEnabled(const std::string& name) const
+{
+	return mSettings.filter.empty() || name.find(mSettings.filter) != std::string::npos;
+}
+
+void BenchmarkRunner::Run(const std::string& name, int problemSize, const std::function<void()>& fnIteration)
+{
+	if (!IsEnabled(name))
+		return;
+
+	for (int i = 0; i < mSettings.warmupIterations; ++i)
+	{
+		fnIteration();
+	}
+
+	std::vector<float> samples;
+	const float minDurationMs = mSettings.minDuration * 1000.0f;
+	float totalMs = 0.0f;
+	const MemoryTracker::Counters allocationsBegin = MemoryTracker::GetCounters();
+	while (static_cast<int>(samples.size()) < mSettings.maxIterations
+		&& (static_cast<int>(samples.size()) < mSettings.minIterations || totalMs < minDurationMs))
+	{
+		const Clock::time_point start = Clock::now();
+		fnIteration();
+		samples.push_back(GetElapsedMs(start));
+		totalMs += samples.back();
+	}
+	const MemoryTracker::Counters allocationsEnd = MemoryTracker::GetCounters();
+
+	std::sort(samples.begin(), samples.end());
+	auto Percentile = [&](float p) { return samples[std::min(samples.size() - 1, static_cast<size_t>(p * samples.size()))]; };
+
+	BenchmarkResult result;
+	result.name = name;
+	result.problemSize = problemSize;
+	result.iterations = static_cast<int>(samples.size());
+	result.minMs = samples.front();
+	result.medianMs = Percentile(0.50f);
+	result.p95Ms = Percentile(0.95f);
+	result.meanMs = totalMs / samples.size();
+	if (MemoryTracker::IsEnabled())
+	{	// the counters include the worker threads: the allocations of the tasks are counted too
+		result.allocationsPerIteration = static_cast<float>(allocationsEnd.numAllocations - allocationsBegin.numAllocations) / samples.size();
+		result.bytesPerIteration = static_cast<float>(allocationsEnd.numAllocatedBytes - allocationsBegin.numAllocatedBytes) / samples.size();
+	}
+	mResults.push_back(result);
+
+	Log::Info("%-36s size=%-8d median=%9.4fms  min=%9.4fms  p95=%9.4fms  allocs=%-9.1f (%d iterations)"
+		, name.c_str(), problemSize, result.medianMs, result.minMs, result.p95Ms, result.allocationsPerIteration, result.iterations);
+}
+
+// one result per line, which keeps ReadJSON() simple and the diffs of the baseline files readable
+bool BenchmarkRunner::WriteJSON(const std::string& filePath) const
+{
+	DirectoryUtil::CreateFolderIfItDoesntExist(DirectoryUtil::GetFolderPath(filePath));
+	std::ofstream file(filePath, std::ios::trunc);
+	if (!file.is_open())
+	{
+		Log::Error("Benchmark: Couldn't open %s for writing.", filePath.c_str());
+		return false;
+	}
+
+	char line[512];
+	file << "{\n";
+	file << "\t\"date\": \"" << GetCurrentTimeAsString() << "\",\n";
+	file << "\t\"hardwareThreads\": " << std::thread::hardware_concurrency() << ",\n";
+	file << "\t\"benchmarks\": [\n";
+	for (size_t i = 0; i < mResults.size(); ++i)
+	{
+		const BenchmarkResult& r = mResults[i];
+		sprintf_s(line, "\t\t{ \"name\": \"%s\", \"size\": %d, \"iterations\": %d, \"min_ms\": %.6f, \"median_ms\": %.6f, \"p95_ms\": %.6f, \"mean_ms\": %.6f, \"allocs\": %.2f, \"alloc_bytes\": %.1f }%s\n"
+			, r.name.c_str(), r.problemSize, r.iterations, r.minMs, r.medianMs, r.p95Ms, r.meanMs, r.allocationsPerIteration, r.bytesPerIteration
+			, i == mResults.size() - 1 ? "" : ","
+		);
+		file << line;
+	}
+	file << "\t]\n";
+	file << "}\n";
+	return file.good();
+}
+
+bool BenchmarkRunner::ReadJSON(const std::string& filePath, std::vector<BenchmarkResult>& results)
+{
+	std::ifstream file(filePath);
+	if (!file.is_open())
+	{
+		Log::Error("Benchmark: Couldn't open %s", filePath.c_str());
+		return false;
+	}
+
+	// returns the text after "@key": on @line, or nullptr
+	auto FindValue = [](const std::string& line, const char* key) -> const char*
+	{
+		const std::string quotedKey = std::string("\"") + key + "\":";
+		const size_t pos = line.find(quotedKey);
+		return pos == std::string::npos ? nullptr : line.c_str() + pos + quotedKey.size();
+	};
+
+	std::string line;
+	while (std::getline(file, line))
+	{
+		const char* pName = FindValue(line, "name");
+		if (!pName)
+			continue;
+
+		const char* pNameBegin = strchr(pName, '"');
+		const char* pNameEnd = pNameBegin ? strchr(pNameBegin + 1, '"') : nullptr;
+		const char* pSize = FindValue(line, "size");
+		const char* pIterations = FindValue(line, "iterations");
+		const char* pMin = FindValue(line, "min_ms");
+		const char* pMedian = FindValue(line, "median_ms");
+		const char* pP95 = FindValue(line, "p95_ms");
+		const char* pMean = FindValue(line, "mean_ms");
+		const char* pAllocs = FindValue(line, "allocs");
+		const char* pAllocBytes = FindValue(line, "alloc_bytes");
+		if (!pNameEnd || !pSize || !pMedian)
+		{
+			Log::Warning("Benchmark: Skipping malformed result in %s: %s", filePath.c_str(), line.c_str());
+			continue;
+		}
+
+		BenchmarkResult r;
+		r.name = std::string(pNameBegin + 1, pNameEnd);
+		r.problemSize = atoi(pSize);
+		r.iterations  = pIterations ? atoi(pIterations) : 0;
+		r.minMs       = pMin  ? strtof(pMin , nullptr) : 0.0f;
+		r.medianMs    = strtof(pMedian, nullptr);
+		r.p95Ms       = pP95  ? strtof(pP95 , nullptr) : 0.0f;
+		r.meanMs      = pMean ? strtof(pMean, nullptr) : 0.0f;
+		r.allocationsPerIteration = pAllocs     ? strtof(pAllocs    , nullptr) : -1.0f;	// older baselines didn't count the allocations
+		r.bytesPerIteration       = pAllocBytes ? strtof(pAllocBytes, nullptr) : -1.0f;
+		results.push_back(r);
+	}
+	return true;
+}
+
+int BenchmarkRunner::CompareToBaseline(const std::vector<BenchmarkResult>& baseline, float threshold) const
+{
+	int numRegressions = 0;
+	int numImprovements = 0;
+	Log::Info("Comparison against baseline (threshold %.1f%%):", threshold * 100.0f);
+	for (const BenchmarkResult& r : mResults)
+	{
+		const auto it = std::find_if(baseline.begin(), baseline.end(), [&](const BenchmarkResult& b)
+		{
+			return b.name == r.name && b.problemSize == r.problemSize;
+		});
+		if (it == baseline.end())
+		{
+			Log::Info("\t%-36s size=%-8d                  : not in baseline", r.name.c_str(), r.problemSize);
+			continue;
+		}
+
+		const float change = it->medianMs > 0.0f ? (r.medianMs - it->medianMs) / it->medianMs : 0.0f;
+		const char* pVerdict = "";
+		if      (change >  threshold) { pVerdict = "REGRESSION"; ++numRegressions; }
+		else if (change < -threshold) { pVerdict = "improved";   ++numImprovements; }
+
+		char line[256];
+		sprintf_s(line, "\t%-36s size=%-8d %9.4fms -> %9.4fms : %+6.1f%% %s"
+			, r.name.c_str(), r.problemSize, it->medianMs, r.medianMs, change * 100.0f, pVerdict);
+		if (change > threshold) Log::Error(std::string(line));	// @line is already formatted
+		else                    Log::Info(std::string(line));
+
+		// allocation counts are deterministic unlike the timings, the absolute slack covers the
+		// rounding of the per-iteration averages and the occasional one-off allocation (e.g. a vector growing)
+		constexpr float ALLOCATION_SLACK = 0.5f;
+		if (r.allocationsPerIteration >= 0.0f && it->allocationsPerIteration >= 0.0f
+			&& r.allocationsPerIteration > it->allocationsPerIteration * (1.0f + threshold) + ALLOCATION_SLACK)
+		{
+			sprintf_s(line, "\t%-36s size=%-8d %9.1f -> %9.1f allocations per iteration : REGRESSION"
+				, r.name.c_str(), r.problemSize, it->allocationsPerIteration, r.allocationsPerIteration);
+			Log::Error(std::string(line));
+			if (change <= threshold) ++numRegressions;	// counted once per benchmark
+		}
+	}
+	Log::Info("%d regression(s), %d improvement(s) out of %d benchmarks.", numRegressions, numImprovements, static_cast<int>(mResults.size()));
+	return numRegressions;
+}
@@ -0,0 +1,353 @@
+//	VQEngine | DirectX11 Renderer
+//	Copyright(C) 2018  - Volkan Ilbeyli
+//
+//	This program is free software : you can redistribute it and / or modify
+//	it under the terms of the GNU General Public License as published by
+//	the Free Software Foundation, either version 3 of the License, or
+//	(at your option) any later version.
+//
+//	This program is distributed in the hope that it will be useful,
+//	but WITHOUT ANY WARRANTY; without even the implied warranty of
+//	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+//	GNU General Public License for more details.
+//
+//	You should have received a copy of the GNU General Public License
+//	along with this program.If not, see <http://www.gnu.org/licenses/>.
+//
+//	Contact: volkanilbeyli@gmail.com
+
+// Headless benchmarks of the engine's CPU paths: no window, no D3D device. e.g.:
+//
+//   Benchmark.exe -Size=10000 -Output=results.json
+//   Benchmark.exe -Baseline=baseline.json -Threshold=0.1     : exits with 1 if there are regressions
+//
+// The processed textures are compared against their source image as well: a texture below the PSNR
+// threshold of its compression mode counts as a regression, with or without a baseline.
+//
+//   -Size=<N>          : number of objects/tasks/elements of the synthetic workloads, repeatable. (default: 1000, 10000)
+//   -Filter=<name>     : only runs the benchmarks whose name contains <name>
+//   -MinTime=<sec>     : minimum time spent timing each benchmark (default: 0.5)
+//   -Output=<file>     : JSON results (default: %APPDATA%/VQEngine/Benchmark/Results_<time>.json)
+//   -Baseline=<file>   : JSON results of an earlier run to compare the medians against
+//   -Threshold=<ratio> : slowdown or allocation increase that counts as a regression (default: 0.1 = 10%)
+//
+#define NOMINMAX
+
+#include "Benchmark.h"
+#include "SceneBenchmark.h"
+
+#include "Application/Application.h"
+#include "Application/ThreadPool.h"
+#include "Engine/Culling.h"
+#include "Engine/Transform.h"
+#include "Renderer/TextureProcessor.h"
+
+#include "Utilities/CustomParser.h"
+#include "Utilities/Log.h"
+#include "Utilities/utils.h"
+#include "Utilities/MemoryTracker.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <limits>
+#include <numeric>
+#include <random>
+
+#include <objbase.h>
+
+// the benchmarks that need the synthetic scene file, the ones after the parser need the scene loaded too
+static const char* SCENE_BENCHMARKS[] = { "Parser.ReadScene", "Scene.CalculateSceneBoundingBox", "Scene.GatherLightData", "Scene.PreRender" };
+
+// the texture processing benchmarks don't scale with -Size: one texture, each compression mode
+// with the minimum PSNR of its output against the source image. Uncompressed has to be lossless, the block
+// compressed photo textures usually end up in the low 30s: the threshold catches broken encodes, not small losses.
+static const char* TEXTURE_BENCHMARK_SOURCE = "Data/Textures/openart/151.JPG";
+static const struct { ETextureCompression compression; float minPSNR; } TEXTURE_BENCHMARKS[] =
+{
+	{ ETextureCompression::NONE, std::numeric_limits<float>::infinity() },
+	{ ETextureCompression::BC1 , 28.0f },
+	{ ETextureCompression::BC3 , 28.0f },
+};
+
+struct BenchmarkOptions
+{
+	std::vector<int>  sizes;
+	BenchmarkSettings settings;
+	std::string       outputFilePath;
+	std::string       baselineFilePath;
+	float             threshold = 0.1f;
+
+	static BenchmarkOptions Parse(int argc, char* argv[]);
+};
+
+BenchmarkOptions BenchmarkOptions::Parse(int argc, char* argv[])
+{
+	BenchmarkOptions options;
+	for (int i = 1; i < argc; ++i)
+	{
+		const std::string arg = argv[i];
+		auto Value = [&](const char* pFlag) { return arg.substr(strlen(pFlag)); };
+		
+		if      (arg.find("-Size=") == 0)      options.sizes.push_back(std::atoi(Value("-Size=").c_str()));
+		else if (arg.find("-Filter=") == 0)    options.settings.filter = Value("-Filter=");
+		else if (arg.find("-MinTime=") == 0)   options.settings.minDuration = static_cast<float>(std::atof(Value("-MinTime=").c_str()));
+		else if (arg.find("-Output=") == 0)    options.outputFilePath = Value("-Output=");
+		else if (arg.find("-Baseline=") == 0)  options.baselineFilePath = Value("-Baseline=");
+		else if (arg.find("-Threshold=") == 0) options.threshold = static_cast<float>(std::atof(Value("-Threshold=").c_str()));
+		else Log::Warning("Unknown command line argument: %s", arg.c_str());
+	}
+
+	options.sizes.erase(std::remove_if(RANGE(options.sizes), [](int size) { return size <= 0; }), options.sizes.end());
+	if (options.sizes.empty())
+	{
+		options.sizes = { 1000, 10000 };
+	}
+	if (options.outputFilePath.empty())
+	{
+		options.outputFilePath = Application::s_WorkspaceDirectory + "/Benchmark/Results_" + GetCurrentTimeAsString() + ".json";
+	}
+	return options;
+}
+
+static void BenchmarkSceneParsing(BenchmarkRunner& runner, const std::string& sceneFilePath, int numObjects)
+{
+	runner.Run("Parser.ReadScene", numObjects, [&]()
+	{
+		SerializedScene scene = Parser::ReadSceneFile(nullptr, sceneFilePath);
+	});
+}
+
+static void BenchmarkScene(BenchmarkRunner& runner, VQEngine::ThreadPool& threadPool, const std::string& sceneFilePath, int numObjects)
+{
+	if (std::none_of(std::begin(SCENE_BENCHMARKS) + 1, std::end(SCENE_BENCHMARKS), [&](const char* pName) { return runner.IsEnabled(pName); }))
+		return;
+
+	SceneBenchmark scene(&threadPool);
+	if (!scene.LoadSyntheticScene(sceneFilePath))
+		return;
+
+	runner.Run("Scene.CalculateSceneBoundingBox", numObjects, [&]() { scene.CalculateBoundingBoxes(); });
+	runner.Run("Scene.GatherLightData", numObjects, [&]() { scene.GatherLights(); });
+	
+	scene.GatherLights();	// the engine gathers the lights before PreRender()
+	runner.Run("Scene.PreRender", numObjects, [&]() { scene.PreRenderFrame(); });
+
+	const SceneStats& stats = scene.GetFrameStats().scene;
+	Log::Info("\tPreRender: %d objects, %d culled from the main view, %d culled from %d spot light views"
+		, stats.numObjects, stats.numMainViewCulledObjects, stats.numSpotsCulledObjects, stats.numSpots);
+}
+
+static void BenchmarkThreadPool(BenchmarkRunner& runner, VQEngine::ThreadPool& threadPool, int numTasks)
+{
+	// dispatch overhead: tasks that do next to nothing
+	runner.Run("ThreadPool.EmptyTasks", numTasks, [&]()
+	{
+		std::atomic<int> counter(0);
+		std::vector<std::future<void>> futures(numTasks);
+		for (std::future<void>& f : futures)
+		{
+			f = threadPool.AddTask([&]() { counter.fetch_add(1, std::memory_order_relaxed); });
+		}
+		for (std::future<void>& f : futures)
+		{
+			f.wait();
+		}
+	});
+
+	// throughput: a large sum split into one task per worker, 
+	// replaces the 'unit test' that used to be in the ThreadPool constructor.
+	constexpr size_t NUM_ELEMENTS_PER_TASK = 1024;
+	std::vector<int> numbers(numTasks * NUM_ELEMENTS_PER_TASK);
+	std::iota(RANGE(numbers), 0);
+	const size_t numWorkers = std::max<size_t>(1, threadPool.GetThreadCount());
+	runner.Run("ThreadPool.ParallelSum", static_cast<int>(numbers.size()), [&]()
+	{
+		const size_t chunkSize = (numbers.size() + numWorkers - 1) / numWorkers;
+		std::vector<std::future<long long>> futures;
+		for (size_t begin = 0; begin < numbers.size(); begin += chunkSize)
+		{
+			const size_t end = std::min(numbers.size(), begin + chunkSize);
+			futures.push_back(threadPool.AddTask([&numbers, begin, end]()
+			{
+				return std::accumulate(numbers.begin() + begin, numbers.begin() + end, 0ll);
+			}));
+		}
+		long long sum = 0;
+		for (std::future<long long>& f : futures)
+		{
+			sum += f.get();
+		}
+		assert(sum == static_cast<long long>(numbers.size()) * (numbers.size() - 1) / 2);
+	});
+}
+
+static void BenchmarkVectorMath(BenchmarkRunner& runner, int numElements)
+{
+	std::mt19937 rng(numElements);
+	std::uniform_real_distribution<float> position(-500.0f, 500.0f), angle(0.0f, 360.0f), scale(0.5f, 20.0f);
+
+	std::vector<Transform> transforms(numElements);
+	for (Transform& tf : transforms)
+	{
+		tf.SetPosition(position(rng), position(rng), position(rng));
+		tf.RotateAroundGlobalXAxisDegrees(angle(rng));
+		tf.RotateAroundGlobalYAxisDegrees(angle(rng));
+		tf.SetUniformScale(scale(rng));
+	}
+
+	std::vector<XMMATRIX> worldMatrices(numElements);
+	std::vector<BoundingBox> worldBounds(numElements);
+	std::vector<FrustumPlaneset> frustums(numElements);
+	BoundingBox localBounds;
+	localBounds.low = vec3(-1.0f);
+	localBounds.hi  = vec3(+1.0f);
+
+	const XMMATRIX viewProj = XMMatrixLookAtLH(vec3(0.0f, 50.0f, -600.0f), vec3::Zero, vec3::Up) * XMMatrixPerspectiveFovLH(60.0f * DEG2RAD, 16.0f / 9.0f, 0.1f, 1500.0f);
+	int numVisible = 0;
+
+	runner.Run("vectormath.WorldTransformationMatrix", numElements, [&]()
+	{
+		for (int i = 0; i < numElements; ++i)
+			worldMatrices[i] = transforms[i].WorldTransformationMatrix();
+	});
+	runner.Run("vectormath.TransformAABB", numElements, [&]()
+	{
+		for (int i = 0; i < numElements; ++i)
+			worldBounds[i] = TransformAABB(localBounds, worldMatrices[i]);
+	});
+	runner.Run("vectormath.FrustumPlaneset::ExtractFromMatrix", numElements, [&]()
+	{
+		for (int i = 0; i < numElements; ++i)
+			frustums[i] = FrustumPlaneset::ExtractFromMatrix(worldMatrices[i] * viewProj);
+	});
+	runner.Run("vectormath.IsVisible", numElements, [&]()
+	{
+		const FrustumPlaneset frustum = FrustumPlaneset::ExtractFromMatrix(viewProj);
+		numVisible = 0;
+		for (int i = 0; i < numElements; ++i)
+			numVisible += IsVisible(frustum, worldBounds[i]) ? 1 : 0;
+	});
+	if (runner.IsEnabled("vectormath.IsVisible"))
+	{
+		Log::Info("\tIsVisible: %d/%d bounding boxes visible", numVisible, numElements);
+	}
+}
+
+// doesn't scale with -Size either: the event stream of the scratch profiler holds 8K scopes at most
+static void BenchmarkProfiler(BenchmarkRunner& runner)
+{
+	constexpr int NUM_SCOPES = 4096;
+	float nsPerScope = 0.0f;
+	runner.Run("CPUProfiler.Scope", NUM_SCOPES, [&]() { nsPerScope = CPUProfiler::MeasureScopeOverhead(NUM_SCOPES); });
+	if (runner.IsEnabled("CPUProfiler.Scope"))
+	{
+		Log::Info("\tCPUProfiler: %.1f ns per profile scope", nsPerScope);
+	}
+}
+
+// returns the number of processed textures that don't match their source image within their PSNR threshold
+static int BenchmarkTextureProcessor(BenchmarkRunner& runner, const std::string& outputFolder)
+{
+	auto fnGetName = [](ETextureCompression compression) { return std::string("TextureProcessor.Process.") + TextureProcessor::GetCompressionName(compression); };
+	if (std::none_of(std::begin(TEXTURE_BENCHMARKS), std::end(TEXTURE_BENCHMARKS), [&](const auto& benchmark) { return runner.IsEnabled(fnGetName(benchmark.compression)); }))
+		return 0;
+
+	std::vector<uint8_t> sourceData;
+	if (!TextureProcessor::ReadFile(TEXTURE_BENCHMARK_SOURCE, sourceData))
+	{
+		Log::Error("Benchmark: Couldn't read %s", TEXTURE_BENCHMARK_SOURCE);
+		return 1;
+	}
+	DirectoryUtil::CreateFolderIfItDoesntExist(outputFolder);
+
+	int numFailures = 0;
+	for (const auto& benchmark : TEXTURE_BENCHMARKS)
+	{
+		const std::string compressionName = TextureProcessor::GetCompressionName(benchmark.compression);
+		const std::string name = fnGetName(benchmark.compression);
+		if (!runner.IsEnabled(name))
+			continue;
+
+		// the first run also gives the image size for the problem size and the file to compare
+		TextureProcessSettings settings;
+		settings.compression = benchmark.compression;
+		const std::string outputFilePath = outputFolder + "/TextureProcessor_" + compressionName + ".dds";
+		TextureProcessStats stats = {};
+		if (!TextureProcessor::Process(sourceData.data(), sourceData.size(), outputFilePath, settings, &stats))
+		{
+			++numFailures;
+			continue;
+		}
+
+		runner.Run(name, stats.width * stats.height, [&]()
+		{
+			TextureProcessor::Process(sourceData.data(), sourceData.size(), outputFilePath, settings);
+		});
+
+		ImageDiff diff = {};
+		if (!TextureProcessor::CompareImages(TEXTURE_BENCHMARK_SOURCE, outputFilePath, diff))
+		{
+			++numFailures;
+			continue;
+		}
+		if (diff.psnr < benchmark.minPSNR)
+		{
+			Log::Error("\t%s: PSNR %.2f dB against the source image, expected at least %.2f dB", compressionName.c_str(), diff.psnr, benchmark.minPSNR);
+			++numFailures;
+			continue;
+		}
+		Log::Info("\t%s: PSNR %.2f dB against the source image, %d mips, %.1f MB", compressionName.c_str(), diff.psnr, stats.mipCount, stats.outputBytes / (1024.0f * 1024.0f));
+	}
+	return numFailures;
+}
+
+int main(int argc, char* argv[])
+{
+	Application::s_WorkspaceDirectory = DirectoryUtil::GetSpecialFolderPath(DirectoryUtil::ESpecialFolder::APPDATA) + "/VQEngine";
+	CPUProfiler::SetThreadName("Main");
+	MemoryTracker::SetEnabled(true);	// the allocations per iteration are compared against the baseline too
+	CoInitializeEx(nullptr, COINIT_MULTITHREADED);	// the WIC decoder of the TextureProcessor
+
+	const BenchmarkOptions options = BenchmarkOptions::Parse(argc, argv);
+	BenchmarkRunner runner(options.settings);
+	VQEngine::ThreadPool threadPool(std::max<size_t>(1, VQEngine::ThreadPool::sHardwareThreadCount - 2));	// same as the Application
+
+	for (const int size : options.sizes)
+	{
+		Log::Info("---------------- Size: %d ----------------", size);
+		const std::string sceneFilePath = Application::s_WorkspaceDirectory + "/Benchmark/SyntheticScene_" + std::to_string(size) + ".scn";
+		const bool bNeedsScene = std::any_of(std::begin(SCENE_BENCHMARKS), std::end(SCENE_BENCHMARKS), [&](const char* pName) { return runner.IsEnabled(pName); });
+		if (bNeedsScene && Parser::WriteSyntheticScene(sceneFilePath, size))
+		{
+			BenchmarkSceneParsing(runner, sceneFilePath, size);
+			BenchmarkScene(runner, threadPool, sceneFilePath, size);
+		}
+		BenchmarkThreadPool(runner, threadPool, size);
+		BenchmarkVectorMath(runner, size);
+	}
+	BenchmarkProfiler(runner);
+	const int numTextureFailures = BenchmarkTextureProcessor(runner, Application::s_WorkspaceDirectory + "/Benchmark");
+
+	if (runner.GetResults().empty())
+	{
+		Log::Error("No benchmarks were run.");
+		return 2;
+	}
+
+	if (runner.WriteJSON(options.outputFilePath))
+	{
+		Log::Info("Results written to %s", options.outputFilePath.c_str());
+	}
+
+	int numRegressions = numTextureFailures;
+	if (!options.baselineFilePath.empty())
+	{
+		std::vector<BenchmarkResult> baseline;
+		if (!BenchmarkRunner::ReadJSON(options.baselineFilePath, baseline))
+			return 2;
+		
+		numRegressions += runner.CompareToBaseline(baseline, options.threshold);
+	}
+	return numRegressions > 0 ? 1 : 0;
+}
@@ -0,0 +1,120 @@
+//	VQEngine | DirectX11 Renderer
+//	Copyright(C) 2018  - Volkan Ilbeyli
+//
+//	This program is free software : you can redistribute it and / or modify
+//	it under the terms of the GNU General Public License as published by
+//	the Free Software Foundation, either version 3 of the License, or
+//	(at your option) any later version.
+//
+//	This program is distributed in the hope that it will be useful,
+//	but WITHOUT ANY WARRANTY; without even the implied warranty of
+//	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+//	GNU General Public License for more details.
+//
+//	You should have received a copy of the GNU General Public License
+//	along with this program.If not, see <http://www.gnu.org/licenses/>.
+//
+//	Contact: volkanilbeyli@gmail.com
+#define NOMINMAX
+
+#include "SceneBenchmark.h"
+
+#include "Engine/Culling.h"
+#include "Engine/Settings.h"
+
+#include "Utilities/CustomParser.h"
+#include "Utilities/Log.h"
+
+#include <random>
+
+SceneBenchmark::SceneBenchmark(VQEngine::ThreadPool* pThreadPool)
+	: Scene(nullptr, nullptr)
+{
+	mpThreadPool = pThreadPool;
+
+	// vertices in the [-1, 1] range of the built-in meshes, laid out like a vertex buffer
+	std::mt19937 rng(0);
+	std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+	mMeshVertices.resize(EGeometry::MESH_TYPE_COUNT * NUM_VERTICES_PER_MESH);
+	for (DefaultVertexBufferData& v : mMeshVertices)
+	{
+		v.position = vec3(unit(rng), unit(rng), unit(rng));
+		v.normal = vec3::UpF3;
+		v.tangent = vec3::RightF3;
+		v.uv = vec2(0.0f, 0.0f);
+	}
+}
+
+SceneBenchmark::~SceneBenchmark()
+{
+	if (mbLoaded)
+	{
+		UnloadScene();
+	}
+}
+
+bool SceneBenchmark::LoadSyntheticScene(const std::string& filePath)
+{
+	SerializedScene scene = Parser::ReadSceneFile(nullptr, filePath);
+	if (scene.loadSuccess != '1')
+	{
+		Log::Error("SceneBenchmark: Couldn't read %s", filePath.c_str());
+		return false;
+	}
+	if (scene.objects.size() > MAX_NUM_OBJECTS)
+	{
+		Log::Error("SceneBenchmark: %s has %d objects, the scene can hold %d.", filePath.c_str(), static_cast<int>(scene.objects.size()), MAX_NUM_OBJECTS);
+		return false;
+	}
+
+	Settings::Window windowSettings = {};
+	windowSettings.width = 1920;
+	windowSettings.height = 1080;
+	LoadScene(scene, windowSettings, std::vector<Mesh>());
+	CalculateBoundingBoxes();
+	mbLoaded = true;
+	return true;
+}
+
+void SceneBenchmark::Load(SerializedScene& scene)
+{
+	// the synthetic scenes only have point lights which don't cast shadows: add shadowing spot
+	// lights looking down on the scene for the shadow view culling to have some work.
+	for (int i = 0; i < NUM_SHADOWING_SPOT_LIGHTS; ++i)
+	{
+		Light l(Light::ELightType::SPOT, LinearColor::white, 1000.0f, 300.0f, 60.0f, true);
+		l.transform.SetPosition(-400.0f + 200.0f * i, 300.0f, 0.0f);
+		l.transform.SetXRotationDeg(90.0f);
+		mLights.push_back(l);
+	}
+}
+
+void SceneBenchmark::PreRenderFrame()
+{
+	mProfiler.BeginProfile();
+	mProfiler.BeginEntry(PROFILE_SCOPE_ID("PreRender"));
+	PreRender(&mProfiler, mFrameStats);
+	mProfiler.EndEntry();
+	mProfiler.EndProfile();
+}
+
+void SceneBenchmark::GatherLights()
+{
+	GatherLightData(mLightingData);
+}
+
+void SceneBenchmark::CalculateBoundingBoxes()
+{
+	BoundingBox sceneBounds = EmptyBoundingBox();
+	for (GameObject* pObj : mpObjects)
+	{
+		const XMMATRIX world = pObj->GetTransform().WorldTransformationMatrix();
+		BoundingBox objectBounds = EmptyBoundingBox();
+		for (MeshID meshID : pObj->GetModelData().mMeshIDs)
+		{
+			const DefaultVertexBufferData* pVertices = &mMeshVertices[(meshID % EGeometry::MESH_TYPE_COUNT) * NUM_VERTICES_PER_MESH];
+			AccumulateVertexBounds(pVertices, NUM_VERTICES_PER_MESH, sizeof(DefaultVertexBufferData), world, sceneBounds, objectBounds);
+		}
+		pObj->mBoundingBox = objectBounds;
+	}
+}
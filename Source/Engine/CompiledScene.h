@@ -0,0 +1,57 @@
+//	VQEngine | DirectX11 Renderer
+//	Copyright(C) 2018  - Volkan Ilbeyli
+//
+//	This program is free software : you can redistribute it and / or modify
+//	it under the terms of the GNU General Public License as published by
+//	the Free Software Foundation, either version 3 of the License, or
+//	(at your option) any later version.
+//
+//	This program is distributed in the hope that it will be useful,
+//	but WITHOUT ANY WARRANTY; without even the implied warranty of
+//	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+//	GNU General Public License for more details.
+//
+//	You should have received a copy of the GNU General Public License
+//	along with this program.If not, see <http://www.gnu.org/licenses/>.
+//
+//	Contact: volkanilbeyli@gmail.com
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+struct SerializedScene;
+class Renderer;
+
+//----------------------------------------------------------------------------------------------------------------
+// COMPILED SCENE
+//----------------------------------------------------------------------------------------------------------------
+// Versioned binary form of a SerializedScene: cameras, lights, scene settings, materials and the objects
+// with their transforms, meshes and model references. Written by the -CompileScenes mode and preferred
+// over parsing the text scene file when it's up to date with it.
+//
+// Loading reads the file with a single read and fills the SerializedScene from flat arrays: the object
+// array and the material pool are sized from the header up front, nothing is parsed or looked up by name.
+// Textures are stored by file name and created through the renderer the same way the parser does.
+//
+class CompiledScene
+{
+public:
+	// @sceneFilePath: "Data\ScenesFiles\Objects.scn" -> "<workspace>\SceneCache\Objects.scn.vqsc"
+	//
+	static std::string GetFilePath(const std::string& sceneFilePath);
+
+	// Hash of the scene file contents, a compiled scene is only used if it was compiled from the same contents.
+	// Returns 0 if the scene file can't be read.
+	//
+	static uint64_t GetSourceKey(const std::string& sceneFilePath);
+
+	static void Serialize(const SerializedScene& scene, uint64_t sourceKey, std::vector<char>& outData);
+	static bool Write(const std::string& filePath, const SerializedScene& scene, uint64_t sourceKey);
+
+	// Returns false if the file is missing, outdated, compiled from a different @sourceKey or corrupt.
+	// @pRenderer can be null to read the scene without creating its textures.
+	//
+	static bool Read(const std::string& filePath, uint64_t sourceKey, Renderer* pRenderer, SerializedScene& outScene);
+};
@@ -0,0 +1,87 @@
+//	VQEngine | DirectX11 Renderer
+//	Copyright(C) 2018  - Volkan Ilbeyli
+//
+//	This program is free software : you can redistribute it and / or modify
+//	it under the terms of the GNU General Public License as published by
+//	the Free Software Foundation, either version 3 of the License, or
+//	(at your option) any later version.
+//
+//	This program is distributed in the hope that it will be useful,
+//	but WITHOUT ANY WARRANTY; without even the implied warranty of
+//	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+//	GNU General Public License for more details.
+//
+//	You should have received a copy of the GNU General Public License
+//	along with this program.If not, see <http://www.gnu.org/licenses/>.
+//
+//	Contact: volkanilbeyli@gmail.com
+#pragma once
+
+#include "Mesh.h"
+#include "SceneView.h"
+
+#include <vector>
+
+class GameObject;
+
+//----------------------------------------------------------------------------------------------------------------
+// CULLING & BOUNDING VOLUME KERNELS
+//----------------------------------------------------------------------------------------------------------------
+// The view frustum culling, render list sorting and bounding box routines of the Scene. They only work on
+// game objects, meshes and matrices and don't touch the Renderer, so the benchmarks can drive them headless.
+//
+
+// returns true if any part of @aabb is on the inner side of all the planes of @frustum
+//
+bool IsVisible(const FrustumPlaneset& frustum, const BoundingBox& aabb);
+
+// transforms all 8 corners of the model space @aabb_local into world space
+// and returns the axis aligned box that bounds them.
+//
+BoundingBox TransformAABB(const BoundingBox& aabb_local, const XMMATRIX& world);
+
+// @pCulledObjs is appended with the objects of @pObjs that are visible from @frustumPlanes.
+// returns the number of culled objects.
+//
+size_t CullGameObjects(
+	const FrustumPlaneset&                  frustumPlanes
+	, const std::vector<const GameObject*>& pObjs
+	, std::vector<const GameObject*>&       pCulledObjs
+);
+
+// Game objects are culled based on their bounding boxes first, meaning that we
+// cull meshes in 'gameobject-sized-batches'. For the game objects that survive,
+// the meshes are culled individually to refine the draw list of large models 
+// such as sponza, where only a portion of the model is visible at a time.
+//
+// @culledMeshIDs is filled with the visible meshes of @pObj.
+// returns the number of culled meshes.
+//
+size_t CullMeshes(
+	const FrustumPlaneset&     frustumPlanes
+	, const GameObject*        pObj
+	, const std::vector<Mesh>& meshes
+	, MeshRenderList&          culledMeshIDs
+);
+
+// Render list order: objects are sorted according to BUILT_IN_TYPE < CUSTOM, 
+// and BUILT_IN_TYPEs are sorted in themselves
+//
+bool SortByMeshType(const GameObject* pObj0, const GameObject* pObj1);
+
+// returns an inverted box (low=+max, hi=-max) that any point grows into a valid one
+//
+BoundingBox EmptyBoundingBox();
+
+// grows @worldBounds with the world space and @localBounds with the model space positions of @numVertices vertices.
+// the vertices are @stride bytes apart and their position is the first member, as in DefaultVertexBufferData
+// and CompactVertexBufferData. world space positions are clamped to filter out degenerate meshes.
+//
+void AccumulateVertexBounds(
+	const void*       pVertices
+	, size_t          numVertices
+	, size_t          stride
+	, const XMMATRIX& world
+	, BoundingBox&    worldBounds
+	, BoundingBox&    localBounds
+);
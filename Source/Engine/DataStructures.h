@@ -106,12 +106,17 @@ struct SceneLightingData
 class TextRenderer;
 struct TextDrawDescription;
 
-#define DENDER_STATS_STRUCT_ELEM_COUNT 4
+#define DENDER_STATS_STRUCT_ELEM_COUNT 9
 #define DEFINE_RENDER_STATS_STRUCT_MEMBERS\
 		int numVertices;                  \
 		int numIndices;	                  \
 		int numDrawCalls;                 \
 		int numTriangles;                 \
+		int numShaderChanges;             \
+		int numStateChanges;              \
+		int numRenderTargetChanges;       \
+		int numResourceBindings;          \
+		int numConstantBufferUpdates;     \
 
 struct RendererStats
 {
@@ -134,10 +139,23 @@ struct SceneStats
 	int numSpotsCulledObjects;
 	int numPointsCulledObjects;
 	int numDirectionalCulledObjects;
+
+	int numMainViewCulledMeshes;
+	int numSpotsCulledMeshes;
+
+	int numMainViewOccludedObjects;
+
+	int numMainViewLODMeshes;	// meshes rendered with a simplified LOD
+	int numShadowViewLODMeshes;
+};
+struct MemoryStats	// heap allocations of the frame, see MemoryTracker
+{
+	int numAllocations;
+	int numAllocatedBytes;
 };
 struct FrameStats
 {
-	static const size_t numStat = (sizeof(int) + sizeof(RendererStats) + sizeof(SceneStats)) / sizeof(int);
+	static const size_t numStat = (sizeof(int) + sizeof(RendererStats) + sizeof(SceneStats) + sizeof(MemoryStats)) / sizeof(int);
 	union 
 	{
 		struct
@@ -145,12 +163,14 @@ struct FrameStats
 			int fps;
 			DEFINE_RENDER_STATS_STRUCT_MEMBERS;
 			SceneStats scene;
+			MemoryStats memory;
 		};
 		struct
 		{
 			int fps;
 			RendererStats rstats;
 			SceneStats scene;
+			MemoryStats memory;
 		};
 		int stats[numStat];
 	};
@@ -20,6 +20,10 @@
 
 #include "Utilities/PerfTimer.h"
 #include "Utilities/Profiler.h"
+#include "Utilities/MemoryTracker.h"
+#include "Utilities/MetricsServer.h"
+
+#include "FrameRecorder.h"
 
 #include "Light.h"
 #include "Mesh.h"
@@ -84,15 +88,32 @@ public:
 	//----------------------------------------------------------------------------------------------------------------
 	// CORE INTERFACE
 	//----------------------------------------------------------------------------------------------------------------
-	bool Initialize(HWND hwnd);
+	bool Initialize(HWND hwnd, VQEngine::ThreadPool* pThreadPool, bool bHeadless = false);	// @bHeadless: render on the null device
 	void Exit();
 	
 	bool Load(VQEngine::ThreadPool* pThreadPool);
 	void SimulateAndRenderFrame();
 
+	// Waits for the scene to load, then simulates and renders @numFrames frames and logs their render stats.
+	// Replays run until the recording ends instead. The frame times and per pass CPU costs of these frames are logged on Exit().
+	void RunHeadless(int numFrames);
+
 	void SendLightData() const;
 	inline void Engine::Pause()  { mbIsPaused = true; }
+
+	// Captures the CPU profiler timeline of @numFrames frames into the ProfileCaptures folder of the workspace,
+	// starting with the next frame that isn't a loading screen frame.
+	void CaptureProfile(int numFrames);
 	inline void Engine::Unpause(){ mbIsPaused = false; }
+
+	// Publishes the frame stats and the CPU scope timings of each frame on the loopback @port, see MetricsServer.
+	bool StartMetricsServer(unsigned short port);
+
+	// Records the input and dt of the frames into @filePath, or replays a recording, see FrameRecorder.
+	// Called before Load(): the scene and the random seed of the scene loading come from the recording.
+	bool StartRecording(const std::string& filePath);
+	bool StartReplay(const std::string& filePath);
+	bool IsReplayFinished() const;
 	
 	//----------------------------------------------------------------------------------------------------------------
 	// GETTERS
@@ -126,6 +147,7 @@ private:
 	bool ReloadScene();
 
 	void CalcFrameStats(float dt);
+	void PublishFrameMetrics(float dt);
 	void HandleInput();
 
 	// prepares rendering context: gets data from scene and sets up data structures ready to be sent to GPU
@@ -154,6 +176,8 @@ private:
 	PerfTimer*						mpTimer;
 	CPUProfiler*					mpCPUProfiler;
 	GPUProfiler*					mpGPUProfiler;
+	unique_ptr<MetricsServer>		mpMetricsServer;
+	unique_ptr<FrameRecorder>		mpFrameRecorder;
 	float mCurrentFrameTime;
 public:
 	VQEngine::ThreadPool*			mpThreadPool;
@@ -198,6 +222,12 @@ private:
 	ZPrePass						mZPrePass;
 	ForwardLightingPass				mForwardLightingPass;
 
+	// post processing is recorded into the render graph every frame, its
+	// transient render targets are aliased onto the pooled ones.
+	RenderGraph						mRenderGraph;
+	TransientResourcePool			mTransientResourcePool;
+	size_t							mRenderGraphAllocatedMemory = 0;	// logs the aliasing stats when it changes
+
 	std::vector<const GameObject*>	mTBNDrawObjects;
 	
 	VQEngine::UI					mUI;
@@ -212,6 +242,10 @@ private:
 	EngineConfig		mEngineConfig;
 
 	unsigned long long	mFrameCount;
+	int					mNumProfileCaptureFrames = 0;	// pending capture request
+	TimingHistogram		mFrameTimes;					// since the app started, logged on exit
+	TimingHistogram		mRecentFrameTimes;				// window title, restarted every few seconds
+	MemoryTracker::Counters mPrevFrameAllocations = {};	// heap allocations are reported as per-frame deltas
 
 	//----------------------------------------------------------------------------------------------------------------
 	// THREADED LOADING
@@ -0,0 +1,92 @@
+//	VQEngine | DirectX11 Renderer
+//	Copyright(C) 2018  - Volkan Ilbeyli
+//
+//	This program is free software : you can redistribute it and / or modify
+//	it under the terms of the GNU General Public License as published by
+//	the Free Software Foundation, either version 3 of the License, or
+//	(at your option) any later version.
+//
+//	This program is distributed in the hope that it will be useful,
+//	but WITHOUT ANY WARRANTY; without even the implied warranty of
+//	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+//	GNU General Public License for more details.
+//
+//	You should have received a copy of the GNU General Public License
+//	along with this program.If not, see <http://www.gnu.org/licenses/>.
+//
+//	Contact: volkanilbeyli@gmail.com
+#pragma once
+
+#include "Application/Input.h"
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+//----------------------------------------------------------------------------------------------------------------
+// FRAME RECORDER
+//----------------------------------------------------------------------------------------------------------------
+// Records the input state and the dt of each simulated frame into a file (-Record), and replays them (-Replay):
+// the replayed frames read the recorded input and advance the simulation by the recorded dt instead of the
+// wall clock, so every replay of a recording moves the camera and updates the scene the same way and produces
+// the same render lists. The frame times of a replay are still measured with the real clock, which makes the
+// replays of a recording comparable A/B runs, windowed or -Headless.
+//
+// The recording also has the scene and the seed of the random number sequences the scene is loaded with.
+// Loading screen frames aren't recorded: their count depends on how long the loading takes.
+//
+class FrameRecorder
+{
+public:
+	~FrameRecorder();	// closes the recording file
+
+	bool BeginRecording(const std::string& filePath, unsigned seed, int level);
+	bool LoadReplay(const std::string& filePath);
+
+	inline bool		IsReplaying() const { return mbReplay; }
+	inline bool		IsReplayFinished() const { return mbReplay && mFrameIndex >= mReplayFrames.size(); }
+	inline size_t	GetNumReplayFrames() const { return mReplayFrames.size(); }
+	inline unsigned	GetSeed() const { return mSeed; }
+	inline int		GetLevel() const { return mLevel; }
+	inline double	GetSimulationTime() const { return mSimulationTime; }	// sum of the dt of the simulated frames
+
+	// Records the input state of the frame, or replaces it with the recorded one.
+	// Returns the dt to simulate the frame with: @dt when recording, the recorded dt when replaying.
+	//
+	float BeginFrame(Input& input, float dt);
+
+	// @stateHash: camera and culling results of the frame. Written into the recording,
+	// or compared against the recorded one to check that the replay is deterministic.
+	//
+	void EndFrame(uint64_t stateHash);
+
+private:
+	struct FrameRecord
+	{
+		float    dt;
+		uint8_t  keys[KEY_COUNT / 8];	// bit per key
+		uint8_t  prevKeys[KEY_COUNT / 8];
+		uint32_t buttons;				// bit per mouse button
+		int32_t  mouseDelta[2];
+		int16_t  mouseScroll;
+		uint8_t  bIgnoreInput;
+		uint8_t  padding;
+		uint64_t stateHash;
+	};
+	static void        Pack(const Input::State& state, float dt, FrameRecord& outRecord);
+	static Input::State Unpack(const FrameRecord& record);
+
+private:
+	std::string					mFilePath;
+	bool						mbReplay = false;
+	unsigned					mSeed = 0;
+	int							mLevel = 0;
+	double						mSimulationTime = 0.0;
+	size_t						mFrameIndex = 0;
+	FrameRecord					mCurrentFrame = {};
+
+	std::ofstream				mRecordingFile;
+	std::vector<FrameRecord>	mReplayFrames;
+	size_t						mNumStateMismatches = 0;
+};
@@ -35,13 +35,6 @@ struct GameObjectRenderSettings
 	bool bCastShadow = true;
 };
 
-struct BoundingBox
-{
-	vec3 low = vec3::Zero;
-	vec3 hi = vec3::Zero;
-	void Render(Renderer* pRenderer, const XMMATRIX& viewProj) const;
-};
-
 class GameObject
 {
 // GameObjects only contain Transform data, and the rest of 
@@ -87,11 +80,12 @@ public:
 private:
 	// friend std::shared_ptr<GameObject> Scene::CreateNewGameObject();					// #TODO: clean up: use either friend functions or ...
 	// friend std::shared_ptr<GameObject> SerializedScene::CreateNewGameObject();
-	// friend void Parser::ParseScene(Renderer*, const std::vector<std::string>&, SerializedScene&);
+	// friend void Parser::ParseScene(Renderer*, const std::vector<std::string_view>&, SerializedScene&);
 	friend class Scene;
 	friend struct SerializedScene;
 	friend class Parser;
 	friend class GameObjectPool;
+	friend class SceneBenchmark;	// sets the bounding boxes of the headless benchmark scenes
 	GameObject(Scene* pScene);
 
  private:
@@ -19,10 +19,23 @@
 
 #include "Renderer/RenderingEnums.h"
 #include "Renderer/BufferObject.h"
+#include "Renderer/RenderingStructs.h"
 
 #include "Utilities/utils.h"
+#include "Utilities/vectormath.h"
 
 #include <vector>
+#include <type_traits>
+#include <cstdint>
+
+class Renderer;
+
+struct BoundingBox
+{
+	vec3 low = vec3::Zero;
+	vec3 hi = vec3::Zero;
+	void Render(Renderer* pRenderer, const XMMATRIX& viewProj) const;
+};
 
 class Mesh
 {
@@ -31,16 +44,56 @@ class Mesh
 public:
 	template<class VertexBufferType> 
 	Mesh(const std::vector<VertexBufferType>& vertices, const std::vector<unsigned>& indices, const std::string& name);
+
+	// creates the buffers directly from the given memory, i.e. a memory mapped model cache.
+	// the index buffer is 16-bit if the mesh has few enough vertices, 32-bit otherwise.
+	template<class VertexBufferType>
+	Mesh(const VertexBufferType* pVertices, size_t numVertices, const unsigned* pIndices, size_t numIndices, const std::string& name);
+
+	// level of detail of @mesh: shares the vertex buffer of @mesh, only creates the index buffer
+	Mesh(const Mesh& mesh, const unsigned* pIndices, size_t numIndices, const std::string& name);
 	//	template<class VertexBufferType> Mesh(const std::vector<VertexBufferType>& vertices, const std::vector<unsigned>& indices, const std::vector<std::string> textureFileNames);	// TODO
 
 	inline std::pair<BufferID, BufferID> GetIABuffers() const { return std::make_pair(mVertexBufferID, mIndexBufferID); }
 
+	// model space bounding box of the mesh, used for mesh-level culling of multi-mesh models.
+	// only meshes imported through the ModelLoader have a valid AABB.
+	inline const BoundingBox& GetLocalAABB() const { return mLocalAABB; }
+	inline void SetLocalAABB(const BoundingBox& aabb) { mLocalAABB = aabb; }
+
+	// CompactVertexBufferData vertices: drawn with the COMPACT_VERTEX variant of the vertex shaders
+	inline bool HasCompactVertices() const { return mbCompactVertices; }
+	inline bool Has16BitIndices() const { return mIndexStride == sizeof(uint16_t); }
+
+	inline size_t GetVertexBufferSize() const { return mbSharedVertexBuffer ? 0 : mNumVertices * mVertexStride; }
+	inline size_t GetIndexBufferSize() const { return mNumIndices * mIndexStride; }
+	inline bool IsLOD() const { return mbSharedVertexBuffer; }
+
+	// size of the buffers with 32-bit indices and without the compact vertex layout
+	inline size_t GetUncompressedBufferSize() const
+	{
+		const size_t vertexStride = mbCompactVertices ? sizeof(DefaultVertexBufferData) : mVertexStride;
+		return (mbSharedVertexBuffer ? 0 : mNumVertices * vertexStride) + mNumIndices * sizeof(unsigned);
+	}
+
+	static constexpr size_t MAX_VERTICES_16BIT_INDICES = 0x10000;
+
 	Mesh() = default;
 private:
+	void CreateIndexBuffer(const unsigned* pIndices, size_t numIndices, size_t numVertices);
+
 	BufferID  mVertexBufferID = -1;
 	BufferID  mIndexBufferID = -1;
 
+	BoundingBox mLocalAABB;
 	std::string mMeshName;
+
+	size_t mNumVertices = 0;
+	size_t mNumIndices = 0;
+	size_t mVertexStride = 0;
+	size_t mIndexStride = 0;
+	bool   mbCompactVertices = false;
+	bool   mbSharedVertexBuffer = false;
 };
 
 
@@ -49,21 +102,29 @@ Mesh::Mesh(
 	const std::vector<VertexBufferType>& vertices,
 	const std::vector<unsigned>& indices,
 	const std::string& name
+)
+	: Mesh(vertices.data(), vertices.size(), indices.data(), indices.size(), name)
+{}
+
+template<class VertexBufferType>
+Mesh::Mesh(
+	const VertexBufferType* pVertices, size_t numVertices,
+	const unsigned* pIndices, size_t numIndices,
+	const std::string& name
 )
 {
 	BufferDesc bufferDesc = {};
 
 	bufferDesc.mType = VERTEX_BUFER;
 	bufferDesc.mUsage = GPU_READ_WRITE;
-	bufferDesc.mElementCount = static_cast<unsigned>(vertices.size());
-	bufferDesc.mStride = sizeof(vertices[0]);
-	mVertexBufferID = spRenderer->CreateBuffer(bufferDesc, vertices.data());
+	bufferDesc.mElementCount = static_cast<unsigned>(numVertices);
+	bufferDesc.mStride = sizeof(VertexBufferType);
+	mVertexBufferID = spRenderer->CreateBuffer(bufferDesc, pVertices);
 
-	bufferDesc.mType = INDEX_BUFFER;
-	bufferDesc.mUsage = GPU_READ_WRITE;
-	bufferDesc.mElementCount = static_cast<unsigned>(indices.size());
-	bufferDesc.mStride = sizeof(unsigned);
-	mIndexBufferID = spRenderer->CreateBuffer(bufferDesc, indices.data());
+	CreateIndexBuffer(pIndices, numIndices, numVertices);
 
 	mMeshName = name;
+	mNumVertices = numVertices;
+	mVertexStride = sizeof(VertexBufferType);
+	mbCompactVertices = std::is_same<VertexBufferType, CompactVertexBufferData>::value;
 }
@@ -0,0 +1,105 @@
+//	VQEngine | DirectX11 Renderer
+//	Copyright(C) 2018  - Volkan Ilbeyli
+//
+//	This program is free software : you can redistribute it and / or modify
+//	it under the terms of the GNU General Public License as published by
+//	the Free Software Foundation, either version 3 of the License, or
+//	(at your option) any later version.
+//
+//	This program is distributed in the hope that it will be useful,
+//	but WITHOUT ANY WARRANTY; without even the implied warranty of
+//	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+//	GNU General Public License for more details.
+//
+//	You should have received a copy of the GNU General Public License
+//	along with this program.If not, see <http://www.gnu.org/licenses/>.
+//
+//	Contact: volkanilbeyli@gmail.com
+#pragma once
+
+#include <vector>
+#include <cstddef>
+
+// Post-transform vertex cache statistics of an index buffer, simulated with a FIFO cache
+//
+struct VertexCacheStats
+{
+	size_t numTriangles;
+	size_t numVertices;		// referenced vertices
+	size_t numTransformed;	// cache misses: vertex shader invocations
+
+	// average cache miss ratio: vertex shader invocations per triangle, 3.0 worst, ~0.5 for large regular grids
+	inline float GetACMR() const { return numTriangles > 0 ? static_cast<float>(numTransformed) / numTriangles : 0.0f; }
+
+	// average transformed vertex ratio: vertex shader invocations per vertex, 1.0 ideal
+	inline float GetATVR() const { return numVertices > 0 ? static_cast<float>(numTransformed) / numVertices : 0.0f; }
+
+	inline VertexCacheStats& operator+=(const VertexCacheStats& other)
+	{
+		numTriangles += other.numTriangles; numVertices += other.numVertices; numTransformed += other.numTransformed;
+		return *this;
+	}
+};
+
+//----------------------------------------------------------------------------------------------------------------
+// MESH OPTIMIZER
+//----------------------------------------------------------------------------------------------------------------
+// Reorders the triangle lists of imported meshes for the GPU: triangles so that consecutive triangles
+// share vertices still in the post-transform cache, then vertices in the order the triangles use them
+// so the vertex fetch reads the vertex buffer front to back. Doesn't change the triangles or the
+// winding, only the order they're stored in. Works on mesh local indices, CPU only.
+//
+class MeshOptimizer
+{
+public:
+	// FIFO size used for the statistics: conservative, the caches of current GPUs are at least this large
+	static constexpr size_t ANALYSIS_CACHE_SIZE = 16;
+
+	static VertexCacheStats AnalyzeVertexCache(const unsigned* pIndices, size_t numIndices, size_t numVertices, size_t cacheSize = ANALYSIS_CACHE_SIZE);
+
+	// Tom Forsyth's linear-speed vertex cache optimization: greedily emits the triangle with the highest
+	// score, vertices score higher the more recently they were used and the fewer triangles they have left.
+	//
+	static void OptimizeVertexCache(unsigned* pIndices, size_t numIndices, size_t numVertices);
+
+	// Reorders the vertices in the order of first use by the index buffer and remaps the indices.
+	// Vertices no triangle uses are moved to the end of the buffer.
+	//
+	template<class TVertex>
+	static void OptimizeVertexFetch(TVertex* pVertices, size_t numVertices, unsigned* pIndices, size_t numIndices);
+
+	// Returns the new position of each vertex for OptimizeVertexFetch()
+	//
+	static std::vector<unsigned> GetVertexFetchRemap(const unsigned* pIndices, size_t numIndices, size_t numVertices);
+
+	// True if both index buffers hold the same triangles with the same winding, in any order.
+	// @pRemap maps the vertices of @pIndices to the vertices of @pOptimizedIndices, identity if null.
+	//
+	static bool IsSameTriangleList(const unsigned* pIndices, const unsigned* pOptimizedIndices, size_t numIndices, const unsigned* pRemap = nullptr);
+
+	// Quadric error metric simplification (Garland & Heckbert): collapses edges onto one of their vertices
+	// in the order of increasing error, so the result uses a subset of the vertices and only needs a new
+	// index buffer. Vertices on open borders and on attribute seams (several vertices at one position)
+	// stay in place. Stops at @targetNumIndices or before a collapse would move the surface further than
+	// @maxError, relative to the size of the mesh.
+	//
+	// @pPositions: float3 positions, @positionStride bytes apart. @pOutError: relative error of the result.
+	//
+	static std::vector<unsigned> SimplifyMesh(
+		const float* pPositions, size_t positionStride, size_t numVertices,
+		const unsigned* pIndices, size_t numIndices,
+		size_t targetNumIndices, float maxError, float* pOutError = nullptr
+	);
+};
+
+template<class TVertex>
+void MeshOptimizer::OptimizeVertexFetch(TVertex* pVertices, size_t numVertices, unsigned* pIndices, size_t numIndices)
+{
+	const std::vector<unsigned> remap = GetVertexFetchRemap(pIndices, numIndices, numVertices);
+
+	std::vector<TVertex> vertices(pVertices, pVertices + numVertices);
+	for (size_t i = 0; i < numVertices; ++i)
+		pVertices[remap[i]] = vertices[i];
+	for (size_t i = 0; i < numIndices; ++i)
+		pIndices[i] = remap[pIndices[i]];
+}
@@ -35,13 +35,16 @@ class Scene;
 
 
 using MeshToMaterialLookup = std::unordered_map<MeshID, MaterialID>;
+using MeshToLODLookup = std::unordered_map<MeshID, std::vector<MeshID>>;	// mesh -> LOD1, LOD2, ...
 
 struct ModelData
 {
 	std::vector<MeshID>		mMeshIDs;
 	std::vector<MeshID>		mTransparentMeshIDs;
-	MeshToMaterialLookup	mMaterialLookupPerMesh;
+	MeshToMaterialLookup	mMaterialLookupPerMesh;	// has the LOD meshes too
+	MeshToLODLookup			mLODLookupPerMesh;		// only the meshes that have LODs
 	inline bool HasMaterial() const { return !mMaterialLookupPerMesh.empty(); }
+	inline bool HasLODs() const { return !mLODLookupPerMesh.empty(); }
 };
 
 struct Model
@@ -53,6 +56,11 @@ struct Model
 		, const std::string&	modelName
 		, ModelData&&			modelDataIn);
 
+	// Checks that a model keeps the meshes, materials and LODs of the ModelData it's created from.
+	// Logs the members that get lost and returns false if any of them does.
+	//
+	static bool RunModelDataTests();
+
 
 	ModelData		mData;
 	
@@ -78,9 +86,20 @@ public:
 
 	void UnloadSceneModels(Scene* pScene);
 
+	// Imports the bundled models through assimp and checks the mesh optimizations on each mesh: the vertex
+	// cache and fetch optimizations keep the triangle list and don't regress the ACMR, the LODs have no
+	// degenerate or flipped triangles and stay within their error limits. CPU only.
+	//
+	static bool RunMeshOptimizationTests();
+
 
 private:
 	static const char* sRootFolderModels;
+
+	// Creates the meshes and materials of the model at @fullPath, from the model cache if it's
+	// up to date, otherwise imports the model through assimp and writes the cache.
+	//
+	bool ImportModel(const std::string& fullPath, const std::string& modelDirectory, Scene* pScene, ModelData& outData, bool& bOutLoadedFromCache);
 	
 
 	// Key -> Value := model_path -> ModelData
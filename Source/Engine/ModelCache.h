@@ -0,0 +1,155 @@
+//	VQEngine | DirectX11 Renderer
+//	Copyright(C) 2018  - Volkan Ilbeyli
+//
+//	This program is free software : you can redistribute it and / or modify
+//	it under the terms of the GNU General Public License as published by
+//	the Free Software Foundation, either version 3 of the License, or
+//	(at your option) any later version.
+//
+//	This program is distributed in the hope that it will be useful,
+//	but WITHOUT ANY WARRANTY; without even the implied warranty of
+//	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+//	GNU General Public License for more details.
+//
+//	You should have received a copy of the GNU General Public License
+//	along with this program.If not, see <http://www.gnu.org/licenses/>.
+//
+//	Contact: volkanilbeyli@gmail.com
+#pragma once
+
+#include "Renderer/RenderingStructs.h"
+#include "Utilities/MappedFile.h"
+
+#include <vector>
+#include <string>
+#include <cstdint>
+
+// Texture slots of an imported material, matching the assimp texture types we import
+//
+enum EModelTextureType : uint32_t
+{
+	MODEL_TEXTURE_DIFFUSE = 0,
+	MODEL_TEXTURE_SPECULAR,
+	MODEL_TEXTURE_NORMALS,
+	MODEL_TEXTURE_HEIGHT,
+	MODEL_TEXTURE_ALPHA,
+
+	NUM_MODEL_TEXTURE_TYPES
+};
+
+// Material values read from the model file. Only the values flagged are applied
+// on top of the material defaults, the same way the assimp import does.
+//
+struct ModelMaterialDesc
+{
+	enum EFlags : uint32_t
+	{
+		HAS_DIFFUSE   = 1 << 0,
+		HAS_SPECULAR  = 1 << 1,
+		HAS_ALPHA     = 1 << 2,
+		HAS_ROUGHNESS = 1 << 3,
+		HAS_METALNESS = 1 << 4,
+	};
+	static constexpr uint32_t NO_TEXTURE = 0xFFFFFFFF;
+
+	uint32_t flags;
+	float    diffuse[3];
+	float    specular[3];
+	float    alpha;
+	float    roughness;
+	float    metalness;
+	uint32_t textures[NUM_MODEL_TEXTURE_TYPES];	// offsets into the string table, NO_TEXTURE if not used
+};
+
+// Index range of a simplified level of detail of a mesh, indexes the vertices of the mesh
+//
+struct ModelMeshLOD
+{
+	uint32_t firstIndex;
+	uint32_t numIndices;
+};
+
+// Range of a mesh in the vertex/index blobs of the model
+//
+struct ModelMeshDesc
+{
+	static constexpr uint32_t MAX_LOD_COUNT = 4;	// including the full resolution mesh
+
+	uint32_t firstVertex;
+	uint32_t numVertices;
+	uint32_t firstIndex;
+	uint32_t numIndices;
+	uint32_t material;		// index into the material array
+	float    aabbMin[3];	// model space
+	float    aabbMax[3];
+	uint32_t numLODs;		// simplified levels of detail in lods[], coarser with each level
+	ModelMeshLOD lods[MAX_LOD_COUNT - 1];
+};
+
+// Non-owning view of the flattened model data: meshes are stored in the order
+// the node hierarchy is traversed. Points either into ImportedModelData or into
+// a memory mapped cache file.
+//
+struct ModelDataView
+{
+	const ModelMeshDesc*           pMeshes = nullptr;
+	size_t                         numMeshes = 0;
+	const ModelMaterialDesc*       pMaterials = nullptr;
+	size_t                         numMaterials = 0;
+	const DefaultVertexBufferData* pVertices = nullptr;
+	size_t                         numVertices = 0;
+	const unsigned*                pIndices = nullptr;
+	size_t                         numIndices = 0;
+	const char*                    pStringTable = nullptr;	// null terminated strings
+	size_t                         stringTableSize = 0;
+
+	inline const char* GetString(uint32_t offset) const { return offset < stringTableSize ? pStringTable + offset : nullptr; }
+};
+
+// CPU side output of the assimp import
+//
+struct ImportedModelData
+{
+	std::vector<ModelMeshDesc>           meshes;
+	std::vector<ModelMaterialDesc>       materials;
+	std::vector<DefaultVertexBufferData> vertices;
+	std::vector<unsigned>                indices;
+	std::vector<char>                    stringTable;
+
+	uint32_t      AddString(const std::string& str);
+	ModelDataView GetView() const;
+};
+
+//----------------------------------------------------------------------------------------------------------------
+// MODEL CACHE
+//----------------------------------------------------------------------------------------------------------------
+// Versioned binary dump of ImportedModelData, written after the first import of a model.
+// The file is memory mapped on load and the vertex/index blobs are handed to the renderer
+// directly from the mapping, the only work done is validating the header.
+//
+// The cache is rebuilt when the model file (or the .mtl next to it) is newer than the cache,
+// same as the shader cache, or when MODEL_CACHE_VERSION changes.
+//
+class ModelCache
+{
+public:
+	static std::string GetCacheFilePath(const std::string& modelPath);
+	static bool        IsCacheDirty(const std::string& modelPath, const std::string& cacheFilePath);
+	static bool        Write(const std::string& cacheFilePath, const ModelDataView& data);
+
+	~ModelCache();
+
+	// Maps @cacheFilePath into memory. Returns false if the file can't be mapped or is
+	// not a valid cache file of the current version.
+	//
+	bool Open(const std::string& cacheFilePath);
+	void Close();
+
+	// Valid until Close()
+	//
+	inline const ModelDataView& GetView() const { return mView; }
+
+private:
+	MappedFile    mFile;
+	ModelDataView mView;
+};
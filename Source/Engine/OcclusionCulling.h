@@ -0,0 +1,136 @@
+//	VQEngine | DirectX11 Renderer
+//	Copyright(C) 2018  - Volkan Ilbeyli
+//
+//	This program is free software : you can redistribute it and / or modify
+//	it under the terms of the GNU General Public License as published by
+//	the Free Software Foundation, either version 3 of the License, or
+//	(at your option) any later version.
+//
+//	This program is distributed in the hope that it will be useful,
+//	but WITHOUT ANY WARRANTY; without even the implied warranty of
+//	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+//	GNU General Public License for more details.
+//
+//	You should have received a copy of the GNU General Public License
+//	along with this program.If not, see <http://www.gnu.org/licenses/>.
+//
+//	Contact: volkanilbeyli@gmail.com
+#pragma once
+
+#include "Mesh.h"
+
+#include <vector>
+
+namespace VQEngine { class ThreadPool; }
+
+// CPU-side copy of an occluder's geometry in model space. Occluders are
+// rasterized every frame so we keep only the position data around.
+//
+struct OccluderMesh
+{
+	std::vector<vec3>     positions;
+	std::vector<unsigned> indices;
+	BoundingBox           localAABB;
+
+	inline size_t NumTriangles() const { return indices.size() / 3; }
+};
+
+//----------------------------------------------------------------------------------------------------------------
+// SOFTWARE OCCLUSION CULLER
+//----------------------------------------------------------------------------------------------------------------
+// Rasterizes a small set of occluder meshes into a low resolution depth buffer on the CPU
+// and tests the screen space bounds of the objects that passed frustum culling against it.
+//
+// - Depth convention follows D3D: z/w in [0, 1], 0=near, the buffer is cleared to 1=far.
+// - The depth buffer is split into tiles, each tile is rasterized by a separate
+//   ThreadPool task with SSE, 4 pixels at a time.
+// - A hierarchical depth buffer (HiZ) stores the farthest depth of each 8x8 pixel block,
+//   which lets most of the occludee tests finish without touching the full res buffer.
+// - Triangles crossing the near plane are dropped instead of clipped, which only makes
+//   the culler more conservative.
+//
+// The culler has no dependency on the Renderer and can be driven headless.
+//
+class OcclusionCuller
+{
+public:
+	static constexpr int DEPTH_BUFFER_WIDTH  = 256;
+	static constexpr int DEPTH_BUFFER_HEIGHT = 128;
+
+	static constexpr int TILE_WIDTH  = 64;	// one ThreadPool task per tile
+	static constexpr int TILE_HEIGHT = 32;
+	static constexpr int NUM_TILES_X = DEPTH_BUFFER_WIDTH  / TILE_WIDTH;
+	static constexpr int NUM_TILES_Y = DEPTH_BUFFER_HEIGHT / TILE_HEIGHT;
+
+	static constexpr int HIZ_BLOCK_SIZE = 8;
+	static constexpr int HIZ_WIDTH  = DEPTH_BUFFER_WIDTH  / HIZ_BLOCK_SIZE;
+	static constexpr int HIZ_HEIGHT = DEPTH_BUFFER_HEIGHT / HIZ_BLOCK_SIZE;
+
+	struct Stats
+	{
+		int numOccluders;
+		int numOccluderTriangles;	// triangles that made it to the rasterizer
+	};
+
+public:
+	OcclusionCuller();
+
+	// Clears the depth buffers and the occluder list for a new view
+	//
+	void BeginFrame(const XMMATRIX& viewProj);
+
+	// Queues @pMesh transformed with @world for rasterization.
+	// @pMesh must stay alive until RasterizeOccluders() returns.
+	//
+	void AddOccluder(const OccluderMesh* pMesh, const XMMATRIX& world);
+
+	// Transforms and bins the occluder triangles, then rasterizes the tiles
+	// on @pThreadPool workers. Runs serially if @pThreadPool is nullptr.
+	//
+	void RasterizeOccluders(VQEngine::ThreadPool* pThreadPool);
+
+	// Returns false if the world space @aabb is completely hidden behind the occluders.
+	// The test is conservative: anything that crosses the near plane is visible.
+	//
+	bool IsVisible(const BoundingBox& aabb_world) const;
+
+	// Headless self-check: rasterizes a test scene serially and on @pThreadPool, compares the depth buffer
+	// against a scalar reference image and the HiZ against the depth buffer, and checks the visibility
+	// of a set of boxes (behind, in front of, beside and crossing the occluders) against the expected set.
+	// Logs the failures and returns false if there are any.
+	//
+	static bool RunTests(VQEngine::ThreadPool* pThreadPool);
+
+	inline const Stats&	GetStats() const { return mStats; }
+	inline const float*	GetDepthBuffer() const { return mDepthBuffer.data(); }	// DEPTH_BUFFER_WIDTH x DEPTH_BUFFER_HEIGHT
+	inline const float*	GetHiZBuffer() const { return mHiZBuffer.data(); }		// HIZ_WIDTH x HIZ_HEIGHT
+
+private:
+	struct Occluder
+	{
+		const OccluderMesh* pMesh;
+		XMMATRIX            world;
+	};
+
+	// screen space triangle: x,y in pixels, z in NDC depth [0, 1]
+	struct ScreenTriangle
+	{
+		XMFLOAT3 v[3];
+		int minX, minY, maxX, maxY;	// inclusive pixel bounds
+	};
+
+	void TransformAndBinOccluders();
+	void RasterizeTile(int tileX, int tileY);
+
+private:
+	XMMATRIX                    mViewProj;
+	std::vector<Occluder>       mOccluders;
+
+	std::vector<ScreenTriangle> mTriangles;
+	std::vector<unsigned>       mTileBins[NUM_TILES_X * NUM_TILES_Y];	// triangle indices per tile
+
+	std::vector<float>          mDepthBuffer;
+	std::vector<float>          mHiZBuffer;
+
+	Stats                       mStats;
+};
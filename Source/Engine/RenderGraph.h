@@ -0,0 +1,224 @@
+//	VQEngine | DirectX11 Renderer
+//	Copyright(C) 2018  - Volkan Ilbeyli
+//
+//	This program is free software : you can redistribute it and / or modify
+//	it under the terms of the GNU General Public License as published by
+//	the Free Software Foundation, either version 3 of the License, or
+//	(at your option) any later version.
+//
+//	This program is distributed in the hope that it will be useful,
+//	but WITHOUT ANY WARRANTY; without even the implied warranty of
+//	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+//	GNU General Public License for more details.
+//
+//	You should have received a copy of the GNU General Public License
+//	along with this program.If not, see <http://www.gnu.org/licenses/>.
+//
+//	Contact: volkanilbeyli@gmail.com
+#pragma once
+
+#include "Application/HandleTypedefs.h"
+#include "Renderer/RenderingEnums.h"
+
+#include <vector>
+#include <string>
+#include <functional>
+
+class Renderer;
+class RenderGraph;
+
+using RGResourceID = int;	// handle to a virtual resource of a RenderGraph, only valid for the frame it's created in
+
+struct RGResourceDesc
+{
+	int          width  = 0;
+	int          height = 0;
+	EImageFormat format = IMAGE_FORMAT_UNKNOWN;
+
+	size_t GetSizeInBytes() const;
+	inline bool operator==(const RGResourceDesc& other) const { return width == other.width && height == other.height && format == other.format; }
+	inline bool operator!=(const RGResourceDesc& other) const { return !(*this == other); }
+};
+
+//----------------------------------------------------------------------------------------------------------------
+// TRANSIENT RESOURCE POOL
+//----------------------------------------------------------------------------------------------------------------
+// Owns the physical render targets the RenderGraph aliases its transient resources onto.
+// Renderer doesn't support releasing render targets, so the pool never shrinks: render
+// targets are created on demand and handed out again in the following frames.
+//
+class TransientResourcePool
+{
+public:
+	// Marks every pooled render target as available. Called once per graph execution.
+	//
+	void BeginFrame();
+
+	// Returns a render target matching @desc that hasn't been handed out since BeginFrame(),
+	// creates a new one if there's none available.
+	//
+	RenderTargetID Acquire(Renderer* pRenderer, const RGResourceDesc& desc);
+
+	inline size_t GetAllocatedMemory() const { return mAllocatedMemory; }
+	inline size_t GetNumRenderTargets() const { return mRenderTargets.size(); }
+
+private:
+	struct PooledRenderTarget
+	{
+		RGResourceDesc desc;
+		RenderTargetID renderTarget;
+		bool           bInUse;
+	};
+	std::vector<PooledRenderTarget> mRenderTargets;
+	size_t                          mAllocatedMemory = 0;
+};
+
+//----------------------------------------------------------------------------------------------------------------
+// RENDER GRAPH
+//----------------------------------------------------------------------------------------------------------------
+// Passes declare the resources they read and write instead of owning their render targets.
+// Every frame the graph is recorded, compiled and executed:
+//
+// - Record : ImportXXX() / CreateTransientRenderTarget() / AddPass() / MarkOutput()
+// - Compile: culls the passes that don't contribute to an output, validates the pass order,
+//            computes the lifetime of each transient resource and assigns the transient resources
+//            with non-overlapping lifetimes and identical descriptors to the same physical slot.
+// - Execute: acquires one pooled render target per physical slot and runs the passes in order.
+//
+// Compile() doesn't touch the Renderer, the scheduling, lifetimes and the aliasing plan
+// can be inspected without a device through GetCompiledPasses() / GetPhysicalSlot() / GetStats().
+//
+class RenderGraph
+{
+public:
+	using ExecuteCallback = std::function<void(Renderer* pRenderer, const RenderGraph& graph)>;
+
+	struct Stats
+	{
+		int    numPasses;
+		int    numCulledPasses;
+		int    numTransientResources;	// transient resources used by the passes that survived culling
+		int    numPhysicalResources;	// physical slots after aliasing
+		size_t requestedMemory;			// bytes if every declared transient resource had its own render target
+		size_t allocatedMemory;			// bytes of the physical slots
+
+		inline size_t GetMemorySaved() const { return requestedMemory - allocatedMemory; }
+	};
+
+public:
+	// Clears the recorded passes and resources for a new frame
+	//
+	void Reset();
+
+	//------------------------------------------------------------------------
+	// RECORD
+	//------------------------------------------------------------------------
+	RGResourceID ImportRenderTarget(const char* pName, RenderTargetID renderTarget);
+	RGResourceID ImportTexture(const char* pName, TextureID texture);	// i.e. compute outputs that aren't render targets
+	RGResourceID CreateTransientRenderTarget(const char* pName, const RGResourceDesc& desc);
+
+	// Passes execute in the order they're added. @bHasSideEffects keeps the pass from being culled
+	// even if none of its outputs are consumed.
+	//
+	void AddPass(const char* pName
+		, const std::vector<RGResourceID>& reads
+		, const std::vector<RGResourceID>& writes
+		, ExecuteCallback fnExecute
+		, bool bHasSideEffects = false
+	);
+
+	// Passes that (indirectly) write to the output resources are kept, the rest is culled.
+	//
+	void MarkOutput(RGResourceID resource);
+
+	//------------------------------------------------------------------------
+	// COMPILE & EXECUTE
+	//------------------------------------------------------------------------
+	// GPU-free. Returns false if the recorded graph is invalid, i.e. a pass reads
+	// a transient resource that no earlier pass writes.
+	//
+	bool Compile();
+
+	// Binds the physical slots to pooled render targets and runs the compiled passes
+	//
+	void Execute(Renderer* pRenderer, TransientResourcePool& pool);
+
+	// Checks the compiled graph: the passes run in submission order and after the passes they depend on,
+	// every resource a pass reads is visible to it (imported, or written by an earlier compiled pass),
+	// and the transient resources sharing a physical slot have disjoint lifetimes.
+	// Logs the violations and returns false if there are any.
+	//
+	bool Validate() const;
+
+	// Compiles synthetic graphs (a bloom chain with a culled branch, a side effect pass, invalid reads) and
+	// checks the schedule, the culling and the aliasing plan against the expected ones. GPU-free.
+	//
+	static bool RunCompileTests();
+
+	//------------------------------------------------------------------------
+	// QUERIES
+	//------------------------------------------------------------------------
+	// Only valid during Execute() for transient resources
+	//
+	RenderTargetID GetRenderTarget(RGResourceID resource) const;
+	TextureID      GetTexture(const Renderer* pRenderer, RGResourceID resource) const;
+
+	inline const std::vector<int>& GetCompiledPasses() const { return mCompiledPasses; }	// indices of the passes in execution order
+	inline const std::string&      GetPassName(int pass) const { return mPasses[pass].name; }
+	inline int                     GetPhysicalSlot(RGResourceID resource) const { return mResources[resource].physicalSlot; }	// -1 if not allocated
+	inline const Stats&            GetStats() const { return mStats; }
+
+private:
+	enum EResourceType
+	{
+		TRANSIENT_RENDER_TARGET = 0,
+		IMPORTED_RENDER_TARGET,
+		IMPORTED_TEXTURE,
+	};
+	struct Resource
+	{
+		std::string    name;
+		EResourceType  type;
+		RGResourceDesc desc;
+		int            externalHandle;	// RenderTargetID or TextureID of the imported resources
+		bool           bOutput;
+
+		// compile results
+		int            firstUse;		// index into mCompiledPasses
+		int            lastUse;
+		int            physicalSlot;
+	};
+	struct Pass
+	{
+		std::string               name;
+		std::vector<RGResourceID> reads;
+		std::vector<RGResourceID> writes;
+		ExecuteCallback           fnExecute;
+		bool                      bHasSideEffects;
+
+		// compile results
+		std::vector<int>          dependencies;	// passes that produce the data this pass consumes
+		bool                      bCulled;
+	};
+	struct PhysicalSlot
+	{
+		RGResourceDesc desc;
+		int            lastUse;
+		RenderTargetID renderTarget;	// assigned on Execute()
+	};
+
+	RGResourceID AddResource(const char* pName, EResourceType type, const RGResourceDesc& desc, int externalHandle);
+
+	bool BuildDependencies();
+	void CullPasses();
+	void ComputeLifetimes();
+	void AssignPhysicalSlots();
+
+private:
+	std::vector<Resource>     mResources;
+	std::vector<Pass>         mPasses;
+	std::vector<int>          mCompiledPasses;
+	std::vector<PhysicalSlot> mPhysicalSlots;
+	Stats                     mStats = {};
+	bool                      mbCompiled = false;
+};
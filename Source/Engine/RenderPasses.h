@@ -22,6 +22,7 @@
 
 #include "Engine/Settings.h"
 #include "Skybox.h"
+#include "RenderGraph.h"
 
 #include "Renderer/RenderingEnums.h"
 
@@ -111,10 +112,14 @@ struct BloomPass : public RenderPass
 		, _blurSampler(-1)
 		, _colorRT(-1)
 		, _brightRT(-1)
+		, _finalRT(-1)
 		, _blurPingPong({ -1, -1 }
 		) {}
 
 	SamplerID						_blurSampler;
+	RGResourceDesc					_rtDesc;
+
+	// transient render targets, assigned by the render graph when the bloom passes execute
 	RenderTargetID					_colorRT;
 	RenderTargetID					_brightRT;
 	RenderTargetID					_finalRT;
@@ -134,10 +139,18 @@ struct BloomPass : public RenderPass
 
 
 	void Initialize(Renderer* pRenderer, const Settings::Bloom& bloomSettings, const RenderTargetDesc& rtDesc);
-	void Render(Renderer* pRenderer, RenderTargetID rtDestination, const Settings::Bloom& settings) const;
 	void UpdateSettings(Renderer* pRenderer, const Settings::Bloom& bloomSettings);
 
+	// Adds the bright filter, blur and combine passes reading @worldRT. @outBloomRT is the combined result.
+	//
+	void AddRenderGraphPasses(Renderer* pRenderer, RenderGraph& graph, RGResourceID worldRT, const Settings::Bloom& settings, RGResourceID& outBloomRT);
+
 	TextureID GetBloomTexture(const Renderer* pRenderer) const;
+
+private:
+	void RenderBrightFilter(Renderer* pRenderer, TextureID worldTexture, const Settings::Bloom& settings) const;
+	void RenderBlur(Renderer* pRenderer, const Settings::Bloom& settings) const;
+	void RenderCombine(Renderer* pRenderer) const;
 };
 
 struct TonemappingCombinePass : public RenderPass
@@ -156,7 +169,11 @@ struct PostProcessPass : public RenderPass
 	{}
 	void UpdateSettings(const Settings::PostProcess& newSettings, Renderer* pRenderer);
 	void Initialize(Renderer* pRenderer, const Settings::PostProcess& postProcessSettings);
-	void Render(Renderer* pRenderer, bool bBloomOn, TextureID texOverride = -1) const;
+
+	// Adds the bloom and tonemapping passes, the tonemapping pass writes to the back buffer
+	// which is marked as the output of the graph.
+	//
+	void AddRenderGraphPasses(Renderer* pRenderer, RenderGraph& graph, bool bBloomOn, TextureID texOverride = -1);
 
 	RenderTargetID			_worldRenderTarget;
 	BloomPass				_bloomPass;
@@ -222,6 +239,7 @@ struct DeferredRenderingPasses : public RenderPass
 	DepthStencilStateID _geometryStencilState;
 	ShaderID			_geometryShader;
 	ShaderID			_geometryInstancedShader;
+	ShaderID			_geometryCompactVertexShader;	// meshes with CompactVertexBufferData
 	ShaderID			_ambientShader;
 	ShaderID			_ambientIBLShader;
 	//ShaderID			_environmentMapSpecularShader;
@@ -253,6 +271,7 @@ struct ForwardLightingPass : public RenderPass
 	ShaderID fwdPhong;
 	ShaderID fwdBRDF;
 	ShaderID fwdBRDFInstanced;
+	ShaderID fwdBRDFCompactVertex;	// meshes with CompactVertexBufferData
 };
 
 struct DebugPass : public RenderPass
@@ -399,4 +418,5 @@ struct ZPrePass : public RenderPass
 	SamplerID normalMapSampler;
 	ShaderID objShader;
 	ShaderID objShaderInstanced;
+	ShaderID objShaderCompactVertex;	// meshes with CompactVertexBufferData
 };
\ No newline at end of file
@@ -26,6 +26,7 @@
 
 #include "Camera.h"
 #include "SceneView.h"
+#include "OcclusionCulling.h"
 
 #include <memory>
 #include <mutex>
@@ -206,10 +207,27 @@ private:
 	SceneView	mSceneView;
 	ShadowView	mShadowView;
 
+	// software occlusion culling: occluder geometry is copied to the CPU once at load time
+	OcclusionCuller									mOcclusionCuller;
+	std::unordered_map<MeshID, OccluderMesh>		mOccluderMeshes;
+	std::vector<std::pair<const GameObject*, MeshID>>	mOccluders;
+
 private:
 	void StartLoadingModels();
 	void EndLoadingModels();
 	void CalculateSceneBoundingBox();
+
+	// picks the large, low poly opaque meshes of the scene as occluders.
+	// needs to happen after the bounding boxes are calculated.
+	void SelectOccluders();
+
+	// logs the vertex/index buffer memory of the scene's meshes and how much of it the
+	// 16-bit indices and the compact vertex layout save.
+	void LogMeshMemory() const;
+
+	// rasterizes the occluders from the main view and removes the objects
+	// hidden behind them from @renderList. returns the number of culled objects.
+	size_t CullOccludedGameObjects(RenderList& renderList);
 };
 
 
@@ -218,14 +236,26 @@ private:
 
 
 
+// Texture files a material of the scene file refers to. The materials only hold the TextureIDs,
+// the file names are kept for writing the scene out (see CompiledScene).
+//
+struct SerializedMaterialTextures
+{
+	MaterialID	material;
+	std::string	diffuseMap;
+	std::string	normalMap;
+};
+
 struct SerializedScene
 {
 	GameObject*		CreateNewGameObject();
+	SerializedMaterialTextures& GetMaterialTextures(MaterialID material);
 
 	std::vector<Settings::Camera>	cameras;
 	std::vector<Light>				lights;
 	DirectionalLight				directionalLight;
 	MaterialPool					materials;
+	std::vector<SerializedMaterialTextures> materialTextures;
 	std::vector<GameObject>			objects;
 	Settings::SceneRender			settings;
 	char loadSuccess = '0';
@@ -31,6 +31,7 @@ class SceneResourceView
 {
 private:
 	static std::pair<BufferID, BufferID> GetVertexAndIndexBuffersOfMesh(const Scene* pScene, MeshID meshID);
+	static bool HasCompactVertices(const Scene* pScene, MeshID meshID);	// drawn with the COMPACT_VERTEX shaders
 	static const Material* GetMaterial(const Scene* pScene, MaterialID materialID);
 
 	friend class GameObject;
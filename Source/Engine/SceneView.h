@@ -36,6 +36,12 @@ using LightInstancedRenderListLookup = std::unordered_map<const Light*, RenderLi
 
 using RenderListLookupEntry = std::pair<MeshID, RenderList>;
 
+// culled mesh lists per game object: only the game objects that went through
+// mesh-level culling or LOD selection have an entry, the rest render all the meshes of their model.
+using MeshRenderList = std::vector<MeshID>;
+using MeshRenderListLookup = std::unordered_map<const GameObject*, MeshRenderList>;
+using LightMeshRenderListLookup = std::unordered_map<const Light*, MeshRenderListLookup>;
+
 struct ShadowView
 {
 
@@ -51,6 +57,13 @@ struct ShadowView
 	// culled render lists per shadowing light
 	LightRenderListLookup shadowMapRenderListLookUp;
 	LightInstancedRenderListLookup shadowMapInstancedRenderListLookUp;
+	LightMeshRenderListLookup shadowMapMeshRenderListLookUp;
+	MeshRenderListLookup directionalMeshRenderListLookUp;	// LODs of the casters
+
+	// returns the meshes of @pObj to render into @pLight's shadow map
+	//
+	const MeshRenderList& GetMeshRenderList(const Light* pLight, const GameObject* pObj) const;
+	const MeshRenderList& GetDirectionalMeshRenderList(const GameObject* pObj) const;
 
 	void Clear()
 	{
@@ -83,5 +96,10 @@ struct SceneView
 	// list of objects that fall within the main camera's view frustum
 	RenderList culledOpaqueList;
 	RenderListLookup culluedOpaqueInstancedRenderListLookup;
+	MeshRenderListLookup culledOpaqueMeshRenderListLookup;
 
+	// returns the meshes of @pObj that survived mesh-level culling, with the LODs selected
+	// for the view, or all of its meshes if the object wasn't culled at mesh level.
+	//
+	const MeshRenderList& GetMeshRenderList(const GameObject* pObj) const;
 };
\ No newline at end of file
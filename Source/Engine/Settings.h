@@ -67,6 +67,7 @@ namespace Settings
 		bool		bAmbientOcclusion;
 		bool		bEnableEnvironmentLighting;
 		bool		bPreLoadEnvironmentMaps;
+		bool		bCompactVertices = false;	// quantized vertex layout (CompactVertexBufferData) for the imported meshes
 	};
 
 
@@ -106,9 +107,9 @@ namespace Settings
 		int levelToLoad;
 		std::vector<std::string> sceneNames;
 
-		// caching is slower... keeping this false.
-		// it can be useful: environment map textures can be dumped on disk.
-		bool bCacheEnvironmentMapsOnDisk = false;
+		// pre-filtered environment maps and the BRDF LUT are cached as raw mip chains
+		// (RawTextureFile) and uploaded from the mapped file, skipping the convolution.
+		bool bCacheEnvironmentMapsOnDisk = true;
 	};
 
 
@@ -119,6 +120,9 @@ namespace Settings
 	{
 		bool bViewFrustumCull_MainView = true;
 		bool bViewFrustumCull_LocalLights = true;
+		bool bViewFrustumCull_Meshes = true;	// cull the meshes of multi-mesh models individually
+		bool bOcclusionCull_MainView = true;	// CPU software occlusion culling against the occluders of the scene
+		bool bMeshLODs = true;	// render the simplified LODs of the imported meshes based on their size on screen
 		bool bShadowViewCull = false;	// not implemented yet
 		bool bSortRenderLists = true;
 	};
@@ -83,6 +83,15 @@ public:
 	static TextureID		sBRDFIntegrationLUTTexture;
 	static Texture CreateBRDFIntegralLUTTexture();
 
+	// loads the LUT from the texture cache if it's enabled, renders (and caches) it otherwise
+	static TextureID LoadOrCreateBRDFIntegralLUT();
+
+	// CPU reference of IntegrateBRDF() in BRDF.hlsl for validating the LUT: F0 scale & bias for the given input
+	static void IntegrateBRDF_CPU(float NdotV, float roughness, int sampleCount, float& outF0Scale, float& outF0Bias);
+
+	// compares @gridSize x @gridSize texels of the LUT against the CPU reference, returns the max absolute error
+	static float ValidateBRDFIntegralLUT(TextureID lut, int gridSize);
+
 	// renders pre-filtered environment map texture into mip levels 
 	// with the convolution being based on the roughness
 	static ShaderID	sPrefilterShader;
@@ -95,7 +104,7 @@ public:
 	// MEMBER INTERFACE
 	//--------------------------------------------------------
 	EnvironmentMap();
-	TextureID InitializePrefilteredEnvironmentMap(const Texture& specularMap, const Texture& irradienceMap, const std::string& cacheFolderPath);
+	TextureID InitializePrefilteredEnvironmentMap(const Texture& specularMap, const Texture& irradienceMap);
 	void Initialize(Renderer* pRenderer, const EnvironmentMapFileNames& files, const std::string& rootDirectory);
 
 	//--------------------------------------------------------
@@ -17,6 +17,7 @@
 //	Contact: volkanilbeyli@gmail.com
 
 #include "RenderPasses.h"
+#include "RenderGraph.h"
 #include "SceneResources.h"
 #include "Engine.h"
 #include "GameObject.h"
@@ -43,11 +44,10 @@ constexpr bool USE_CONSTANT_BUFFER_FOR_BLUR_STRENGTH = false;
 
 void BloomPass::Initialize(Renderer* pRenderer, const Settings::Bloom& bloomSettings, const RenderTargetDesc& rtDesc)
 {
-	this->_colorRT = pRenderer->AddRenderTarget(rtDesc);
-	this->_brightRT = pRenderer->AddRenderTarget(rtDesc);
-	this->_finalRT = pRenderer->AddRenderTarget(rtDesc);
-	this->_blurPingPong[0] = pRenderer->AddRenderTarget(rtDesc);
-	this->_blurPingPong[1] = pRenderer->AddRenderTarget(rtDesc);
+	// render targets are transient, allocated by the render graph every frame. see AddRenderGraphPasses().
+	this->_rtDesc.width  = rtDesc.textureDesc.width;
+	this->_rtDesc.height = rtDesc.textureDesc.height;
+	this->_rtDesc.format = rtDesc.format;
 
 	const int BLUR_KERNEL_DIMENSION = 15;	// should be odd
 	const char* pFSQ_VS = "FullScreenquad_vs.hlsl";
@@ -216,15 +216,66 @@ void BloomPass::UpdateSettings(Renderer* pRenderer, const Settings::Bloom& bloom
 
 
 
-struct BlurParameters { unsigned blurStrength; };
-void BloomPass::Render(Renderer* pRenderer, RenderTargetID _worldRenderTarget, const Settings::Bloom& settings) const
+void BloomPass::AddRenderGraphPasses(Renderer* pRenderer, RenderGraph& graph, RGResourceID worldRT, const Settings::Bloom& settings, RGResourceID& outBloomRT)
+{
+	const bool bPixelShaderBlur = mSelectedBloomShader == BloomPass::PS_1D_Kernels;
+
+	const RGResourceID colorRT  = graph.CreateTransientRenderTarget("Bloom Color", _rtDesc);
+	const RGResourceID brightRT = graph.CreateTransientRenderTarget("Bloom Bright", _rtDesc);
+	const RGResourceID finalRT  = graph.CreateTransientRenderTarget("Bloom Final", _rtDesc);
+
+	// the compute blur writes to its own RW textures, the pixel shader blur ping-pongs between two render targets
+	std::array<RGResourceID, 2> blurPingPong = { -1, -1 };
+	RGResourceID blurOutput = -1;
+	if (bPixelShaderBlur)
+	{
+		blurPingPong[0] = graph.CreateTransientRenderTarget("Bloom Blur Ping", _rtDesc);
+		blurPingPong[1] = graph.CreateTransientRenderTarget("Bloom Blur Pong", _rtDesc);
+		blurOutput = blurPingPong[0];
+	}
+	else
+	{
+		blurOutput = graph.ImportTexture("Bloom Blur<CS>", GetBloomTexture(pRenderer));
+	}
+
+	// the "Bloom" event spans all three passes: they're either all culled or all executed
+	// as the combine pass consumes the outputs of the other two.
+	graph.AddPass("Bloom Filter", { worldRT }, { colorRT, brightRT }, [=](Renderer* pRenderer, const RenderGraph& graph)
+	{
+		_colorRT = graph.GetRenderTarget(colorRT);
+		_brightRT = graph.GetRenderTarget(brightRT);
+		pRenderer->BeginEvent("Bloom");
+		RenderBrightFilter(pRenderer, graph.GetTexture(pRenderer, worldRT), settings);
+	});
+
+	const std::vector<RGResourceID> blurWrites = bPixelShaderBlur
+		? std::vector<RGResourceID>{ blurPingPong[0], blurPingPong[1] }
+		: std::vector<RGResourceID>{ blurOutput };
+	graph.AddPass("Bloom Blur", { brightRT }, blurWrites, [=](Renderer* pRenderer, const RenderGraph& graph)
+	{
+		if (bPixelShaderBlur)
+		{
+			_blurPingPong[0] = graph.GetRenderTarget(blurPingPong[0]);
+			_blurPingPong[1] = graph.GetRenderTarget(blurPingPong[1]);
+		}
+		RenderBlur(pRenderer, settings);
+	});
+
+	graph.AddPass("Bloom Combine", { colorRT, blurOutput }, { finalRT }, [=](Renderer* pRenderer, const RenderGraph& graph)
+	{
+		_finalRT = graph.GetRenderTarget(finalRT);
+		RenderCombine(pRenderer);
+		pRenderer->EndEvent(); // bloom
+	});
+
+	outBloomRT = finalRT;
+}
+
+
+void BloomPass::RenderBrightFilter(Renderer* pRenderer, TextureID worldTexture, const Settings::Bloom& settings) const
 {
-	const TextureID worldTexture = pRenderer->GetRenderTargetTexture(_worldRenderTarget);
 	const auto IABuffersQuad = ENGINE->GetGeometryVertexAndIndexBuffers(EGeometry::FULLSCREENQUAD);
-	const ShaderID currentShader = pRenderer->GetActiveShader();
 
-	//pCPU->BeginEntry("Bloom");
-	pRenderer->BeginEvent("Bloom");
 	pGPU->BeginEntry("Bloom Filter");
 
 	// bright filter
@@ -242,8 +293,12 @@ void BloomPass::Render(Renderer* pRenderer, RenderTargetID _worldRenderTarget, c
 	pRenderer->EndEvent();
 
 	pGPU->EndEntry();
+}
+
 
-	// blur
+struct BlurParameters { unsigned blurStrength; };
+void BloomPass::RenderBlur(Renderer* pRenderer, const Settings::Bloom& settings) const
+{
 	const TextureID brightTexture = pRenderer->GetRenderTargetTexture(_brightRT);
 	const int BlurPassCount = settings.blurStrength * 2;	// 1 pass for Horizontal and Vertical each
 
@@ -364,8 +419,11 @@ void BloomPass::Render(Renderer* pRenderer, RenderTargetID _worldRenderTarget, c
 		Log::Warning("Unsupported Bloom Shader = %d", mSelectedBloomShader);
 		break;
 	}
+}
 
 
+void BloomPass::RenderCombine(Renderer* pRenderer) const
+{
 	// additive blend combine
 	const TextureID colorTex = pRenderer->GetRenderTargetTexture(_colorRT);
 	const TextureID bloomTex = GetBloomTexture(pRenderer);
@@ -380,10 +438,7 @@ void BloomPass::Render(Renderer* pRenderer, RenderTargetID _worldRenderTarget, c
 	pRenderer->Apply();
 	pRenderer->DrawIndexed();
 	pRenderer->EndEvent();
-
-	//pCPU->EndEntry(); // bloom
-	pRenderer->EndEvent(); // bloom
-	pGPU->EndEntry(); // bloom
+	pGPU->EndEntry();
 }
 
 
@@ -392,7 +447,7 @@ TextureID BloomPass::GetBloomTexture(const Renderer* pRenderer) const
 {
 	switch (mSelectedBloomShader)
 	{
-	case BloomPass::PS_1D_Kernels: return pRenderer->GetRenderTargetTexture(_blurPingPong[0]);
+	case BloomPass::PS_1D_Kernels: return _blurPingPong[0] == -1 ? -1 : pRenderer->GetRenderTargetTexture(_blurPingPong[0]);
 	case BloomPass::CS_1D_Kernels: return blurComputeOutputPingPong[1];
 	case BloomPass::CS_1D_Kernels_Transpoze_Out: return blurComputeOutputPingPong[0];
 	case BloomPass::NUM_BLOOM_SHADERS:
@@ -0,0 +1,522 @@
+//	VQEngine | DirectX11 Renderer
+//	Copyright(C) 2018  - Volkan Ilbeyli
+//
+//	This program is free software : you can redistribute it and / or modify
+//	it under the terms of the GNU General Public License as published by
+//	the Free Software Foundation, either version 3 of the License, or
+//	(at your option) any later version.
+//
+//	This program is distributed in the hope that it will be useful,
+//	but WITHOUT ANY WARRANTY; without even the implied warranty of
+//	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+//	GNU General Public License for more details.
+//
+//	You should have received a copy of the GNU General Public License
+//	along with this program.If not, see <http://www.gnu.org/licenses/>.
+//
+//	Contact: volkanilbeyli@gmail.com
+
+#include "CompiledScene.h"
+#include "Scene.h"
+
+#include "Application/Application.h"
+#include "Renderer/Renderer.h"
+
+#include "Utilities/Log.h"
+#include "Utilities/utils.h"
+
+#include <fstream>
+#include <algorithm>
+#include <unordered_map>
+#include <cstring>
+
+// bump the version whenever the layout below or the way the parser builds a SerializedScene changes
+static constexpr uint32_t COMPILED_SCENE_MAGIC   = 0x43535156;	// 'VQSC'
+static constexpr uint32_t COMPILED_SCENE_VERSION = 1;
+static constexpr size_t   BLOB_ALIGNMENT         = 16;
+static constexpr size_t   MATERIAL_POOL_SIZE     = 4096;		// same as Parser::ReadSceneFile()
+static constexpr uint32_t NO_STRING              = 0xFFFFFFFF;
+static constexpr uint32_t NO_MATERIAL            = 0xFFFFFFFF;
+
+// File layout: header followed by the blobs, each starting at a BLOB_ALIGNMENT boundary:
+//
+//   CompiledSceneHeader | Settings::SceneRender | CompiledDirectionalLight | Settings::Camera[] | CompiledLight[]
+//   | CompiledMaterial[] | CompiledObject[] | CompiledMesh[] | char[]
+//
+struct CompiledSceneHeader
+{
+	uint32_t magic;
+	uint32_t version;
+	uint64_t sourceKey;
+	uint32_t sceneSettingsSize;		// plain structs are stored as they are, reject files written with a different layout
+	uint32_t cameraSize;
+	uint32_t numCameras;
+	uint32_t numLights;
+	uint32_t numMaterials;
+	uint32_t numObjects;
+	uint32_t numMeshes;
+	uint32_t stringTableSize;
+};
+
+struct CompiledTransform
+{
+	float position[3];
+	float rotation[4];	// quaternion: V.xyz, S
+	float scale[3];
+};
+
+struct CompiledDirectionalLight
+{
+	float   color[3];
+	float   brightness;
+	float   direction[3];
+	int32_t enabled;
+	float   shadowMapDistance;
+	float   depthBias;
+	float   shadowMapAndViewportSize[2];
+};
+
+struct CompiledLight
+{
+	uint32_t type;
+	float    color[3];
+	float    range;
+	float    brightness;
+	uint32_t castsShadow;
+	float    depthBias;
+	float    farPlaneDistance;
+	float    lightData[2];	// attenuation or spot angle
+	int32_t  renderMesh;
+	CompiledTransform transform;
+};
+
+struct CompiledMaterial
+{
+	uint32_t type;
+	float    diffuse[3];
+	float    alpha;
+	float    specular[3];
+	float    tiling[2];
+	float    metalness;		// BRDF
+	float    roughness;		// BRDF
+	float    shininess;		// Blinn-Phong
+	uint32_t diffuseMap;	// offsets into the string table, NO_STRING if not used
+	uint32_t normalMap;
+};
+
+struct CompiledObject
+{
+	CompiledTransform transform;
+	uint32_t firstMesh;
+	uint32_t numMeshes;
+	uint32_t modelName;		// offset into the string table, NO_STRING if the object has no model
+};
+
+struct CompiledMesh
+{
+	int32_t  meshID;
+	uint32_t material;		// index into the material array, NO_MATERIAL if not set
+};
+
+static inline size_t AlignBlob(size_t offset) { return (offset + BLOB_ALIGNMENT - 1) & ~(BLOB_ALIGNMENT - 1); }
+
+struct BlobOffsets
+{
+	size_t settings, directionalLight, cameras, lights, materials, objects, meshes, stringTable, end;
+};
+
+static BlobOffsets GetBlobOffsets(const CompiledSceneHeader& header)
+{
+	BlobOffsets o;
+	o.settings         = AlignBlob(sizeof(CompiledSceneHeader));
+	o.directionalLight = AlignBlob(o.settings         + sizeof(Settings::SceneRender));
+	o.cameras          = AlignBlob(o.directionalLight + sizeof(CompiledDirectionalLight));
+	o.lights           = AlignBlob(o.cameras   + header.numCameras   * sizeof(Settings::Camera));
+	o.materials        = AlignBlob(o.lights    + header.numLights    * sizeof(CompiledLight));
+	o.objects          = AlignBlob(o.materials + header.numMaterials * sizeof(CompiledMaterial));
+	o.meshes           = AlignBlob(o.objects   + header.numObjects   * sizeof(CompiledObject));
+	o.stringTable      = AlignBlob(o.meshes    + header.numMeshes    * sizeof(CompiledMesh));
+	o.end              = o.stringTable + header.stringTableSize;
+	return o;
+}
+
+static inline void StoreVec3(const vec3& v, float* pOut) { pOut[0] = v.x(); pOut[1] = v.y(); pOut[2] = v.z(); }
+static inline vec3 LoadVec3(const float* p) { return vec3(p[0], p[1], p[2]); }
+
+static CompiledTransform StoreTransform(const Transform& tf)
+{
+	CompiledTransform c;
+	StoreVec3(tf._position, c.position);
+	StoreVec3(tf._rotation.V, c.rotation);
+	c.rotation[3] = tf._rotation.S;
+	StoreVec3(tf._scale, c.scale);
+	return c;
+}
+
+static Transform LoadTransform(const CompiledTransform& c)
+{
+	Quaternion rotation = Quaternion::Identity();
+	rotation.V = LoadVec3(c.rotation);
+	rotation.S = c.rotation[3];
+	return Transform(LoadVec3(c.position), rotation, LoadVec3(c.scale));
+}
+
+static bool ReadWholeFile(const std::string& filePath, std::vector<char>& outData)
+{
+	std::ifstream file(filePath, std::ios::binary | std::ios::ate);
+	if (!file.is_open())
+		return false;
+
+	const std::streamsize size = file.tellg();
+	file.seekg(0, std::ios::beg);
+	outData.resize(static_cast<size_t>(size));
+	return size == 0 || static_cast<bool>(file.read(outData.data(), size));
+}
+
+
+std::string CompiledScene::GetFilePath(const std::string& sceneFilePath)
+{
+	// flatten the path into a file name, same as the model cache: Data\ScenesFiles\Objects.scn -> Data_ScenesFiles_Objects.scn.vqsc
+	std::string fileName = sceneFilePath;
+	std::replace_if(fileName.begin(), fileName.end(), [](char c) { return c == '/' || c == '\\' || c == ':'; }, '_');
+	return Application::s_WorkspaceDirectory + "\\SceneCache\\" + fileName + ".vqsc";
+}
+
+uint64_t CompiledScene::GetSourceKey(const std::string& sceneFilePath)
+{
+	std::vector<char> source;
+	if (!ReadWholeFile(sceneFilePath, source))
+		return 0;
+	return HashValue(COMPILED_SCENE_VERSION, HashBytes(source.data(), source.size()));
+}
+
+void CompiledScene::Serialize(const SerializedScene& scene, uint64_t sourceKey, std::vector<char>& outData)
+{
+	std::vector<CompiledLight>    lights;
+	std::vector<CompiledMaterial> materials;
+	std::vector<CompiledObject>   objects;
+	std::vector<CompiledMesh>     meshes;
+	std::vector<char>             stringTable;
+
+	auto fnAddString = [&stringTable](const std::string& str) -> uint32_t
+	{
+		if (str.empty())
+			return NO_STRING;
+		const uint32_t offset = static_cast<uint32_t>(stringTable.size());
+		stringTable.insert(stringTable.end(), str.begin(), str.end());
+		stringTable.push_back('\0');
+		return offset;
+	};
+
+	// LIGHTS
+	//
+	lights.reserve(scene.lights.size());
+	for (const Light& l : scene.lights)
+	{
+		CompiledLight c = {};
+		c.type             = static_cast<uint32_t>(l.type);
+		StoreVec3(l.color.Value(), c.color);
+		c.range            = l.range;
+		c.brightness       = l.brightness;
+		c.castsShadow      = l.castsShadow ? 1 : 0;
+		c.depthBias        = l.depthBias;
+		c.farPlaneDistance = l.farPlaneDistance;
+		c.lightData[0]     = l.spotAngle.x();
+		c.lightData[1]     = l.spotAngle.y();
+		c.renderMesh       = static_cast<int32_t>(l.renderMesh);
+		c.transform        = StoreTransform(l.transform);
+		lights.push_back(c);
+	}
+
+	// MATERIALS
+	//
+	// materials are stored in the order the objects refer to them, which is the order the parser created them in
+	std::unordered_map<int, const SerializedMaterialTextures*> textureLookup;
+	for (const SerializedMaterialTextures& textures : scene.materialTextures)
+		textureLookup[textures.material.ID] = &textures;
+
+	std::unordered_map<int, uint32_t> materialIndices;
+	auto fnGetMaterialIndex = [&](MaterialID materialID) -> uint32_t
+	{
+		const auto it = materialIndices.find(materialID.ID);
+		if (it != materialIndices.end())
+			return it->second;
+
+		const Material* pMaterial = scene.materials.GetMaterial_const(materialID);
+		CompiledMaterial c = {};
+		c.type = static_cast<uint32_t>(materialID.GetType());
+		StoreVec3(pMaterial->diffuse.Value(), c.diffuse);
+		c.alpha = pMaterial->alpha;
+		StoreVec3(pMaterial->specular, c.specular);
+		c.tiling[0] = pMaterial->tiling.x();
+		c.tiling[1] = pMaterial->tiling.y();
+		if (c.type == GGX_BRDF)
+		{
+			c.metalness = static_cast<const BRDF_Material*>(pMaterial)->metalness;
+			c.roughness = static_cast<const BRDF_Material*>(pMaterial)->roughness;
+		}
+		else
+		{
+			c.shininess = static_cast<const BlinnPhong_Material*>(pMaterial)->shininess;
+		}
+
+		const auto itTextures = textureLookup.find(materialID.ID);
+		c.diffuseMap = itTextures != textureLookup.end() ? fnAddString(itTextures->second->diffuseMap) : NO_STRING;
+		c.normalMap  = itTextures != textureLookup.end() ? fnAddString(itTextures->second->normalMap)  : NO_STRING;
+
+		const uint32_t index = static_cast<uint32_t>(materials.size());
+		materials.push_back(c);
+		materialIndices[materialID.ID] = index;
+		return index;
+	};
+
+	// OBJECTS
+	//
+	objects.reserve(scene.objects.size());
+	for (const GameObject& obj : scene.objects)
+	{
+		const ModelData& modelData = obj.GetModelData();
+
+		CompiledObject c = {};
+		c.transform = StoreTransform(obj.GetTransform());
+		c.firstMesh = static_cast<uint32_t>(meshes.size());
+		c.numMeshes = static_cast<uint32_t>(modelData.mMeshIDs.size());
+		c.modelName = fnAddString(obj.GetModelName());
+		for (MeshID meshID : modelData.mMeshIDs)
+		{
+			const auto itMaterial = modelData.mMaterialLookupPerMesh.find(meshID);
+			meshes.push_back({ meshID, itMaterial != modelData.mMaterialLookupPerMesh.end() ? fnGetMaterialIndex(itMaterial->second) : NO_MATERIAL });
+		}
+		objects.push_back(c);
+	}
+
+	// HEADER
+	//
+	CompiledSceneHeader header = {};
+	header.magic             = COMPILED_SCENE_MAGIC;
+	header.version           = COMPILED_SCENE_VERSION;
+	header.sourceKey         = sourceKey;
+	header.sceneSettingsSize = sizeof(Settings::SceneRender);
+	header.cameraSize        = sizeof(Settings::Camera);
+	header.numCameras        = static_cast<uint32_t>(scene.cameras.size());
+	header.numLights         = static_cast<uint32_t>(lights.size());
+	header.numMaterials      = static_cast<uint32_t>(materials.size());
+	header.numObjects        = static_cast<uint32_t>(objects.size());
+	header.numMeshes         = static_cast<uint32_t>(meshes.size());
+	header.stringTableSize   = static_cast<uint32_t>(stringTable.size());
+	const BlobOffsets offsets = GetBlobOffsets(header);
+
+	const DirectionalLight& dl = scene.directionalLight;
+	CompiledDirectionalLight directionalLight = {};
+	StoreVec3(dl.color.Value(), directionalLight.color);
+	directionalLight.brightness = dl.brightness;
+	StoreVec3(dl.direction, directionalLight.direction);
+	directionalLight.enabled = dl.enabled;
+	directionalLight.shadowMapDistance = dl.shadowMapDistance;
+	directionalLight.depthBias = dl.depthBias;
+	directionalLight.shadowMapAndViewportSize[0] = dl.shadowMapAndViewportSize.x();
+	directionalLight.shadowMapAndViewportSize[1] = dl.shadowMapAndViewportSize.y();
+
+	outData.assign(offsets.end, 0);	// zero padding between the blobs
+	auto fnWriteBlob = [&outData](size_t offset, const void* pData, size_t size)
+	{
+		if (size > 0)
+			memcpy(outData.data() + offset, pData, size);
+	};
+	fnWriteBlob(0                         , &header               , sizeof(header));
+	fnWriteBlob(offsets.settings          , &scene.settings       , sizeof(Settings::SceneRender));
+	fnWriteBlob(offsets.directionalLight  , &directionalLight     , sizeof(directionalLight));
+	fnWriteBlob(offsets.cameras           , scene.cameras.data()  , scene.cameras.size() * sizeof(Settings::Camera));
+	fnWriteBlob(offsets.lights            , lights.data()         , lights.size()        * sizeof(CompiledLight));
+	fnWriteBlob(offsets.materials         , materials.data()      , materials.size()     * sizeof(CompiledMaterial));
+	fnWriteBlob(offsets.objects           , objects.data()        , objects.size()       * sizeof(CompiledObject));
+	fnWriteBlob(offsets.meshes            , meshes.data()         , meshes.size()        * sizeof(CompiledMesh));
+	fnWriteBlob(offsets.stringTable       , stringTable.data()    , stringTable.size());
+}
+
+bool CompiledScene::Write(const std::string& filePath, const SerializedScene& scene, uint64_t sourceKey)
+{
+	DirectoryUtil::CreateFolderIfItDoesntExist(DirectoryUtil::GetFolderPath(filePath));
+
+	std::vector<char> data;
+	Serialize(scene, sourceKey, data);
+
+	std::ofstream file(filePath, std::ios::binary | std::ios::trunc);
+	if (!file.is_open())
+	{
+		Log::Error("CompiledScene: Couldn't open %s for writing.", filePath.c_str());
+		return false;
+	}
+	file.write(data.data(), data.size());
+	if (!file.good())
+	{
+		Log::Error("CompiledScene: Error writing %s.", filePath.c_str());
+		file.close();
+		DeleteFile(filePath.c_str());
+		return false;
+	}
+	return true;
+}
+
+bool CompiledScene::Read(const std::string& filePath, uint64_t sourceKey, Renderer* pRenderer, SerializedScene& outScene)
+{
+	std::vector<char> data;
+	if (!ReadWholeFile(filePath, data))
+		return false;
+
+	if (data.size() < sizeof(CompiledSceneHeader))
+	{
+		Log::Warning("CompiledScene: %s is truncated.", filePath.c_str());
+		return false;
+	}
+
+	const char* pBase = data.data();
+	const CompiledSceneHeader& header = *reinterpret_cast<const CompiledSceneHeader*>(pBase);
+	const BlobOffsets offsets = GetBlobOffsets(header);
+	const bool bValid = header.magic == COMPILED_SCENE_MAGIC
+		&& header.version == COMPILED_SCENE_VERSION
+		&& header.sceneSettingsSize == sizeof(Settings::SceneRender)
+		&& header.cameraSize == sizeof(Settings::Camera)
+		&& offsets.end <= data.size()
+		&& (header.stringTableSize == 0 || pBase[offsets.stringTable + header.stringTableSize - 1] == '\0');
+	if (!bValid)
+	{
+		Log::Warning("CompiledScene: %s is outdated or corrupt.", filePath.c_str());
+		return false;
+	}
+	if (header.sourceKey != sourceKey)
+	{
+		Log::Info("CompiledScene: %s was compiled from a different version of the scene file.", filePath.c_str());
+		return false;
+	}
+
+	const Settings::Camera*         pCameras   = reinterpret_cast<const Settings::Camera*>(pBase + offsets.cameras);
+	const CompiledLight*            pLights    = reinterpret_cast<const CompiledLight*>(pBase + offsets.lights);
+	const CompiledMaterial*         pMaterials = reinterpret_cast<const CompiledMaterial*>(pBase + offsets.materials);
+	const CompiledObject*           pObjects   = reinterpret_cast<const CompiledObject*>(pBase + offsets.objects);
+	const CompiledMesh*             pMeshes    = reinterpret_cast<const CompiledMesh*>(pBase + offsets.meshes);
+	const CompiledDirectionalLight& dl         = *reinterpret_cast<const CompiledDirectionalLight*>(pBase + offsets.directionalLight);
+	auto fnGetString = [&](uint32_t offset) { return offset < header.stringTableSize ? std::string(pBase + offsets.stringTable + offset) : std::string(); };
+
+	// indices are used as-is below, reject the file rather than reading past the arrays
+	for (uint32_t i = 0; i < header.numObjects; ++i)
+	{
+		if (static_cast<size_t>(pObjects[i].firstMesh) + pObjects[i].numMeshes > header.numMeshes)
+		{
+			Log::Warning("CompiledScene: %s has invalid mesh ranges.", filePath.c_str());
+			return false;
+		}
+	}
+	for (uint32_t i = 0; i < header.numMeshes; ++i)
+	{
+		if (pMeshes[i].material != NO_MATERIAL && pMeshes[i].material >= header.numMaterials)
+		{
+			Log::Warning("CompiledScene: %s has invalid material indices.", filePath.c_str());
+			return false;
+		}
+	}
+	for (uint32_t i = 0; i < header.numMaterials; ++i)
+	{
+		if (pMaterials[i].type >= MATERIAL_TYPE_COUNT)
+		{
+			Log::Warning("CompiledScene: %s has invalid material types.", filePath.c_str());
+			return false;
+		}
+	}
+
+	// SETTINGS, CAMERAS & LIGHTS
+	//
+	memcpy(&outScene.settings, pBase + offsets.settings, sizeof(Settings::SceneRender));
+	outScene.cameras.assign(pCameras, pCameras + header.numCameras);
+
+	outScene.directionalLight.color      = LinearColor(LoadVec3(dl.color));
+	outScene.directionalLight.brightness = dl.brightness;
+	outScene.directionalLight.direction  = LoadVec3(dl.direction);
+	outScene.directionalLight.enabled    = dl.enabled;
+	outScene.directionalLight.shadowMapDistance = dl.shadowMapDistance;
+	outScene.directionalLight.depthBias  = dl.depthBias;
+	outScene.directionalLight.shadowMapAndViewportSize = vec2(dl.shadowMapAndViewportSize[0], dl.shadowMapAndViewportSize[1]);
+
+	outScene.lights.clear();
+	outScene.lights.reserve(header.numLights);
+	for (uint32_t i = 0; i < header.numLights; ++i)
+	{
+		const CompiledLight& c = pLights[i];
+		Light l;
+		l.type             = static_cast<Light::ELightType>(c.type);
+		l.color            = LinearColor(LoadVec3(c.color));
+		l.range            = c.range;
+		l.brightness       = c.brightness;
+		l.castsShadow      = c.castsShadow != 0;
+		l.depthBias        = c.depthBias;
+		l.farPlaneDistance = c.farPlaneDistance;
+		l.spotAngle        = vec2(c.lightData[0], c.lightData[1]);
+		l.renderMesh       = static_cast<EGeometry>(c.renderMesh);
+		l.transform        = LoadTransform(c.transform);
+		outScene.lights.push_back(l);
+	}
+
+	// MATERIALS
+	//
+	// the pool holds a default material per type and never hands out its last entry
+	outScene.materials.Clear();
+	outScene.materials.Initialize(std::max(MATERIAL_POOL_SIZE, static_cast<size_t>(header.numMaterials) + 2));
+	outScene.materialTextures.clear();
+	std::vector<Material*> materials(header.numMaterials, nullptr);
+	for (uint32_t i = 0; i < header.numMaterials; ++i)
+	{
+		const CompiledMaterial& c = pMaterials[i];
+		Material* pMaterial = outScene.materials.CreateAndGetMaterial(static_cast<EMaterialType>(c.type));
+		pMaterial->diffuse  = LinearColor(LoadVec3(c.diffuse));
+		pMaterial->alpha    = c.alpha;
+		pMaterial->specular = LoadVec3(c.specular);
+		pMaterial->tiling   = vec2(c.tiling[0], c.tiling[1]);
+		if (c.type == GGX_BRDF)
+		{
+			static_cast<BRDF_Material*>(pMaterial)->metalness = c.metalness;
+			static_cast<BRDF_Material*>(pMaterial)->roughness = c.roughness;
+		}
+		else
+		{
+			static_cast<BlinnPhong_Material*>(pMaterial)->shininess = c.shininess;
+		}
+
+		if (c.diffuseMap != NO_STRING || c.normalMap != NO_STRING)
+		{
+			SerializedMaterialTextures& textures = outScene.GetMaterialTextures(pMaterial->ID);
+			textures.diffuseMap = fnGetString(c.diffuseMap);
+			textures.normalMap  = fnGetString(c.normalMap);
+			if (pRenderer && !textures.diffuseMap.empty()) pMaterial->diffuseMap = pRenderer->CreateTextureFromFile(textures.diffuseMap);
+			if (pRenderer && !textures.normalMap.empty())  pMaterial->normalMap  = pRenderer->CreateTextureFromFile(textures.normalMap);
+		}
+		materials[i] = pMaterial;
+	}
+
+	// OBJECTS
+	//
+	outScene.objects.clear();
+	outScene.objects.reserve(header.numObjects);
+	for (uint32_t i = 0; i < header.numObjects; ++i)
+	{
+		const CompiledObject& c = pObjects[i];
+		GameObject* pObject = outScene.CreateNewGameObject();
+		if (c.modelName != NO_STRING)
+		{
+			Model m;
+			m.mbLoaded = false;
+			m.mModelDirectory = "";
+			m.mModelName = fnGetString(c.modelName);
+			pObject->SetModel(m);
+		}
+		pObject->SetTransform(LoadTransform(c.transform));
+		for (uint32_t mesh = c.firstMesh; mesh < c.firstMesh + c.numMeshes; ++mesh)
+		{
+			pObject->AddMesh(pMeshes[mesh].meshID);
+			if (pMeshes[mesh].material != NO_MATERIAL)
+				pObject->AddMaterial(materials[pMeshes[mesh].material]);
+		}
+	}
+
+	outScene.loadSuccess = '1';
+	return true;
+}
@@ -0,0 +1,270 @@
+//	VQEngine | DirectX11 Renderer
+//	Copyright(C) 2018  - Volkan Ilbeyli
+//
+//	This program is free software : you can redistribute it and / or modify
+//	it under the terms of the GNU General Public License as published by
+//	the Free Software Foundation, either version 3 of the License, or
+//	(at your option) any later version.
+//
+//	This program is distributed in the hope that it will be useful,
+//	but WITHOUT ANY WARRANTY; without even the implied warranty of
+//	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+//	GNU General Public License for more details.
+//
+//	You should have received a copy of the GNU General Public License
+//	along with this program.If not, see <http://www.gnu.org/licenses/>.
+//
+//	Contact: volkanilbeyli@gmail.com
+#define NOMINMAX
+
+#include "Culling.h"
+#include "GameObject.h"
+
+#include "Utilities/Log.h"
+
+#include <algorithm>
+#include <cassert>
+#include <limits>
+
+bool IsVisible(const FrustumPlaneset& frustum, const BoundingBox& aabb)
+{
+	const vec4 points[] =
+	{
+	{ aabb.low.x(), aabb.low.y(), aabb.low.z(), 1.0f },
+	{ aabb.hi.x() , aabb.low.y(), aabb.low.z(), 1.0f },
+	{ aabb.hi.x() , aabb.hi.y() , aabb.low.z(), 1.0f },
+	{ aabb.low.x(), aabb.hi.y() , aabb.low.z(), 1.0f },
+
+	{ aabb.low.x(), aabb.low.y(), aabb.hi.z() , 1.0f},
+	{ aabb.hi.x() , aabb.low.y(), aabb.hi.z() , 1.0f},
+	{ aabb.hi.x() , aabb.hi.y() , aabb.hi.z() , 1.0f},
+	{ aabb.low.x(), aabb.hi.y() , aabb.hi.z() , 1.0f},
+	};
+
+	for (int i = 0; i < 6; ++i)	// for each plane
+	{
+		bool bInside = false;
+		for (int j = 0; j < 8; ++j)	// for each point
+		{
+			if (XMVector4Dot(points[j], frustum.abcd[i]).m128_f32[0] > 0.000002f)
+			{
+				bInside = true;
+				break;
+			}
+		}
+		if (!bInside)
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+BoundingBox TransformAABB(const BoundingBox& aabb_local, const XMMATRIX& world)
+{
+	const vec3& lo = aabb_local.low;
+	const vec3& hi = aabb_local.hi;
+	const vec4 points[] =
+	{
+		{ lo.x(), lo.y(), lo.z(), 1.0f },
+		{ hi.x(), lo.y(), lo.z(), 1.0f },
+		{ hi.x(), hi.y(), lo.z(), 1.0f },
+		{ lo.x(), hi.y(), lo.z(), 1.0f },
+
+		{ lo.x(), lo.y(), hi.z(), 1.0f },
+		{ hi.x(), lo.y(), hi.z(), 1.0f },
+		{ hi.x(), hi.y(), hi.z(), 1.0f },
+		{ lo.x(), hi.y(), hi.z(), 1.0f },
+	};
+
+	XMVECTOR mins = XMVector4Transform(points[0], world);
+	XMVECTOR maxs = mins;
+	for (int i = 1; i < 8; ++i)
+	{
+		const XMVECTOR p = XMVector4Transform(points[i], world);
+		mins = XMVectorMin(mins, p);
+		maxs = XMVectorMax(maxs, p);
+	}
+
+	BoundingBox aabb_world;
+	aabb_world.low = mins;
+	aabb_world.hi  = maxs;
+	return aabb_world;
+}
+
+size_t CullMeshes(
+	const FrustumPlaneset&     frustumPlanes
+	, const GameObject*        pObj
+	, const std::vector<Mesh>& meshes
+	, MeshRenderList&          culledMeshIDs
+)
+{
+	const XMMATRIX world = pObj->GetTransform().WorldTransformationMatrix();
+	const std::vector<MeshID>& meshIDs = pObj->GetModelData().mMeshIDs;
+
+	culledMeshIDs.clear();
+	for (MeshID id : meshIDs)
+	{
+		if (IsVisible(frustumPlanes, TransformAABB(meshes[id].GetLocalAABB(), world)))
+		{
+			culledMeshIDs.push_back(id);
+		}
+	}
+	return meshIDs.size() - culledMeshIDs.size();
+}
+
+size_t CullGameObjects(
+	const FrustumPlaneset&                  frustumPlanes
+	, const std::vector<const GameObject*>& pObjs
+	, std::vector<const GameObject*>&       pCulledObjs
+)
+{
+	size_t currIdx = 0;
+	std::for_each(RANGE(pObjs), [&](const GameObject* pObj)
+	{
+		// aabb is static and in world space during load time.
+		// this wouldn't work for dynamic objects in this state.
+		const BoundingBox aabb_world = [&]() 
+		{
+			const XMMATRIX world = pObj->GetTransform().WorldTransformationMatrix();
+			const XMMATRIX worldRotation = pObj->GetTransform().RotationMatrix();
+			const BoundingBox& aabb_local = pObj->GetAABB();
+#if 1
+			// transform low and high points of the bounding box: model->world
+			return BoundingBox(
+			{ 
+				XMVector4Transform(vec4(aabb_local.low, 1.0f), world), 
+				XMVector4Transform(vec4(aabb_local.hi , 1.0f), world) 
+			});
+#else
+			//----------------------------------------------------------------------------------
+			// TODO: there's an error in the code below. 
+			// bug repro: turn your back to the nanosuit in sponza scene -> suit won't be culled.
+			//----------------------------------------------------------------------------------
+			// transform center and extent and construct high and low later
+			// we can use XMVector3Transform() for the extent vector to save some instructions
+			const vec3 extent = aabb_local.hi - aabb_local.low;
+			const vec4 center = vec4((aabb_local.hi + aabb_local.low) * 0.5f, 1.0f);
+			const vec3 tfC = XMVector4Transform(center, world);
+			const vec3 tfEx = XMVector3Transform(extent, worldRotation) * 0.5f;
+			return BoundingBox(
+			{
+				{tfC - tfEx},	// lo
+				{tfC + tfEx}	// hi
+			});
+#endif
+		}();
+
+		//assert(!pObj->GetModelData().mMeshIDs.empty());
+		if (pObj->GetModelData().mMeshIDs.empty())
+		{
+#if _DEBUG
+			Log::Warning("CullGameObject(): GameObject with empty mesh list.");
+#endif
+			return;
+		}
+
+		if (IsVisible(frustumPlanes, aabb_world))
+		{
+			pCulledObjs.push_back(pObj);
+			++currIdx;
+		}
+	});
+	return pObjs.size() - currIdx;
+}
+
+bool SortByMeshType(const GameObject* pObj0, const GameObject* pObj1)
+{
+	const ModelData& model0 = pObj0->GetModelData();
+	const ModelData& model1 = pObj1->GetModelData();
+
+	const MeshID mID0 = model0.mMeshIDs.empty() ? -1 : model0.mMeshIDs.back();
+	const MeshID mID1 = model1.mMeshIDs.empty() ? -1 : model1.mMeshIDs.back();
+	
+	assert(mID0 != -1 && mID1 != -1);
+
+	// case: one of the objects have a custom mesh
+	if (mID0 >= EGeometry::MESH_TYPE_COUNT || mID1 >= EGeometry::MESH_TYPE_COUNT)
+	{
+		if (mID0 < EGeometry::MESH_TYPE_COUNT)
+			return true;
+			
+		if (mID1 < EGeometry::MESH_TYPE_COUNT)
+			return false;
+
+		return false;
+	}
+
+	// case: both objects are built-in types
+	else
+	{
+		return mID0 < mID1;
+	}
+}
+
+BoundingBox EmptyBoundingBox()
+{
+	constexpr float max_f = std::numeric_limits<float>::max();
+	BoundingBox aabb;
+	aabb.low = vec3(max_f);
+	aabb.hi = vec3(-(max_f - 1.0f));
+	return aabb;
+}
+
+void AccumulateVertexBounds(
+	const void*       pVertices
+	, size_t          numVertices
+	, size_t          stride
+	, const XMMATRIX& world
+	, BoundingBox&    worldBounds
+	, BoundingBox&    localBounds
+)
+{
+	constexpr float DegenerateMeshPositionChannelValueMax = 15000.0f; // make sure no vertex.xyz is > 15,000.0f
+
+	vec3& mins = worldBounds.low;
+	vec3& maxs = worldBounds.hi;
+	vec3& mins_obj = localBounds.low;
+	vec3& maxs_obj = localBounds.hi;
+	const char* pVertexData = static_cast<const char*>(pVertices);
+	for (size_t i = 0; i < numVertices; ++i)
+	{
+		const vec3& position = *reinterpret_cast<const vec3*>(pVertexData + i * stride);
+		const vec3 worldPos = vec3(XMVector4Transform(vec4(position, 1.0f), world));
+		const float x_mesh = std::min(worldPos.x(), DegenerateMeshPositionChannelValueMax);
+		const float y_mesh = std::min(worldPos.y(), DegenerateMeshPositionChannelValueMax);
+		const float z_mesh = std::min(worldPos.z(), DegenerateMeshPositionChannelValueMax);
+
+		const float x_mesh_local = position.x();
+		const float y_mesh_local = position.y();
+		const float z_mesh_local = position.z();
+
+		// scene bounding box - world space
+		mins = vec3
+		(
+			std::min(x_mesh, mins.x()),
+			std::min(y_mesh, mins.y()),
+			std::min(z_mesh, mins.z())
+		);
+		maxs = vec3
+		(
+			std::max(x_mesh, maxs.x()),
+			std::max(y_mesh, maxs.y()),
+			std::max(z_mesh, maxs.z())
+		);
+
+		// object bounding box - model space
+		mins_obj = vec3
+		(
+			std::min(x_mesh_local, mins_obj.x()),
+			std::min(y_mesh_local, mins_obj.y()),
+			std::min(z_mesh_local, mins_obj.z())
+		);
+		maxs_obj = vec3
+		(
+			std::max(x_mesh_local, maxs_obj.x()),
+			std::max(y_mesh_local, maxs_obj.y()),
+			std::max(z_mesh_local, maxs_obj.z())
+		);
+	}
+}
@@ -92,6 +92,12 @@ void DeferredRenderingPasses::Initialize(Renderer * pRenderer)
 
 	// deferred geometry is accessed from elsewhere, needs to be globally defined
 	assert(EShaders::DEFERRED_GEOMETRY == _geometryShader);	// this assumption may break, make sure it doesn't...
+
+	const ShaderDesc geomShaderCompactVertexDesc = { "GBufferPass-CompactVertex", {
+		ShaderStageDesc{ "Deferred_Geometry_vs.hlsl", { ShaderMacro{ "COMPACT_VERTEX", "1" } } },
+		ShaderStageDesc{ "Deferred_Geometry_ps.hlsl", {} }
+	} };
+	_geometryCompactVertexShader = pRenderer->CreateShader(geomShaderCompactVertexDesc);
 }
 
 void DeferredRenderingPasses::InitializeGBuffer(Renderer* pRenderer)
@@ -167,7 +173,8 @@ void DeferredRenderingPasses::RenderGBuffer(Renderer* pRenderer, const Scene* pS
 	{
 		return mesh == EGeometry::TRIANGLE || mesh == EGeometry::QUAD || mesh == EGeometry::GRID;
 	};
-	auto RenderObject = [&](const GameObject* pObj)
+	// the meshes with compact vertices are drawn in a second sweep with the COMPACT_VERTEX shader
+	auto RenderObject = [&](const GameObject* pObj, bool bCompactVertices)
 	{
 		const Transform& tf = pObj->GetTransform();
 		const ModelData& model = pObj->GetModelData();
@@ -183,8 +190,11 @@ void DeferredRenderingPasses::RenderGBuffer(Renderer* pRenderer, const Scene* pS
 		pRenderer->SetRasterizerState(EDefaultRasterizerState::CULL_BACK);
 
 		SurfaceMaterial material;
-		for (MeshID id : model.mMeshIDs)
+		for (MeshID id : sceneView.GetMeshRenderList(pObj))
 		{
+			if (SceneResourceView::HasCompactVertices(pScene, id) != bCompactVertices)
+				continue;
+
 			const auto IABuffer = SceneResourceView::GetVertexAndIndexBuffersOfMesh(pScene, id);
 
 			// SET MATERIAL CONSTANT BUFFER & TEXTURES
@@ -244,10 +254,23 @@ void DeferredRenderingPasses::RenderGBuffer(Renderer* pRenderer, const Scene* pS
 	int numObj = 0;
 	for (const auto* obj : sceneView.culledOpaqueList)
 	{
-		RenderObject(obj);
+		RenderObject(obj, false);
 		++numObj;
 	}
 
+	if (Engine::GetSettings().rendering.bCompactVertices)
+	{
+		pRenderer->SetShader(_geometryCompactVertexShader);
+		pRenderer->BindRenderTargets(_GBuffer._diffuseRoughnessRT, _GBuffer._specularMetallicRT, _GBuffer._normalRT);
+		pRenderer->BindDepthTarget(ENGINE->GetWorldDepthTarget());
+		pRenderer->SetSamplerState("sNormalSampler", EDefaultSamplerState::LINEAR_FILTER_SAMPLER_WRAP_UVW);
+		pRenderer->Apply();
+		for (const auto* obj : sceneView.culledOpaqueList)
+		{
+			RenderObject(obj, true);
+		}
+	}
+
 
 
 	// RENDER INSTANCED SCENE OBJECTS
@@ -32,6 +32,7 @@
 // -------------------------------------------------------
 #include "Engine.h"
 #include "Camera.h"
+#include "CompiledScene.h"
 
 #include "Application/Application.h"
 #include "Application/Input.h"
@@ -41,6 +42,8 @@
 #include "Utilities/PerfTimer.h"
 #include "Utilities/CustomParser.h"
 #include "Utilities/Profiler.h"
+#include "Utilities/MemoryTracker.h"
+#include "Utilities/MetricsServer.h"
 
 #include "Renderer/Renderer.h"
 #include "Renderer/TextRenderer.h"
@@ -53,10 +56,14 @@
 #include "Scenes/SponzaScene.h"
 
 #include <sstream>
+#include <array>
+#include <chrono>
 #include <DirectXMath.h>
 
 using namespace VQEngine;
 
+constexpr int PROFILE_CAPTURE_FRAME_COUNT = 300;	// F10
+
 void Engine::StartRenderThread()
 {
 	mbStopRenderThread = false;
@@ -117,7 +124,10 @@ void Engine::ToggleBloom()
 	Log::Info("Toggle Bloom: %s", mEngineConfig.bBloom ? "On" : "Off");
 }
 
-float Engine::GetTotalTime() const { return mpTimer->TotalTime(); }
+float Engine::GetTotalTime() const
+{	// the scenes animate with the total time: recordings and replays use the simulated time
+	return mpFrameRecorder ? static_cast<float>(mpFrameRecorder->GetSimulationTime()) : mpTimer->TotalTime();
+}
 
 
 
@@ -147,8 +157,11 @@ Engine::Engine()
 Engine::~Engine(){}
 
 
-bool Engine::Initialize(HWND hwnd)
+bool Engine::Initialize(HWND hwnd, ThreadPool* pThreadPool, bool bHeadless /*= false*/)
 {
+	MemoryTracker::TagScope memoryTag(EMemoryTag::LOADER);
+	mpThreadPool = pThreadPool;	// shaders are compiled on the thread pool before the scene loading starts
+	CPUProfiler::SetThreadName("Main");
 	StartRenderThread();
 	mpTimer->Start();
 	if (!mpRenderer || !mpInput || !mpTimer)
@@ -164,7 +177,7 @@ bool Engine::Initialize(HWND hwnd)
 	const Settings::Window& windowSettings = sEngineSettings.window;
 
 	mpInput->Initialize();
-	if (!mpRenderer->Initialize(hwnd, windowSettings))
+	if (!mpRenderer->Initialize(hwnd, windowSettings, bHeadless))
 	{
 		Log::Error("Cannot initialize Renderer.\n");
 		return false;
@@ -238,6 +251,7 @@ bool Engine::Initialize(HWND hwnd)
 
 bool Engine::Load(ThreadPool* pThreadPool)
 {
+	MemoryTracker::TagScope memoryTag(EMemoryTag::LOADER);
 	mpCPUProfiler->BeginProfile();
 	mpThreadPool = pThreadPool;
 	const Settings::Rendering& rendererSettings = sEngineSettings.rendering;
@@ -349,7 +363,7 @@ bool Engine::Load(ThreadPool* pThreadPool)
 	// LOAD ENVIRONMENT MAPS
 	//
 	mpTimer->Start();
-	mpCPUProfiler->BeginEntry("EngineLoad");
+	mpCPUProfiler->BeginEntry(PROFILE_SCOPE_ID("EngineLoad"));
 	Log::Info("-------------------- LOADING ENVIRONMENT MAPS --------------------- ");
 	Skybox::InitializePresets(mpRenderer, rendererSettings);
 	Log::Info("-------------------- ENVIRONMENT MAPS LOADED IN %.2fs. --------------------", mpTimer->StopGetDeltaTimeAndReset());
@@ -395,11 +409,28 @@ bool Engine::Load(ThreadPool* pThreadPool)
 
 bool Engine::LoadSceneFromFile()
 {
+	if (mpFrameRecorder)
+	{	// the scenes that place objects and lights randomly are loaded the same way in the replays of a recording
+		SeedRandom(mpFrameRecorder->GetSeed());
+	}
 	mCurrentLevel = sEngineSettings.levelToLoad;
 	SerializedScene mSerializedScene;
 	{
+		// prefer the compiled scene if it's up to date with the scene file (see -CompileScenes)
+		const std::string sceneFilePath = Parser::GetSceneFilePath(sEngineSettings.sceneNames[mCurrentLevel]);
+		const std::string compiledFilePath = CompiledScene::GetFilePath(sceneFilePath);
+		const auto readStart = std::chrono::high_resolution_clock::now();
+
 		std::unique_lock<std::mutex> lck(mLoadRenderingMutex);
-		mSerializedScene = Parser::ReadScene(mpRenderer, sEngineSettings.sceneNames[mCurrentLevel]);
+		const bool bCompiled = DirectoryUtil::FileExists(compiledFilePath)
+			&& CompiledScene::Read(compiledFilePath, CompiledScene::GetSourceKey(sceneFilePath), mpRenderer, mSerializedScene);
+		if (!bCompiled)
+		{
+			mSerializedScene = Parser::ReadSceneFile(mpRenderer, sceneFilePath);
+		}
+
+		const std::chrono::duration<float, std::milli> readTime = std::chrono::high_resolution_clock::now() - readStart;
+		Log::Info("Scene: read %s in %.2fms (%s)", sEngineSettings.sceneNames[mCurrentLevel].c_str(), readTime.count(), bCompiled ? "compiled" : "parsed");
 	}
 	if (mSerializedScene.loadSuccess == '0')
 	{
@@ -411,7 +442,22 @@ bool Engine::LoadSceneFromFile()
 	mpActiveScene = mpScenes[mCurrentLevel];
 	mpActiveScene->mpThreadPool = mpThreadPool;
 
+	// texture load throughput: models load their textures in parallel on the thread pool
+	mpRenderer->ResetTextureLoadStats();
+	const auto sceneLoadStart = std::chrono::high_resolution_clock::now();
+
 	mpActiveScene->LoadScene(mSerializedScene, sEngineSettings.window, mBuiltinMeshes);
+	{
+		const std::chrono::duration<float, std::milli> sceneLoadTime = std::chrono::high_resolution_clock::now() - sceneLoadStart;
+		const TextureLoadStats texStats = mpRenderer->GetTextureLoadStats();
+		Log::Info("Textures: %d requests | %d decoded (%d processed into the texture cache), %d failed | %d cache hits, %d waited on in-flight decodes | decode %.2fms (all threads) / %.2fms scene load, %.1f textures/s"
+			, texStats.numRequests
+			, texStats.numDecodes, texStats.numProcessed, texStats.numFailedDecodes
+			, texStats.numCacheHits, texStats.numInFlightWaits
+			, texStats.decodeTimeMs, sceneLoadTime.count()
+			, sceneLoadTime.count() > 0.0f ? texStats.numDecodes * 1000.0f / sceneLoadTime.count() : 0.0f
+		);
+	}
 
 	// update engine settings and post process settings
 	// todo: multiple data - inconsistent state -> sort out ownership
@@ -428,6 +474,7 @@ bool Engine::LoadSceneFromFile()
 
 bool Engine::LoadScene(int level)
 {
+	MemoryTracker::TagScope memoryTag(EMemoryTag::LOADER);	// propagated to the loading task
 #if LOAD_ASYNC
 	mActiveLoadingScreen = mLoadingScreenTextures[RandU(0, mLoadingScreenTextures.size())];
 	mbLoading = true;
@@ -500,6 +547,19 @@ bool Engine::LoadShaders()
 			ShaderDesc{ "DepthShader"       , ShaderDesc::CreateStageDescsFromShaderName("DepthShader", VS_PS)},
 		};
 		
+		// compile everything that's not in the shader cache in parallel before creating the shaders one by one:
+		// the builtin shaders and the stages the render passes created in the previous runs (manifest).
+		{
+			mpRenderer->LoadShaderManifest();
+			std::vector<ShaderStageDesc> stages = mpRenderer->GetKnownShaderStages();
+			for (const ShaderDesc& desc : shaderDescs)
+				stages.insert(stages.end(), desc.stages.begin(), desc.stages.end());
+
+			const ShaderPrecompileStats stats = mpRenderer->PrecompileShaders(stages, mpThreadPool);
+			Log::Info("Shader cache: %d stages | %d compiled, %d up to date, %d failed | %.2fms"
+				, stats.numStages, stats.numCompiled, stats.GetNumUpToDate(), stats.numFailed, stats.timeMs);
+		}
+
 		// todo: do not depend on array index, use a lookup, remove s_shaders[]
 		for (int i = 0; i < shaderDescs.size(); ++i)
 		{
@@ -514,7 +574,25 @@ bool Engine::LoadShaders()
 
 void Engine::Exit()
 {
+	if (mFrameTimes.GetCount() > 0)
+	{
+		Log::Info("Frame times of %llu frames: avg %.2f ms | p50 %.2f ms | p95 %.2f ms | p99 %.2f ms | max %.2f ms"
+			, static_cast<unsigned long long>(mFrameTimes.GetCount())
+			, mFrameTimes.GetMean() * 1000.0f
+			, mFrameTimes.GetPercentile(50.0f) * 1000.0f
+			, mFrameTimes.GetPercentile(95.0f) * 1000.0f
+			, mFrameTimes.GetPercentile(99.0f) * 1000.0f
+			, mFrameTimes.GetMax() * 1000.0f
+		);
+	}
+	mpCPUProfiler->PrintStats();
+	if (MemoryTracker::IsEnabled())
+	{
+		MemoryTracker::LogStats();
+	}
 	mpCPUProfiler->EndProfile();
+	mpMetricsServer.reset();
+	mpFrameRecorder.reset();
 	mpGPUProfiler->Exit();
 	mUI.Exit();
 	mpTextRenderer->Exit();
@@ -536,11 +614,19 @@ void Engine::Exit()
 void Engine::SimulateAndRenderFrame()
 {
 	const float dt = mpTimer->Tick();
+	const bool bLoading = mbLoading;	// latched: the loading thread can finish during the frame
+
+	// recorded/replayed frames: the simulation runs on the replayed input and dt, the frame stats on the measured dt
+	float simulationDt = dt;
+	if (mpFrameRecorder && !bLoading)
+	{
+		simulationDt = mpFrameRecorder->BeginFrame(*mpInput, dt);
+	}
 
 	HandleInput();
 
 #if LOAD_ASYNC
-	if (mbLoading)
+	if (bLoading)
 	{
 		CalcFrameStats(dt);
 		//std::atomic_fetch_add(&mAccumulator, dt);	// not supported by ryzen?
@@ -563,13 +649,24 @@ void Engine::SimulateAndRenderFrame()
 		}
 #endif
 
-		mpCPUProfiler->BeginEntry("CPU");
+		if (mNumProfileCaptureFrames > 0)
+		{
+			const std::string captureDirectory = Application::s_WorkspaceDirectory + "\\ProfileCaptures";
+			DirectoryUtil::CreateFolderIfItDoesntExist(captureDirectory);
+			mpCPUProfiler->BeginCapture(captureDirectory + "\\Capture_" + GetCurrentTimeAsString() + ".json", mNumProfileCaptureFrames);
+			mNumProfileCaptureFrames = 0;
+		}
+
+		mpCPUProfiler->BeginEntry(PROFILE_SCOPE_ID("CPU"));
 		if (!mbIsPaused)
 		{
 			CalcFrameStats(dt);
 
-			mpCPUProfiler->BeginEntry("Update()");
-			mpActiveScene->UpdateScene(dt);
+			mpCPUProfiler->BeginEntry(PROFILE_SCOPE_ID("Update()"));
+			{
+				MemoryTracker::TagScope memoryTag(EMemoryTag::SCENE);
+				mpActiveScene->UpdateScene(simulationDt);
+			}
 			mpCPUProfiler->EndEntry();	// Update
 
 			PreRender();
@@ -581,7 +678,7 @@ void Engine::SimulateAndRenderFrame()
 
 		// PRESENT THE FRAME
 		//
-		mpCPUProfiler->BeginEntry("Present");
+		mpCPUProfiler->BeginEntry(PROFILE_SCOPE_ID("Present"));
 		mpRenderer->EndFrame();
 		mpCPUProfiler->EndEntry();
 
@@ -589,6 +686,22 @@ void Engine::SimulateAndRenderFrame()
 		mpCPUProfiler->EndEntry();	// CPU
 		mpCPUProfiler->StateCheck();
 
+		// heap allocations of this frame, displayed with the next frame's stats
+		const MemoryTracker::Counters allocations = MemoryTracker::GetCounters();
+		mFrameStats.memory.numAllocations    = static_cast<int>(allocations.numAllocations - mPrevFrameAllocations.numAllocations);
+		mFrameStats.memory.numAllocatedBytes = static_cast<int>(allocations.numAllocatedBytes - mPrevFrameAllocations.numAllocatedBytes);
+		mPrevFrameAllocations = allocations;
+
+		if (mpMetricsServer && mpMetricsServer->HasClients())
+		{
+			PublishFrameMetrics(dt);
+		}
+
+		if (mpFrameRecorder)
+		{	// the camera and the culling results tell if a replay diverges from the recording
+			const SceneView& sceneView = mpActiveScene->mSceneView;
+			mpFrameRecorder->EndFrame(HashValue(mFrameStats.scene, HashValue(sceneView.viewProj)));
+		}
 
 		++mFrameCount;
 
@@ -617,6 +730,7 @@ void Engine::SimulateAndRenderFrame()
 
 void Engine::RenderThread()	// This thread is currently only used during loading.
 {
+	CPUProfiler::SetThreadName("Loading Screen");
 	constexpr bool bOneTimeLoadingScreenRender = false; // We're looping;
 	while (!mbStopRenderThread)
 	{
@@ -628,7 +742,8 @@ void Engine::RenderThread()	// This thread is currently only used during loading
 		//           StopRenderThreadAndWait() waits on join
 		mSignalRender.wait(lck);
 #endif
-		mpCPUProfiler->BeginEntry("CPU");
+		mpCPUProfiler->SetProfilingThread();	// the update thread takes it back with BeginProfile() when loading is done
+		mpCPUProfiler->BeginEntry(PROFILE_SCOPE_ID("CPU"));
 
 		mpGPUProfiler->BeginProfile(mFrameCount);
 		mpGPUProfiler->BeginEntry("GPU");
@@ -641,7 +756,7 @@ void Engine::RenderThread()	// This thread is currently only used during loading
 		mpGPUProfiler->EndProfile(mFrameCount);
 
 
-		mpCPUProfiler->BeginEntry("Present");
+		mpCPUProfiler->BeginEntry(PROFILE_SCOPE_ID("Present"));
 		mpRenderer->EndFrame();
 		mpCPUProfiler->EndEntry(); // Present
 
@@ -659,6 +774,153 @@ void Engine::RenderThread()	// This thread is currently only used during loading
 	mSignalRender.notify_all();
 }
 
+void Engine::CaptureProfile(int numFrames)
+{
+	if (mpCPUProfiler->IsCapturing())
+	{
+		Log::Warning("Profile capture already in progress.");
+		return;
+	}
+	mNumProfileCaptureFrames = numFrames;
+}
+
+bool Engine::StartRecording(const std::string& filePath)
+{
+	if (mpFrameRecorder)
+	{
+		Log::Warning("FrameRecorder: already %s, can't record into %s", mpFrameRecorder->IsReplaying() ? "replaying" : "recording", filePath.c_str());
+		return false;
+	}
+
+	const unsigned seed = static_cast<unsigned>(PerfTimer::GetTick());
+	std::unique_ptr<FrameRecorder> pRecorder = std::make_unique<FrameRecorder>();
+	if (!pRecorder->BeginRecording(filePath, seed, sEngineSettings.levelToLoad))
+		return false;
+	mpFrameRecorder = std::move(pRecorder);
+	return true;
+}
+
+bool Engine::StartReplay(const std::string& filePath)
+{
+	if (mpFrameRecorder)
+	{
+		Log::Warning("FrameRecorder: already %s, can't replay %s", mpFrameRecorder->IsReplaying() ? "replaying" : "recording", filePath.c_str());
+		return false;
+	}
+
+	std::unique_ptr<FrameRecorder> pRecorder = std::make_unique<FrameRecorder>();
+	if (!pRecorder->LoadReplay(filePath))
+		return false;
+	if (pRecorder->GetLevel() < 0 || pRecorder->GetLevel() >= static_cast<int>(sEngineSettings.sceneNames.size()))
+	{
+		Log::Error("FrameRecorder: %s is a recording of scene %d, which doesn't exist.", filePath.c_str(), pRecorder->GetLevel());
+		return false;
+	}
+	sEngineSettings.levelToLoad = pRecorder->GetLevel();
+	mpFrameRecorder = std::move(pRecorder);
+	return true;
+}
+
+bool Engine::IsReplayFinished() const
+{
+	return mpFrameRecorder && mpFrameRecorder->IsReplayFinished();
+}
+
+bool Engine::StartMetricsServer(unsigned short port)
+{
+	if (!mpMetricsServer)
+	{
+		mpMetricsServer = std::make_unique<MetricsServer>();
+	}
+	return mpMetricsServer->Start(port);
+}
+
+void Engine::PublishFrameMetrics(float dt)
+{
+	MetricsServer::Frame frame;
+	frame.frameIndex = mFrameCount;
+	frame.frameTimeMs = dt * 1000.0f;
+
+	FrameStats stats = mFrameStats;
+	stats.rstats = mpRenderer->GetRenderStats();	// mFrameStats has the render stats of the previous frame
+	frame.counters.reserve(FrameStats::numStat);
+	for (size_t i = 0; i < FrameStats::numStat; ++i)
+	{
+		frame.counters.push_back(MetricsServer::Counter{ FrameStats::statNames[i], stats.stats[i] });
+	}
+
+	// the timeline of the frame is aggregated when the outermost entry ends: CPU time of each scope over all the threads
+	for (const CPUProfiler::TimelineEvent& event : mpCPUProfiler->GetTimeline())
+	{
+		const float timeMs = static_cast<float>(PerfTimer::TicksToSeconds(event.endTick - event.beginTick) * 1000.0);
+		auto it = std::find_if(frame.scopeTimes.begin(), frame.scopeTimes.end(), [&](const MetricsServer::ScopeTime& s) { return s.scopeID == event.scopeID; });
+		if (it == frame.scopeTimes.end())	frame.scopeTimes.push_back(MetricsServer::ScopeTime{ event.scopeID, timeMs });
+		else								it->timeMs += timeMs;
+	}
+	mpMetricsServer->Publish(std::move(frame));
+}
+
+void Engine::RunHeadless(int numFrames)
+{
+	// loading frames aren't measured, the first frame after loading joins the loading screen thread
+	while (mbLoading || mRenderThread.joinable())
+	{
+		SimulateAndRenderFrame();
+	}
+	mFrameTimes.Reset();
+	mpCPUProfiler->EndProfile();	// reset the cpu profiler entries
+	mpCPUProfiler->BeginProfile();
+
+	std::array<long long, DENDER_STATS_STRUCT_ELEM_COUNT> statSums = {};
+	std::array<int, DENDER_STATS_STRUCT_ELEM_COUNT> statMaxs = {};
+	long long allocationSum = 0, allocatedByteSum = 0;
+	int allocationMax = 0, allocatedByteMax = 0;
+	mPrevFrameAllocations = MemoryTracker::GetCounters();	// don't count the loading allocations
+
+	// the frame that joins the loading thread already replays the first recorded frame
+	const bool bReplay = mpFrameRecorder && mpFrameRecorder->IsReplaying();
+	int frame = 0;
+	for (; bReplay ? !mpFrameRecorder->IsReplayFinished() : frame < numFrames; ++frame)
+	{
+		SimulateAndRenderFrame();
+		mpInput->PostUpdate();
+
+		const RendererStats& stats = mpRenderer->GetRenderStats();
+		for (size_t i = 0; i < DENDER_STATS_STRUCT_ELEM_COUNT; ++i)
+		{
+			statSums[i] += stats.arr[i];
+			statMaxs[i] = std::max(statMaxs[i], stats.arr[i]);
+		}
+		allocationSum += mFrameStats.memory.numAllocations;
+		allocatedByteSum += mFrameStats.memory.numAllocatedBytes;
+		allocationMax = std::max(allocationMax, mFrameStats.memory.numAllocations);
+		allocatedByteMax = std::max(allocatedByteMax, mFrameStats.memory.numAllocatedBytes);
+	}
+	const int numMeasuredFrames = frame;
+	const double averageDivisor = std::max(numMeasuredFrames, 1);
+
+	static const char* STAT_NAMES[DENDER_STATS_STRUCT_ELEM_COUNT] =
+	{
+		"Vertices", "Indices", "Draw Calls", "Triangles",
+		"Shader Changes", "State Changes", "Render Target Changes", "Resource Bindings", "Constant Buffer Updates"
+	};
+	std::ostringstream report;
+	report.precision(1);
+	report << std::fixed;
+	report << "Headless run: " << numMeasuredFrames << " frames of " << sEngineSettings.sceneNames[mCurrentLevel]
+		<< (mpRenderer->IsNullDevice() ? " on the null device" : "") << ", render stats per frame: avg / max";
+	for (size_t i = 0; i < DENDER_STATS_STRUCT_ELEM_COUNT; ++i)
+	{
+		report << "\n  " << STAT_NAMES[i] << ": " << static_cast<double>(statSums[i]) / averageDivisor << " / " << statMaxs[i];
+	}
+	if (MemoryTracker::IsEnabled())
+	{
+		report << "\n  Heap Allocations: " << static_cast<double>(allocationSum) / averageDivisor << " / " << allocationMax;
+		report << "\n  Heap Allocated Bytes: " << static_cast<double>(allocatedByteSum) / averageDivisor << " / " << allocatedByteMax;
+	}
+	Log::Info(report.str());
+}
+
 void Engine::HandleInput()
 {
 	if (mpInput->IsKeyTriggered("Backspace"))	TogglePause();
@@ -669,6 +931,7 @@ void Engine::HandleInput()
 	if (mpInput->IsKeyTriggered("F4")) mEngineConfig.bRenderTargets = !mEngineConfig.bRenderTargets;
 	if (mpInput->IsKeyTriggered("F5")) mEngineConfig.bBoundingBoxes = !mEngineConfig.bBoundingBoxes;
 	if (mpInput->IsKeyTriggered("F6")) ToggleRenderingPath();
+	if (mpInput->IsKeyTriggered("F10")) CaptureProfile(PROFILE_CAPTURE_FRAME_COUNT);
 
 	//if (mpInput->IsKeyTriggered("'")) 
 	if (mpInput->IsKeyTriggered("F"))// && mpInput->AreKeysDown(2, "ctrl", "shift"))
@@ -779,9 +1042,16 @@ void Engine::CalcFrameStats(float dt)
 	constexpr size_t RefreshRate = 5;	// refresh every 5 frames
 	constexpr size_t SampleCount = 50;	// over 50 dt samples
 
+	constexpr size_t RecentFrameCount = 600;	// percentiles of the window title
+
 	static std::vector<float> dtSamples(SampleCount, 0.0f);
 
 	dtSamples[frameCount % SampleCount] = dt;
+	if (!mbLoading)
+	{
+		mFrameTimes.Record(dt);
+		mRecentFrameTimes.Record(dt);
+	}
 
 	float dtSampleSum = 0.0f;
 	std::for_each(dtSamples.begin(), dtSamples.end(), [&dtSampleSum](float dt) { dtSampleSum += dt; });
@@ -797,10 +1067,15 @@ void Engine::CalcFrameStats(float dt)
 		std::ostringstream stats;
 		stats.precision(2);
 		stats << std::fixed;
-		stats << "VQEngine | " << "CPU: " << frameTime * 1000.0f << " ms  GPU: " << frameTimeGPU * 1000.f << " ms | FPS: ";
+		stats << "VQEngine | " << "CPU: " << frameTime * 1000.0f << " ms  GPU: " << frameTimeGPU * 1000.f << " ms | ";
+		stats << "p95: " << mRecentFrameTimes.GetPercentile(95.0f) * 1000.0f << " ms  p99: " << mRecentFrameTimes.GetPercentile(99.0f) * 1000.0f
+			<< " ms  max: " << mRecentFrameTimes.GetMax() * 1000.0f << " ms | FPS: ";
 		stats.precision(4);
 		stats << fps;
 		SetWindowText(mpRenderer->GetWindow(), stats.str().c_str());
+
+		if (mRecentFrameTimes.GetCount() >= RecentFrameCount)
+			mRecentFrameTimes.Reset();
 	}
 
 	++frameCount;
@@ -857,10 +1132,11 @@ void Engine::SendLightData() const
 
 void Engine::PreRender()
 {
+	MemoryTracker::TagScope memoryTag(EMemoryTag::SCENE);
 #if LOAD_ASYNC
 	if (mbLoading) return;
 #endif
-	mpCPUProfiler->BeginEntry("PreRender()");
+	mpCPUProfiler->BeginEntry(PROFILE_SCOPE_ID("PreRender()"));
 
 	mpActiveScene->mSceneView.bIsPBRLightingUsed = IsLightingModelPBR();
 	mpActiveScene->mSceneView.bIsDeferredRendering = mEngineConfig.bDeferredOrForward;
@@ -893,7 +1169,8 @@ void Engine::PreRender()
 // ====================================================================================
 void Engine::Render()
 {
-	mpCPUProfiler->BeginEntry("Render()");
+	MemoryTracker::TagScope memoryTag(EMemoryTag::RENDERER);
+	mpCPUProfiler->BeginEntry(PROFILE_SCOPE_ID("Render()"));
 
 	mpGPUProfiler->BeginProfile(mFrameCount);
 	mpGPUProfiler->BeginEntry("GPU");
@@ -905,7 +1182,7 @@ void Engine::Render()
 
 	// SHADOW MAPS
 	//------------------------------------------------------------------------
-	mpCPUProfiler->BeginEntry("Shadow Pass");
+	mpCPUProfiler->BeginEntry(PROFILE_SCOPE_ID("Shadow Pass"));
 	mpGPUProfiler->BeginEntry("Shadow Pass");
 	mpRenderer->BeginEvent("Shadow Pass");
 	
@@ -947,7 +1224,7 @@ void Engine::Render()
 
 		// GEOMETRY - DEPTH PASS
 		mpGPUProfiler->BeginEntry("Geometry Pass");
-		mpCPUProfiler->BeginEntry("Geometry Pass");
+		mpCPUProfiler->BeginEntry(PROFILE_SCOPE_ID("Geometry Pass"));
 		mpRenderer->BeginEvent("Geometry Pass");
 		mDeferredRenderingPasses.RenderGBuffer(mpRenderer, mpActiveScene, mpActiveScene->mSceneView);
 		mpRenderer->EndEvent();	
@@ -955,7 +1232,7 @@ void Engine::Render()
 		mpGPUProfiler->EndEntry();
 
 		// AMBIENT OCCLUSION  PASS
-		mpCPUProfiler->BeginEntry("AO Pass");
+		mpCPUProfiler->BeginEntry(PROFILE_SCOPE_ID("AO Pass"));
 		if (mEngineConfig.bSSAO && bSceneSSAO)
 		{
 			mAOPass.RenderAmbientOcclusion(mpRenderer, texNormal, mpActiveScene->mSceneView);
@@ -963,12 +1240,12 @@ void Engine::Render()
 		mpCPUProfiler->EndEntry(); // AO Pass
 
 		// DEFERRED LIGHTING PASS
-		mpCPUProfiler->BeginEntry("Lighting Pass");
+		mpCPUProfiler->BeginEntry(PROFILE_SCOPE_ID("Lighting Pass"));
 		mpGPUProfiler->BeginEntry("Lighting Pass");
 		mpRenderer->BeginEvent("Lighting Pass");
 #if ENABLE_TRANSPARENCY
 		mpGPUProfiler->BeginEntry("Opaque Pass (ScreenSpace)");
-		mpCPUProfiler->BeginEntry("Opaque Pass (ScreenSpace)");
+		mpCPUProfiler->BeginEntry(PROFILE_SCOPE_ID("Opaque Pass (ScreenSpace)"));
 #endif
 		{
 			mDeferredRenderingPasses.RenderLightingPass(deferredLightingParams);
@@ -983,7 +1260,7 @@ void Engine::Render()
 		
 		// TRANSPARENT OBJECTS - FORWARD RENDER
 		mpGPUProfiler->BeginEntry("Alpha Pass (Forward)");
-		mpCPUProfiler->BeginEntry("Alpha Pass (Forward)");
+		mpCPUProfiler->BeginEntry(PROFILE_SCOPE_ID("Alpha Pass (Forward)"));
 		{
 			mpRenderer->BindDepthTarget(GetWorldDepthTarget());
 			mpRenderer->SetShader(EShaders::FORWARD_BRDF);
@@ -997,7 +1274,7 @@ void Engine::Render()
 			const TextureID texIrradianceMap = mSceneView.environmentMap.irradianceMap;
 			const SamplerID smpEnvMap = mSceneView.environmentMap.envMapSampler < 0 ? EDefaultSamplerState::POINT_SAMPLER : mSceneView.environmentMap.envMapSampler;
 			const TextureID prefilteredEnvMap = mSceneView.environmentMap.prefilteredEnvironmentMap;
-			const TextureID tBRDFLUT = mpRenderer->GetRenderTargetTexture(EnvironmentMap::sBRDFIntegrationLUTRT);
+			const TextureID tBRDFLUT = EnvironmentMap::sBRDFIntegrationLUTTexture;	// no render target when loaded from the cache
 			const bool bSkylight = mSceneView.bIsIBLEnabled && texIrradianceMap != -1;
 			if (bSkylight)
 			{
@@ -1023,7 +1300,7 @@ void Engine::Render()
 		mpCPUProfiler->EndEntry();
 		mpGPUProfiler->EndEntry();
 
-		mpCPUProfiler->BeginEntry("Skybox & Lights");
+		mpCPUProfiler->BeginEntry(PROFILE_SCOPE_ID("Skybox & Lights"));
 		// LIGHT SOURCES
 		mpRenderer->BindDepthTarget(mWorldDepthTarget);
 		
@@ -1124,14 +1401,37 @@ void Engine::Render()
 
 	// POST PROCESS PASS | DEBUG PASS | UI PASS
 	//------------------------------------------------------------------------
-	mpCPUProfiler->BeginEntry("Post Process");
+	mpCPUProfiler->BeginEntry(PROFILE_SCOPE_ID("Post Process"));
 	mpGPUProfiler->BeginEntry("Post Process"); 
+	mRenderGraph.Reset();
 #if FULLSCREEN_DEBUG_TEXTURE
 	const TextureID texDebug = mAOPass.GetBlurredAOTexture(mpRenderer);
-	mPostProcessPass.Render(mpRenderer, mEngineConfig.bBloom, mbOutputDebugTexture ? texDebug : -1);
+	mPostProcessPass.AddRenderGraphPasses(mpRenderer, mRenderGraph, mEngineConfig.bBloom, mbOutputDebugTexture ? texDebug : -1);
 #else
-	mPostProcessPass.Render(mpRenderer, mEngineConfig.bBloom);
+	mPostProcessPass.AddRenderGraphPasses(mpRenderer, mRenderGraph, mEngineConfig.bBloom);
 #endif
+	if (mRenderGraph.Compile())
+	{
+		if (mpRenderer->IsStateValidationEnabled())
+			mRenderGraph.Validate();
+
+		const RenderGraph::Stats& rgStats = mRenderGraph.GetStats();
+		if (rgStats.allocatedMemory != mRenderGraphAllocatedMemory)
+		{
+			Log::Info("RenderGraph: %d/%d passes culled, %d transient render targets aliased onto %d (%.2f MB -> %.2f MB, saved %.2f MB)"
+				, rgStats.numCulledPasses, rgStats.numPasses
+				, rgStats.numTransientResources, rgStats.numPhysicalResources
+				, rgStats.requestedMemory / (1024.0f * 1024.0f)
+				, rgStats.allocatedMemory / (1024.0f * 1024.0f)
+				, rgStats.GetMemorySaved() / (1024.0f * 1024.0f)
+			);
+			mRenderGraphAllocatedMemory = rgStats.allocatedMemory;
+		}
+
+		mpRenderer->BeginEvent("Post Processing");
+		mRenderGraph.Execute(mpRenderer, mTransientResourcePool);
+		mpRenderer->EndEvent();
+	}
 	mpCPUProfiler->EndEntry();
 	mpGPUProfiler->EndEntry();
 	//------------------------------------------------------------------------
@@ -1151,7 +1451,7 @@ void Engine::RenderDebug(const XMMATRIX& viewProj)
 
 	if (mEngineConfig.bRenderTargets)	// RENDER TARGETS
 	{
-		mpCPUProfiler->BeginEntry("Debug Textures");
+		mpCPUProfiler->BeginEntry(PROFILE_SCOPE_ID("Debug Textures"));
 		const int screenWidth = sEngineSettings.window.width;
 		const int screenHeight = sEngineSettings.window.height;
 		const float aspectRatio = static_cast<float>(screenWidth) / screenHeight;
@@ -1281,7 +1581,7 @@ void Engine::RenderDebug(const XMMATRIX& viewProj)
 void Engine::RenderUI() const
 {
 	mpGPUProfiler->BeginEntry("UI");
-	mpCPUProfiler->BeginEntry("UI");
+	mpCPUProfiler->BeginEntry(PROFILE_SCOPE_ID("UI"));
 	mpRenderer->SetRasterizerState(EDefaultRasterizerState::CULL_NONE);	
 	if (mEngineConfig.mbShowProfiler) { mUI.RenderPerfStats(mFrameStats); }
 	if (mEngineConfig.mbShowControls) { mUI.RenderEngineControls(); }
@@ -1299,6 +1599,9 @@ void Engine::RenderUI() const
 #endif
 	}
 
+	// all the UI text of the frame is batched into a single draw
+	mpTextRenderer->Flush();
+
 	mpCPUProfiler->EndEntry();	// UI
 	mpGPUProfiler->EndEntry();
 }
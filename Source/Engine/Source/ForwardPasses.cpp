@@ -48,12 +48,19 @@ void ZPrePass::Initialize(Renderer* pRenderer)
 
 	objShader = pRenderer->CreateShader(shaders[0]);
 	objShaderInstanced = pRenderer->CreateShader(shaders[1]);
+
+	const ShaderDesc compactVertexShaderDesc = { "ZPrePass-CompactVertex", {
+		ShaderStageDesc{"Deferred_Geometry_vs.hlsl"            , { ShaderMacro{ "COMPACT_VERTEX", "1" } } },
+		ShaderStageDesc{"ViewSpaceNormalsAndPositions_ps.hlsl" , {} }
+	}};
+	objShaderCompactVertex = pRenderer->CreateShader(compactVertexShaderDesc);
 }
 
 void ZPrePass::RenderDepth(const RenderParams& args) const
 {
 	//--------------------------------------------------------------------------------------------------------------------
-	auto RenderObject = [&](const GameObject* pObj)
+	// the meshes with compact vertices are drawn in a second sweep with the COMPACT_VERTEX shader
+	auto RenderObject = [&](const GameObject* pObj, bool bCompactVertices)
 	{
 		const Transform& tf = pObj->GetTransform();
 		const ModelData& model = pObj->GetModelData();
@@ -70,8 +77,11 @@ void ZPrePass::RenderDepth(const RenderParams& args) const
 
 		SurfaceMaterial material;
 		args.pRenderer->SetConstant1i("textureConfig", 0);
-		for (MeshID id : model.mMeshIDs)
+		for (MeshID id : args.sceneView.GetMeshRenderList(pObj))
 		{
+			if (SceneResourceView::HasCompactVertices(args.pScene, id) != bCompactVertices)
+				continue;
+
 			const auto IABuffer = SceneResourceView::GetVertexAndIndexBuffersOfMesh(args.pScene, id);
 
 			// SET MATERIAL CONSTANT BUFFER & TEXTURES
@@ -132,10 +142,22 @@ void ZPrePass::RenderDepth(const RenderParams& args) const
 	int numObj = 0;
 	for (const GameObject* pObj : args.sceneView.culledOpaqueList)
 	{
-		RenderObject(pObj);
+		RenderObject(pObj, false);
 		++numObj;
 	}
 
+	if (Engine::GetSettings().rendering.bCompactVertices)
+	{
+		args.pRenderer->SetShader(objShaderCompactVertex);
+		args.pRenderer->SetSamplerState("sNormalSampler", EDefaultSamplerState::LINEAR_FILTER_SAMPLER_WRAP_UVW);
+		args.pRenderer->BindRenderTarget(normals);
+		args.pRenderer->BindDepthTarget(ENGINE->GetWorldDepthTarget());
+		for (const GameObject* pObj : args.sceneView.culledOpaqueList)
+		{
+			RenderObject(pObj, true);
+		}
+	}
+
 
 	// RENDER INSTANCED SCENE OBJECTS
 	//
@@ -212,6 +234,13 @@ void ForwardLightingPass::Initialize(Renderer* pRenderer)
 		}
 	};
 	fwdBRDFInstanced = pRenderer->CreateShader(instancedBRDFDesc);
+
+	const ShaderDesc compactVertexBRDFDesc = { "Forward_BRDF-CompactVertex", {
+			ShaderStageDesc{"Forward_BRDF_vs.hlsl", { ShaderMacro{ "COMPACT_VERTEX", "1" } } },
+			ShaderStageDesc{"Forward_BRDF_ps.hlsl", {} }
+		}
+	};
+	fwdBRDFCompactVertex = pRenderer->CreateShader(compactVertexBRDFDesc);
 }
 
 void ForwardLightingPass::RenderLightingPass(const RenderParams& args) const
@@ -225,7 +254,8 @@ void ForwardLightingPass::RenderLightingPass(const RenderParams& args) const
 	{
 		return mesh == EGeometry::TRIANGLE || mesh == EGeometry::QUAD || mesh == EGeometry::GRID;
 	};
-	auto RenderObject = [&](const GameObject* pObj)
+	// the meshes with compact vertices are drawn in a second sweep with the COMPACT_VERTEX shader
+	auto RenderObject = [&](const GameObject* pObj, bool bCompactVertices)
 	{
 		const Transform& tf = pObj->GetTransform();
 		const ModelData& model = pObj->GetModelData();
@@ -241,8 +271,11 @@ void ForwardLightingPass::RenderLightingPass(const RenderParams& args) const
 		pRenderer->SetRasterizerState(EDefaultRasterizerState::CULL_BACK);
 
 		SurfaceMaterial material;
-		for (MeshID id : model.mMeshIDs)
+		for (MeshID id : args.sceneView.GetMeshRenderList(pObj))
 		{
+			if (SceneResourceView::HasCompactVertices(args.pScene, id) != bCompactVertices)
+				continue;
+
 			const auto IABuffer = SceneResourceView::GetVertexAndIndexBuffersOfMesh(args.pScene, id);
 
 			// SET MATERIAL CONSTANT BUFFER & TEXTURES
@@ -284,6 +317,7 @@ void ForwardLightingPass::RenderLightingPass(const RenderParams& args) const
 	pRenderer->Apply();
 
 	//if (mSelectedShader == EShaders::FORWARD_BRDF || mSelectedShader == EShaders::FORWARD_PHONG)
+	auto SetLightingResources = [&]()
 	{
 		pRenderer->SetTexture("texAmbientOcclusion", args.tSSAO);
 
@@ -314,17 +348,29 @@ void ForwardLightingPass::RenderLightingPass(const RenderParams& args) const
 		pRenderer->SetSamplerState("sLinearSampler", EDefaultSamplerState::LINEAR_FILTER_SAMPLER_WRAP_UVW);
 
 		ENGINE->SendLightData();
-	}
+	};
+	SetLightingResources();
 
 	// RENDER NON-INSTANCED SCENE OBJECTS
 	//
 	int numObj = 0;
 	for (const auto* obj : args.sceneView.culledOpaqueList)
 	{
-		RenderObject(obj);
+		RenderObject(obj, false);
 		++numObj;
 	}
 
+	if (Engine::GetSettings().rendering.bCompactVertices)
+	{
+		pRenderer->SetShader(fwdBRDFCompactVertex);
+		pRenderer->Apply();
+		SetLightingResources();
+		for (const auto* obj : args.sceneView.culledOpaqueList)
+		{
+			RenderObject(obj, true);
+		}
+	}
+
 
 
 	// RENDER INSTANCED SCENE OBJECTS
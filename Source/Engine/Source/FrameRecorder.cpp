@@ -0,0 +1,209 @@
+//	VQEngine | DirectX11 Renderer
+//	Copyright(C) 2018  - Volkan Ilbeyli
+//
+//	This program is free software : you can redistribute it and / or modify
+//	it under the terms of the GNU General Public License as published by
+//	the Free Software Foundation, either version 3 of the License, or
+//	(at your option) any later version.
+//
+//	This program is distributed in the hope that it will be useful,
+//	but WITHOUT ANY WARRANTY; without even the implied warranty of
+//	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+//	GNU General Public License for more details.
+//
+//	You should have received a copy of the GNU General Public License
+//	along with this program.If not, see <http://www.gnu.org/licenses/>.
+//
+//	Contact: volkanilbeyli@gmail.com
+
+#include "FrameRecorder.h"
+
+#include "Utilities/Log.h"
+#include "Utilities/utils.h"
+
+#include <cstring>
+
+static constexpr uint32_t FRAME_RECORDING_MAGIC   = 0x50525156;	// 'VQRP'
+static constexpr uint32_t FRAME_RECORDING_VERSION = 1;
+
+struct FrameRecordingHeader
+{
+	uint32_t magic;
+	uint32_t version;
+	uint32_t frameRecordSize;	// the frame records follow the header until the end of the file
+	uint32_t seed;
+	int32_t  level;
+};
+
+static_assert(MOUSE_BUTTON_COUNT <= 32, "FrameRecord::buttons has a bit per mouse button");
+
+
+FrameRecorder::~FrameRecorder()
+{
+	if (mRecordingFile.is_open())
+	{
+		mRecordingFile.close();
+		Log::Info("FrameRecorder: recorded %llu frames (%.2fs) into %s"
+			, static_cast<unsigned long long>(mFrameIndex), mSimulationTime, mFilePath.c_str());
+	}
+	if (mbReplay)
+	{
+		if (mNumStateMismatches > 0)
+			Log::Warning("FrameRecorder: %llu of %llu replayed frames didn't match the recording."
+				, static_cast<unsigned long long>(mNumStateMismatches), static_cast<unsigned long long>(mFrameIndex));
+		else
+			Log::Info("FrameRecorder: replayed %llu frames, all of them matched the recording."
+				, static_cast<unsigned long long>(mFrameIndex));
+	}
+}
+
+bool FrameRecorder::BeginRecording(const std::string& filePath, unsigned seed, int level)
+{
+	DirectoryUtil::CreateFolderIfItDoesntExist(DirectoryUtil::GetFolderPath(filePath));
+	mRecordingFile.open(filePath, std::ios::out | std::ios::binary | std::ios::trunc);
+	if (!mRecordingFile.is_open())
+	{
+		Log::Error("FrameRecorder: Couldn't open %s for writing.", filePath.c_str());
+		return false;
+	}
+
+	FrameRecordingHeader header;
+	header.magic = FRAME_RECORDING_MAGIC;
+	header.version = FRAME_RECORDING_VERSION;
+	header.frameRecordSize = sizeof(FrameRecord);
+	header.seed = seed;
+	header.level = level;
+	mRecordingFile.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+	mFilePath = filePath;
+	mSeed = seed;
+	mLevel = level;
+	Log::Info("FrameRecorder: recording the frames into %s (seed=%u)", filePath.c_str(), seed);
+	return mRecordingFile.good();
+}
+
+bool FrameRecorder::LoadReplay(const std::string& filePath)
+{
+	std::ifstream file(filePath, std::ios::in | std::ios::binary | std::ios::ate);
+	if (!file.is_open())
+	{
+		Log::Error("FrameRecorder: Couldn't open %s", filePath.c_str());
+		return false;
+	}
+
+	const size_t fileSize = static_cast<size_t>(file.tellg());
+	file.seekg(0);
+	FrameRecordingHeader header = {};
+	if (fileSize < sizeof(header) || !file.read(reinterpret_cast<char*>(&header), sizeof(header))
+		|| header.magic != FRAME_RECORDING_MAGIC
+		|| header.version != FRAME_RECORDING_VERSION
+		|| header.frameRecordSize != sizeof(FrameRecord))
+	{
+		Log::Error("FrameRecorder: %s isn't a frame recording of this version.", filePath.c_str());
+		return false;
+	}
+
+	const size_t numFrames = (fileSize - sizeof(header)) / sizeof(FrameRecord);
+	if ((fileSize - sizeof(header)) % sizeof(FrameRecord) != 0)
+	{	// the application didn't exit cleanly while recording
+		Log::Warning("FrameRecorder: %s is truncated, replaying the %llu complete frames.", filePath.c_str(), static_cast<unsigned long long>(numFrames));
+	}
+	mReplayFrames.resize(numFrames);
+	if (numFrames > 0 && !file.read(reinterpret_cast<char*>(mReplayFrames.data()), numFrames * sizeof(FrameRecord)))
+	{
+		Log::Error("FrameRecorder: Error reading %s", filePath.c_str());
+		return false;
+	}
+
+	mFilePath = filePath;
+	mbReplay = true;
+	mSeed = header.seed;
+	mLevel = header.level;
+	Log::Info("FrameRecorder: replaying %llu frames of %s (seed=%u)", static_cast<unsigned long long>(numFrames), filePath.c_str(), mSeed);
+	return true;
+}
+
+float FrameRecorder::BeginFrame(Input& input, float dt)
+{
+	if (!mbReplay)
+	{
+		Pack(input.GetState(), dt, mCurrentFrame);
+		mSimulationTime += dt;
+		return dt;
+	}
+
+	if (IsReplayFinished())
+	{	// nothing left to replay: the frames run w/o input
+		FrameRecord emptyFrame = {};
+		emptyFrame.dt = dt;
+		input.SetState(Unpack(emptyFrame));
+		mSimulationTime += dt;
+		return dt;
+	}
+
+	const FrameRecord& record = mReplayFrames[mFrameIndex];
+	input.SetState(Unpack(record));
+	mSimulationTime += record.dt;
+	return record.dt;
+}
+
+void FrameRecorder::EndFrame(uint64_t stateHash)
+{
+	if (!mbReplay)
+	{
+		mCurrentFrame.stateHash = stateHash;
+		mRecordingFile.write(reinterpret_cast<const char*>(&mCurrentFrame), sizeof(mCurrentFrame));
+		++mFrameIndex;
+		return;
+	}
+
+	if (IsReplayFinished())
+		return;
+
+	if (mReplayFrames[mFrameIndex].stateHash != stateHash)
+	{
+		if (mNumStateMismatches == 0)	// the following frames are likely to diverge as well
+			Log::Warning("FrameRecorder: replayed frame %llu doesn't match the recording: the camera or the culling results differ."
+				, static_cast<unsigned long long>(mFrameIndex));
+		++mNumStateMismatches;
+	}
+	++mFrameIndex;
+}
+
+void FrameRecorder::Pack(const Input::State& state, float dt, FrameRecord& outRecord)
+{
+	outRecord = {};
+	outRecord.dt = dt;
+	for (int key = 0; key < KEY_COUNT; ++key)
+	{
+		if (state.keys[key])     outRecord.keys[key / 8]     |= 1 << (key % 8);
+		if (state.prevKeys[key]) outRecord.prevKeys[key / 8] |= 1 << (key % 8);
+	}
+	for (int button = 0; button < MOUSE_BUTTON_COUNT; ++button)
+	{
+		if (state.buttons[button]) outRecord.buttons |= 1u << button;
+	}
+	outRecord.mouseDelta[0] = static_cast<int32_t>(state.mouseDelta[0]);
+	outRecord.mouseDelta[1] = static_cast<int32_t>(state.mouseDelta[1]);
+	outRecord.mouseScroll = state.mouseScroll;
+	outRecord.bIgnoreInput = state.bIgnoreInput ? 1 : 0;
+}
+
+Input::State FrameRecorder::Unpack(const FrameRecord& record)
+{
+	Input::State state;
+	for (int key = 0; key < KEY_COUNT; ++key)
+	{
+		state.keys[key]     = (record.keys[key / 8]     & (1 << (key % 8))) != 0;
+		state.prevKeys[key] = (record.prevKeys[key / 8] & (1 << (key % 8))) != 0;
+	}
+	for (int button = 0; button < MOUSE_BUTTON_COUNT; ++button)
+	{
+		state.buttons[button] = (record.buttons & (1u << button)) != 0;
+	}
+	state.mouseDelta[0] = record.mouseDelta[0];
+	state.mouseDelta[1] = record.mouseDelta[1];
+	state.mouseScroll = record.mouseScroll;
+	state.bIgnoreInput = record.bIgnoreInput != 0;
+	return state;
+}
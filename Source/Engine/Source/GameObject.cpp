@@ -24,6 +24,8 @@
 
 #include "Engine.h"
 
+#include <cassert>
+
 GameObject::GameObject(Scene* pScene) : mpScene(pScene) {};
 
 void GameObject::AddMesh(MeshID meshID)
@@ -73,6 +75,7 @@ void GameObject::RenderTransparent(
 	for(MeshID id : mModel.mData.mTransparentMeshIDs)
 	{
 		const auto IABuffer = SceneResourceView::GetVertexAndIndexBuffersOfMesh(mpScene, id);
+		assert(!SceneResourceView::HasCompactVertices(mpScene, id));	// transparent meshes use the default vertex layout, see CreateModelResources()
 
 		// SET MATERIAL CONSTANTS
 		if (UploadMaterialDataToGPU)
@@ -84,6 +84,10 @@ EMaterialType GetMaterialType(MaterialID matID)
 	//return EMaterialType::MATERIAL_TYPE_COUNT;
 	return matID.ID & TYPE_MASK ? EMaterialType::BLINN_PHONG : EMaterialType::GGX_BRDF;
 }
+EMaterialType MaterialID::GetType() const
+{
+	return GetMaterialType(*this);
+}
 
 
 BlinnPhong_Material MaterialPool::RandomBlinnPhongMaterial(MaterialID matID)
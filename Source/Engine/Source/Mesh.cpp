@@ -17,6 +17,42 @@
 //	Contact: volkanilbeyli@gmail.com
 
 #include "Mesh.h"
+#include "Renderer/Renderer.h"
 #include "Utilities/Log.h"
 
 Renderer* Mesh::spRenderer = nullptr;
+
+Mesh::Mesh(const Mesh& mesh, const unsigned* pIndices, size_t numIndices, const std::string& name)
+	: mVertexBufferID(mesh.mVertexBufferID)
+	, mLocalAABB(mesh.mLocalAABB)
+	, mMeshName(name)
+	, mNumVertices(mesh.mNumVertices)
+	, mVertexStride(mesh.mVertexStride)
+	, mbCompactVertices(mesh.mbCompactVertices)
+	, mbSharedVertexBuffer(true)
+{
+	CreateIndexBuffer(pIndices, numIndices, mNumVertices);
+}
+
+void Mesh::CreateIndexBuffer(const unsigned* pIndices, size_t numIndices, size_t numVertices)
+{
+	BufferDesc bufferDesc = {};
+	bufferDesc.mType = INDEX_BUFFER;
+	bufferDesc.mUsage = GPU_READ_WRITE;
+	bufferDesc.mElementCount = static_cast<unsigned>(numIndices);
+	if (numVertices <= MAX_VERTICES_16BIT_INDICES)
+	{
+		std::vector<uint16_t> indices16(numIndices);
+		for (size_t i = 0; i < numIndices; ++i)
+			indices16[i] = static_cast<uint16_t>(pIndices[i]);
+		bufferDesc.mStride = sizeof(uint16_t);
+		mIndexBufferID = spRenderer->CreateBuffer(bufferDesc, indices16.data());
+	}
+	else
+	{
+		bufferDesc.mStride = sizeof(unsigned);
+		mIndexBufferID = spRenderer->CreateBuffer(bufferDesc, pIndices);
+	}
+	mNumIndices = numIndices;
+	mIndexStride = bufferDesc.mStride;
+}
@@ -0,0 +1,589 @@
+//	VQEngine | DirectX11 Renderer
+//	Copyright(C) 2018  - Volkan Ilbeyli
+//
+//	This program is free software : you can redistribute it and / or modify
+//	it under the terms of the GNU General Public License as published by
+//	the Free Software Foundation, either version 3 of the License, or
+//	(at your option) any later version.
+//
+//	This program is distributed in the hope that it will be useful,
+//	but WITHOUT ANY WARRANTY; without even the implied warranty of
+//	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+//	GNU General Public License for more details.
+//
+//	You should have received a copy of the GNU General Public License
+//	along with this program.If not, see <http://www.gnu.org/licenses/>.
+//
+//	Contact: volkanilbeyli@gmail.com
+
+#include "MeshOptimizer.h"
+
+#include <algorithm>
+#include <array>
+#include <unordered_map>
+#include <cmath>
+#include <cfloat>
+#include <cstring>
+#include <cstdint>
+#include <cassert>
+
+// Scoring parameters from Tom Forsyth's "Linear-Speed Vertex Cache Optimisation"
+static constexpr size_t FORSYTH_CACHE_SIZE     = 32;	// LRU cache modeled while ordering the triangles
+static constexpr float  FORSYTH_CACHE_DECAY    = 1.5f;
+static constexpr float  FORSYTH_LAST_TRI_SCORE = 0.75f;	// vertices of the last triangle score a bit lower so we don't keep fanning around them
+static constexpr float  FORSYTH_VALENCE_SCALE  = 2.0f;
+static constexpr float  FORSYTH_VALENCE_POWER  = 0.5f;
+static constexpr size_t FORSYTH_MAX_VALENCE    = 32;	// vertices with more triangles left than this score the same
+
+static constexpr unsigned INVALID_INDEX = 0xFFFFFFFF;
+
+struct ForsythScoreTables
+{
+	float cache[FORSYTH_CACHE_SIZE];
+	float valence[FORSYTH_MAX_VALENCE];
+
+	ForsythScoreTables()
+	{
+		for (size_t i = 0; i < FORSYTH_CACHE_SIZE; ++i)
+		{
+			cache[i] = i < 3
+				? FORSYTH_LAST_TRI_SCORE
+				: powf(1.0f - static_cast<float>(i - 3) / (FORSYTH_CACHE_SIZE - 3), FORSYTH_CACHE_DECAY);
+		}
+		valence[0] = 0.0f;
+		for (size_t i = 1; i < FORSYTH_MAX_VALENCE; ++i)
+			valence[i] = FORSYTH_VALENCE_SCALE * powf(static_cast<float>(i), -FORSYTH_VALENCE_POWER);
+	}
+};
+
+static inline float GetVertexScore(const ForsythScoreTables& tables, int cachePosition, unsigned numRemainingTriangles)
+{
+	if (numRemainingTriangles == 0)
+		return -1.0f;	// no triangles left to emit, doesn't matter where it is in the cache
+
+	const float cacheScore = cachePosition >= 0 ? tables.cache[cachePosition] : 0.0f;
+	return cacheScore + tables.valence[std::min<size_t>(numRemainingTriangles, FORSYTH_MAX_VALENCE - 1)];
+}
+
+
+VertexCacheStats MeshOptimizer::AnalyzeVertexCache(const unsigned* pIndices, size_t numIndices, size_t numVertices, size_t cacheSize /*= ANALYSIS_CACHE_SIZE*/)
+{
+	VertexCacheStats stats = {};
+	stats.numTriangles = numIndices / 3;
+
+	// a vertex is in the FIFO if it was inserted less than cacheSize insertions ago
+	std::vector<size_t> insertionTime(numVertices, 0);
+	std::vector<bool> bReferenced(numVertices, false);
+	size_t time = cacheSize + 1;
+	for (size_t i = 0; i < numIndices; ++i)
+	{
+		const unsigned v = pIndices[i];
+		assert(v < numVertices);
+		if (time - insertionTime[v] > cacheSize)
+		{
+			insertionTime[v] = time++;
+			++stats.numTransformed;
+		}
+		if (!bReferenced[v])
+		{
+			bReferenced[v] = true;
+			++stats.numVertices;
+		}
+	}
+	return stats;
+}
+
+void MeshOptimizer::OptimizeVertexCache(unsigned* pIndices, size_t numIndices, size_t numVertices)
+{
+	const size_t numTriangles = numIndices / 3;
+	if (numTriangles == 0)
+		return;
+
+	static const ForsythScoreTables sTables;
+	const std::vector<unsigned> indices(pIndices, pIndices + numTriangles * 3);
+
+	// VERTEX -> TRIANGLE ADJACENCY
+	//
+	// the triangles of vertex v are adjacency[adjacencyOffsets[v], adjacencyOffsets[v] + numRemaining[v]),
+	// emitted triangles are swapped out of the end of the range.
+	//
+	std::vector<unsigned> numRemaining(numVertices, 0);
+	for (unsigned v : indices)
+	{
+		assert(v < numVertices);
+		++numRemaining[v];
+	}
+
+	std::vector<unsigned> adjacencyOffsets(numVertices + 1, 0);
+	for (size_t v = 0; v < numVertices; ++v)
+		adjacencyOffsets[v + 1] = adjacencyOffsets[v] + numRemaining[v];
+
+	std::vector<unsigned> adjacency(indices.size());
+	{
+		std::vector<unsigned> fillPositions(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+		for (size_t i = 0; i < indices.size(); ++i)
+			adjacency[fillPositions[indices[i]]++] = static_cast<unsigned>(i / 3);
+	}
+
+	// INITIAL SCORES
+	//
+	std::vector<int>   cachePositions(numVertices, -1);
+	std::vector<float> vertexScores(numVertices);
+	for (size_t v = 0; v < numVertices; ++v)
+		vertexScores[v] = GetVertexScore(sTables, -1, numRemaining[v]);
+
+	std::vector<float> triangleScores(numTriangles);
+	std::vector<bool>  bEmitted(numTriangles, false);
+	unsigned bestTriangle = INVALID_INDEX;
+	float bestScore = -1.0f;
+	for (size_t t = 0; t < numTriangles; ++t)
+	{
+		const unsigned* tri = &indices[t * 3];
+		triangleScores[t] = vertexScores[tri[0]] + vertexScores[tri[1]] + vertexScores[tri[2]];
+		if (triangleScores[t] > bestScore)
+		{
+			bestScore = triangleScores[t];
+			bestTriangle = static_cast<unsigned>(t);
+		}
+	}
+
+	// EMIT TRIANGLES
+	//
+	std::array<unsigned, FORSYTH_CACHE_SIZE + 3> cache, newCache;
+	size_t cacheCount = 0;
+	size_t nextDeadEndCandidate = 0;
+	unsigned* pOutput = pIndices;
+	for (size_t numEmitted = 0; numEmitted < numTriangles; ++numEmitted)
+	{
+		if (bestTriangle == INVALID_INDEX)
+		{
+			// dead end: the cached vertices have no triangles left, continue with the next triangle in input order
+			while (bEmitted[nextDeadEndCandidate])
+				++nextDeadEndCandidate;
+			bestTriangle = static_cast<unsigned>(nextDeadEndCandidate);
+		}
+
+		const unsigned* tri = &indices[bestTriangle * 3];
+		*pOutput++ = tri[0];
+		*pOutput++ = tri[1];
+		*pOutput++ = tri[2];
+		bEmitted[bestTriangle] = true;
+
+		// remove the triangle from the adjacency of its vertices
+		for (int k = 0; k < 3; ++k)
+		{
+			const unsigned v = tri[k];
+			unsigned* pTriangles = &adjacency[adjacencyOffsets[v]];
+			const unsigned n = numRemaining[v];
+			for (unsigned i = 0; i < n; ++i)
+			{
+				if (pTriangles[i] == bestTriangle)
+				{
+					std::swap(pTriangles[i], pTriangles[n - 1]);
+					--numRemaining[v];
+					break;
+				}
+			}
+		}
+
+		// move the vertices of the triangle to the front of the LRU cache
+		size_t newCacheCount = 0;
+		for (int k = 0; k < 3; ++k)
+		{
+			if (std::find(newCache.begin(), newCache.begin() + newCacheCount, tri[k]) == newCache.begin() + newCacheCount)
+				newCache[newCacheCount++] = tri[k];	// degenerate triangles repeat vertices
+		}
+		for (size_t i = 0; i < cacheCount; ++i)
+		{
+			const unsigned v = cache[i];
+			if (v != tri[0] && v != tri[1] && v != tri[2])
+				newCache[newCacheCount++] = v;
+		}
+
+		// update the vertex scores, vertices past the cache size were just evicted
+		for (size_t i = 0; i < newCacheCount; ++i)
+		{
+			const unsigned v = newCache[i];
+			cachePositions[v] = i < FORSYTH_CACHE_SIZE ? static_cast<int>(i) : -1;
+			vertexScores[v] = GetVertexScore(sTables, cachePositions[v], numRemaining[v]);
+		}
+		cacheCount = std::min(newCacheCount, FORSYTH_CACHE_SIZE);
+		std::copy(newCache.begin(), newCache.begin() + cacheCount, cache.begin());
+
+		// only the triangles of the updated vertices changed score, pick the next triangle among them
+		bestTriangle = INVALID_INDEX;
+		bestScore = -1.0f;
+		for (size_t i = 0; i < newCacheCount; ++i)
+		{
+			const unsigned v = newCache[i];
+			const unsigned* pTriangles = &adjacency[adjacencyOffsets[v]];
+			for (unsigned j = 0; j < numRemaining[v]; ++j)
+			{
+				const unsigned t = pTriangles[j];
+				const unsigned* adjTri = &indices[t * 3];
+				triangleScores[t] = vertexScores[adjTri[0]] + vertexScores[adjTri[1]] + vertexScores[adjTri[2]];
+				if (triangleScores[t] > bestScore)
+				{
+					bestScore = triangleScores[t];
+					bestTriangle = t;
+				}
+			}
+		}
+	}
+}
+
+std::vector<unsigned> MeshOptimizer::GetVertexFetchRemap(const unsigned* pIndices, size_t numIndices, size_t numVertices)
+{
+	std::vector<unsigned> remap(numVertices, INVALID_INDEX);
+	unsigned nextVertex = 0;
+	for (size_t i = 0; i < numIndices; ++i)
+	{
+		const unsigned v = pIndices[i];
+		assert(v < numVertices);
+		if (remap[v] == INVALID_INDEX)
+			remap[v] = nextVertex++;
+	}
+	for (size_t v = 0; v < numVertices; ++v)
+	{
+		if (remap[v] == INVALID_INDEX)
+			remap[v] = nextVertex++;
+	}
+	return remap;
+}
+
+bool MeshOptimizer::IsSameTriangleList(const unsigned* pIndices, const unsigned* pOptimizedIndices, size_t numIndices, const unsigned* pRemap /*= nullptr*/)
+{
+	using Triangle = std::array<unsigned, 3>;
+
+	// rotate the smallest index to the front: same triangle, same winding
+	auto fnGetSortedTriangles = [numIndices](const unsigned* pIndices, const unsigned* pRemap)
+	{
+		std::vector<Triangle> triangles(numIndices / 3);
+		for (size_t t = 0; t < triangles.size(); ++t)
+		{
+			Triangle tri;
+			for (int k = 0; k < 3; ++k)
+				tri[k] = pRemap ? pRemap[pIndices[t * 3 + k]] : pIndices[t * 3 + k];
+			std::rotate(tri.begin(), std::min_element(tri.begin(), tri.end()), tri.end());
+			triangles[t] = tri;
+		}
+		std::sort(triangles.begin(), triangles.end());
+		return triangles;
+	};
+	return fnGetSortedTriangles(pIndices, pRemap) == fnGetSortedTriangles(pOptimizedIndices, nullptr);
+}
+
+
+//----------------------------------------------------------------------------------------------------------------
+// SIMPLIFICATION
+//----------------------------------------------------------------------------------------------------------------
+static constexpr double SIMPLIFY_MIN_NORMAL_DOT = 0.25;	// collapses that turn a triangle more than ~75 degrees are rejected
+static constexpr double SIMPLIFY_MIN_AREA_RATIO = 1e-3;	// collapses that squash a triangle into a sliver are rejected
+
+// Sum of the squared distances to the planes of the triangles around a vertex, weighted by triangle area
+//
+struct Quadric
+{
+	double a00, a11, a22, a01, a02, a12;	// symmetric 3x3: n * n^T
+	double b0, b1, b2;						// n * d
+	double c;								// d * d
+	double weight;							// area of the planes, normalizes the error to a squared distance
+
+	inline void AddPlane(const double n[3], double d, double w)
+	{
+		a00 += w * n[0] * n[0]; a11 += w * n[1] * n[1]; a22 += w * n[2] * n[2];
+		a01 += w * n[0] * n[1]; a02 += w * n[0] * n[2]; a12 += w * n[1] * n[2];
+		b0 += w * n[0] * d; b1 += w * n[1] * d; b2 += w * n[2] * d;
+		c += w * d * d;
+		weight += w;
+	}
+	inline Quadric& operator+=(const Quadric& q)
+	{
+		a00 += q.a00; a11 += q.a11; a22 += q.a22; a01 += q.a01; a02 += q.a02; a12 += q.a12;
+		b0 += q.b0; b1 += q.b1; b2 += q.b2; c += q.c; weight += q.weight;
+		return *this;
+	}
+	inline double GetError(const std::array<float, 3>& p) const
+	{
+		const double x = p[0], y = p[1], z = p[2];
+		const double e = a00 * x * x + a11 * y * y + a22 * z * z
+			+ 2.0 * (a01 * x * y + a02 * x * z + a12 * y * z)
+			+ 2.0 * (b0 * x + b1 * y + b2 * z)
+			+ c;
+		return weight > 0.0 ? fabs(e) / weight : 0.0;
+	}
+};
+
+using Position = std::array<float, 3>;
+
+static inline std::array<double, 3> GetTriangleNormal(const Position& p0, const Position& p1, const Position& p2)	// not normalized
+{
+	const double e0[3] = { p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2] };
+	const double e1[3] = { p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2] };
+	return { e0[1] * e1[2] - e0[2] * e1[1], e0[2] * e1[0] - e0[0] * e1[2], e0[0] * e1[1] - e0[1] * e1[0] };
+}
+
+struct PositionHasher
+{
+	size_t operator()(const Position& p) const
+	{
+		uint32_t bits[3];
+		memcpy(bits, p.data(), sizeof(bits));
+		return (bits[0] * 73856093u) ^ (bits[1] * 19349663u) ^ (bits[2] * 83492791u);
+	}
+};
+
+std::vector<unsigned> MeshOptimizer::SimplifyMesh(
+	const float* pPositions, size_t positionStride, size_t numVertices,
+	const unsigned* pIndices, size_t numIndices,
+	size_t targetNumIndices, float maxError, float* pOutError /*= nullptr*/
+)
+{
+	std::vector<unsigned> indices(pIndices, pIndices + numIndices);
+	if (pOutError) *pOutError = 0.0f;
+	if (numVertices == 0 || numIndices <= targetNumIndices)
+		return indices;
+
+	// positions scaled into the unit cube so the error is relative to the size of the mesh
+	std::vector<Position> positions(numVertices);
+	Position lo = { FLT_MAX, FLT_MAX, FLT_MAX };
+	Position hi = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+	for (size_t v = 0; v < numVertices; ++v)
+	{
+		const float* p = reinterpret_cast<const float*>(reinterpret_cast<const char*>(pPositions) + v * positionStride);
+		for (int k = 0; k < 3; ++k)
+		{
+			positions[v][k] = p[k];
+			lo[k] = std::min(lo[k], p[k]);
+			hi[k] = std::max(hi[k], p[k]);
+		}
+	}
+	const float extent = std::max(hi[0] - lo[0], std::max(hi[1] - lo[1], hi[2] - lo[2]));
+	const float scale = extent > 0.0f ? 1.0f / extent : 0.0f;
+	for (Position& p : positions)
+		for (int k = 0; k < 3; ++k)
+			p[k] = (p[k] - lo[k]) * scale;
+
+	// vertices sharing a position: the first one of each position stands for the others
+	std::vector<unsigned> positionVertex(numVertices);
+	std::vector<unsigned> numVerticesAtPosition(numVertices, 0);
+	{
+		std::unordered_map<Position, unsigned, PositionHasher> positionLookup;
+		positionLookup.reserve(numVertices);
+		for (size_t v = 0; v < numVertices; ++v)
+		{
+			positionVertex[v] = positionLookup.emplace(positions[v], static_cast<unsigned>(v)).first->second;
+			++numVerticesAtPosition[positionVertex[v]];
+		}
+	}
+
+	// lock the seams, the open borders and the non-manifold edges: an edge is on the border if the
+	// opposite half edge doesn't exist, and non-manifold if the same half edge is there more than once.
+	std::vector<bool> bLockedPosition(numVertices, false);
+	{
+		auto fnHalfEdgeKey = [](unsigned v0, unsigned v1) { return (static_cast<uint64_t>(v0) << 32) | v1; };
+		std::unordered_map<uint64_t, unsigned> halfEdgeCounts;
+		halfEdgeCounts.reserve(numIndices);
+		for (size_t i = 0; i < numIndices; i += 3)
+			for (size_t k = 0; k < 3; ++k)
+				++halfEdgeCounts[fnHalfEdgeKey(positionVertex[indices[i + k]], positionVertex[indices[i + (k + 1) % 3]])];
+
+		for (size_t i = 0; i < numIndices; i += 3)
+		{
+			for (size_t k = 0; k < 3; ++k)
+			{
+				const unsigned v0 = positionVertex[indices[i + k]];
+				const unsigned v1 = positionVertex[indices[i + (k + 1) % 3]];
+				const auto itOpposite = halfEdgeCounts.find(fnHalfEdgeKey(v1, v0));
+				if (itOpposite == halfEdgeCounts.end() || itOpposite->second > 1 || halfEdgeCounts.at(fnHalfEdgeKey(v0, v1)) > 1)
+					bLockedPosition[v0] = bLockedPosition[v1] = true;
+			}
+		}
+		for (size_t v = 0; v < numVertices; ++v)
+			if (numVerticesAtPosition[v] > 1)
+				bLockedPosition[v] = true;
+	}
+	auto fnIsLocked = [&](unsigned v) { return bLockedPosition[positionVertex[v]]; };
+
+	// plane quadrics, accumulated per position
+	std::vector<Quadric> quadrics(numVertices, Quadric{});
+	for (size_t i = 0; i < numIndices; i += 3)
+	{
+		const Position& p0 = positions[indices[i + 0]];
+		std::array<double, 3> n = GetTriangleNormal(p0, positions[indices[i + 1]], positions[indices[i + 2]]);
+		const double length = sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+		if (length == 0.0)
+			continue;
+		for (double& x : n) x /= length;
+		const double d = -(n[0] * p0[0] + n[1] * p0[1] + n[2] * p0[2]);
+		for (size_t k = 0; k < 3; ++k)
+			quadrics[positionVertex[indices[i + k]]].AddPlane(n.data(), d, 0.5 * length);
+	}
+
+	// normals of the source triangles around each position. A collapse can turn a triangle a little at a time over
+	// several passes, so besides its previous state the collapsed triangle has to face at least one of the source
+	// triangles at its corners, otherwise it folded over the surface it replaces.
+	std::vector<unsigned> sourceNormalOffsets(numVertices + 1, 0);
+	std::vector<std::array<double, 3>> sourceNormals(numIndices);
+	{
+		for (size_t i = 0; i < numIndices; ++i)
+			++sourceNormalOffsets[positionVertex[indices[i]] + 1];
+		for (size_t v = 0; v < numVertices; ++v)
+			sourceNormalOffsets[v + 1] += sourceNormalOffsets[v];
+		std::vector<unsigned> writeOffsets(sourceNormalOffsets.begin(), sourceNormalOffsets.end() - 1);
+		for (size_t i = 0; i < numIndices; i += 3)
+		{
+			const std::array<double, 3> n = GetTriangleNormal(positions[indices[i + 0]], positions[indices[i + 1]], positions[indices[i + 2]]);
+			for (size_t k = 0; k < 3; ++k)
+				sourceNormals[writeOffsets[positionVertex[indices[i + k]]]++] = n;
+		}
+	}
+	auto fnFacesSourceSurface = [&](const std::array<double, 3>& n, const unsigned tri[3])
+	{
+		for (int k = 0; k < 3; ++k)
+		{
+			const unsigned position = positionVertex[tri[k]];
+			for (unsigned i = sourceNormalOffsets[position]; i < sourceNormalOffsets[position + 1]; ++i)
+				if (n[0] * sourceNormals[i][0] + n[1] * sourceNormals[i][1] + n[2] * sourceNormals[i][2] > 0.0)
+					return true;
+		}
+		return false;
+	};
+
+	// each pass collapses the cheapest edges of the current index buffer, at most one collapse
+	// per vertex so the candidates computed at the beginning of the pass stay valid.
+	struct Collapse
+	{
+		unsigned v0, v1;	// v0 moves onto v1
+		double error;
+	};
+	const double maxSquaredError = static_cast<double>(maxError) * maxError;
+	double resultError = 0.0;
+	std::vector<unsigned> collapseTarget(numVertices);
+	std::vector<bool> bCollapsedThisPass(numVertices);
+	std::vector<unsigned> triangleOffsets(numVertices + 1);
+	std::vector<unsigned> triangles;
+	std::vector<Collapse> collapses;
+	while (indices.size() > targetNumIndices)
+	{
+		const size_t numTriangles = indices.size() / 3;
+
+		// triangles around each vertex
+		std::fill(triangleOffsets.begin(), triangleOffsets.end(), 0);
+		for (unsigned v : indices)
+			++triangleOffsets[v + 1];
+		for (size_t v = 0; v < numVertices; ++v)
+			triangleOffsets[v + 1] += triangleOffsets[v];
+		triangles.resize(indices.size());
+		{
+			std::vector<unsigned> writeOffsets(triangleOffsets.begin(), triangleOffsets.end() - 1);
+			for (size_t i = 0; i < indices.size(); ++i)
+				triangles[writeOffsets[indices[i]]++] = static_cast<unsigned>(i / 3);
+		}
+
+		// cheapest collapse of each vertex that can move
+		collapses.clear();
+		{
+			std::vector<Collapse> bestCollapses(numVertices, Collapse{ INVALID_INDEX, INVALID_INDEX, DBL_MAX });
+			for (size_t i = 0; i < indices.size(); i += 3)
+			{
+				for (size_t k = 0; k < 3; ++k)
+				{
+					const unsigned v0 = indices[i + k];
+					if (fnIsLocked(v0))
+						continue;
+					for (size_t j = 1; j < 3; ++j)
+					{
+						const unsigned v1 = indices[i + (k + j) % 3];
+						Quadric q = quadrics[v0];
+						q += quadrics[positionVertex[v1]];
+						const double error = q.GetError(positions[v1]);
+						if (error < bestCollapses[v0].error)
+							bestCollapses[v0] = Collapse{ v0, v1, error };
+					}
+				}
+			}
+			for (const Collapse& c : bestCollapses)
+				if (c.v0 != INVALID_INDEX && c.error <= maxSquaredError)
+					collapses.push_back(c);
+		}
+		std::sort(collapses.begin(), collapses.end(), [](const Collapse& c0, const Collapse& c1) { return c0.error < c1.error; });
+
+		for (size_t v = 0; v < numVertices; ++v)
+			collapseTarget[v] = static_cast<unsigned>(v);
+		std::fill(bCollapsedThisPass.begin(), bCollapsedThisPass.end(), false);
+
+		const size_t numTargetTriangles = targetNumIndices / 3;
+		size_t numRemainingTriangles = numTriangles;
+		size_t numCollapses = 0;
+		for (const Collapse& c : collapses)
+		{
+			if (numRemainingTriangles <= numTargetTriangles)
+				break;
+			if (bCollapsedThisPass[c.v0] || bCollapsedThisPass[c.v1])
+				continue;
+
+			// reject the collapse if it flips a triangle that doesn't collapse with the edge
+			bool bFlips = false;
+			size_t numCollapsedTriangles = 0;
+			for (unsigned t = triangleOffsets[c.v0]; t < triangleOffsets[c.v0 + 1] && !bFlips; ++t)
+			{
+				const unsigned* pTriangle = &indices[triangles[t] * 3];
+				const unsigned tri[3] = { collapseTarget[pTriangle[0]], collapseTarget[pTriangle[1]], collapseTarget[pTriangle[2]] };
+				if (tri[0] == tri[1] || tri[1] == tri[2] || tri[0] == tri[2])
+					continue;	// collapsed earlier in the pass
+				if (tri[0] == c.v1 || tri[1] == c.v1 || tri[2] == c.v1)
+				{
+					++numCollapsedTriangles;
+					continue;
+				}
+
+				Position p[3], pCollapsed[3];
+				unsigned triCollapsed[3];
+				for (int k = 0; k < 3; ++k)
+				{
+					triCollapsed[k] = tri[k] == c.v0 ? c.v1 : tri[k];
+					p[k] = positions[tri[k]];
+					pCollapsed[k] = positions[triCollapsed[k]];
+				}
+				const std::array<double, 3> n0 = GetTriangleNormal(p[0], p[1], p[2]);
+				const std::array<double, 3> n1 = GetTriangleNormal(pCollapsed[0], pCollapsed[1], pCollapsed[2]);
+				const double dot = n0[0] * n1[0] + n0[1] * n1[1] + n0[2] * n1[2];
+				const double length0 = sqrt(n0[0] * n0[0] + n0[1] * n0[1] + n0[2] * n0[2]);
+				const double length1 = sqrt(n1[0] * n1[0] + n1[1] * n1[1] + n1[2] * n1[2]);
+				bFlips = dot <= SIMPLIFY_MIN_NORMAL_DOT * length0 * length1
+					|| length1 < SIMPLIFY_MIN_AREA_RATIO * length0
+					|| !fnFacesSourceSurface(n1, triCollapsed);
+			}
+			if (bFlips)
+				continue;
+
+			collapseTarget[c.v0] = c.v1;
+			quadrics[positionVertex[c.v1]] += quadrics[c.v0];
+			bCollapsedThisPass[c.v0] = bCollapsedThisPass[c.v1] = true;
+			numRemainingTriangles -= std::min(numCollapsedTriangles, numRemainingTriangles);
+			resultError = std::max(resultError, c.error);
+			++numCollapses;
+		}
+		if (numCollapses == 0)
+			break;
+
+		// apply the collapses and drop the degenerate triangles
+		size_t numWritten = 0;
+		for (size_t i = 0; i < indices.size(); i += 3)
+		{
+			const unsigned v0 = collapseTarget[indices[i + 0]];
+			const unsigned v1 = collapseTarget[indices[i + 1]];
+			const unsigned v2 = collapseTarget[indices[i + 2]];
+			if (v0 == v1 || v1 == v2 || v0 == v2)
+				continue;
+			indices[numWritten++] = v0;
+			indices[numWritten++] = v1;
+			indices[numWritten++] = v2;
+		}
+		indices.resize(numWritten);
+	}
+
+	if (pOutError) *pOutError = static_cast<float>(sqrt(resultError));
+	return indices;
+}
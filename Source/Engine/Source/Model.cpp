@@ -17,9 +17,11 @@
 //	Contact: volkanilbeyli@gmail.com
 
 #include "Model.h"
+#include "MeshOptimizer.h"
 #include "Renderer/GeometryGenerator.h"
 
 #include <thread>
+#include <limits>
 
 #if _DEBUG
 #include "Utilities/Log.h"
@@ -58,6 +60,7 @@ Model::Model(const std::string& directoryFullPath, const std::string & modelName
 	mData.mMeshIDs = std::move(modelDataIn.mMeshIDs);
 	mData.mMaterialLookupPerMesh = std::move(modelDataIn.mMaterialLookupPerMesh);
 	mData.mTransparentMeshIDs = std::move(modelDataIn.mTransparentMeshIDs);
+	mData.mLODLookupPerMesh = std::move(modelDataIn.mLODLookupPerMesh);
 	mbLoaded = true;
 }
 
@@ -68,8 +71,10 @@ Model::Model(const std::string& directoryFullPath, const std::string & modelName
 #include "Utilities/PerfTimer.h"
 
 #include "Renderer/Renderer.h"
+#include "Renderer/VertexQuantization.h"
 
 #include "Scene.h"
+#include "ModelCache.h"
 
 #include <assimp/Importer.hpp>
 #include <assimp/scene.h>
@@ -78,42 +83,164 @@ Model::Model(const std::string& directoryFullPath, const std::string & modelName
 #include "Engine.h"
 
 #include <functional>
+#include <algorithm>
+#include <map>
+#include <tuple>
+#include <cstring>
 
 
 const char* ModelLoader::sRootFolderModels = "Data/Models/";
 
 using namespace Assimp;
-using fnTypeProcessNode = std::function<ModelData(aiNode* const, const aiScene*, std::vector<Mesh>&)>;
-using fnTypeProcessMesh = std::function<Mesh(aiMesh*, const aiScene*)>;
+
+
+bool Model::RunModelDataTests()
+{
+	// two meshes, the second one transparent, the first one with two LODs sharing its material
+	ModelData data;
+	data.mMeshIDs = { 0, 1 };
+	data.mTransparentMeshIDs = { 1 };
+	data.mMaterialLookupPerMesh = { { 0, { 10 } }, { 1, { 11 } }, { 2, { 10 } }, { 3, { 10 } } };
+	data.mLODLookupPerMesh = { { 0, { 2, 3 } } };
+	const ModelData expected = data;
+
+	const Model model("", "TestModel", std::move(data));
+	bool bPassed = true;
+	auto fnCheck = [&](bool bCondition, const char* pMember)
+	{
+		if (bCondition) return;
+		Log::Error("Model: %s isn't carried over from the model data", pMember);
+		bPassed = false;
+	};
+	fnCheck(model.mData.mMeshIDs == expected.mMeshIDs, "mMeshIDs");
+	fnCheck(model.mData.mTransparentMeshIDs == expected.mTransparentMeshIDs, "mTransparentMeshIDs");
+	fnCheck(std::all_of(expected.mMaterialLookupPerMesh.begin(), expected.mMaterialLookupPerMesh.end(), [&](const std::pair<const MeshID, MaterialID>& entry)
+	{
+		const auto it = model.mData.mMaterialLookupPerMesh.find(entry.first);
+		return it != model.mData.mMaterialLookupPerMesh.end() && it->second.ID == entry.second.ID;
+	}), "mMaterialLookupPerMesh");
+	fnCheck(model.mData.HasLODs() && model.mData.mLODLookupPerMesh == expected.mLODLookupPerMesh, "mLODLookupPerMesh");
+	return bPassed;
+}
 
 
 //----------------------------------------------------------------------------------------------------------------
 // ASSIMP HELPER FUNCTIONS
 //----------------------------------------------------------------------------------------------------------------
-std::vector<TextureID> LoadMaterialTextures(
-	aiMaterial*			pMaterial, 
-	aiTextureType		type, 
-	const std::string&	textureName, 
-	Renderer*			mpRenderer, 
-	const std::string&	modelDirectory
-)
+// The assimp scene is flattened into ImportedModelData on the CPU, which is what the model cache
+// stores. The GPU resources are created from that data in CreateModelResources() regardless of
+// whether it comes from assimp or from the cache.
+//
+static uint32_t ImportMaterialTexture(aiMaterial* pMaterial, aiTextureType type, ImportedModelData& model)
+{
+	assert(pMaterial->GetTextureCount(type) <= 1);
+	if (pMaterial->GetTextureCount(type) == 0)
+		return ModelMaterialDesc::NO_TEXTURE;
+
+	aiString str;
+	pMaterial->GetTexture(type, 0, &str);
+	return model.AddString(str.C_Str());
+}
+
+static void ImportMaterial(aiMaterial* material, const aiScene* pAiScene, ImportedModelData& model)
 {
-	std::vector<TextureID> textures;
-	for (unsigned int i = 0; i < pMaterial->GetTextureCount(type); i++)
+	// MATERIAL - http://assimp.sourceforge.net/lib_html/materials.html
+	ModelMaterialDesc mat = {};
+	mat.textures[MODEL_TEXTURE_DIFFUSE ] = ImportMaterialTexture(material, aiTextureType_DIFFUSE , model);
+	mat.textures[MODEL_TEXTURE_SPECULAR] = ImportMaterialTexture(material, aiTextureType_SPECULAR, model);
+	mat.textures[MODEL_TEXTURE_NORMALS ] = ImportMaterialTexture(material, aiTextureType_NORMALS , model);
+	mat.textures[MODEL_TEXTURE_HEIGHT  ] = ImportMaterialTexture(material, aiTextureType_HEIGHT  , model);
+	mat.textures[MODEL_TEXTURE_ALPHA   ] = ImportMaterialTexture(material, aiTextureType_OPACITY , model);
+
+	aiString name;
+	if (aiReturn_SUCCESS == material->Get(AI_MATKEY_NAME, name))
 	{
-		aiString str;
-		pMaterial->GetTexture(type, i, &str);
-		std::string path = str.C_Str();
-		textures.push_back(mpRenderer->CreateTextureFromFile(path, modelDirectory));
+		// we don't store names for materials. probably best to store them in a lookup somewhere,
+		// away from the material data.
+		//
+		// pBRDF->
 	}
-	return textures;
-}
 
+	aiColor3D color(0.f, 0.f, 0.f);
+	if (aiReturn_SUCCESS == material->Get(AI_MATKEY_COLOR_DIFFUSE, color))
+	{
+		mat.flags |= ModelMaterialDesc::HAS_DIFFUSE;
+		mat.diffuse[0] = color.r; mat.diffuse[1] = color.g; mat.diffuse[2] = color.b;
+	}
+
+	aiColor3D specular(0.f, 0.f, 0.f);
+	if (aiReturn_SUCCESS == material->Get(AI_MATKEY_COLOR_SPECULAR, specular))
+	{
+		mat.flags |= ModelMaterialDesc::HAS_SPECULAR;
+		mat.specular[0] = specular.r; mat.specular[1] = specular.g; mat.specular[2] = specular.b;
+	}
+
+	aiColor3D transparent(0.0f, 0.0f, 0.0f);
+	if (aiReturn_SUCCESS == material->Get(AI_MATKEY_COLOR_TRANSPARENT, transparent))
+	{	// Defines the transparent color of the material, this is the color to be multiplied 
+		// with the color of translucent light to construct the final 'destination color' 
+		// for a particular position in the screen buffer. T
+		//
+		//pBRDF->specular = vec3(specular.r, specular.g, specular.b);
+	}
+
+	float opacity = 0.0f;
+	if (aiReturn_SUCCESS == material->Get(AI_MATKEY_OPACITY, opacity))
+	{
+		mat.flags |= ModelMaterialDesc::HAS_ALPHA;
+		mat.alpha = opacity;
+	}
+
+	float shininess = 0.0f;
+	if (aiReturn_SUCCESS == material->Get(AI_MATKEY_SHININESS, shininess))
+	{
+		// Phong Shininess -> Beckmann BRDF Roughness conversion
+		//
+		// https://simonstechblog.blogspot.com/2011/12/microfacet-brdf.html
+		// https://computergraphics.stackexchange.com/questions/1515/what-is-the-accepted-method-of-converting-shininess-to-roughness-and-vice-versa
+		//
+		mat.flags |= ModelMaterialDesc::HAS_ROUGHNESS;
+		mat.roughness = sqrtf(2.0f / (2.0f + shininess));
+	}
+
+#if MAKE_IRONMAN_METALLIC || MAKE_ZENBALL_METALLIC
+
+	// ---
+	// quick hack to assign metallic value to the loaded mesh
+	//
+	std::string fileName(pAiScene->mRootNode->mName.C_Str());
+	std::transform(RANGE(fileName), fileName.begin(), ::tolower);
+	auto tokens = StrUtil::split(fileName, '.');
+	if (!tokens.empty() && (tokens[0] == "ironman" || tokens[0] == "zen_orb"))
+	{
+		mat.flags |= ModelMaterialDesc::HAS_METALNESS;
+		mat.metalness = 1.0f;
+	}
+	//---
+#endif
+
+	// other material keys to consider
+	//
+	// AI_MATKEY_TWOSIDED
+	// AI_MATKEY_ENABLE_WIREFRAME
+	// AI_MATKEY_BLEND_FUNC
+	// AI_MATKEY_BUMPSCALING
+
+	model.materials.push_back(mat);
+}
 
-Mesh ProcessMesh(aiMesh * mesh, const aiScene * scene)
+static void ImportMesh(aiMesh * mesh, ImportedModelData& model)
 {
-	std::vector<DefaultVertexBufferData> Vertices;
-	std::vector<unsigned> Indices;
+	ModelMeshDesc meshDesc = {};
+	meshDesc.firstVertex = static_cast<uint32_t>(model.vertices.size());
+	meshDesc.numVertices = mesh->mNumVertices;
+	meshDesc.firstIndex  = static_cast<uint32_t>(model.indices.size());
+	meshDesc.material    = mesh->mMaterialIndex;
+
+	// model space bounding box of the mesh, accumulated while walking the vertices
+	constexpr float max_f = std::numeric_limits<float>::max();
+	XMVECTOR aabbMin = XMVectorReplicate( max_f);
+	XMVECTOR aabbMax = XMVectorReplicate(-max_f);
 
 	// Walk through each of the mesh's vertices
 	for (unsigned int i = 0; i < mesh->mNumVertices; i++)
@@ -126,6 +253,8 @@ Mesh ProcessMesh(aiMesh * mesh, const aiScene * scene)
 			mesh->mVertices[i].y,
 			mesh->mVertices[i].z
 		);
+		aabbMin = XMVectorMin(aabbMin, Vert.position);
+		aabbMax = XMVectorMax(aabbMax, Vert.position);
 
 		// NORMALS
 		if (mesh->mNormals)
@@ -161,7 +290,7 @@ Mesh ProcessMesh(aiMesh * mesh, const aiScene * scene)
 		// 	mesh->mBitangents[i].y,
 		// 	mesh->mBitangents[i].z
 		// );
-		Vertices.push_back(Vert);
+		model.vertices.push_back(Vert);
 	}
 
 	// now walk through each of the mesh's faces (a face is a mesh its triangle) and retrieve the corresponding vertex indices.
@@ -170,122 +299,201 @@ Mesh ProcessMesh(aiMesh * mesh, const aiScene * scene)
 		aiFace face = mesh->mFaces[i];
 		// retrieve all indices of the face and store them in the indices vector
 		for (unsigned int j = 0; j < face.mNumIndices; j++)
-			Indices.push_back(face.mIndices[j]);
+			model.indices.push_back(face.mIndices[j]);
 	}
+	meshDesc.numIndices = static_cast<uint32_t>(model.indices.size()) - meshDesc.firstIndex;
 
 	// TODO: mesh name
 
-	Mesh newMesh;
+	XMStoreFloat3(reinterpret_cast<XMFLOAT3*>(meshDesc.aabbMin), aabbMin);
+	XMStoreFloat3(reinterpret_cast<XMFLOAT3*>(meshDesc.aabbMax), aabbMax);
+	model.meshes.push_back(meshDesc);
+}
+
+static void ImportNode(aiNode* const pNode, const aiScene* pAiScene, ImportedModelData& model)
+{
+	for (unsigned int i = 0; i < pNode->mNumMeshes; i++)
+	{	// process all the node's meshes (if any)
+		ImportMesh(pAiScene->mMeshes[pNode->mMeshes[i]], model);
+	}
+	for (unsigned int i = 0; i < pNode->mNumChildren; i++)
+	{	// then do the same for each of its children
+		ImportNode(pNode->mChildren[i], pAiScene, model);
+	}
+}
+
+static void ImportScene(const aiScene* pAiScene, ImportedModelData& model)
+{
+	for (unsigned int i = 0; i < pAiScene->mNumMaterials; i++)
 	{
-		std::unique_lock<std::mutex> lck(Engine::mLoadRenderingMutex);
-		newMesh = Mesh(Vertices, Indices, "ImportedModelMesh0");	// return a mesh object created from the extracted mesh data
+		ImportMaterial(pAiScene->mMaterials[i], pAiScene, model);
 	}
-	return newMesh;
+	ImportNode(pAiScene->mRootNode, pAiScene, model);
 }
 
-ModelData ProcessNode(
-	aiNode* const		pNode,
-	const aiScene*		pAiScene,
-	const std::string&	modelDirectory,
-	Renderer*			mpRenderer,		// creates resources
-	Scene*				pScene			// write
-)
+// Reorders the triangles and vertices of each mesh for the post-transform cache and the vertex fetch.
+// Runs once on the cold load, the cache file stores the optimized buffers.
+//
+static void OptimizeMeshes(ImportedModelData& model, const std::string& modelName)
 {
-	ModelData modelData;
-	std::vector<MeshID>& ModelMeshIDs = modelData.mMeshIDs;
+	PerfTimer t;
+	t.Start();
 
-	for (unsigned int i = 0; i < pNode->mNumMeshes; i++)
-	{	// process all the node's meshes (if any)
-		aiMesh* pAiMesh = pAiScene->mMeshes[pNode->mMeshes[i]];
+	VertexCacheStats before = {};
+	VertexCacheStats after = {};
+	for (const ModelMeshDesc& mesh : model.meshes)
+	{
+		DefaultVertexBufferData* pVertices = model.vertices.data() + mesh.firstVertex;
+		unsigned* pIndices = model.indices.data() + mesh.firstIndex;
+		before += MeshOptimizer::AnalyzeVertexCache(pIndices, mesh.numIndices, mesh.numVertices);
+
+#if _DEBUG
+		const std::vector<unsigned> sourceIndices(pIndices, pIndices + mesh.numIndices);
+#endif
+		MeshOptimizer::OptimizeVertexCache(pIndices, mesh.numIndices, mesh.numVertices);
+#if _DEBUG
+		const std::vector<unsigned> remap = MeshOptimizer::GetVertexFetchRemap(pIndices, mesh.numIndices, mesh.numVertices);
+#endif
+		MeshOptimizer::OptimizeVertexFetch(pVertices, mesh.numVertices, pIndices, mesh.numIndices);
+#if _DEBUG
+		if (!MeshOptimizer::IsSameTriangleList(sourceIndices.data(), pIndices, mesh.numIndices, remap.data()))
+			Log::Error("MeshOptimizer: %s has different triangles after optimization", modelName.c_str());
+#endif
 
-		// MATERIAL - http://assimp.sourceforge.net/lib_html/materials.html
-		aiMaterial* material = pAiScene->mMaterials[pAiMesh->mMaterialIndex];
-		std::vector<TextureID> diffuseMaps  = LoadMaterialTextures(material, aiTextureType_DIFFUSE	, "texture_diffuse" , mpRenderer, modelDirectory);
-		std::vector<TextureID> specularMaps = LoadMaterialTextures(material, aiTextureType_SPECULAR , "texture_specular", mpRenderer, modelDirectory);
-		std::vector<TextureID> normalMaps   = LoadMaterialTextures(material, aiTextureType_NORMALS	, "texture_normal"  , mpRenderer, modelDirectory);
-		std::vector<TextureID> heightMaps   = LoadMaterialTextures(material, aiTextureType_HEIGHT   , "texture_height"  , mpRenderer, modelDirectory);
-		std::vector<TextureID> alphaMaps    = LoadMaterialTextures(material, aiTextureType_OPACITY	, "texture_alpha"   , mpRenderer, modelDirectory);
+		after += MeshOptimizer::AnalyzeVertexCache(pIndices, mesh.numIndices, mesh.numVertices);
+	}
 
-		BRDF_Material* pBRDF = static_cast<BRDF_Material*>(pScene->CreateNewMaterial(GGX_BRDF));
-		assert(diffuseMaps.size() <= 1);	assert(normalMaps.size() <= 1);
-		assert(specularMaps.size() <= 1);	assert(heightMaps.size() <= 1);
-		assert(alphaMaps.size() <= 1);
-		if (!diffuseMaps.empty())	pBRDF->diffuseMap = diffuseMaps[0];
-		if (!normalMaps.empty())	pBRDF->normalMap = normalMaps[0];
-		if (!specularMaps.empty())	pBRDF->specularMap = specularMaps[0];
-		if (!heightMaps.empty())	pBRDF->heightMap = heightMaps[0];
-		if (!alphaMaps.empty())		pBRDF->mask = alphaMaps[0];
-
-		aiString name;
-		if (aiReturn_SUCCESS == material->Get(AI_MATKEY_NAME, name))
-		{
-			// we don't store names for materials. probably best to store them in a lookup somewhere,
-			// away from the material data.
-			//
-			// pBRDF->
-		}
+	t.Stop();
+	Log::Info("Optimized Model '%s' in %.2f ms: ACMR %.3f -> %.3f | ATVR %.3f -> %.3f (%zu triangles, FIFO%zu)"
+		, modelName.c_str(), t.DeltaTime() * 1000.0f
+		, before.GetACMR(), after.GetACMR(), before.GetATVR(), after.GetATVR()
+		, after.numTriangles, MeshOptimizer::ANALYSIS_CACHE_SIZE
+	);
+}
 
-		aiColor3D color(0.f, 0.f, 0.f);
-		if (aiReturn_SUCCESS == material->Get(AI_MATKEY_COLOR_DIFFUSE, color))
-		{
-			pBRDF->diffuse = vec3(color.r, color.g, color.b);
-		}
+// Simplified levels of detail of each mesh, appended to the index blob. The LODs index the vertices
+// of the full resolution mesh, so each level only costs an index buffer.
+//
+static constexpr size_t LOD_MIN_TRIANGLES  = 256;	// meshes smaller than this aren't worth simplifying
+static constexpr float  LOD_TRIANGLE_RATIO = 0.5f;	// each level targets half the triangles of the previous one
+static constexpr float  LOD_MIN_REDUCTION  = 0.8f;	// no more levels once a level keeps more triangles than this ratio
+static constexpr float  LOD_MAX_ERRORS[ModelMeshDesc::MAX_LOD_COUNT - 1] = { 0.01f, 0.025f, 0.05f };	// relative to the mesh size
+
+static void GenerateLODs(ImportedModelData& model, const std::string& modelName)
+{
+	PerfTimer t;
+	t.Start();
+
+	size_t numTriangles[ModelMeshDesc::MAX_LOD_COUNT] = {};	// meshes without a level count with their coarsest level
+	for (ModelMeshDesc& mesh : model.meshes)
+	{
+		const std::vector<unsigned> sourceIndices(model.indices.begin() + mesh.firstIndex, model.indices.begin() + mesh.firstIndex + mesh.numIndices);
+		const float* pPositions = &model.vertices[mesh.firstVertex].position.x();
 
-		aiColor3D specular(0.f, 0.f, 0.f);
-		if (aiReturn_SUCCESS == material->Get(AI_MATKEY_COLOR_SPECULAR, specular))
+		size_t numPreviousIndices = sourceIndices.size();
+		for (uint32_t lod = 1; lod < ModelMeshDesc::MAX_LOD_COUNT && sourceIndices.size() / 3 >= LOD_MIN_TRIANGLES; ++lod)
 		{
-			pBRDF->specular = vec3(specular.r, specular.g, specular.b);
-		}
+			// each level is simplified from the full resolution mesh so the error bound holds against it
+			const size_t targetNumIndices = static_cast<size_t>(numPreviousIndices * LOD_TRIANGLE_RATIO) / 3 * 3;
+			std::vector<unsigned> indices = MeshOptimizer::SimplifyMesh(
+				pPositions, sizeof(DefaultVertexBufferData), mesh.numVertices,
+				sourceIndices.data(), sourceIndices.size(),
+				targetNumIndices, LOD_MAX_ERRORS[lod - 1]
+			);
+			if (indices.empty() || indices.size() > numPreviousIndices * LOD_MIN_REDUCTION)
+				break;
 
-		aiColor3D transparent(0.0f, 0.0f, 0.0f);
-		if (aiReturn_SUCCESS == material->Get(AI_MATKEY_COLOR_TRANSPARENT, transparent))
-		{	// Defines the transparent color of the material, this is the color to be multiplied 
-			// with the color of translucent light to construct the final 'destination color' 
-			// for a particular position in the screen buffer. T
-			//
-			//pBRDF->specular = vec3(specular.r, specular.g, specular.b);
+			MeshOptimizer::OptimizeVertexCache(indices.data(), indices.size(), mesh.numVertices);
+
+			ModelMeshLOD& meshLOD = mesh.lods[mesh.numLODs++];
+			meshLOD.firstIndex = static_cast<uint32_t>(model.indices.size());
+			meshLOD.numIndices = static_cast<uint32_t>(indices.size());
+			model.indices.insert(model.indices.end(), indices.begin(), indices.end());
+			numPreviousIndices = indices.size();
 		}
 
-		float opacity = 0.0f;
-		if (aiReturn_SUCCESS == material->Get(AI_MATKEY_OPACITY, opacity))
+		for (uint32_t lod = 0; lod < ModelMeshDesc::MAX_LOD_COUNT; ++lod)
 		{
-			pBRDF->alpha = opacity;
+			const uint32_t level = std::min(lod, mesh.numLODs);
+			numTriangles[lod] += (level == 0 ? mesh.numIndices : mesh.lods[level - 1].numIndices) / 3;
 		}
+	}
+
+	t.Stop();
+	Log::Info("Generated LODs of Model '%s' in %.2f ms: %zu | %zu | %zu | %zu triangles"
+		, modelName.c_str(), t.DeltaTime() * 1000.0f
+		, numTriangles[0], numTriangles[1], numTriangles[2], numTriangles[3]
+	);
+}
 
-		float shininess = 0.0f;
-		if (aiReturn_SUCCESS == material->Get(AI_MATKEY_SHININESS, shininess))
+// Creates the meshes and materials of the model. Each mesh gets its own material instance.
+// With the compact vertex format enabled, the opaque meshes the quantization doesn't visibly change
+// are created with CompactVertexBufferData. The transparent meshes keep the default format: the
+// forward transparent and debug shaders don't have COMPACT_VERTEX variants.
+//
+static ModelData CreateModelResources(
+	const ModelDataView& data,
+	const std::string&	modelDirectory,
+	Renderer*			mpRenderer,		// creates resources
+	Scene*				pScene			// write
+)
+{
+	ModelData modelData;
+	std::vector<MeshID>& ModelMeshIDs = modelData.mMeshIDs;
+	const bool bCompactVertices = Engine::GetSettings().rendering.bCompactVertices;
+
+	for (size_t i = 0; i < data.numMeshes; i++)
+	{
+		const ModelMeshDesc& meshDesc = data.pMeshes[i];
+		const ModelMaterialDesc& mat = data.pMaterials[meshDesc.material];
+
+		// MATERIAL
+		BRDF_Material* pBRDF = static_cast<BRDF_Material*>(pScene->CreateNewMaterial(GGX_BRDF));
+		auto fnLoadTexture = [&](EModelTextureType type, TextureID& outTexture)
+		{
+			const char* pTextureName = data.GetString(mat.textures[type]);
+			if (pTextureName)
+				outTexture = mpRenderer->CreateTextureFromFile(pTextureName, modelDirectory);
+		};
+		fnLoadTexture(MODEL_TEXTURE_DIFFUSE , pBRDF->diffuseMap);
+		fnLoadTexture(MODEL_TEXTURE_NORMALS , pBRDF->normalMap);
+		fnLoadTexture(MODEL_TEXTURE_SPECULAR, pBRDF->specularMap);
+		fnLoadTexture(MODEL_TEXTURE_HEIGHT  , pBRDF->heightMap);
+		fnLoadTexture(MODEL_TEXTURE_ALPHA   , pBRDF->mask);
+
+		if (mat.flags & ModelMaterialDesc::HAS_DIFFUSE)   pBRDF->diffuse = vec3(mat.diffuse[0], mat.diffuse[1], mat.diffuse[2]);
+		if (mat.flags & ModelMaterialDesc::HAS_SPECULAR)  pBRDF->specular = vec3(mat.specular[0], mat.specular[1], mat.specular[2]);
+		if (mat.flags & ModelMaterialDesc::HAS_ALPHA)     pBRDF->alpha = mat.alpha;
+		if (mat.flags & ModelMaterialDesc::HAS_ROUGHNESS) pBRDF->roughness = mat.roughness;
+		if (mat.flags & ModelMaterialDesc::HAS_METALNESS) pBRDF->metalness = mat.metalness;
+
+		// MESH
+		const DefaultVertexBufferData* pVertices = data.pVertices + meshDesc.firstVertex;
+		const unsigned* pIndices = data.pIndices + meshDesc.firstIndex;
+		std::vector<CompactVertexBufferData> compactVertices;
+		if (bCompactVertices && !pBRDF->IsTransparent())
 		{
-			// Phong Shininess -> Beckmann BRDF Roughness conversion
-			//
-			// https://simonstechblog.blogspot.com/2011/12/microfacet-brdf.html
-			// https://computergraphics.stackexchange.com/questions/1515/what-is-the-accepted-method-of-converting-shininess-to-roughness-and-vice-versa
-			//
-			pBRDF->roughness = sqrtf(2.0f / (2.0f + shininess));
+			// half float UVs lose precision away from the origin, i.e. on heavily tiled meshes
+			const VertexQuantizationError error = VertexQuantization::GetRoundTripError(pVertices, meshDesc.numVertices);
+			if (error.maxUVError <= VertexQuantization::MAX_UV_ERROR)
+			{
+				compactVertices.resize(meshDesc.numVertices);
+				VertexQuantization::Encode(pVertices, meshDesc.numVertices, compactVertices.data());
+			}
 		}
 
-#if MAKE_IRONMAN_METALLIC || MAKE_ZENBALL_METALLIC
-
-		// ---
-		// quick hack to assign metallic value to the loaded mesh
-		//
-		std::string fileName(pAiScene->mRootNode->mName.C_Str());
-		std::transform(RANGE(fileName), fileName.begin(), ::tolower);
-		auto tokens = StrUtil::split(fileName, '.');
-		if (!tokens.empty() && (tokens[0] == "ironman" || tokens[0] == "zen_orb"))
+		Mesh mesh;
 		{
-			pBRDF->metalness = 1.0f;
+			std::unique_lock<std::mutex> lck(Engine::mLoadRenderingMutex);
+			mesh = compactVertices.empty()
+				? Mesh(pVertices, meshDesc.numVertices, pIndices, meshDesc.numIndices, "ImportedModelMesh0")
+				: Mesh(compactVertices.data(), compactVertices.size(), pIndices, meshDesc.numIndices, "ImportedModelMesh0");
 		}
-		//---
-#endif
 
-		// other material keys to consider
-		//
-		// AI_MATKEY_TWOSIDED
-		// AI_MATKEY_ENABLE_WIREFRAME
-		// AI_MATKEY_BLEND_FUNC
-		// AI_MATKEY_BUMPSCALING
-		
-		Mesh mesh = ProcessMesh(pAiMesh, pAiScene);
+		BoundingBox aabb;
+		aabb.low = vec3(meshDesc.aabbMin[0], meshDesc.aabbMin[1], meshDesc.aabbMin[2]);
+		aabb.hi  = vec3(meshDesc.aabbMax[0], meshDesc.aabbMax[1], meshDesc.aabbMax[2]);
+		mesh.SetLocalAABB(aabb);
 		{
 			MeshID id = pScene->AddMesh_Async(mesh);
 			ModelMeshIDs.push_back(id);
@@ -296,21 +504,18 @@ ModelData ProcessNode(
 		{
 			modelData.mTransparentMeshIDs.push_back(ModelMeshIDs.back());
 		}
-	}
-	for (unsigned int i = 0; i < pNode->mNumChildren; i++)
-	{	// then do the same for each of its children
-		ModelData childModelData = ProcessNode(pNode->mChildren[i], pAiScene, modelDirectory, mpRenderer, pScene);
-		std::vector<MeshID>& ChildMeshes = childModelData.mMeshIDs;
-		std::vector<MeshID>& ChildMeshesTransparent = childModelData.mTransparentMeshIDs;
 
-		std::copy(ChildMeshes.begin(), ChildMeshes.end(), std::back_inserter(ModelMeshIDs));
-		std::copy(ChildMeshesTransparent.begin(), ChildMeshesTransparent.end(), std::back_inserter(modelData.mTransparentMeshIDs));
-		for (auto& kvp : childModelData.mMaterialLookupPerMesh)
+		// LODs
+		for (uint32_t lod = 0; lod < meshDesc.numLODs; ++lod)
 		{
-#if _DEBUG
-			assert(modelData.mMaterialLookupPerMesh.find(kvp.first) == modelData.mMaterialLookupPerMesh.end());
-#endif
-			modelData.mMaterialLookupPerMesh[kvp.first] = kvp.second;
+			Mesh lodMesh;
+			{
+				std::unique_lock<std::mutex> lck(Engine::mLoadRenderingMutex);
+				lodMesh = Mesh(mesh, data.pIndices + meshDesc.lods[lod].firstIndex, meshDesc.lods[lod].numIndices, "ImportedModelMesh0_LOD" + std::to_string(lod + 1));
+			}
+			const MeshID lodID = pScene->AddMesh_Async(lodMesh);
+			modelData.mLODLookupPerMesh[ModelMeshIDs.back()].push_back(lodID);
+			modelData.mMaterialLookupPerMesh[lodID] = pBRDF->ID;
 		}
 	}
 	return modelData;
@@ -330,6 +535,43 @@ constexpr auto ASSIMP_LOAD_FLAGS
 | aiProcess_JoinIdenticalVertices
 | aiProcess_GenSmoothNormals;
 
+bool ModelLoader::ImportModel(const std::string& fullPath, const std::string& modelDirectory, Scene* pScene, ModelData& outData, bool& bOutLoadedFromCache)
+{
+	// WARM LOAD - map the cache and create the buffers straight from the mapped memory
+	//
+	const std::string cacheFilePath = ModelCache::GetCacheFilePath(fullPath);
+	if (!ModelCache::IsCacheDirty(fullPath, cacheFilePath))
+	{
+		ModelCache cache;
+		if (cache.Open(cacheFilePath))
+		{
+			outData = CreateModelResources(cache.GetView(), modelDirectory, mpRenderer, pScene);
+			bOutLoadedFromCache = true;
+			return true;
+		}
+	}
+
+	// COLD LOAD - import through assimp and write the cache for the next run
+	//
+	Importer importer;
+	const aiScene* scene = importer.ReadFile(fullPath, ASSIMP_LOAD_FLAGS);
+	if (!scene || scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE || !scene->mRootNode)
+	{
+		Log::Error("Assimp error: %s", importer.GetErrorString());
+		return false;
+	}
+
+	ImportedModelData importedData;
+	ImportScene(scene, importedData);
+	OptimizeMeshes(importedData, DirectoryUtil::GetFileNameWithoutExtension(fullPath));
+	GenerateLODs(importedData, DirectoryUtil::GetFileNameWithoutExtension(fullPath));
+	ModelCache::Write(cacheFilePath, importedData.GetView());
+
+	outData = CreateModelResources(importedData.GetView(), modelDirectory, mpRenderer, pScene);
+	bOutLoadedFromCache = false;
+	return true;
+}
+
 Model ModelLoader::LoadModel(const std::string & modelPath, Scene* pScene)
 {
 	assert(mpRenderer);
@@ -352,14 +594,12 @@ Model ModelLoader::LoadModel(const std::string & modelPath, Scene* pScene)
 
 	// IMPORT SCENE
 	//
-	Importer importer;
-	const aiScene* scene = importer.ReadFile(fullPath, ASSIMP_LOAD_FLAGS);
-	if (!scene || scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE || !scene->mRootNode)
+	ModelData data;
+	bool bLoadedFromCache = false;
+	if (!ImportModel(fullPath, modelDirectory, pScene, data, bLoadedFromCache))
 	{
-		Log::Error("Assimp error: %s", importer.GetErrorString());
 		return Model();
 	}
-	ModelData data = ProcessNode(scene->mRootNode, scene, modelDirectory, mpRenderer, pScene);
 
 	// cache the model
 	const Model model = Model(modelDirectory, modelName, std::move(data));
@@ -375,7 +615,7 @@ Model ModelLoader::LoadModel(const std::string & modelPath, Scene* pScene)
 		mSceneModels.at(pScene).push_back(fullPath);
 	}
 	t.Stop();
-	Log::Info("Loaded Model '%s' in %.2f seconds.", modelName.c_str(), t.DeltaTime());
+	Log::Info("Loaded Model '%s' in %.2f seconds (%s).", modelName.c_str(), t.DeltaTime(), bLoadedFromCache ? "warm: model cache" : "cold: assimp import");
 	return model;
 }
 
@@ -404,14 +644,12 @@ Model ModelLoader::LoadModel_Async(const std::string& modelPath, Scene* pScene)
 
 	// IMPORT SCENE
 	//
-	Importer importer;
-	const aiScene* scene = importer.ReadFile(fullPath, ASSIMP_LOAD_FLAGS);
-	if (!scene || scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE || !scene->mRootNode)
+	ModelData data;
+	bool bLoadedFromCache = false;
+	if (!ImportModel(fullPath, modelDirectory, pScene, data, bLoadedFromCache))
 	{
-		Log::Error("Assimp error: %s", importer.GetErrorString());
 		return Model();
 	}
-	ModelData data = ProcessNode(scene->mRootNode, scene, modelDirectory, mpRenderer, pScene);
 
 	// cache the model
 	const Model model = Model(modelDirectory, modelName, std::move(data));
@@ -434,7 +672,7 @@ Model ModelLoader::LoadModel_Async(const std::string& modelPath, Scene* pScene)
 	}
 
 	t.Stop();
-	//Log::Info("Loaded Model '%s' in %.2f seconds.", modelName.c_str(), t.DeltaTime());
+	Log::Info("Loaded Model '%s' in %.2f seconds (%s).", modelName.c_str(), t.DeltaTime(), bLoadedFromCache ? "warm: model cache" : "cold: assimp import");
 	return model;
 }
 
@@ -446,3 +684,199 @@ void ModelLoader::UnloadSceneModels(Scene * pScene)
 		mLoadedModels.erase(modelDirectory);
 	}
 }
+
+
+//----------------------------------------------------------------------------------------------------------------
+// SELF-CHECK
+//----------------------------------------------------------------------------------------------------------------
+// models shipped in Data/Models/, the ones that can't be found are skipped
+static const char* const BUNDLED_MODELS[] =
+{
+	"platform.obj",
+	"nanosuit/nanosuit.obj",
+	"SaiNarayan/CorinthianPillar/column.obj",
+	"SaiNarayan/Wanderer/Wanderer_LP.obj",
+};
+
+static inline XMVECTOR GetTriangleNormal(const DefaultVertexBufferData* pVertices, const unsigned* pTriangle)	// not normalized
+{
+	const XMVECTOR p0 = pVertices[pTriangle[0]].position;
+	const XMVECTOR p1 = pVertices[pTriangle[1]].position;
+	const XMVECTOR p2 = pVertices[pTriangle[2]].position;
+	return XMVector3Cross(XMVectorSubtract(p1, p0), XMVectorSubtract(p2, p0));
+}
+
+// Runs the optimizations of OptimizeMeshes() and GenerateLODs() on a copy of each mesh of @model and
+// checks their results against the source mesh. Logs the failed checks and returns false if there are any.
+//
+static bool TestMeshOptimizations(const ImportedModelData& model, const std::string& modelName)
+{
+	bool bPassed = true;
+	auto fnCheck = [&](bool bCondition, size_t meshIndex, const char* pCheck)
+	{
+		if (bCondition) return;
+		Log::Error("MeshOptimizer test: %s mesh %zu: %s", modelName.c_str(), meshIndex, pCheck);
+		bPassed = false;
+	};
+
+	VertexCacheStats before = {};
+	VertexCacheStats after = {};
+	size_t numLODs = 0;
+	for (size_t meshIndex = 0; meshIndex < model.meshes.size(); ++meshIndex)
+	{
+		const ModelMeshDesc& mesh = model.meshes[meshIndex];
+		const DefaultVertexBufferData* pSourceVertices = model.vertices.data() + mesh.firstVertex;
+		const unsigned* pSourceIndices = model.indices.data() + mesh.firstIndex;
+		std::vector<DefaultVertexBufferData> vertices(pSourceVertices, pSourceVertices + mesh.numVertices);
+		std::vector<unsigned> indices(pSourceIndices, pSourceIndices + mesh.numIndices);
+
+		// VERTEX CACHE: same triangles with the same winding, in an order that doesn't miss the cache more often
+		//
+		const VertexCacheStats meshBefore = MeshOptimizer::AnalyzeVertexCache(indices.data(), indices.size(), vertices.size());
+		MeshOptimizer::OptimizeVertexCache(indices.data(), indices.size(), vertices.size());
+		const VertexCacheStats meshAfter = MeshOptimizer::AnalyzeVertexCache(indices.data(), indices.size(), vertices.size());
+		fnCheck(MeshOptimizer::IsSameTriangleList(pSourceIndices, indices.data(), indices.size()), meshIndex, "OptimizeVertexCache() changed the triangles");
+		before += meshBefore;
+		after += meshAfter;
+
+		// VERTEX FETCH: vertices in the order of first use, the vertex data moves along with the indices
+		//
+		const std::vector<unsigned> remap = MeshOptimizer::GetVertexFetchRemap(indices.data(), indices.size(), vertices.size());
+		MeshOptimizer::OptimizeVertexFetch(vertices.data(), vertices.size(), indices.data(), indices.size());
+		fnCheck(MeshOptimizer::IsSameTriangleList(pSourceIndices, indices.data(), indices.size(), remap.data()), meshIndex, "OptimizeVertexFetch() changed the triangles");
+
+		bool bSameVertexData = true;
+		for (size_t v = 0; v < vertices.size(); ++v)
+			bSameVertexData &= memcmp(&vertices[remap[v]], &pSourceVertices[v], sizeof(DefaultVertexBufferData)) == 0;
+		fnCheck(bSameVertexData, meshIndex, "OptimizeVertexFetch() didn't move the vertex data with the indices");
+
+		unsigned numFetched = 0;
+		bool bFetchInOrder = true;
+		for (unsigned v : indices)
+		{
+			bFetchInOrder &= v <= numFetched;
+			numFetched += v == numFetched ? 1 : 0;
+		}
+		fnCheck(bFetchInOrder, meshIndex, "the vertices aren't in the order of first use");
+		fnCheck(MeshOptimizer::AnalyzeVertexCache(indices.data(), indices.size(), vertices.size()).numTransformed == meshAfter.numTransformed
+			, meshIndex, "OptimizeVertexFetch() changed the cache behavior");
+
+		// LODs: simplified from the source mesh with the settings of GenerateLODs()
+		//
+		if (mesh.numIndices / 3 < LOD_MIN_TRIANGLES)
+			continue;
+
+		// source triangles around each position, the seams share them
+		std::map<std::tuple<float, float, float>, std::vector<unsigned>> sourceTrianglesAtPosition;
+		auto fnGetSourceTriangles = [&](unsigned v) -> std::vector<unsigned>&
+		{
+			const vec3& p = pSourceVertices[v].position;
+			return sourceTrianglesAtPosition[std::make_tuple(p.x(), p.y(), p.z())];
+		};
+
+		// triangles this small don't have a meaningful normal in float precision
+		XMVECTOR lo = pSourceVertices[0].position;
+		XMVECTOR hi = lo;
+		for (size_t v = 1; v < mesh.numVertices; ++v)
+		{
+			lo = XMVectorMin(lo, pSourceVertices[v].position);
+			hi = XMVectorMax(hi, pSourceVertices[v].position);
+		}
+		const float extentSq = XMVectorGetX(XMVector3LengthSq(XMVectorSubtract(hi, lo)));
+		const float minNormalLengthSq = extentSq * extentSq * 1e-14f;	// area of 1e-7 * extent^2, around the float precision
+
+		size_t numSourceDegenerate = 0;
+		for (size_t i = 0; i < mesh.numIndices; i += 3)
+		{
+			numSourceDegenerate += XMVectorGetX(XMVector3LengthSq(GetTriangleNormal(pSourceVertices, &pSourceIndices[i]))) <= minNormalLengthSq ? 1 : 0;
+			for (size_t k = 0; k < 3; ++k)
+				fnGetSourceTriangles(pSourceIndices[i + k]).push_back(static_cast<unsigned>(i));
+		}
+
+		size_t numPreviousIndices = mesh.numIndices;
+		for (uint32_t lod = 1; lod < ModelMeshDesc::MAX_LOD_COUNT; ++lod)
+		{
+			const size_t targetNumIndices = static_cast<size_t>(numPreviousIndices * LOD_TRIANGLE_RATIO) / 3 * 3;
+			float error = 0.0f;
+			const std::vector<unsigned> lodIndices = MeshOptimizer::SimplifyMesh(
+				&pSourceVertices[0].position.x(), sizeof(DefaultVertexBufferData), mesh.numVertices,
+				pSourceIndices, mesh.numIndices,
+				targetNumIndices, LOD_MAX_ERRORS[lod - 1], &error
+			);
+			fnCheck(error <= LOD_MAX_ERRORS[lod - 1], meshIndex, "SimplifyMesh() exceeded the error limit");
+			fnCheck(lodIndices.size() % 3 == 0 && lodIndices.size() <= mesh.numIndices, meshIndex, "SimplifyMesh() returned an invalid triangle list");
+			fnCheck(std::all_of(lodIndices.begin(), lodIndices.end(), [&](unsigned v) { return v < mesh.numVertices; }), meshIndex, "SimplifyMesh() returned out of range indices");
+
+			size_t numDegenerate = 0;	// repeated vertices or no area, same as in the source mesh at most
+			size_t numFlipped = 0;		// facing away from all the source triangles at their corners
+			for (size_t i = 0; i + 2 < lodIndices.size(); i += 3)
+			{
+				const unsigned* pTriangle = &lodIndices[i];
+				const XMVECTOR n = GetTriangleNormal(pSourceVertices, pTriangle);
+				if (pTriangle[0] == pTriangle[1] || pTriangle[1] == pTriangle[2] || pTriangle[0] == pTriangle[2]
+					|| XMVectorGetX(XMVector3LengthSq(n)) <= minNormalLengthSq)
+				{
+					++numDegenerate;
+					continue;
+				}
+
+				bool bFacesSource = false;
+				for (size_t k = 0; k < 3 && !bFacesSource; ++k)
+					for (unsigned sourceTriangle : fnGetSourceTriangles(pTriangle[k]))
+						bFacesSource |= XMVectorGetX(XMVector3Dot(n, GetTriangleNormal(pSourceVertices, &pSourceIndices[sourceTriangle]))) > 0.0f;
+				numFlipped += bFacesSource ? 0 : 1;
+			}
+			if (numDegenerate > numSourceDegenerate || numFlipped > 0)
+			{
+				Log::Error("MeshOptimizer test: %s mesh %zu LOD%u: %zu degenerate (%zu in the source) and %zu flipped of %zu triangles"
+					, modelName.c_str(), meshIndex, lod, numDegenerate, numSourceDegenerate, numFlipped, lodIndices.size() / 3);
+				bPassed = false;
+			}
+
+			// same stopping rule as GenerateLODs(): the next level simplifies further only if this one did
+			if (lodIndices.empty() || lodIndices.size() > numPreviousIndices * LOD_MIN_REDUCTION)
+				break;
+			numPreviousIndices = lodIndices.size();
+			++numLODs;
+		}
+	}
+
+	fnCheck(after.GetACMR() <= before.GetACMR(), model.meshes.size(), "ACMR regressed after OptimizeVertexCache()");
+	Log::Info("MeshOptimizer test: %s: %zu meshes, ACMR %.3f -> %.3f, %zu LODs", modelName.c_str(), model.meshes.size(), before.GetACMR(), after.GetACMR(), numLODs);
+	return bPassed;
+}
+
+bool ModelLoader::RunMeshOptimizationTests()
+{
+	bool bPassed = true;
+	size_t numTestedModels = 0;
+	for (const char* pModelPath : BUNDLED_MODELS)
+	{
+		const std::string fullPath = std::string(sRootFolderModels) + pModelPath;
+		if (!DirectoryUtil::FileExists(fullPath))
+		{
+			Log::Warning("MeshOptimizer test: %s not found, skipping.", fullPath.c_str());
+			continue;
+		}
+
+		Importer importer;
+		const aiScene* scene = importer.ReadFile(fullPath, ASSIMP_LOAD_FLAGS);
+		if (!scene || scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE || !scene->mRootNode)
+		{
+			Log::Error("MeshOptimizer test: Assimp error: %s", importer.GetErrorString());
+			bPassed = false;
+			continue;
+		}
+
+		ImportedModelData importedData;
+		ImportScene(scene, importedData);
+		bPassed &= TestMeshOptimizations(importedData, DirectoryUtil::GetFileNameWithoutExtension(fullPath));
+		++numTestedModels;
+	}
+	if (numTestedModels == 0)
+	{
+		Log::Error("MeshOptimizer test: none of the bundled models found in %s", sRootFolderModels);
+		bPassed = false;
+	}
+	return bPassed;
+}
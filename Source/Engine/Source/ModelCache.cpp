@@ -0,0 +1,235 @@
+//	VQEngine | DirectX11 Renderer
+//	Copyright(C) 2018  - Volkan Ilbeyli
+//
+//	This program is free software : you can redistribute it and / or modify
+//	it under the terms of the GNU General Public License as published by
+//	the Free Software Foundation, either version 3 of the License, or
+//	(at your option) any later version.
+//
+//	This program is distributed in the hope that it will be useful,
+//	but WITHOUT ANY WARRANTY; without even the implied warranty of
+//	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+//	GNU General Public License for more details.
+//
+//	You should have received a copy of the GNU General Public License
+//	along with this program.If not, see <http://www.gnu.org/licenses/>.
+//
+//	Contact: volkanilbeyli@gmail.com
+
+#include "ModelCache.h"
+
+#include "Application/Application.h"
+
+#include "Utilities/Log.h"
+#include "Utilities/utils.h"
+
+#include <fstream>
+#include <algorithm>
+
+// bump the version whenever the layout below, ModelMeshDesc, ModelMaterialDesc, DefaultVertexBufferData
+// or the import settings / mesh optimization / LOD generation of the ModelLoader change.
+static constexpr uint32_t MODEL_CACHE_MAGIC   = 0x434D5156;	// 'VQMC'
+static constexpr uint32_t MODEL_CACHE_VERSION = 3;
+static constexpr size_t   BLOB_ALIGNMENT      = 16;
+
+// File layout: header followed by the blobs, each starting at a BLOB_ALIGNMENT boundary:
+//
+//   ModelCacheHeader | ModelMeshDesc[] | ModelMaterialDesc[] | DefaultVertexBufferData[] | unsigned[] | char[]
+//
+// The index blob holds the full resolution meshes followed by their LODs.
+//
+struct ModelCacheHeader
+{
+	uint32_t magic;
+	uint32_t version;
+	uint32_t vertexStride;
+	uint32_t numMeshes;
+	uint32_t numMaterials;
+	uint32_t numVertices;
+	uint32_t numIndices;
+	uint32_t stringTableSize;
+};
+
+static inline size_t AlignBlob(size_t offset) { return (offset + BLOB_ALIGNMENT - 1) & ~(BLOB_ALIGNMENT - 1); }
+
+struct BlobOffsets
+{
+	size_t meshes, materials, vertices, indices, stringTable, end;
+};
+
+static BlobOffsets GetBlobOffsets(const ModelCacheHeader& header)
+{
+	BlobOffsets o;
+	o.meshes      = AlignBlob(sizeof(ModelCacheHeader));
+	o.materials   = AlignBlob(o.meshes    + header.numMeshes    * sizeof(ModelMeshDesc));
+	o.vertices    = AlignBlob(o.materials + header.numMaterials * sizeof(ModelMaterialDesc));
+	o.indices     = AlignBlob(o.vertices  + header.numVertices  * static_cast<size_t>(header.vertexStride));
+	o.stringTable = AlignBlob(o.indices   + header.numIndices   * sizeof(unsigned));
+	o.end         = o.stringTable + header.stringTableSize;
+	return o;
+}
+
+
+//----------------------------------------------------------------------------------------------------------------
+// IMPORTED MODEL DATA
+//----------------------------------------------------------------------------------------------------------------
+uint32_t ImportedModelData::AddString(const std::string& str)
+{
+	const uint32_t offset = static_cast<uint32_t>(stringTable.size());
+	stringTable.insert(stringTable.end(), str.begin(), str.end());
+	stringTable.push_back('\0');
+	return offset;
+}
+
+ModelDataView ImportedModelData::GetView() const
+{
+	ModelDataView v;
+	v.pMeshes         = meshes.data();     v.numMeshes       = meshes.size();
+	v.pMaterials      = materials.data();  v.numMaterials    = materials.size();
+	v.pVertices       = vertices.data();   v.numVertices     = vertices.size();
+	v.pIndices        = indices.data();    v.numIndices      = indices.size();
+	v.pStringTable    = stringTable.data(); v.stringTableSize = stringTable.size();
+	return v;
+}
+
+
+//----------------------------------------------------------------------------------------------------------------
+// MODEL CACHE
+//----------------------------------------------------------------------------------------------------------------
+std::string ModelCache::GetCacheFilePath(const std::string& modelPath)
+{
+	// flatten the relative model path into a file name: Data/Models/sponza/sponza.obj -> Data_Models_sponza_sponza.obj.vqmc
+	std::string fileName = modelPath;
+	std::replace_if(fileName.begin(), fileName.end(), [](char c) { return c == '/' || c == '\\' || c == ':'; }, '_');
+	return Application::s_WorkspaceDirectory + "\\ModelCache\\" + fileName + ".vqmc";
+}
+
+bool ModelCache::IsCacheDirty(const std::string& modelPath, const std::string& cacheFilePath)
+{
+	if (!DirectoryUtil::FileExists(cacheFilePath)) return true;
+	if (DirectoryUtil::IsFileNewer(modelPath, cacheFilePath)) return true;
+
+	// .obj files keep their materials in a separate file next to them
+	const std::string materialFilePath = DirectoryUtil::GetFolderPath(modelPath) + DirectoryUtil::GetFileNameWithoutExtension(modelPath) + ".mtl";
+	return DirectoryUtil::FileExists(materialFilePath) && DirectoryUtil::IsFileNewer(materialFilePath, cacheFilePath);
+}
+
+bool ModelCache::Write(const std::string& cacheFilePath, const ModelDataView& data)
+{
+	DirectoryUtil::CreateFolderIfItDoesntExist(DirectoryUtil::GetFolderPath(cacheFilePath));
+
+	std::ofstream file(cacheFilePath, std::ios::binary | std::ios::trunc);
+	if (!file.is_open())
+	{
+		Log::Error("ModelCache: Couldn't open %s for writing.", cacheFilePath.c_str());
+		return false;
+	}
+
+	ModelCacheHeader header = {};
+	header.magic           = MODEL_CACHE_MAGIC;
+	header.version         = MODEL_CACHE_VERSION;
+	header.vertexStride    = sizeof(DefaultVertexBufferData);
+	header.numMeshes       = static_cast<uint32_t>(data.numMeshes);
+	header.numMaterials    = static_cast<uint32_t>(data.numMaterials);
+	header.numVertices     = static_cast<uint32_t>(data.numVertices);
+	header.numIndices      = static_cast<uint32_t>(data.numIndices);
+	header.stringTableSize = static_cast<uint32_t>(data.stringTableSize);
+	const BlobOffsets offsets = GetBlobOffsets(header);
+
+	const char padding[BLOB_ALIGNMENT] = {};
+	auto fnWriteBlob = [&](size_t offset, const void* pData, size_t size)
+	{
+		const size_t paddingSize = offset - static_cast<size_t>(file.tellp());
+		file.write(padding, paddingSize);
+		if (size > 0)
+			file.write(static_cast<const char*>(pData), size);
+	};
+
+	file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	fnWriteBlob(offsets.meshes     , data.pMeshes     , data.numMeshes    * sizeof(ModelMeshDesc));
+	fnWriteBlob(offsets.materials  , data.pMaterials  , data.numMaterials * sizeof(ModelMaterialDesc));
+	fnWriteBlob(offsets.vertices   , data.pVertices   , data.numVertices  * sizeof(DefaultVertexBufferData));
+	fnWriteBlob(offsets.indices    , data.pIndices    , data.numIndices   * sizeof(unsigned));
+	fnWriteBlob(offsets.stringTable, data.pStringTable, data.stringTableSize);
+
+	if (!file.good())
+	{
+		Log::Error("ModelCache: Error writing %s.", cacheFilePath.c_str());
+		file.close();
+		DeleteFile(cacheFilePath.c_str());
+		return false;
+	}
+	return true;
+}
+
+ModelCache::~ModelCache()
+{
+	Close();
+}
+
+bool ModelCache::Open(const std::string& cacheFilePath)
+{
+	Close();
+
+	if (!mFile.Open(cacheFilePath))
+	{
+		Log::Warning("ModelCache: Couldn't open %s.", cacheFilePath.c_str());
+		return false;
+	}
+	if (mFile.GetSize() < sizeof(ModelCacheHeader))
+	{
+		Log::Warning("ModelCache: %s is truncated.", cacheFilePath.c_str());
+		Close();
+		return false;
+	}
+
+	const char* pBase = static_cast<const char*>(mFile.GetData());
+	const ModelCacheHeader& header = *reinterpret_cast<const ModelCacheHeader*>(pBase);
+	const BlobOffsets offsets = GetBlobOffsets(header);
+	const bool bValid = header.magic == MODEL_CACHE_MAGIC
+		&& header.version == MODEL_CACHE_VERSION
+		&& header.vertexStride == sizeof(DefaultVertexBufferData)
+		&& offsets.end <= mFile.GetSize();
+	if (!bValid)
+	{
+		Log::Warning("ModelCache: %s is outdated or corrupt.", cacheFilePath.c_str());
+		Close();
+		return false;
+	}
+
+	mView.pMeshes         = reinterpret_cast<const ModelMeshDesc*>(pBase + offsets.meshes);
+	mView.numMeshes       = header.numMeshes;
+	mView.pMaterials      = reinterpret_cast<const ModelMaterialDesc*>(pBase + offsets.materials);
+	mView.numMaterials    = header.numMaterials;
+	mView.pVertices       = reinterpret_cast<const DefaultVertexBufferData*>(pBase + offsets.vertices);
+	mView.numVertices     = header.numVertices;
+	mView.pIndices        = reinterpret_cast<const unsigned*>(pBase + offsets.indices);
+	mView.numIndices      = header.numIndices;
+	mView.pStringTable    = pBase + offsets.stringTable;
+	mView.stringTableSize = header.stringTableSize;
+
+	// ranges are used as-is when creating the buffers, reject the file rather than reading past the mapping
+	for (size_t i = 0; i < mView.numMeshes; ++i)
+	{
+		const ModelMeshDesc& mesh = mView.pMeshes[i];
+		bool bValidMesh = static_cast<size_t>(mesh.firstVertex) + mesh.numVertices <= mView.numVertices
+			&& static_cast<size_t>(mesh.firstIndex) + mesh.numIndices <= mView.numIndices
+			&& mesh.material < mView.numMaterials
+			&& mesh.numLODs < ModelMeshDesc::MAX_LOD_COUNT;
+		for (uint32_t lod = 0; bValidMesh && lod < mesh.numLODs; ++lod)
+			bValidMesh = static_cast<size_t>(mesh.lods[lod].firstIndex) + mesh.lods[lod].numIndices <= mView.numIndices;
+		if (!bValidMesh)
+		{
+			Log::Warning("ModelCache: %s has invalid mesh ranges.", cacheFilePath.c_str());
+			Close();
+			return false;
+		}
+	}
+	return true;
+}
+
+void ModelCache::Close()
+{
+	mFile.Close();
+	mView = ModelDataView();
+}
@@ -0,0 +1,491 @@
+//	VQEngine | DirectX11 Renderer
+//	Copyright(C) 2018  - Volkan Ilbeyli
+//
+//	This program is free software : you can redistribute it and / or modify
+//	it under the terms of the GNU General Public License as published by
+//	the Free Software Foundation, either version 3 of the License, or
+//	(at your option) any later version.
+//
+//	This program is distributed in the hope that it will be useful,
+//	but WITHOUT ANY WARRANTY; without even the implied warranty of
+//	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+//	GNU General Public License for more details.
+//
+//	You should have received a copy of the GNU General Public License
+//	along with this program.If not, see <http://www.gnu.org/licenses/>.
+//
+//	Contact: volkanilbeyli@gmail.com
+
+#define NOMINMAX
+
+#include "OcclusionCulling.h"
+
+#include "Application/ThreadPool.h"
+#include "Utilities/Log.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <future>
+#include <limits>
+
+static_assert(OcclusionCuller::DEPTH_BUFFER_WIDTH  % OcclusionCuller::TILE_WIDTH  == 0, "Depth buffer width must be a multiple of the tile width");
+static_assert(OcclusionCuller::DEPTH_BUFFER_HEIGHT % OcclusionCuller::TILE_HEIGHT == 0, "Depth buffer height must be a multiple of the tile height");
+static_assert(OcclusionCuller::TILE_WIDTH  % OcclusionCuller::HIZ_BLOCK_SIZE == 0, "Tiles must contain whole HiZ blocks");
+static_assert(OcclusionCuller::TILE_HEIGHT % OcclusionCuller::HIZ_BLOCK_SIZE == 0, "Tiles must contain whole HiZ blocks");
+static_assert(OcclusionCuller::HIZ_BLOCK_SIZE % 4 == 0, "The rasterizer processes 4 pixels at a time");
+
+constexpr float DEPTH_CLEAR_VALUE = 1.0f;
+
+// clip space -> pixel coordinates. y is flipped: pixel (0,0) is the top left corner.
+static inline XMFLOAT3 ClipToScreen(const XMVECTOR& clip)
+{
+	const float invW = 1.0f / XMVectorGetW(clip);
+	return XMFLOAT3
+	(
+		( XMVectorGetX(clip) * invW * 0.5f + 0.5f) * OcclusionCuller::DEPTH_BUFFER_WIDTH,
+		(-XMVectorGetY(clip) * invW * 0.5f + 0.5f) * OcclusionCuller::DEPTH_BUFFER_HEIGHT,
+		XMVectorGetZ(clip) * invW
+	);
+}
+
+
+OcclusionCuller::OcclusionCuller()
+	: mViewProj(XMMatrixIdentity())
+	, mDepthBuffer(DEPTH_BUFFER_WIDTH * DEPTH_BUFFER_HEIGHT, DEPTH_CLEAR_VALUE)
+	, mHiZBuffer(HIZ_WIDTH * HIZ_HEIGHT, DEPTH_CLEAR_VALUE)
+	, mStats({})
+{}
+
+void OcclusionCuller::BeginFrame(const XMMATRIX& viewProj)
+{
+	mViewProj = viewProj;
+	mOccluders.clear();
+	mTriangles.clear();
+	for (std::vector<unsigned>& bin : mTileBins)
+		bin.clear();
+
+	std::fill(RANGE(mDepthBuffer), DEPTH_CLEAR_VALUE);
+	std::fill(RANGE(mHiZBuffer), DEPTH_CLEAR_VALUE);
+	mStats = {};
+}
+
+void OcclusionCuller::AddOccluder(const OccluderMesh* pMesh, const XMMATRIX& world)
+{
+	mOccluders.push_back({ pMesh, world });
+}
+
+void OcclusionCuller::RasterizeOccluders(VQEngine::ThreadPool* pThreadPool)
+{
+	TransformAndBinOccluders();
+
+	if (pThreadPool == nullptr)
+	{
+		for (int tileY = 0; tileY < NUM_TILES_Y; ++tileY)
+		for (int tileX = 0; tileX < NUM_TILES_X; ++tileX)
+			RasterizeTile(tileX, tileY);
+		return;
+	}
+
+	// tiles don't share any pixels or HiZ blocks, they can be rasterized independently.
+	std::future<void> tileTasks[NUM_TILES_X * NUM_TILES_Y];
+	for (int tileY = 0; tileY < NUM_TILES_Y; ++tileY)
+	for (int tileX = 0; tileX < NUM_TILES_X; ++tileX)
+	{
+		tileTasks[tileY * NUM_TILES_X + tileX] = pThreadPool->AddTask([=]() { RasterizeTile(tileX, tileY); });
+	}
+	for (std::future<void>& task : tileTasks)
+		task.wait();
+}
+
+void OcclusionCuller::TransformAndBinOccluders()
+{
+	std::vector<XMFLOAT3> screenVerts;
+	std::vector<bool>     nearClipped;
+
+	mStats.numOccluders = static_cast<int>(mOccluders.size());
+	for (const Occluder& occluder : mOccluders)
+	{
+		const OccluderMesh& mesh = *occluder.pMesh;
+		const XMMATRIX wvp = occluder.world * mViewProj;
+
+		// TRANSFORM VERTICES
+		//
+		screenVerts.resize(mesh.positions.size());
+		nearClipped.resize(mesh.positions.size());
+		for (size_t i = 0; i < mesh.positions.size(); ++i)
+		{
+			const XMVECTOR clip = XMVector4Transform(vec4(mesh.positions[i], 1.0f), wvp);
+
+			// z_clip < 0: the vertex is in front of the near plane (or behind the camera)
+			nearClipped[i] = XMVectorGetZ(clip) < 0.0f;
+			if (!nearClipped[i])
+			{
+				screenVerts[i] = ClipToScreen(clip);
+			}
+		}
+
+		// SETUP & BIN TRIANGLES
+		//
+		for (size_t i = 0; i + 2 < mesh.indices.size(); i += 3)
+		{
+			const unsigned i0 = mesh.indices[i + 0];
+			const unsigned i1 = mesh.indices[i + 1];
+			const unsigned i2 = mesh.indices[i + 2];
+			if (nearClipped[i0] || nearClipped[i1] || nearClipped[i2])
+				continue;
+
+			ScreenTriangle tri;
+			tri.v[0] = screenVerts[i0];
+			tri.v[1] = screenVerts[i1];
+			tri.v[2] = screenVerts[i2];
+
+			const float minXf = std::min({ tri.v[0].x, tri.v[1].x, tri.v[2].x });
+			const float minYf = std::min({ tri.v[0].y, tri.v[1].y, tri.v[2].y });
+			const float maxXf = std::max({ tri.v[0].x, tri.v[1].x, tri.v[2].x });
+			const float maxYf = std::max({ tri.v[0].y, tri.v[1].y, tri.v[2].y });
+
+			// pixel centers are at +0.5: only the pixels whose centers fall in the bounds can be covered.
+			tri.minX = std::max(0                     , static_cast<int>(std::ceil (minXf - 0.5f)));
+			tri.minY = std::max(0                     , static_cast<int>(std::ceil (minYf - 0.5f)));
+			tri.maxX = std::min(DEPTH_BUFFER_WIDTH - 1, static_cast<int>(std::floor(maxXf - 0.5f)));
+			tri.maxY = std::min(DEPTH_BUFFER_HEIGHT - 1,static_cast<int>(std::floor(maxYf - 0.5f)));
+			if (tri.minX > tri.maxX || tri.minY > tri.maxY)
+				continue;	// off-screen or doesn't cover any pixel center
+
+			const unsigned triIndex = static_cast<unsigned>(mTriangles.size());
+			mTriangles.push_back(tri);
+
+			for (int tileY = tri.minY / TILE_HEIGHT; tileY <= tri.maxY / TILE_HEIGHT; ++tileY)
+			for (int tileX = tri.minX / TILE_WIDTH ; tileX <= tri.maxX / TILE_WIDTH ; ++tileX)
+			{
+				mTileBins[tileY * NUM_TILES_X + tileX].push_back(triIndex);
+			}
+		}
+	}
+	mStats.numOccluderTriangles = static_cast<int>(mTriangles.size());
+}
+
+void OcclusionCuller::RasterizeTile(int tileX, int tileY)
+{
+	const int tileMinX = tileX * TILE_WIDTH;
+	const int tileMinY = tileY * TILE_HEIGHT;
+	const int tileMaxX = tileMinX + TILE_WIDTH - 1;
+	const int tileMaxY = tileMinY + TILE_HEIGHT - 1;
+
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 pixelOffsetsX = _mm_setr_ps(0.5f, 1.5f, 2.5f, 3.5f);
+
+	// RASTERIZE BINNED TRIANGLES
+	//
+	for (unsigned triIndex : mTileBins[tileY * NUM_TILES_X + tileX])
+	{
+		const ScreenTriangle& tri = mTriangles[triIndex];
+		const XMFLOAT3& v0 = tri.v[0];
+		const XMFLOAT3& v1 = tri.v[1];
+		const XMFLOAT3& v2 = tri.v[2];
+
+		// edge functions E(p) = A*p.x + B*p.y + C, one per edge,
+		// opposite to the vertex whose barycentric weight it yields.
+		float A0 = v1.y - v2.y, B0 = v2.x - v1.x, C0 = v1.x * v2.y - v1.y * v2.x;
+		float A1 = v2.y - v0.y, B1 = v0.x - v2.x, C1 = v2.x * v0.y - v2.y * v0.x;
+		float A2 = v0.y - v1.y, B2 = v1.x - v0.x, C2 = v0.x * v1.y - v0.y * v1.x;
+		float area = C0 + C1 + C2;	// twice the signed area
+
+		if (std::abs(area) < 1e-6f)
+			continue;	// degenerate
+
+		// occluders are rasterized regardless of their winding order
+		if (area < 0.0f)
+		{
+			A0 = -A0; B0 = -B0; C0 = -C0;
+			A1 = -A1; B1 = -B1; C1 = -C1;
+			A2 = -A2; B2 = -B2; C2 = -C2;
+			area = -area;
+		}
+		const float invArea = 1.0f / area;
+
+		// z(p) = z0 + (z1-z0)*l1 + (z2-z0)*l2, with l = E / area
+		const __m128 vZ0  = _mm_set1_ps(v0.z);
+		const __m128 vZ10 = _mm_set1_ps((v1.z - v0.z) * invArea);
+		const __m128 vZ20 = _mm_set1_ps((v2.z - v0.z) * invArea);
+
+		const __m128 vA0 = _mm_set1_ps(A0), vB0 = _mm_set1_ps(B0), vC0 = _mm_set1_ps(C0);
+		const __m128 vA1 = _mm_set1_ps(A1), vB1 = _mm_set1_ps(B1), vC1 = _mm_set1_ps(C1);
+		const __m128 vA2 = _mm_set1_ps(A2), vB2 = _mm_set1_ps(B2), vC2 = _mm_set1_ps(C2);
+		const __m128 vStepX0 = _mm_set1_ps(A0 * 4.0f);
+		const __m128 vStepX1 = _mm_set1_ps(A1 * 4.0f);
+		const __m128 vStepX2 = _mm_set1_ps(A2 * 4.0f);
+
+		// clip the triangle bounds to the tile, align x to the SIMD width
+		const int minX = std::max(tri.minX, tileMinX) & ~3;
+		const int maxX = std::min(tri.maxX, tileMaxX);
+		const int minY = std::max(tri.minY, tileMinY);
+		const int maxY = std::min(tri.maxY, tileMaxY);
+
+		const __m128 px = _mm_add_ps(_mm_set1_ps(static_cast<float>(minX)), pixelOffsetsX);
+		for (int y = minY; y <= maxY; ++y)
+		{
+			const __m128 py = _mm_set1_ps(static_cast<float>(y) + 0.5f);
+			__m128 e0 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(vA0, px), _mm_mul_ps(vB0, py)), vC0);
+			__m128 e1 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(vA1, px), _mm_mul_ps(vB1, py)), vC1);
+			__m128 e2 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(vA2, px), _mm_mul_ps(vB2, py)), vC2);
+
+			float* pRow = &mDepthBuffer[y * DEPTH_BUFFER_WIDTH];
+			for (int x = minX; x <= maxX; x += 4)
+			{
+				const __m128 inside = _mm_and_ps(_mm_and_ps(_mm_cmpge_ps(e0, zero), _mm_cmpge_ps(e1, zero)), _mm_cmpge_ps(e2, zero));
+				if (_mm_movemask_ps(inside))
+				{
+					const __m128 depth = _mm_add_ps(vZ0, _mm_add_ps(_mm_mul_ps(e1, vZ10), _mm_mul_ps(e2, vZ20)));
+					const __m128 prev  = _mm_loadu_ps(pRow + x);
+					const __m128 write = _mm_and_ps(inside, _mm_cmplt_ps(depth, prev));
+					_mm_storeu_ps(pRow + x, _mm_or_ps(_mm_and_ps(write, depth), _mm_andnot_ps(write, prev)));
+				}
+				e0 = _mm_add_ps(e0, vStepX0);
+				e1 = _mm_add_ps(e1, vStepX1);
+				e2 = _mm_add_ps(e2, vStepX2);
+			}
+		}
+	}
+
+	// BUILD HiZ : farthest depth per block
+	//
+	for (int blockY = tileMinY / HIZ_BLOCK_SIZE; blockY <= tileMaxY / HIZ_BLOCK_SIZE; ++blockY)
+	for (int blockX = tileMinX / HIZ_BLOCK_SIZE; blockX <= tileMaxX / HIZ_BLOCK_SIZE; ++blockX)
+	{
+		__m128 maxDepth = _mm_setzero_ps();
+		for (int y = blockY * HIZ_BLOCK_SIZE; y < (blockY + 1) * HIZ_BLOCK_SIZE; ++y)
+		{
+			const float* pRow = &mDepthBuffer[y * DEPTH_BUFFER_WIDTH];
+			for (int x = blockX * HIZ_BLOCK_SIZE; x < (blockX + 1) * HIZ_BLOCK_SIZE; x += 4)
+			{
+				maxDepth = _mm_max_ps(maxDepth, _mm_loadu_ps(pRow + x));
+			}
+		}
+		maxDepth = _mm_max_ps(maxDepth, _mm_shuffle_ps(maxDepth, maxDepth, _MM_SHUFFLE(2, 3, 0, 1)));
+		maxDepth = _mm_max_ps(maxDepth, _mm_shuffle_ps(maxDepth, maxDepth, _MM_SHUFFLE(1, 0, 3, 2)));
+		mHiZBuffer[blockY * HIZ_WIDTH + blockX] = _mm_cvtss_f32(maxDepth);
+	}
+}
+
+bool OcclusionCuller::IsVisible(const BoundingBox& aabb_world) const
+{
+	const vec3& lo = aabb_world.low;
+	const vec3& hi = aabb_world.hi;
+	const vec4 corners[] =
+	{
+		{ lo.x(), lo.y(), lo.z(), 1.0f },
+		{ hi.x(), lo.y(), lo.z(), 1.0f },
+		{ hi.x(), hi.y(), lo.z(), 1.0f },
+		{ lo.x(), hi.y(), lo.z(), 1.0f },
+		{ lo.x(), lo.y(), hi.z(), 1.0f },
+		{ hi.x(), lo.y(), hi.z(), 1.0f },
+		{ hi.x(), hi.y(), hi.z(), 1.0f },
+		{ lo.x(), hi.y(), hi.z(), 1.0f },
+	};
+
+	// SCREEN SPACE BOUNDS
+	//
+	float minXf = std::numeric_limits<float>::max();
+	float minYf = std::numeric_limits<float>::max();
+	float maxXf = -std::numeric_limits<float>::max();
+	float maxYf = -std::numeric_limits<float>::max();
+	float minZ  = std::numeric_limits<float>::max();
+	for (const vec4& corner : corners)
+	{
+		const XMVECTOR clip = XMVector4Transform(corner, mViewProj);
+		if (XMVectorGetZ(clip) < 0.0f)
+			return true;	// crosses the near plane
+
+		const XMFLOAT3 p = ClipToScreen(clip);
+		minXf = std::min(minXf, p.x); maxXf = std::max(maxXf, p.x);
+		minYf = std::min(minYf, p.y); maxYf = std::max(maxYf, p.y);
+		minZ  = std::min(minZ, p.z);
+	}
+
+	// every pixel the bounds touch, not only the ones with covered centers
+	const int minX = std::max(0, static_cast<int>(std::floor(minXf)));
+	const int minY = std::max(0, static_cast<int>(std::floor(minYf)));
+	const int maxX = std::min(DEPTH_BUFFER_WIDTH  - 1, static_cast<int>(std::floor(maxXf)));
+	const int maxY = std::min(DEPTH_BUFFER_HEIGHT - 1, static_cast<int>(std::floor(maxYf)));
+	if (minX > maxX || minY > maxY)
+		return true;	// off-screen: frustum culling is responsible for these
+
+	// HIERARCHICAL TEST
+	//
+	for (int blockY = minY / HIZ_BLOCK_SIZE; blockY <= maxY / HIZ_BLOCK_SIZE; ++blockY)
+	for (int blockX = minX / HIZ_BLOCK_SIZE; blockX <= maxX / HIZ_BLOCK_SIZE; ++blockX)
+	{
+		if (minZ > mHiZBuffer[blockY * HIZ_WIDTH + blockX])
+			continue;	// the whole block is in front of the box
+
+		// refine with the full resolution depth buffer
+		const int x0 = std::max(minX, blockX * HIZ_BLOCK_SIZE);
+		const int y0 = std::max(minY, blockY * HIZ_BLOCK_SIZE);
+		const int x1 = std::min(maxX, (blockX + 1) * HIZ_BLOCK_SIZE - 1);
+		const int y1 = std::min(maxY, (blockY + 1) * HIZ_BLOCK_SIZE - 1);
+		for (int y = y0; y <= y1; ++y)
+		for (int x = x0; x <= x1; ++x)
+		{
+			if (minZ <= mDepthBuffer[y * DEPTH_BUFFER_WIDTH + x])
+				return true;
+		}
+	}
+	return false;
+}
+
+
+
+//----------------------------------------------------------------------------------------------------------------
+// SELF-CHECK
+//----------------------------------------------------------------------------------------------------------------
+// depth of the nearest triangle covering each pixel center, evaluated per pixel in double precision.
+// Pixels within a small distance of an edge are marked ambiguous: the SIMD rasterizer steps its edge
+// functions incrementally and may round them to the other side.
+static void RasterizeReference(const std::vector<std::array<XMFLOAT3, 3>>& triangles, std::vector<float>& outDepth, std::vector<bool>& outAmbiguous)
+{
+	constexpr double EDGE_EPSILON = 1e-4;	// in barycentric units
+	outDepth.assign(OcclusionCuller::DEPTH_BUFFER_WIDTH * OcclusionCuller::DEPTH_BUFFER_HEIGHT, DEPTH_CLEAR_VALUE);
+	outAmbiguous.assign(outDepth.size(), false);
+	for (const std::array<XMFLOAT3, 3>& v : triangles)
+	{
+		const double area = (static_cast<double>(v[1].x) - v[0].x) * (static_cast<double>(v[2].y) - v[0].y)
+		                  - (static_cast<double>(v[2].x) - v[0].x) * (static_cast<double>(v[1].y) - v[0].y);
+		if (std::abs(area) < 1e-6)
+			continue;
+
+		for (int y = 0; y < OcclusionCuller::DEPTH_BUFFER_HEIGHT; ++y)
+		for (int x = 0; x < OcclusionCuller::DEPTH_BUFFER_WIDTH; ++x)
+		{
+			const double px = x + 0.5, py = y + 0.5;
+			auto fnEdge = [&](const XMFLOAT3& a, const XMFLOAT3& b) { return ((b.x - a.x) * (py - a.y) - (b.y - a.y) * (px - a.x)) / area; };
+			const double l0 = fnEdge(v[1], v[2]);
+			const double l1 = fnEdge(v[2], v[0]);
+			const double l2 = fnEdge(v[0], v[1]);
+			const double minL = std::min({ l0, l1, l2 });
+			const size_t pixel = static_cast<size_t>(y) * OcclusionCuller::DEPTH_BUFFER_WIDTH + x;
+			if (minL > EDGE_EPSILON)
+				outDepth[pixel] = std::min(outDepth[pixel], static_cast<float>(l0 * v[0].z + l1 * v[1].z + l2 * v[2].z));
+			else if (minL > -EDGE_EPSILON)
+				outAmbiguous[pixel] = true;
+		}
+	}
+}
+
+bool OcclusionCuller::RunTests(VQEngine::ThreadPool* pThreadPool)
+{
+	bool bPassed = true;
+	auto fnCheck = [&](bool bCondition, const char* pCase)
+	{
+		if (bCondition) return;
+		Log::Error("OcclusionCuller test failed: %s", pCase);
+		bPassed = false;
+	};
+
+	// camera at z=-10 looking at +z, same aspect ratio as the depth buffer
+	const XMMATRIX view = XMMatrixLookAtLH(XMVectorSet(0.0f, 0.0f, -10.0f, 1.0f), XMVectorSet(0.0f, 0.0f, 0.0f, 1.0f), XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f));
+	const XMMATRIX proj = XMMatrixPerspectiveFovLH(XM_PIDIV4, static_cast<float>(DEPTH_BUFFER_WIDTH) / DEPTH_BUFFER_HEIGHT, 0.1f, 100.0f);
+	const XMMATRIX viewProj = view * proj;
+
+	// OCCLUDERS: a 6x4 wall at z=0, a slanted floor triangle below it, and a triangle behind the camera
+	//
+	OccluderMesh wall;
+	wall.positions = { vec3(-3.0f, -2.0f, 0.0f), vec3(3.0f, -2.0f, 0.0f), vec3(3.0f, 2.0f, 0.0f), vec3(-3.0f, 2.0f, 0.0f) };
+	wall.indices = { 0, 1, 2, 0, 2, 3 };
+
+	OccluderMesh floorTriangle;
+	floorTriangle.positions = { vec3(-8.0f, -5.0f, 6.0f), vec3(8.0f, -5.0f, 6.0f), vec3(0.0f, -3.5f, 12.0f) };
+	floorTriangle.indices = { 0, 1, 2 };
+
+	OccluderMesh nearPlaneCrossing;
+	nearPlaneCrossing.positions = { vec3(-1.0f, 0.0f, -12.0f), vec3(1.0f, 0.0f, -12.0f), vec3(0.0f, 1.0f, 5.0f) };
+	nearPlaneCrossing.indices = { 0, 1, 2 };
+
+	auto fnRasterize = [&](OcclusionCuller& culler, VQEngine::ThreadPool* pPool)
+	{
+		culler.BeginFrame(viewProj);
+		culler.AddOccluder(&wall, XMMatrixIdentity());
+		culler.AddOccluder(&floorTriangle, XMMatrixIdentity());
+		culler.AddOccluder(&nearPlaneCrossing, XMMatrixIdentity());
+		culler.RasterizeOccluders(pPool);
+	};
+
+	OcclusionCuller serial;
+	fnRasterize(serial, nullptr);
+	fnCheck(serial.GetStats().numOccluders == 3, "occluder count");
+	fnCheck(serial.GetStats().numOccluderTriangles == 3, "the triangle crossing the near plane is dropped");
+
+	// REFERENCE IMAGE
+	//
+	std::vector<std::array<XMFLOAT3, 3>> triangles;
+	for (const ScreenTriangle& tri : serial.mTriangles)
+		triangles.push_back({ tri.v[0], tri.v[1], tri.v[2] });
+
+	std::vector<float> referenceDepth;
+	std::vector<bool> bAmbiguous;
+	RasterizeReference(triangles, referenceDepth, bAmbiguous);
+
+	int numMismatchedPixels = 0, numCoveredPixels = 0;
+	for (size_t pixel = 0; pixel < referenceDepth.size(); ++pixel)
+	{
+		if (bAmbiguous[pixel])
+			continue;
+		numCoveredPixels += referenceDepth[pixel] < DEPTH_CLEAR_VALUE ? 1 : 0;
+		if (std::abs(serial.mDepthBuffer[pixel] - referenceDepth[pixel]) > 1e-5f)
+			++numMismatchedPixels;
+	}
+	if (numMismatchedPixels > 0)
+		Log::Error("OcclusionCuller test: %d pixels differ from the reference image", numMismatchedPixels);
+	fnCheck(numMismatchedPixels == 0, "depth buffer matches the reference image");
+	fnCheck(numCoveredPixels > 0, "the occluders cover some pixels");
+
+	bool bHiZMatches = true;
+	for (int blockY = 0; blockY < HIZ_HEIGHT; ++blockY)
+	for (int blockX = 0; blockX < HIZ_WIDTH; ++blockX)
+	{
+		float maxDepth = 0.0f;
+		for (int y = blockY * HIZ_BLOCK_SIZE; y < (blockY + 1) * HIZ_BLOCK_SIZE; ++y)
+		for (int x = blockX * HIZ_BLOCK_SIZE; x < (blockX + 1) * HIZ_BLOCK_SIZE; ++x)
+			maxDepth = std::max(maxDepth, serial.mDepthBuffer[y * DEPTH_BUFFER_WIDTH + x]);
+		bHiZMatches &= serial.mHiZBuffer[blockY * HIZ_WIDTH + blockX] == maxDepth;
+	}
+	fnCheck(bHiZMatches, "HiZ holds the farthest depth of each block");
+
+	// the tiles don't share pixels: rasterizing them on the workers gives the same image
+	if (pThreadPool)
+	{
+		OcclusionCuller threaded;
+		fnRasterize(threaded, pThreadPool);
+		fnCheck(threaded.mDepthBuffer == serial.mDepthBuffer && threaded.mHiZBuffer == serial.mHiZBuffer, "threaded rasterization matches the serial one");
+	}
+
+	// VISIBILITY SET
+	//
+	struct TestBox
+	{
+		const char* pName;
+		BoundingBox aabb;
+		bool bExpectedVisible;
+	};
+	auto fnBox = [](float x0, float y0, float z0, float x1, float y1, float z1) { BoundingBox bb; bb.low = vec3(x0, y0, z0); bb.hi = vec3(x1, y1, z1); return bb; };
+	const TestBox boxes[] =
+	{
+		{ "behind the wall"          , fnBox(-1.0f, -1.0f,   2.0f, 1.0f, 1.0f,  4.0f), false },
+		{ "in front of the wall"     , fnBox(-1.0f, -1.0f,  -3.0f, 1.0f, 1.0f, -2.0f), true  },
+		{ "beside the wall"          , fnBox( 5.0f, -0.5f,   3.0f, 6.0f, 0.5f,  4.0f), true  },
+		{ "partially behind the wall", fnBox( 2.0f, -0.5f,   2.0f, 4.0f, 0.5f,  3.0f), true  },
+		{ "around the camera"        , fnBox(-1.0f, -1.0f, -10.5f, 1.0f, 1.0f, -9.5f), true  },
+	};
+	for (const TestBox& box : boxes)
+	{
+		if (serial.IsVisible(box.aabb) != box.bExpectedVisible)
+		{
+			Log::Error("OcclusionCuller test: box %s is %s, expected %s", box.pName
+				, box.bExpectedVisible ? "culled" : "visible", box.bExpectedVisible ? "visible" : "culled");
+			bPassed = false;
+		}
+	}
+	return bPassed;
+}
+
@@ -0,0 +1,559 @@
+//	VQEngine | DirectX11 Renderer
+//	Copyright(C) 2018  - Volkan Ilbeyli
+//
+//	This program is free software : you can redistribute it and / or modify
+//	it under the terms of the GNU General Public License as published by
+//	the Free Software Foundation, either version 3 of the License, or
+//	(at your option) any later version.
+//
+//	This program is distributed in the hope that it will be useful,
+//	but WITHOUT ANY WARRANTY; without even the implied warranty of
+//	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+//	GNU General Public License for more details.
+//
+//	You should have received a copy of the GNU General Public License
+//	along with this program.If not, see <http://www.gnu.org/licenses/>.
+//
+//	Contact: volkanilbeyli@gmail.com
+
+#include "RenderGraph.h"
+
+#include "Renderer/Renderer.h"
+
+#include "Utilities/Log.h"
+
+#include <algorithm>
+#include <cassert>
+
+static size_t GetBytesPerPixel(EImageFormat format)
+{
+	switch (format)
+	{
+	case RGBA32F:               return 16;
+	case RGB32F:                return 12;
+	case RGBA16F:
+	case RG32F:                 return 8;
+	case RGBA8UN:
+	case RG16F:
+	case R32F:
+	case R32U:
+	case R32:
+	case R24G8:
+	case R24_UNORM_X8_TYPELESS:
+	case D32F:
+	case D24UNORM_S8U:          return 4;
+	case R8U:
+	case R8UN:                  return 1;
+	default:
+		Log::Warning("RenderGraph: Unknown image format (%d), assuming 4 bytes per pixel.", format);
+		return 4;
+	}
+}
+
+size_t RGResourceDesc::GetSizeInBytes() const
+{
+	return static_cast<size_t>(width) * height * GetBytesPerPixel(format);
+}
+
+
+
+//----------------------------------------------------------------------------------------------------------------
+// TRANSIENT RESOURCE POOL
+//----------------------------------------------------------------------------------------------------------------
+void TransientResourcePool::BeginFrame()
+{
+	for (PooledRenderTarget& rt : mRenderTargets)
+		rt.bInUse = false;
+}
+
+RenderTargetID TransientResourcePool::Acquire(Renderer* pRenderer, const RGResourceDesc& desc)
+{
+	for (PooledRenderTarget& rt : mRenderTargets)
+	{
+		if (!rt.bInUse && rt.desc == desc)
+		{
+			rt.bInUse = true;
+			return rt.renderTarget;
+		}
+	}
+
+	RenderTargetDesc rtDesc = {};
+	rtDesc.textureDesc.width = desc.width;
+	rtDesc.textureDesc.height = desc.height;
+	rtDesc.textureDesc.mipCount = 1;
+	rtDesc.textureDesc.arraySize = 1;
+	rtDesc.textureDesc.format = desc.format;
+	rtDesc.textureDesc.usage = ETextureUsage::RENDER_TARGET_RW;
+	rtDesc.format = desc.format;
+
+	const RenderTargetID newRenderTarget = pRenderer->AddRenderTarget(rtDesc);
+	if (newRenderTarget == -1)
+	{
+		Log::Error("TransientResourcePool: Couldn't create %dx%d render target.", desc.width, desc.height);
+		return -1;
+	}
+
+	mRenderTargets.push_back({ desc, newRenderTarget, true });
+	mAllocatedMemory += desc.GetSizeInBytes();
+	return newRenderTarget;
+}
+
+
+
+//----------------------------------------------------------------------------------------------------------------
+// RENDER GRAPH - RECORD
+//----------------------------------------------------------------------------------------------------------------
+void RenderGraph::Reset()
+{
+	mResources.clear();
+	mPasses.clear();
+	mCompiledPasses.clear();
+	mPhysicalSlots.clear();
+	mStats = {};
+	mbCompiled = false;
+}
+
+RGResourceID RenderGraph::AddResource(const char* pName, EResourceType type, const RGResourceDesc& desc, int externalHandle)
+{
+	Resource r;
+	r.name = pName;
+	r.type = type;
+	r.desc = desc;
+	r.externalHandle = externalHandle;
+	r.bOutput = false;
+	r.firstUse = -1;
+	r.lastUse = -1;
+	r.physicalSlot = -1;
+	mResources.push_back(r);
+	mbCompiled = false;
+	return static_cast<RGResourceID>(mResources.size() - 1);
+}
+
+RGResourceID RenderGraph::ImportRenderTarget(const char* pName, RenderTargetID renderTarget)
+{
+	return AddResource(pName, IMPORTED_RENDER_TARGET, RGResourceDesc(), renderTarget);
+}
+
+RGResourceID RenderGraph::ImportTexture(const char* pName, TextureID texture)
+{
+	return AddResource(pName, IMPORTED_TEXTURE, RGResourceDesc(), texture);
+}
+
+RGResourceID RenderGraph::CreateTransientRenderTarget(const char* pName, const RGResourceDesc& desc)
+{
+	assert(desc.width > 0 && desc.height > 0);
+	return AddResource(pName, TRANSIENT_RENDER_TARGET, desc, -1);
+}
+
+void RenderGraph::AddPass(const char* pName
+	, const std::vector<RGResourceID>& reads
+	, const std::vector<RGResourceID>& writes
+	, ExecuteCallback fnExecute
+	, bool bHasSideEffects /*= false*/)
+{
+	Pass p;
+	p.name = pName;
+	p.reads = reads;
+	p.writes = writes;
+	p.fnExecute = std::move(fnExecute);
+	p.bHasSideEffects = bHasSideEffects;
+	p.bCulled = false;
+	mPasses.push_back(std::move(p));
+	mbCompiled = false;
+}
+
+void RenderGraph::MarkOutput(RGResourceID resource)
+{
+	mResources[resource].bOutput = true;
+}
+
+
+
+//----------------------------------------------------------------------------------------------------------------
+// RENDER GRAPH - COMPILE
+//----------------------------------------------------------------------------------------------------------------
+bool RenderGraph::Compile()
+{
+	mCompiledPasses.clear();
+	mPhysicalSlots.clear();
+	mStats = {};
+	mbCompiled = false;
+
+	if (!BuildDependencies())
+		return false;
+
+	CullPasses();
+	ComputeLifetimes();
+	AssignPhysicalSlots();
+
+	mStats.numPasses = static_cast<int>(mPasses.size());
+	mStats.numCulledPasses = static_cast<int>(mPasses.size() - mCompiledPasses.size());
+	mStats.numPhysicalResources = static_cast<int>(mPhysicalSlots.size());
+	for (const Resource& r : mResources)
+	{
+		if (r.type != TRANSIENT_RENDER_TARGET)
+			continue;
+		mStats.requestedMemory += r.desc.GetSizeInBytes();
+		if (r.physicalSlot != -1)
+			++mStats.numTransientResources;
+	}
+	for (const PhysicalSlot& slot : mPhysicalSlots)
+		mStats.allocatedMemory += slot.desc.GetSizeInBytes();
+
+	mbCompiled = true;
+	return true;
+}
+
+// Passes execute in submission order, so a pass can only depend on the passes recorded before it.
+// We only track the data flow (read-after-write and write-after-write) since that's what decides
+// whether a pass contributes to the outputs.
+//
+bool RenderGraph::BuildDependencies()
+{
+	std::vector<int> lastWriter(mResources.size(), -1);
+	for (int pass = 0; pass < static_cast<int>(mPasses.size()); ++pass)
+	{
+		Pass& p = mPasses[pass];
+		p.dependencies.clear();
+		p.bCulled = false;
+
+		for (RGResourceID r : p.reads)
+		{
+			if (lastWriter[r] != -1)
+			{
+				p.dependencies.push_back(lastWriter[r]);
+			}
+			else if (mResources[r].type == TRANSIENT_RENDER_TARGET)
+			{
+				Log::Error("RenderGraph: Pass '%s' reads transient resource '%s' before it's written.", p.name.c_str(), mResources[r].name.c_str());
+				return false;
+			}
+		}
+		for (RGResourceID r : p.writes)
+		{
+			if (lastWriter[r] != -1)
+				p.dependencies.push_back(lastWriter[r]);
+			lastWriter[r] = pass;
+		}
+	}
+	return true;
+}
+
+// Walks the dependencies backwards starting from the passes that write to the outputs.
+//
+void RenderGraph::CullPasses()
+{
+	std::vector<bool> bNeeded(mPasses.size(), false);
+	for (int pass = static_cast<int>(mPasses.size()) - 1; pass >= 0; --pass)
+	{
+		const Pass& p = mPasses[pass];
+		const bool bWritesOutput = std::any_of(p.writes.begin(), p.writes.end(), [&](RGResourceID r) { return mResources[r].bOutput; });
+		if (bWritesOutput || p.bHasSideEffects)
+			bNeeded[pass] = true;
+
+		if (!bNeeded[pass])
+			continue;
+
+		// dependencies always point to earlier passes, a single reverse sweep is enough
+		for (int dependency : p.dependencies)
+			bNeeded[dependency] = true;
+	}
+
+	for (int pass = 0; pass < static_cast<int>(mPasses.size()); ++pass)
+	{
+		mPasses[pass].bCulled = !bNeeded[pass];
+		if (bNeeded[pass])
+			mCompiledPasses.push_back(pass);
+	}
+}
+
+void RenderGraph::ComputeLifetimes()
+{
+	for (Resource& r : mResources)
+	{
+		r.firstUse = -1;
+		r.lastUse = -1;
+		r.physicalSlot = -1;
+	}
+
+	for (int i = 0; i < static_cast<int>(mCompiledPasses.size()); ++i)
+	{
+		const Pass& p = mPasses[mCompiledPasses[i]];
+		auto fnTouch = [&](RGResourceID id)
+		{
+			Resource& r = mResources[id];
+			if (r.firstUse == -1) r.firstUse = i;
+			r.lastUse = i;
+		};
+		std::for_each(p.reads.begin(), p.reads.end(), fnTouch);
+		std::for_each(p.writes.begin(), p.writes.end(), fnTouch);
+	}
+}
+
+// Greedy interval allocation: resources are visited in the order they come alive and take
+// the first compatible slot whose previous occupant is dead by then.
+//
+void RenderGraph::AssignPhysicalSlots()
+{
+	std::vector<RGResourceID> transients;
+	for (RGResourceID id = 0; id < static_cast<RGResourceID>(mResources.size()); ++id)
+	{
+		const Resource& r = mResources[id];
+		if (r.type == TRANSIENT_RENDER_TARGET && r.firstUse != -1)
+			transients.push_back(id);
+	}
+	std::stable_sort(transients.begin(), transients.end(), [&](RGResourceID a, RGResourceID b)
+	{
+		return mResources[a].firstUse < mResources[b].firstUse;
+	});
+
+	for (RGResourceID id : transients)
+	{
+		Resource& r = mResources[id];
+		for (int slot = 0; slot < static_cast<int>(mPhysicalSlots.size()); ++slot)
+		{
+			PhysicalSlot& s = mPhysicalSlots[slot];
+			if (s.desc == r.desc && s.lastUse < r.firstUse)
+			{
+				r.physicalSlot = slot;
+				s.lastUse = r.lastUse;
+				break;
+			}
+		}
+
+		if (r.physicalSlot == -1)
+		{
+			mPhysicalSlots.push_back({ r.desc, r.lastUse, -1 });
+			r.physicalSlot = static_cast<int>(mPhysicalSlots.size() - 1);
+		}
+	}
+}
+
+
+
+//----------------------------------------------------------------------------------------------------------------
+// RENDER GRAPH - VALIDATION
+//----------------------------------------------------------------------------------------------------------------
+bool RenderGraph::Validate() const
+{
+	if (!mbCompiled)
+	{
+		Log::Error("RenderGraph: Validate() called before a successful Compile().");
+		return false;
+	}
+
+	bool bValid = true;
+	auto fnError = [&](const char* pFormat, const std::string& pass, const std::string& resource)
+	{
+		Log::Error(pFormat, pass.c_str(), resource.c_str());
+		bValid = false;
+	};
+
+	// PASS ORDER
+	//
+	std::vector<int> compiledPosition(mPasses.size(), -1);
+	for (int i = 0; i < static_cast<int>(mCompiledPasses.size()); ++i)
+	{
+		if (i > 0 && mCompiledPasses[i] <= mCompiledPasses[i - 1])
+			fnError("RenderGraph: Pass '%s' is scheduled out of submission order%s", mPasses[mCompiledPasses[i]].name, "");
+		compiledPosition[mCompiledPasses[i]] = i;
+	}
+	for (int pass = 0; pass < static_cast<int>(mPasses.size()); ++pass)
+	{
+		const Pass& p = mPasses[pass];
+		if (compiledPosition[pass] == -1)
+		{
+			const bool bWritesOutput = std::any_of(p.writes.begin(), p.writes.end(), [&](RGResourceID r) { return mResources[r].bOutput; });
+			if (bWritesOutput || p.bHasSideEffects)
+				fnError("RenderGraph: Pass '%s' is culled but it's needed%s", p.name, "");
+			continue;
+		}
+		for (int dependency : p.dependencies)
+		{
+			if (compiledPosition[dependency] == -1 || compiledPosition[dependency] >= compiledPosition[pass])
+				fnError("RenderGraph: Pass '%s' runs before the pass it depends on, '%s'", p.name, mPasses[dependency].name);
+		}
+	}
+
+	// RESOURCE VISIBILITY
+	//
+	std::vector<bool> bWritten(mResources.size(), false);
+	for (int i = 0; i < static_cast<int>(mCompiledPasses.size()); ++i)
+	{
+		const Pass& p = mPasses[mCompiledPasses[i]];
+		for (RGResourceID id : p.reads)
+		{
+			const Resource& r = mResources[id];
+			if (r.type == TRANSIENT_RENDER_TARGET && !bWritten[id])
+				fnError("RenderGraph: Pass '%s' reads '%s' before any scheduled pass writes it", p.name, r.name);
+		}
+		for (RGResourceID id : p.writes)
+			bWritten[id] = true;
+
+		auto fnCheckLifetime = [&](RGResourceID id)
+		{
+			const Resource& r = mResources[id];
+			if (i < r.firstUse || i > r.lastUse)
+				fnError("RenderGraph: Pass '%s' uses '%s' outside of its lifetime", p.name, r.name);
+			if (r.type == TRANSIENT_RENDER_TARGET && r.physicalSlot == -1)
+				fnError("RenderGraph: Pass '%s' uses '%s' which has no physical slot", p.name, r.name);
+		};
+		std::for_each(p.reads.begin(), p.reads.end(), fnCheckLifetime);
+		std::for_each(p.writes.begin(), p.writes.end(), fnCheckLifetime);
+	}
+
+	// ALIASING
+	//
+	for (RGResourceID a = 0; a < static_cast<RGResourceID>(mResources.size()); ++a)
+	{
+		const Resource& ra = mResources[a];
+		if (ra.physicalSlot == -1)
+			continue;
+		if (mPhysicalSlots[ra.physicalSlot].desc != ra.desc)
+			fnError("RenderGraph: '%s' is aliased onto a physical slot with a different descriptor%s", ra.name, "");
+		for (RGResourceID b = a + 1; b < static_cast<RGResourceID>(mResources.size()); ++b)
+		{
+			const Resource& rb = mResources[b];
+			const bool bOverlapping = ra.firstUse <= rb.lastUse && rb.firstUse <= ra.lastUse;
+			if (rb.physicalSlot == ra.physicalSlot && bOverlapping)
+				fnError("RenderGraph: '%s' and '%s' are alive at the same time on the same physical slot", ra.name, rb.name);
+		}
+	}
+	return bValid;
+}
+
+bool RenderGraph::RunCompileTests()
+{
+	bool bPassed = true;
+	auto fnCheck = [&](bool bCondition, const char* pCase)
+	{
+		if (bCondition) return;
+		Log::Error("RenderGraph test failed: %s", pCase);
+		bPassed = false;
+	};
+	auto fnGetScheduleNames = [](const RenderGraph& graph)
+	{
+		std::vector<std::string> names;
+		for (int pass : graph.GetCompiledPasses())
+			names.push_back(graph.GetPassName(pass));
+		return names;
+	};
+
+	const RGResourceDesc halfRes = { 960, 540, RGBA16F };
+	const RGResourceDesc fullRes = { 1920, 1080, RGBA16F };
+
+	// BLOOM CHAIN: the blur ping-pong targets alias the bright filter target, the debug branch is culled
+	//
+	{
+		RenderGraph graph;
+		const RGResourceID world     = graph.ImportRenderTarget("World", 0);
+		const RGResourceID backBuf   = graph.ImportRenderTarget("Back Buffer", 1);
+		const RGResourceID bright    = graph.CreateTransientRenderTarget("Bright", halfRes);
+		const RGResourceID ping      = graph.CreateTransientRenderTarget("Blur Ping", halfRes);
+		const RGResourceID pong      = graph.CreateTransientRenderTarget("Blur Pong", halfRes);
+		const RGResourceID combined  = graph.CreateTransientRenderTarget("Combined", fullRes);
+		const RGResourceID debugView = graph.CreateTransientRenderTarget("Debug View", fullRes);
+
+		graph.AddPass("Bright Filter", { world }, { bright }, nullptr);
+		graph.AddPass("Debug View", { bright }, { debugView }, nullptr);
+		graph.AddPass("Blur H", { bright }, { ping }, nullptr);
+		graph.AddPass("Blur V", { ping }, { pong }, nullptr);
+		graph.AddPass("Combine", { world, pong }, { combined }, nullptr);
+		graph.AddPass("GPU Marker", {}, {}, nullptr, true);
+		graph.AddPass("Tonemapping", { combined }, { backBuf }, nullptr);
+		graph.MarkOutput(backBuf);
+
+		fnCheck(graph.Compile(), "bloom chain compiles");
+		fnCheck(graph.Validate(), "bloom chain validates");
+		fnCheck(fnGetScheduleNames(graph) == std::vector<std::string>{ "Bright Filter", "Blur H", "Blur V", "Combine", "GPU Marker", "Tonemapping" }
+			, "bloom chain schedule: submission order w/o the debug branch, side effect pass kept");
+
+		const Stats& stats = graph.GetStats();
+		fnCheck(stats.numCulledPasses == 1, "bloom chain culls the debug branch");
+		fnCheck(graph.GetPhysicalSlot(debugView) == -1, "culled pass' output isn't allocated");
+		fnCheck(graph.GetPhysicalSlot(bright) == graph.GetPhysicalSlot(pong), "bright filter and blur pong targets alias");
+		fnCheck(graph.GetPhysicalSlot(ping) != graph.GetPhysicalSlot(bright), "blur ping is alive with the other half res targets");
+		fnCheck(stats.numTransientResources == 4 && stats.numPhysicalResources == 3, "bloom chain physical slot count");
+		fnCheck(stats.allocatedMemory == 2 * halfRes.GetSizeInBytes() + fullRes.GetSizeInBytes(), "bloom chain allocated memory");
+		fnCheck(stats.GetMemorySaved() == halfRes.GetSizeInBytes() + fullRes.GetSizeInBytes(), "bloom chain memory saved");
+	}
+
+	// NO OUTPUTS: everything is culled except the side effect pass
+	//
+	{
+		RenderGraph graph;
+		const RGResourceID world = graph.ImportRenderTarget("World", 0);
+		const RGResourceID temp  = graph.CreateTransientRenderTarget("Temp", halfRes);
+		graph.AddPass("Downsample", { world }, { temp }, nullptr);
+		graph.AddPass("Readback", { temp }, {}, nullptr, true);
+		graph.AddPass("Unused", { world }, {}, nullptr);
+
+		fnCheck(graph.Compile(), "side effects compile");
+		fnCheck(graph.Validate(), "side effects validate");
+		fnCheck(fnGetScheduleNames(graph) == std::vector<std::string>{ "Downsample", "Readback" }, "side effect pass keeps its producers");
+	}
+
+	// INVALID: a transient resource is read before it's written
+	//
+	{
+		RenderGraph graph;
+		const RGResourceID backBuf = graph.ImportRenderTarget("Back Buffer", 1);
+		const RGResourceID temp    = graph.CreateTransientRenderTarget("Temp", halfRes);
+		graph.AddPass("Consumer", { temp }, { backBuf }, nullptr);
+		graph.AddPass("Producer", {}, { temp }, nullptr);
+		graph.MarkOutput(backBuf);
+
+		Log::Info("RenderGraph test: the next two errors are expected");
+		fnCheck(!graph.Compile(), "read before write fails to compile");
+		fnCheck(!graph.Validate(), "uncompiled graph doesn't validate");
+	}
+
+	return bPassed;
+}
+
+
+
+//----------------------------------------------------------------------------------------------------------------
+// RENDER GRAPH - EXECUTE
+//----------------------------------------------------------------------------------------------------------------
+void RenderGraph::Execute(Renderer* pRenderer, TransientResourcePool& pool)
+{
+	if (!mbCompiled)
+	{
+		Log::Error("RenderGraph: Execute() called before a successful Compile().");
+		return;
+	}
+
+	pool.BeginFrame();
+	for (PhysicalSlot& slot : mPhysicalSlots)
+		slot.renderTarget = pool.Acquire(pRenderer, slot.desc);
+
+	for (int pass : mCompiledPasses)
+	{
+		if (mPasses[pass].fnExecute)
+			mPasses[pass].fnExecute(pRenderer, *this);
+	}
+}
+
+RenderTargetID RenderGraph::GetRenderTarget(RGResourceID resource) const
+{
+	const Resource& r = mResources[resource];
+	switch (r.type)
+	{
+	case IMPORTED_RENDER_TARGET:  return r.externalHandle;
+	case TRANSIENT_RENDER_TARGET: return r.physicalSlot == -1 ? -1 : mPhysicalSlots[r.physicalSlot].renderTarget;
+	default:
+		Log::Error("RenderGraph: Resource '%s' is not a render target.", r.name.c_str());
+		return -1;
+	}
+}
+
+TextureID RenderGraph::GetTexture(const Renderer* pRenderer, RGResourceID resource) const
+{
+	const Resource& r = mResources[resource];
+	if (r.type == IMPORTED_TEXTURE)
+		return r.externalHandle;
+
+	const RenderTargetID rt = GetRenderTarget(resource);
+	return rt == -1 ? -1 : pRenderer->GetRenderTargetTexture(rt);
+}
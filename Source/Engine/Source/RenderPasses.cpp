@@ -90,50 +90,59 @@ void PostProcessPass::Initialize(Renderer* pRenderer, const Settings::PostProces
 
 
 
-void PostProcessPass::Render(Renderer* pRenderer, bool bBloomOn, TextureID texOverride) const
+void PostProcessPass::AddRenderGraphPasses(Renderer* pRenderer, RenderGraph& graph, bool bBloomOn, TextureID texOverride)
 {
 	const bool bBloom = bBloomOn && _settings.bloom.bEnabled && (texOverride == -1);
-	const auto IABuffersQuad = ENGINE->GetGeometryVertexAndIndexBuffers(EGeometry::FULLSCREENQUAD);
 
-	const TextureID worldTexture = pRenderer->GetRenderTargetTexture(_worldRenderTarget);
-	const TextureID colorTex = texOverride == -1
-		? ( pRenderer->GetRenderTargetTexture(bBloom ? _bloomPass._finalRT : _worldRenderTarget) )
-		: ( texOverride );
+	const RGResourceID worldRT = graph.ImportRenderTarget("World", _worldRenderTarget);
+	const RGResourceID finalRT = graph.ImportRenderTarget("Back Buffer", _tonemappingPass._finalRenderTarget);
 
-
-	pRenderer->BeginEvent("Post Processing");
 	// ======================================================================================
 	// BLOOM  PASS
 	// ======================================================================================
-	if (bBloom) this->_bloomPass.Render(pRenderer, _worldRenderTarget, _settings.bloom);
+	RGResourceID bloomRT = -1;
+	if (bBloom) this->_bloomPass.AddRenderGraphPasses(pRenderer, graph, worldRT, _settings.bloom, bloomRT);
 
 
 	// ======================================================================================
 	// TONEMAPPING PASS
 	// ======================================================================================
-	pRenderer->BeginEvent("Tonemapping");
-	pGPU->BeginEntry("Tonemapping");
-
-	pRenderer->UnbindDepthTarget();
-	pRenderer->SetShader(_tonemappingPass._toneMappingShader, true);
-	pRenderer->SetVertexBuffer(IABuffersQuad.first);
-	pRenderer->SetIndexBuffer(IABuffersQuad.second);
-	pRenderer->SetSamplerState("Sampler", _bloomPass._blurSampler);
-	pRenderer->SetConstant1f("exposure", _settings.toneMapping.exposure);
-	pRenderer->SetConstant1f("isHDR", _settings.HDREnabled ? 1.0f : 0.0f);
-	pRenderer->BindRenderTarget(_tonemappingPass._finalRenderTarget);
-	pRenderer->SetTexture("ColorTexture", colorTex);
-
-	// quick hack for outputting white texture for fullscreen AO debugging
-	pRenderer->SetConstant1i("isSingleChannel", texOverride != -1 ? 1 : 0);
-	// quick hack for outputting white texture for fullscreen AO debugging
-
-	pRenderer->Apply();
-	pRenderer->DrawIndexed();
-
-	pRenderer->EndEvent();	// Tonemapping
-	pGPU->EndEntry();		// Tonemapping
-	pRenderer->EndEvent();	// Post Process
+	const RGResourceID colorRT = bBloom ? bloomRT : worldRT;
+	const std::vector<RGResourceID> tonemappingReads = texOverride == -1
+		? std::vector<RGResourceID>{ colorRT }
+		: std::vector<RGResourceID>{};
+	graph.AddPass("Tonemapping", tonemappingReads, { finalRT }, [=](Renderer* pRenderer, const RenderGraph& graph)
+	{
+		const auto IABuffersQuad = ENGINE->GetGeometryVertexAndIndexBuffers(EGeometry::FULLSCREENQUAD);
+		const TextureID colorTex = texOverride == -1
+			? ( graph.GetTexture(pRenderer, colorRT) )
+			: ( texOverride );
+
+		pRenderer->BeginEvent("Tonemapping");
+		pGPU->BeginEntry("Tonemapping");
+
+		pRenderer->UnbindDepthTarget();
+		pRenderer->SetShader(_tonemappingPass._toneMappingShader, true);
+		pRenderer->SetVertexBuffer(IABuffersQuad.first);
+		pRenderer->SetIndexBuffer(IABuffersQuad.second);
+		pRenderer->SetSamplerState("Sampler", _bloomPass._blurSampler);
+		pRenderer->SetConstant1f("exposure", _settings.toneMapping.exposure);
+		pRenderer->SetConstant1f("isHDR", _settings.HDREnabled ? 1.0f : 0.0f);
+		pRenderer->BindRenderTarget(graph.GetRenderTarget(finalRT));
+		pRenderer->SetTexture("ColorTexture", colorTex);
+
+		// quick hack for outputting white texture for fullscreen AO debugging
+		pRenderer->SetConstant1i("isSingleChannel", texOverride != -1 ? 1 : 0);
+		// quick hack for outputting white texture for fullscreen AO debugging
+
+		pRenderer->Apply();
+		pRenderer->DrawIndexed();
+
+		pRenderer->EndEvent();	// Tonemapping
+		pGPU->EndEntry();		// Tonemapping
+	});
+
+	graph.MarkOutput(finalRT);
 }
 
 
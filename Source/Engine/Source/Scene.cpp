@@ -20,6 +20,7 @@
 
 #include "Scene.h"
 #include "Engine.h"
+#include "Culling.h"
 
 #include "Application/Input.h"
 #include "Application/ThreadPool.h"
@@ -83,7 +84,14 @@ void Scene::LoadScene(SerializedScene& scene, const Settings::Window& windowSett
 	StartLoadingModels();
 	EndLoadingModels();
 
-	CalculateSceneBoundingBox();	// needs to happen after models are loaded
+	// the bounding boxes and the occluders are calculated from the CPU copies of the vertex buffers,
+	// scenes loaded without a renderer (benchmarks) have neither and calculate their own bounds.
+	if (mpRenderer)
+	{
+		CalculateSceneBoundingBox();	// needs to happen after models are loaded
+		SelectOccluders();
+		LogMeshMemory();
+	}
 }
 
 void Scene::UnloadScene()
@@ -99,6 +107,8 @@ void Scene::UnloadScene()
 	mObjectPool.Cleanup();
 	mLights.clear();
 	mMeshes.clear();
+	mOccluders.clear();
+	mOccluderMeshes.clear();
 	mObjectPool.Cleanup();
 	Unload();
 }
@@ -173,7 +183,7 @@ int Scene::RenderOpaque(const SceneView& sceneView) const
 
 		// SET GEOMETRY & MATERIAL, THEN DRAW
 		mpRenderer->SetRasterizerState(EDefaultRasterizerState::CULL_BACK);
-		for(MeshID id : model.mMeshIDs)
+		for(MeshID id : sceneView.GetMeshRenderList(pObj))
 		{
 			const auto IABuffer = mMeshes[id].GetIABuffers();
 
@@ -384,8 +394,6 @@ void Scene::GatherLightData(SceneLightingData & outLightingData)
 	}
 }
 
-bool IsVisible(const FrustumPlaneset& frustum, const BoundingBox& aabb);
-
 void Scene::ResetActiveCamera()
 {
 	mCameras[mSelectedCamera].Reset();
@@ -448,6 +456,163 @@ void Scene::EndLoadingModels()
 	});
 }
 
+// position comes first in both DefaultVertexBufferData and CompactVertexBufferData
+static inline bool HasVertexPositions(const Buffer& vertexBuffer)
+{
+	return vertexBuffer.mpCPUData != nullptr
+		&& (vertexBuffer.mDesc.mStride == sizeof(DefaultVertexBufferData) || vertexBuffer.mDesc.mStride == sizeof(CompactVertexBufferData));
+}
+static inline const vec3& GetVertexPosition(const Buffer& vertexBuffer, unsigned vertex)
+{
+	return *reinterpret_cast<const vec3*>(static_cast<const char*>(vertexBuffer.mpCPUData) + static_cast<size_t>(vertex) * vertexBuffer.mDesc.mStride);
+}
+
+void Scene::SelectOccluders()
+{
+	// good occluders are big on screen and cheap to rasterize: we take the opaque
+	// meshes with a low triangle count whose bounds span a significant portion of
+	// the scene, largest first, until the triangle budget runs out.
+	constexpr size_t MAX_OCCLUDER_TRIANGLES_PER_MESH = 4096;
+	constexpr size_t MAX_OCCLUDER_TRIANGLES = 32768;
+	constexpr float  MIN_OCCLUDER_SIZE_RATIO = 0.1f;	// of the scene bounding box diagonal
+
+	struct OccluderCandidate
+	{
+		const GameObject* pObj;
+		MeshID meshID;
+		size_t numTriangles;
+		float  size;
+	};
+
+	auto Diagonal = [](const BoundingBox& aabb) { return XMVectorGetX(XMVector3Length(aabb.hi - aabb.low)); };
+	const float minOccluderSize = Diagonal(mBoundingBox) * MIN_OCCLUDER_SIZE_RATIO;
+
+	// each mesh is read back once: bounding box from the CPU copy of the vertex buffer
+	std::unordered_map<MeshID, BoundingBox> meshBounds;
+	auto GetMeshBounds = [&](MeshID meshID) -> const BoundingBox*
+	{
+		if (meshBounds.find(meshID) != meshBounds.end())
+			return &meshBounds.at(meshID);
+
+		const Buffer& vertexBuffer = mpRenderer->GetVertexBuffer(mMeshes[meshID].GetIABuffers().first);
+		if (!HasVertexPositions(vertexBuffer))
+			return nullptr;	// see #SHADER REFACTOR in CalculateSceneBoundingBox()
+
+		XMVECTOR mins = XMVectorReplicate( std::numeric_limits<float>::max());
+		XMVECTOR maxs = XMVectorReplicate(-std::numeric_limits<float>::max());
+		for (unsigned i = 0; i < vertexBuffer.mDesc.mElementCount; ++i)
+		{
+			mins = XMVectorMin(mins, GetVertexPosition(vertexBuffer, i));
+			maxs = XMVectorMax(maxs, GetVertexPosition(vertexBuffer, i));
+		}
+		BoundingBox& aabb = meshBounds[meshID];
+		aabb.low = mins;
+		aabb.hi = maxs;
+		return &aabb;
+	};
+
+	// GATHER CANDIDATES
+	//
+	std::vector<OccluderCandidate> candidates;
+	for (const GameObject* pObj : mpObjects)
+	{
+		if (!pObj->mRenderSettings.bRender)
+			continue;
+
+		const ModelData& model = pObj->GetModelData();
+		const XMMATRIX world = pObj->GetTransform().WorldTransformationMatrix();
+		for (MeshID meshID : model.mMeshIDs)
+		{
+			const bool bTransparent = std::find(RANGE(model.mTransparentMeshIDs), meshID) != model.mTransparentMeshIDs.end();
+			if (bTransparent)
+				continue;
+
+			const Buffer& indexBuffer = mpRenderer->GetIndexBuffer(mMeshes[meshID].GetIABuffers().second);
+			const size_t numTriangles = indexBuffer.mDesc.mElementCount / 3;
+			if (numTriangles > MAX_OCCLUDER_TRIANGLES_PER_MESH || indexBuffer.mpCPUData == nullptr)
+				continue;
+
+			const BoundingBox* pBounds = GetMeshBounds(meshID);
+			if (pBounds == nullptr)
+				continue;
+
+			const float size = Diagonal(TransformAABB(*pBounds, world));
+			if (size >= minOccluderSize)
+			{
+				candidates.push_back({ pObj, meshID, numTriangles, size });
+			}
+		}
+	}
+	std::sort(RANGE(candidates), [](const OccluderCandidate& c0, const OccluderCandidate& c1) { return c0.size > c1.size; });
+
+	// SELECT OCCLUDERS WITHIN BUDGET
+	//
+	size_t numTriangles = 0;
+	for (const OccluderCandidate& candidate : candidates)
+	{
+		if (numTriangles + candidate.numTriangles > MAX_OCCLUDER_TRIANGLES)
+			continue;
+		numTriangles += candidate.numTriangles;
+
+		if (mOccluderMeshes.find(candidate.meshID) == mOccluderMeshes.end())
+		{
+			const auto IABuffers = mMeshes[candidate.meshID].GetIABuffers();
+			const Buffer& vertexBuffer = mpRenderer->GetVertexBuffer(IABuffers.first);
+			const Buffer& indexBuffer = mpRenderer->GetIndexBuffer(IABuffers.second);
+
+			OccluderMesh& mesh = mOccluderMeshes[candidate.meshID];
+			mesh.positions.resize(vertexBuffer.mDesc.mElementCount);
+			for (unsigned i = 0; i < vertexBuffer.mDesc.mElementCount; ++i)
+			{
+				mesh.positions[i] = GetVertexPosition(vertexBuffer, i);
+			}
+			if (indexBuffer.mDesc.mStride == sizeof(uint16_t))
+			{
+				const uint16_t* pIndices = static_cast<const uint16_t*>(indexBuffer.mpCPUData);
+				mesh.indices.assign(pIndices, pIndices + indexBuffer.mDesc.mElementCount);
+			}
+			else
+			{
+				const unsigned* pIndices = static_cast<const unsigned*>(indexBuffer.mpCPUData);
+				mesh.indices.assign(pIndices, pIndices + indexBuffer.mDesc.mElementCount);
+			}
+			mesh.localAABB = meshBounds.at(candidate.meshID);
+		}
+		mOccluders.push_back({ candidate.pObj, candidate.meshID });
+	}
+
+	Log::Info("Occluders: %d meshes, %d triangles", static_cast<int>(mOccluders.size()), static_cast<int>(numTriangles));
+}
+
+void Scene::LogMeshMemory() const
+{
+	constexpr float BYTES_TO_MB = 1.0f / (1024.0f * 1024.0f);
+
+	size_t vertexBytes = 0;
+	size_t indexBytes = 0;
+	size_t uncompressedBytes = 0;
+	int numMeshes16BitIndices = 0;
+	int numMeshesCompactVertices = 0;
+	int numLODs = 0;
+	for (const Mesh& mesh : mMeshes)
+	{
+		numLODs += mesh.IsLOD() ? 1 : 0;
+		vertexBytes += mesh.GetVertexBufferSize();
+		indexBytes += mesh.GetIndexBufferSize();
+		uncompressedBytes += mesh.GetUncompressedBufferSize();
+		numMeshes16BitIndices += mesh.Has16BitIndices() ? 1 : 0;
+		numMeshesCompactVertices += mesh.HasCompactVertices() ? 1 : 0;
+	}
+
+	const size_t totalBytes = vertexBytes + indexBytes;
+	const size_t savedBytes = uncompressedBytes - totalBytes;
+	Log::Info("Mesh Memory: %.2f MB (vertices %.2f MB, indices %.2f MB) | saved %.2f MB (%.1f%%) | %d meshes (%d LODs): %d with 16-bit indices, %d with compact vertices"
+		, totalBytes * BYTES_TO_MB, vertexBytes * BYTES_TO_MB, indexBytes * BYTES_TO_MB
+		, savedBytes * BYTES_TO_MB, uncompressedBytes > 0 ? 100.0f * savedBytes / uncompressedBytes : 0.0f
+		, static_cast<int>(mMeshes.size()), numLODs, numMeshes16BitIndices, numMeshesCompactVertices
+	);
+}
+
 void Scene::CalculateSceneBoundingBox()
 {
 	// get the objects for the scene
@@ -460,17 +625,14 @@ void Scene::CalculateSceneBoundingBox()
 		}
 	}
 
-	constexpr float max_f = std::numeric_limits<float>::max();
-	vec3 mins(max_f);
-	vec3 maxs(-(max_f - 1.0f));
+	BoundingBox sceneBounds = EmptyBoundingBox();
 	PerfTimer timer;
 	timer.Start();
 	std::for_each(RANGE(pObjects), [&](GameObject* pObj)
 	{
 		XMMATRIX worldMatrix = pObj->GetTransform().WorldTransformationMatrix();
 
-		vec3 mins_obj(max_f);
-		vec3 maxs_obj(-(max_f - 1.0f));
+		BoundingBox objectBounds = EmptyBoundingBox();
 
 		const ModelData& modelData = pObj->GetModelData();
 		std::for_each(RANGE(modelData.mMeshIDs), [&](const MeshID& meshID)
@@ -480,68 +642,26 @@ void Scene::CalculateSceneBoundingBox()
 			const size_t numVerts = VertexBuffer.mDesc.mElementCount;
 			const size_t stride = VertexBuffer.mDesc.mStride;
 
-			constexpr size_t defaultSz = sizeof(DefaultVertexBufferData);
-			constexpr float DegenerateMeshPositionChannelValueMax = 15000.0f; // make sure no vertex.xyz is > 15,000.0f
-
 			// #SHADER REFACTOR:
 			//
 			// currently all the shader input is using default vertex buffer data.
 			// we just make sure that we can interpret the position data properly here
 			// by ensuring the vertex buffer stride for a given mesh matches
-			// the default vertex buffer.
+			// the default (or the compact) vertex buffer.
 			//
 			// TODO:
 			// Type information is not preserved once the vertex/index buffer is created.
 			// need to figure out a way to interpret the position data in a given buffer
 			//
-			if (stride == defaultSz)
+			if (stride == sizeof(DefaultVertexBufferData) || stride == sizeof(CompactVertexBufferData))
 			{
-				const DefaultVertexBufferData* pData = reinterpret_cast<const DefaultVertexBufferData*>(VertexBuffer.mpCPUData);
-				if (pData == nullptr)
+				if (VertexBuffer.mpCPUData == nullptr)
 				{
 					Log::Info("Nope: %d", int(stride));
 					return;
 				}
 
-				for (int i = 0; i < numVerts; ++i)
-				{
-					const vec3 worldPos = vec3(XMVector4Transform(vec4(pData[i].position, 1.0f), worldMatrix));
-					const float x_mesh = std::min(worldPos.x(), DegenerateMeshPositionChannelValueMax);
-					const float y_mesh = std::min(worldPos.y(), DegenerateMeshPositionChannelValueMax);
-					const float z_mesh = std::min(worldPos.z(), DegenerateMeshPositionChannelValueMax);
-
-					const float x_mesh_local = pData[i].position.x();
-					const float y_mesh_local = pData[i].position.y();
-					const float z_mesh_local = pData[i].position.z();
-
-					// scene bounding box - world space
-					mins = vec3
-					(
-						std::min(x_mesh, mins.x()),
-						std::min(y_mesh, mins.y()),
-						std::min(z_mesh, mins.z())
-					);
-					maxs = vec3
-					(
-						std::max(x_mesh, maxs.x()),
-						std::max(y_mesh, maxs.y()),
-						std::max(z_mesh, maxs.z())
-					);
-
-					// object bounding box - model space
-					mins_obj = vec3
-					(
-						std::min(x_mesh_local, mins_obj.x()),
-						std::min(y_mesh_local, mins_obj.y()),
-						std::min(z_mesh_local, mins_obj.z())
-					);
-					maxs_obj = vec3
-					(
-						std::max(x_mesh_local, maxs_obj.x()),
-						std::max(y_mesh_local, maxs_obj.y()),
-						std::max(z_mesh_local, maxs_obj.z())
-					);
-				}
+				AccumulateVertexBounds(VertexBuffer.mpCPUData, numVerts, stride, worldMatrix, sceneBounds, objectBounds);
 			}
 			else
 			{
@@ -549,18 +669,16 @@ void Scene::CalculateSceneBoundingBox()
 			}
 		});
 
-		pObj->mBoundingBox.hi = maxs_obj;
-		pObj->mBoundingBox.low = mins_obj;
+		pObj->mBoundingBox = objectBounds;
 	});
 
 	timer.Stop();
 	Log::Info("SceneBoundingBox:lo=(%.2f, %.2f, %.2f)\thi=(%.2f, %.2f, %.2f) in %.2fs"
-		, mins.x() , mins.y() , mins.z()
-		, maxs.x() , maxs.y() , maxs.z()
+		, sceneBounds.low.x(), sceneBounds.low.y(), sceneBounds.low.z()
+		, sceneBounds.hi.x() , sceneBounds.hi.y() , sceneBounds.hi.z()
 		, timer.DeltaTime()
 	);
-	mBoundingBox.hi = maxs;
-	mBoundingBox.low = mins;
+	mBoundingBox = sceneBounds;
 }
 
 
@@ -583,9 +701,11 @@ void Scene::UpdateScene(float dt)
 #if _DEBUG
 	if (ENGINE->INP()->IsKeyTriggered("F7"))
 	{
-		bool& toggle = ENGINE->INP()->IsKeyDown("Shift")
-			? mSceneRenderSettings.optimization.bViewFrustumCull_LocalLights
-			: mSceneRenderSettings.optimization.bViewFrustumCull_MainView;
+		bool& toggle = ENGINE->INP()->IsKeyDown("Ctrl")
+			? mSceneRenderSettings.optimization.bOcclusionCull_MainView
+			: ENGINE->INP()->IsKeyDown("Shift")
+				? mSceneRenderSettings.optimization.bViewFrustumCull_LocalLights
+				: mSceneRenderSettings.optimization.bViewFrustumCull_MainView;
 		
 		toggle = !toggle;
 	}
@@ -616,108 +736,101 @@ void Scene::UpdateScene(float dt)
 }
 
 
-static bool IsVisible(const FrustumPlaneset& frustum, const BoundingBox& aabb)
+size_t Scene::CullOccludedGameObjects(RenderList& renderList)
 {
-	const vec4 points[] =
-	{
-	{ aabb.low.x(), aabb.low.y(), aabb.low.z(), 1.0f },
-	{ aabb.hi.x() , aabb.low.y(), aabb.low.z(), 1.0f },
-	{ aabb.hi.x() , aabb.hi.y() , aabb.low.z(), 1.0f },
-	{ aabb.low.x(), aabb.hi.y() , aabb.low.z(), 1.0f },
-
-	{ aabb.low.x(), aabb.low.y(), aabb.hi.z() , 1.0f},
-	{ aabb.hi.x() , aabb.low.y(), aabb.hi.z() , 1.0f},
-	{ aabb.hi.x() , aabb.hi.y() , aabb.hi.z() , 1.0f},
-	{ aabb.low.x(), aabb.hi.y() , aabb.hi.z() , 1.0f},
-	};
+	const FrustumPlaneset frustumPlanes = FrustumPlaneset::ExtractFromMatrix(mSceneView.viewProj);
 
-	for (int i = 0; i < 6; ++i)	// for each plane
+	// RASTERIZE OCCLUDERS
+	//
+	mOcclusionCuller.BeginFrame(mSceneView.viewProj);
+	for (const std::pair<const GameObject*, MeshID>& occluder : mOccluders)
 	{
-		bool bInside = false;
-		for (int j = 0; j < 8; ++j)	// for each point
-		{
-			if (XMVector4Dot(points[j], frustum.abcd[i]).m128_f32[0] > 0.000002f)
-			{
-				bInside = true;
-				break;
-			}
-		}
-		if (!bInside)
+		const XMMATRIX world = occluder.first->GetTransform().WorldTransformationMatrix();
+		const OccluderMesh& mesh = mOccluderMeshes.at(occluder.second);
+		if (IsVisible(frustumPlanes, TransformAABB(mesh.localAABB, world)))
 		{
-			return false;
+			mOcclusionCuller.AddOccluder(&mesh, world);
 		}
 	}
-	return true;
+	mOcclusionCuller.RasterizeOccluders(mpThreadPool);
+
+	// TEST OCCLUDEES
+	//
+	const size_t numObjects = renderList.size();
+	renderList.erase(std::remove_if(RANGE(renderList), [&](const GameObject* pObj)
+	{
+		const XMMATRIX world = pObj->GetTransform().WorldTransformationMatrix();
+		return !mOcclusionCuller.IsVisible(TransformAABB(pObj->GetAABB(), world));
+	}), renderList.end());
+
+	return numObjects - renderList.size();
 }
 
+// LODs are selected per object and view from the height of the bounding sphere on screen, as a ratio of
+// the viewport height. Shadow views pick coarser LODs: there are fewer shadow map texels than screen
+// pixels covering the object and the depth bias hides the difference in the silhouette.
+//
+static constexpr float LOD_SCREEN_SIZES[] = { 0.5f, 0.25f, 0.1f };	// LOD1, LOD2, LOD3 below these sizes
+static constexpr float LOD_SCREEN_SIZE_SCALE_SHADOW_VIEWS = 0.5f;
 
-static size_t CullMeshes(const FrustumPlaneset& frustumPlanes, std::vector<MeshID> todo)
+static int SelectLOD(const GameObject* pObj, const XMMATRIX& viewProj, const XMMATRIX& proj, float screenSizeScale)
 {
-	// We currently cull based on game object bounding boxes, meaning that we
-	// cull meshes in 'gameobject-sized-batches'. Culling can be refined to mesh
-	// level by letting each game object have a culled list of meshes to draw.
-	//
-	return 0;
+	const BoundingBox aabb = TransformAABB(pObj->GetAABB(), pObj->GetTransform().WorldTransformationMatrix());
+	const XMVECTOR lo = aabb.low;
+	const XMVECTOR hi = aabb.hi;
+	const XMVECTOR center = XMVectorSetW(XMVectorScale(XMVectorAdd(lo, hi), 0.5f), 1.0f);
+	const float radius = 0.5f * XMVectorGetX(XMVector3Length(XMVectorSubtract(hi, lo)));
+
+	// clip space w is the view space depth for perspective projections, 1 for orthographic projections
+	const bool bPerspective = XMVectorGetW(proj.r[2]) != 0.0f;
+	const float w = XMVectorGetW(XMVector4Transform(center, viewProj));
+	const float distance = bPerspective ? std::max(w, radius) : 1.0f;
+	const float screenSize = screenSizeScale * radius * XMVectorGetY(proj.r[1]) / distance;
+
+	int lod = 0;
+	while (lod < static_cast<int>(_countof(LOD_SCREEN_SIZES)) && screenSize < LOD_SCREEN_SIZES[lod])
+		++lod;
+	return lod;
 }
 
-static size_t CullGameObjects(
-	const FrustumPlaneset&                  frustumPlanes
-	, const std::vector<const GameObject*>& pObjs
-	, std::vector<const GameObject*>&       pCulledObjs
+// replaces the meshes of the objects that are small on screen with their LODs, starting from the
+// mesh lists of the mesh-level culling if there are any. returns the number of LOD meshes selected.
+//
+static int SelectRenderListLODs(
+	const RenderList&       renderList
+	, const XMMATRIX&       viewProj
+	, const XMMATRIX&       proj
+	, float                 screenSizeScale
+	, MeshRenderListLookup& meshRenderLists
 )
 {
-	size_t currIdx = 0;
-	std::for_each(RANGE(pObjs), [&](const GameObject* pObj)
+	int numLODMeshes = 0;
+	for (const GameObject* pObj : renderList)
 	{
-		// aabb is static and in world space during load time.
-		// this wouldn't work for dynamic objects in this state.
-		const BoundingBox aabb_world = [&]() 
-		{
-			const XMMATRIX world = pObj->GetTransform().WorldTransformationMatrix();
-			const XMMATRIX worldRotation = pObj->GetTransform().RotationMatrix();
-			const BoundingBox& aabb_local = pObj->GetAABB();
-#if 1
-			// transform low and high points of the bounding box: model->world
-			return BoundingBox(
-			{ 
-				XMVector4Transform(vec4(aabb_local.low, 1.0f), world), 
-				XMVector4Transform(vec4(aabb_local.hi , 1.0f), world) 
-			});
-#else
-			//----------------------------------------------------------------------------------
-			// TODO: there's an error in the code below. 
-			// bug repro: turn your back to the nanosuit in sponza scene -> suit won't be culled.
-			//----------------------------------------------------------------------------------
-			// transform center and extent and construct high and low later
-			// we can use XMVector3Transform() for the extent vector to save some instructions
-			const vec3 extent = aabb_local.hi - aabb_local.low;
-			const vec4 center = vec4((aabb_local.hi + aabb_local.low) * 0.5f, 1.0f);
-			const vec3 tfC = XMVector4Transform(center, world);
-			const vec3 tfEx = XMVector3Transform(extent, worldRotation) * 0.5f;
-			return BoundingBox(
-			{
-				{tfC - tfEx},	// lo
-				{tfC + tfEx}	// hi
-			});
-#endif
-		}();
+		const ModelData& model = pObj->GetModelData();
+		if (!model.HasLODs())
+			continue;
 
-		//assert(!pObj->GetModelData().mMeshIDs.empty());
-		if (pObj->GetModelData().mMeshIDs.empty())
-		{
-#if _DEBUG
-			Log::Warning("CullGameObject(): GameObject with empty mesh list.");
-#endif
-			return;
-		}
+		const int lod = SelectLOD(pObj, viewProj, proj, screenSizeScale);
+		if (lod == 0)
+			continue;
+
+		auto it = meshRenderLists.find(pObj);
+		if (it == meshRenderLists.end())
+			it = meshRenderLists.emplace(pObj, model.mMeshIDs).first;
 
-		if (IsVisible(frustumPlanes, aabb_world))
+		for (MeshID& id : it->second)
 		{
-			pCulledObjs.push_back(pObj);
-			++currIdx;
+			const auto itLODs = model.mLODLookupPerMesh.find(id);
+			if (itLODs == model.mLODLookupPerMesh.end())
+				continue;
+
+			const std::vector<MeshID>& lods = itLODs->second;
+			id = lods[std::min<size_t>(lod, lods.size()) - 1];
+			++numLODMeshes;
 		}
-	});
-	return pObjs.size() - currIdx;
+	}
+	return numLODMeshes;
 }
 
 void Scene::PreRender(CPUProfiler* pCPUProfiler, FrameStats& stats)
@@ -751,6 +864,7 @@ void Scene::PreRender(CPUProfiler* pCPUProfiler, FrameStats& stats)
 	mSceneView.opaqueList.clear();
 	mSceneView.culledOpaqueList.clear();
 	mSceneView.culluedOpaqueInstancedRenderListLookup.clear();
+	mSceneView.culledOpaqueMeshRenderListLookup.clear();
 	mSceneView.alphaList.clear();
 	
 	// shadow views
@@ -758,6 +872,8 @@ void Scene::PreRender(CPUProfiler* pCPUProfiler, FrameStats& stats)
 	mShadowView.casters.clear();
 	mShadowView.shadowMapRenderListLookUp.clear();
 	mShadowView.shadowMapInstancedRenderListLookUp.clear();
+	mShadowView.shadowMapMeshRenderListLookUp.clear();
+	mShadowView.directionalMeshRenderListLookUp.clear();
 	//pCPUProfiler->EndEntry();
 
 	// POPULATE RENDER LISTS WITH SCENE OBJECTS
@@ -768,7 +884,7 @@ void Scene::PreRender(CPUProfiler* pCPUProfiler, FrameStats& stats)
 
 	std::unordered_map<MeshID, std::vector<const GameObject*>>& instancedCasterLists = mShadowView.RenderListsPerMeshType;
 	// gather game objects that are to be rendered in the scene
-	pCPUProfiler->BeginEntry("Non-Instanced Lists");
+	pCPUProfiler->BeginEntry(PROFILE_SCOPE_ID("Non-Instanced Lists"));
 	int numObjects = 0;
 	for (GameObject& obj : mObjectPool.mObjects)
 	{
@@ -802,37 +918,25 @@ void Scene::PreRender(CPUProfiler* pCPUProfiler, FrameStats& stats)
 	const bool& bCullMainView = mSceneRenderSettings.optimization.bViewFrustumCull_MainView;
 	const bool& bCullLightView = mSceneRenderSettings.optimization.bViewFrustumCull_LocalLights;
 	const bool& bShadowViewCull = mSceneRenderSettings.optimization.bShadowViewCull;
+	const bool& bCullMeshes = mSceneRenderSettings.optimization.bViewFrustumCull_Meshes;
+	const bool& bOcclusionCull = mSceneRenderSettings.optimization.bOcclusionCull_MainView;
+	const bool& bMeshLODs = mSceneRenderSettings.optimization.bMeshLODs;
 
-	// Meshes are sorted according to BUILT_IN_TYPE < CUSTOM, 
-	// and BUILT_IN_TYPEs are sorted in themselves
-	auto SortByMeshType = [&](const GameObject* pObj0, const GameObject* pObj1)
+	// refines the culled game object list of a view to mesh level: only the
+	// objects with more than one mesh are worth culling at mesh granularity.
+	auto CullRenderListMeshes = [&](const FrustumPlaneset& frustumPlanes, const RenderList& renderList, MeshRenderListLookup& meshRenderLists)
 	{
-		const ModelData& model0 = pObj0->GetModelData();
-		const ModelData& model1 = pObj1->GetModelData();
-
-		const MeshID mID0 = model0.mMeshIDs.empty() ? -1 : model0.mMeshIDs.back();
-		const MeshID mID1 = model1.mMeshIDs.empty() ? -1 : model1.mMeshIDs.back();
-		
-		assert(mID0 != -1 && mID1 != -1);
-
-		// case: one of the objects have a custom mesh
-		if (mID0 >= EGeometry::MESH_TYPE_COUNT || mID1 >= EGeometry::MESH_TYPE_COUNT)
+		size_t numCulledMeshes = 0;
+		for (const GameObject* pObj : renderList)
 		{
-			if (mID0 < EGeometry::MESH_TYPE_COUNT)
-				return true;
-				
-			if (mID1 < EGeometry::MESH_TYPE_COUNT)
-				return false;
+			if (pObj->GetModelData().mMeshIDs.size() < 2)
+				continue;
 
-			return false;
-		}
-
-		// case: both objects are built-in types
-		else
-		{
-			return mID0 < mID1;
+			numCulledMeshes += CullMeshes(frustumPlanes, pObj, mMeshes, meshRenderLists[pObj]);
 		}
+		return static_cast<int>(numCulledMeshes);
 	};
+
 	auto SortByMaterialID = [](const GameObject* pObj0, const GameObject* pObj1)
 	{
 		// TODO:
@@ -851,13 +955,18 @@ void Scene::PreRender(CPUProfiler* pCPUProfiler, FrameStats& stats)
 	stats.scene.numDirectionalCulledObjects = 0;
 	stats.scene.numPointsCulledObjects = 0;
 	stats.scene.numSpotsCulledObjects = 0;
+	stats.scene.numMainViewCulledMeshes = 0;
+	stats.scene.numSpotsCulledMeshes = 0;
+	stats.scene.numMainViewOccludedObjects = 0;
+	stats.scene.numMainViewLODMeshes = 0;
+	stats.scene.numShadowViewLODMeshes = 0;
 	
 #if THREADED_FRUSTUM_CULL
 	// TODO: utilize thread pool for each render list
 
 #else
 	// main view
-	pCPUProfiler->BeginEntry("Cull Views");
+	pCPUProfiler->BeginEntry(PROFILE_SCOPE_ID("Cull Views"));
 	//pCPUProfiler->BeginEntry("Main View");
 	if (bCullMainView)
 	{
@@ -872,6 +981,15 @@ void Scene::PreRender(CPUProfiler* pCPUProfiler, FrameStats& stats)
 		std::copy(RANGE(mSceneView.opaqueList), mainViewRenderList.begin());
 		stats.scene.numMainViewCulledObjects = 0;
 	}
+
+	// the occluders only cover what's visible from the main camera: the objects
+	// hidden from the camera can still cast shadows, shadow views aren't occlusion culled.
+	if (bOcclusionCull && !mOccluders.empty())
+	{
+		pCPUProfiler->BeginEntry(PROFILE_SCOPE_ID("Occlusion Cull"));
+		stats.scene.numMainViewOccludedObjects = static_cast<int>(CullOccludedGameObjects(mainViewRenderList));
+		pCPUProfiler->EndEntry();
+	}
 	//pCPUProfiler->EndEntry();
 
 	// shadow frusta
@@ -889,6 +1007,10 @@ void Scene::PreRender(CPUProfiler* pCPUProfiler, FrameStats& stats)
 			if (bCullLightView)
 			{
 				stats.scene.numSpotsCulledObjects += static_cast<int>(CullGameObjects(l.GetViewFrustumPlanes(), casterList, objList));
+				if (bCullMeshes)
+				{
+					stats.scene.numSpotsCulledMeshes += CullRenderListMeshes(l.GetViewFrustumPlanes(), objList, mShadowView.shadowMapMeshRenderListLookUp[&l]);
+				}
 			}
 			else
 			{
@@ -924,7 +1046,7 @@ void Scene::PreRender(CPUProfiler* pCPUProfiler, FrameStats& stats)
 
 	// SORT OBJECTS PER MESH TYPE, ETC...
 	//
-	pCPUProfiler->BeginEntry("Sort");
+	pCPUProfiler->BeginEntry(PROFILE_SCOPE_ID("Sort"));
 	if (bSortRenderLists) 
 	{ 
 		std::sort(RANGE(mSceneView.culledOpaqueList), SortByMeshType);
@@ -946,7 +1068,7 @@ void Scene::PreRender(CPUProfiler* pCPUProfiler, FrameStats& stats)
 
 	
 	//pCPUProfiler->BeginEntry("Lists");
-	pCPUProfiler->BeginEntry("[Instanced] Directional");
+	pCPUProfiler->BeginEntry(PROFILE_SCOPE_ID("[Instanced] Directional"));
 	for(int i=0; i<casterList.size(); ++i)
 	{
 		const GameObject* pCaster = casterList[i];
@@ -969,7 +1091,7 @@ void Scene::PreRender(CPUProfiler* pCPUProfiler, FrameStats& stats)
 
 
 	// Main View Render Lists
-	pCPUProfiler->BeginEntry("[Instanced] Main View");
+	pCPUProfiler->BeginEntry(PROFILE_SCOPE_ID("[Instanced] Main View"));
 	for (int i = 0; i < mainViewRenderList.size(); ++i)
 	{
 		const GameObject* pObj = mainViewRenderList[i];
@@ -1006,6 +1128,46 @@ void Scene::PreRender(CPUProfiler* pCPUProfiler, FrameStats& stats)
 	}
 	pCPUProfiler->EndEntry();
 
+	// CULL MESHES OF THE MAIN VIEW OBJECTS
+	//
+	// instanced render lists only contain single-mesh built-in objects,
+	// so only the non-instanced list is refined to mesh level.
+	if (bCullMainView && bCullMeshes)
+	{
+		pCPUProfiler->BeginEntry(PROFILE_SCOPE_ID("Cull Meshes"));
+		stats.scene.numMainViewCulledMeshes = CullRenderListMeshes(
+			FrustumPlaneset::ExtractFromMatrix(mSceneView.viewProj)
+			, mSceneView.culledOpaqueList
+			, mSceneView.culledOpaqueMeshRenderListLookup);
+		pCPUProfiler->EndEntry();
+	}
+
+	// SELECT LODS OF THE MAIN & SHADOW VIEWS
+	//
+	if (bMeshLODs)
+	{
+		pCPUProfiler->BeginEntry(PROFILE_SCOPE_ID("Select LODs"));
+		stats.scene.numMainViewLODMeshes = SelectRenderListLODs(mSceneView.culledOpaqueList
+			, mSceneView.viewProj, mSceneView.proj, 1.0f
+			, mSceneView.culledOpaqueMeshRenderListLookup);
+
+		for (const Light& l : mLights)
+		{
+			if (!l.castsShadow || l.type != Light::ELightType::SPOT) continue;
+			stats.scene.numShadowViewLODMeshes += SelectRenderListLODs(mShadowView.shadowMapRenderListLookUp.at(&l)
+				, l.GetLightSpaceMatrix(), l.GetProjectionMatrix(), LOD_SCREEN_SIZE_SCALE_SHADOW_VIEWS
+				, mShadowView.shadowMapMeshRenderListLookUp[&l]);
+		}
+
+		if (mShadowView.pDirectional)
+		{
+			stats.scene.numShadowViewLODMeshes += SelectRenderListLODs(mShadowView.casters
+				, mShadowView.pDirectional->GetLightSpaceMatrix(), mShadowView.pDirectional->GetProjectionMatrix(), LOD_SCREEN_SIZE_SCALE_SHADOW_VIEWS
+				, mShadowView.directionalMeshRenderListLookUp);
+		}
+		pCPUProfiler->EndEntry();
+	}
+
 #if _DEBUG
 	if (!bReportedList)
 	{
@@ -1050,6 +1212,36 @@ void Scene::LoadModel_Async(GameObject* pObject, const std::string& modelPath)
 	mModelLoadQueue.objectModelMap[pObject] = modelPath;
 }
 
+// SceneView / ShadowView -------------------------------------
+
+const MeshRenderList& SceneView::GetMeshRenderList(const GameObject* pObj) const
+{
+	const auto it = culledOpaqueMeshRenderListLookup.find(pObj);
+	return it == culledOpaqueMeshRenderListLookup.end() 
+		? pObj->GetModelData().mMeshIDs 
+		: it->second;
+}
+
+const MeshRenderList& ShadowView::GetMeshRenderList(const Light* pLight, const GameObject* pObj) const
+{
+	const auto itLight = shadowMapMeshRenderListLookUp.find(pLight);
+	if (itLight == shadowMapMeshRenderListLookUp.end())
+		return pObj->GetModelData().mMeshIDs;
+
+	const auto it = itLight->second.find(pObj);
+	return it == itLight->second.end()
+		? pObj->GetModelData().mMeshIDs
+		: it->second;
+}
+
+const MeshRenderList& ShadowView::GetDirectionalMeshRenderList(const GameObject* pObj) const
+{
+	const auto it = directionalMeshRenderListLookUp.find(pObj);
+	return it == directionalMeshRenderListLookUp.end()
+		? pObj->GetModelData().mMeshIDs
+		: it->second;
+}
+
 // SceneResourceView ------------------------------------------
 
 #include "SceneResources.h"
@@ -1058,6 +1250,11 @@ std::pair<BufferID, BufferID> SceneResourceView::GetVertexAndIndexBuffersOfMesh(
 	return pScene->mMeshes[meshID].GetIABuffers();
 }
 
+bool SceneResourceView::HasCompactVertices(const Scene* pScene, MeshID meshID)
+{
+	return pScene->mMeshes[meshID].HasCompactVertices();
+}
+
 const Material* SceneResourceView::GetMaterial(const Scene* pScene, MaterialID materialID)
 {
 	return pScene->mMaterials.GetMaterial_const(materialID);
@@ -1068,3 +1265,11 @@ GameObject* SerializedScene::CreateNewGameObject()
 	objects.push_back(GameObject(nullptr));
 	return &objects.back();
 }
+
+SerializedMaterialTextures& SerializedScene::GetMaterialTextures(MaterialID material)
+{
+	// materials are defined one after another, the entry of the current one is the last one if it exists
+	if (materialTextures.empty() || materialTextures.back().material.ID != material.ID)
+		materialTextures.push_back({ material, "", "" });
+	return materialTextures.back();
+}
@@ -128,13 +128,12 @@ void ShadowMapPass::RenderShadowMaps(Renderer* pRenderer, const ShadowView& shad
 	{
 		return mesh == EGeometry::TRIANGLE || mesh == EGeometry::QUAD || mesh == EGeometry::GRID;
 	};
-	auto RenderDepth = [&](const GameObject* pObj, const XMMATRIX& viewProj)
+	auto RenderDepth = [&](const GameObject* pObj, const XMMATRIX& viewProj, const MeshRenderList& meshIDs)
 	{
-		const ModelData& model = pObj->GetModelData();
 		const PerObjectMatrices objMats = PerObjectMatrices({ pObj->GetTransform().WorldTransformationMatrix() * viewProj });
 
 		pRenderer->SetConstantStruct("ObjMats", &objMats);
-		std::for_each(model.mMeshIDs.begin(), model.mMeshIDs.end(), [&](MeshID id)
+		std::for_each(meshIDs.begin(), meshIDs.end(), [&](MeshID id)
 		{
 			const RasterizerStateID rasterizerState = Is2DGeometry(id) ? EDefaultRasterizerState::CULL_NONE : EDefaultRasterizerState::CULL_FRONT;
 			const auto IABuffer = SceneResourceView::GetVertexAndIndexBuffersOfMesh(ENGINE->mpActiveScene, id);
@@ -176,7 +175,7 @@ void ShadowMapPass::RenderShadowMaps(Renderer* pRenderer, const ShadowView& shad
 
 		for (const GameObject* pObj : shadowView.shadowMapRenderListLookUp.at(shadowView.spots[i]))
 		{
-			RenderDepth(pObj, viewProj);
+			RenderDepth(pObj, viewProj, shadowView.GetMeshRenderList(shadowView.spots[i], pObj));
 		}
 		pRenderer->EndEvent();
 	}
@@ -200,7 +199,7 @@ void ShadowMapPass::RenderShadowMaps(Renderer* pRenderer, const ShadowView& shad
 		pRenderer->BeginRender(ClearCommand::Depth(1.0f));
 		for (const GameObject* pObj : shadowView.casters)
 		{
-			RenderDepth(pObj, viewProj);
+			RenderDepth(pObj, viewProj, shadowView.GetDirectionalMeshRenderList(pObj));
 		}
 
 
@@ -19,8 +19,14 @@
 #include "Engine.h"
 #include "Application/Application.h"
 #include "Renderer/Renderer.h"
+#include "Renderer/RawTextureFile.h"
 #include "Utilities/Log.h"
 
+#include <chrono>
+#include <algorithm>
+#include <cmath>
+#include <experimental/filesystem>
+
 // SKYBOX PRESETS W/ CUBEMAP / ENVIRONMENT MAP
 //==========================================================================================================
 using FilePaths = std::vector<std::string>;
@@ -112,8 +118,7 @@ void Skybox::InitializePresets_Async(Renderer* pRenderer, const Settings::Render
 	}
 	{
 		std::unique_lock<std::mutex> lck(Engine::mLoadRenderingMutex);
-		Texture LUTTexture = EnvironmentMap::CreateBRDFIntegralLUTTexture();
-		EnvironmentMap::sBRDFIntegrationLUTTexture = LUTTexture._id;
+		EnvironmentMap::sBRDFIntegrationLUTTexture = EnvironmentMap::LoadOrCreateBRDFIntegralLUT();
 	}
 
 	// Cubemap Skyboxes
@@ -179,29 +184,7 @@ void Skybox::InitializePresets(Renderer* pRenderer, const Settings::Rendering& r
 {
 	EnvironmentMap::Initialize(pRenderer);
 	EnvironmentMap::LoadShaders();
-	
-	const std::string extension = ".hdr";
-	const std::string BRDFLUTTextureFileName = "BRDFIntegrationLUT";
-	const std::string BRDFLUTTextureFilePath = EnvironmentMap::sTextureCacheDirectory + BRDFLUTTextureFileName + extension;
-	
-	const bool bUseCache = Engine::GetSettings().bCacheEnvironmentMapsOnDisk && DirectoryUtil::FileExists(BRDFLUTTextureFilePath);
-
-	if(bUseCache)
-	{ 
-		EnvironmentMap::sBRDFIntegrationLUTTexture = pRenderer->CreateHDRTexture(BRDFLUTTextureFileName + extension, EnvironmentMap::sTextureCacheDirectory);
-	}
-	else
-	{
-		Texture LUTTexture = EnvironmentMap::CreateBRDFIntegralLUTTexture();
-		EnvironmentMap::sBRDFIntegrationLUTTexture = LUTTexture._id;
-
-		if (Engine::GetSettings().bCacheEnvironmentMapsOnDisk)
-		{
-			pRenderer->SaveTextureToDisk(EnvironmentMap::sBRDFIntegrationLUTTexture, BRDFLUTTextureFilePath, false);
-		}
-
-		// todo: we can unload shaders / render targets here
-	}
+	EnvironmentMap::sBRDFIntegrationLUTTexture = EnvironmentMap::LoadOrCreateBRDFIntegralLUT();
 
 
 	// Cubemap Skyboxes
@@ -319,6 +302,54 @@ Renderer* EnvironmentMap::spRenderer = nullptr;
 std::string EnvironmentMap::sTextureCacheDirectory = "";
 //---------------------------------------------------------------
 
+// IBL Cache - GPU computed textures stored as RawTextureFiles
+//---------------------------------------------------------------
+// bump the version whenever the way the textures are computed changes outside the shaders
+static constexpr uint32_t IBL_CACHE_VERSION = 1;
+static constexpr const char* IBL_CACHE_EXTENSION = ".vqtx";
+
+static constexpr int BRDF_LUT_DIMENSION = 2048;
+static constexpr int BRDF_LUT_SAMPLE_COUNT = 1024;	// SAMPLE_COUNT in BRDF.hlsl
+
+static constexpr const char* SKYBOX_VS_FILE_NAME               = "Skybox_vs.hlsl";
+static constexpr const char* FULLSCREEN_QUAD_VS_FILE_NAME      = "FullscreenQuad_vs.hlsl";
+static constexpr const char* BRDF_INTEGRATOR_PS_FILE_NAME      = "IntegrateBRDF_IBL_ps.hlsl";
+static constexpr const char* PREFILTER_PS_FILE_NAME            = "PreFilterConvolution_ps.hlsl";
+static constexpr const char* RENDER_INTO_CUBEMAP_PS_FILE_NAME  = "RenderIntoCubemap_ps.hlsl";
+
+// the cached textures are invalidated by any change to the shaders (and their includes) that compute them
+static uint64_t HashShaderSources(const std::vector<const char*>& shaderFileNames, uint64_t seed)
+{
+	uint64_t hash = seed;
+	for (const char* pFileName : shaderFileNames)
+		hash = HashValue(ShaderCache::GetContentHash(Renderer::sShaderRoot + std::string(pFileName), {}, ""), hash);
+	return hash;
+}
+
+static uint64_t GetBRDFIntegralLUTCacheKey()
+{
+	uint64_t key = HashValue(IBL_CACHE_VERSION);
+	key = HashValue(BRDF_LUT_DIMENSION, key);
+	return HashShaderSources({ FULLSCREEN_QUAD_VS_FILE_NAME, BRDF_INTEGRATOR_PS_FILE_NAME }, key);
+}
+
+static uint64_t GetPrefilteredEnvironmentMapCacheKey(const std::string& environmentMapFilePath)
+{
+	namespace fs = std::experimental::filesystem;
+
+	uint64_t key = HashValue(IBL_CACHE_VERSION);
+	key = HashValue(PREFILTER_MIP_LEVEL_COUNT, key);
+	key = HashShaderSources({ SKYBOX_VS_FILE_NAME, RENDER_INTO_CUBEMAP_PS_FILE_NAME, PREFILTER_PS_FILE_NAME }, key);
+
+	// size and modification time stand in for the contents of the source image: hashing
+	// a multi-megabyte HDR file would cost a good part of what the cache saves.
+	std::error_code err;
+	key = HashValue(static_cast<uint64_t>(fs::file_size(environmentMapFilePath, err)), key);
+	key = HashValue(static_cast<int64_t>(fs::last_write_time(environmentMapFilePath, err).time_since_epoch().count()), key);
+	return key;
+}
+//---------------------------------------------------------------
+
 EnvironmentMap::EnvironmentMap() : irradianceMap(-1), environmentMap(-1) {}
 
 
@@ -326,56 +357,37 @@ void EnvironmentMap::Initialize(Renderer * pRenderer, const EnvironmentMapFileNa
 {
 	const std::string envMapName = StrUtil::split(rootDirectory, '/').back();
 	const std::string cacheFolderPath = sTextureCacheDirectory + "sIBL/" + envMapName + "/";
-	const std::string extensionEnvMap = "." + DirectoryUtil::GetFileExtension(files.environmentMapFileName);
-	const std::string extensionIrrMap = "." + DirectoryUtil::GetFileExtension(files.irradianceMapFileName);
-
-
-	// input textures for pre-filtered environment map calculation
-	const std::string irradianceTextureFilePath = rootDirectory + files.irradianceMapFileName;
-	const std::string skyboxTextureFilePath = rootDirectory + files.environmentMapFileName;
 
-	// cached mipped-cubemap version of the textures (pick one of them at random -> 0th element 0th mip for example)
-	const std::string cachedPrefilteredEnvMap = cacheFolderPath + DirectoryUtil::GetFileNameWithoutExtension(files.irradianceMapFileName) + "_preFiltered_mip0_0" + extensionIrrMap;
+	// input texture for pre-filtered environment map calculation, and its cached result
+	const std::string environmentMapFilePath = rootDirectory + files.environmentMapFileName;
+	const std::string cachedPrefilteredEnvMap = cacheFolderPath + DirectoryUtil::GetFileNameWithoutExtension(files.environmentMapFileName) + "_preFiltered" + IBL_CACHE_EXTENSION;
 
 	Log::Info("\tLoading Environment Map: %s", envMapName.c_str());
-
-	// get the latest date of the environment map and irradiance map input textures
-	// compare them with the corresponding cached textures
-	//
-	// NOTE: Using the cache is ~10-20% slower. GPU wins. Keeping it off with the override for now.
-	//		see: https://github.com/vilbeyli/VQEngine/issues/106
-	//
-	constexpr bool USE_CACHE = false;
-	const bool bCacheEnabled = Engine::GetSettings().bCacheEnvironmentMapsOnDisk && USE_CACHE;
-	const bool bCacheExists  = bCacheEnabled && DirectoryUtil::FileExists(cachedPrefilteredEnvMap);
-	const bool bUseCache     = bCacheExists && DirectoryUtil::IsFileNewer(cachedPrefilteredEnvMap, irradianceTextureFilePath);
+	const auto start = std::chrono::high_resolution_clock::now();
 
 	// irradiance map texture
 	{
 		std::unique_lock<std::mutex> lck(Engine::mLoadRenderingMutex);
 		this->irradianceMap = pRenderer->CreateHDRTexture(files.irradianceMapFileName, rootDirectory);
 	}
-	
+
+	// the cached pre-filtered map is uploaded straight from the file: no need to load the environment map
+	// itself or run the convolution. It replaces the environment map as the source is only used for pre-filtering.
+	//
+	const bool bCacheEnabled = Engine::GetSettings().bCacheEnvironmentMapsOnDisk;
+	const uint64_t cacheKey = bCacheEnabled ? GetPrefilteredEnvironmentMapCacheKey(environmentMapFilePath) : 0;
+	TextureID cachedPrefilteredEnvironmentMap = -1;
+	if (bCacheEnabled)
+	{
+		std::unique_lock<std::mutex> lck(Engine::mLoadRenderingMutex);
+		cachedPrefilteredEnvironmentMap = pRenderer->CreateTextureFromRawFile(cachedPrefilteredEnvMap, cacheKey);
+	}
+
+	const bool bUseCache = cachedPrefilteredEnvironmentMap != -1;
 	if (bUseCache)
 	{
-		// load pre-filtered & mipped environment map maps
-		std::vector<std::string> cubemapTexturePaths;
-		for (int mip = 0; mip < PREFILTER_MIP_LEVEL_COUNT; ++mip)
-		{
-			for (int i = 0; i < 6; ++i)
-			{
-				std::string cubeMapFaceTexturePath = cacheFolderPath
-					+ DirectoryUtil::GetFileNameWithoutExtension(files.irradianceMapFileName)
-					+ "_preFiltered_mip" + std::to_string(mip) + "_" + std::to_string(i)
-					+ extensionIrrMap;;
-				cubemapTexturePaths.push_back(cubeMapFaceTexturePath);
-			}
-		}
-		{
-			std::unique_lock<std::mutex> lck(Engine::mLoadRenderingMutex);
-			this->prefilteredEnvironmentMap = pRenderer->CreateCubemapFromFaceTextures(cubemapTexturePaths, true, PREFILTER_MIP_LEVEL_COUNT);
-			this->environmentMap = this->prefilteredEnvironmentMap;
-		}
+		this->prefilteredEnvironmentMap = cachedPrefilteredEnvironmentMap;
+		this->environmentMap = this->prefilteredEnvironmentMap;
 	}
 	else
 	{
@@ -383,9 +395,18 @@ void EnvironmentMap::Initialize(Renderer * pRenderer, const EnvironmentMapFileNa
 			std::unique_lock<std::mutex> lck(Engine::mLoadRenderingMutex);
 			this->environmentMap = pRenderer->CreateHDRTexture(files.environmentMapFileName, rootDirectory);
 		}
-		InitializePrefilteredEnvironmentMap(pRenderer->GetTextureObject(environmentMap), pRenderer->GetTextureObject(irradianceMap), cacheFolderPath);
+		InitializePrefilteredEnvironmentMap(pRenderer->GetTextureObject(environmentMap), pRenderer->GetTextureObject(irradianceMap));
+
+		if (bCacheEnabled)
+		{
+			std::unique_lock<std::mutex> lck(Engine::mLoadRenderingMutex);
+			pRenderer->SaveTextureToRawFile(this->prefilteredEnvironmentMap, cachedPrefilteredEnvMap, cacheKey);
+		}
 	}
 
+	const float elapsedMs = std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+	Log::Info("\t%s pre-filtered environment map %s in %.2fms", bUseCache ? "Loaded cached" : "Computed", envMapName.c_str(), elapsedMs);
+
 
 	D3D11_SAMPLER_DESC envMapSamplerDesc = {};
 	envMapSamplerDesc.AddressU = D3D11_TEXTURE_ADDRESS_CLAMP;
@@ -415,19 +436,19 @@ void EnvironmentMap::Initialize(Renderer * pRenderer)
 
 void EnvironmentMap::LoadShaders()
 {
-	const char* pSkyboxVS = "Skybox_vs.hlsl";
+	const char* pSkyboxVS = SKYBOX_VS_FILE_NAME;
 
 	const ShaderDesc BRDFIntegratorShaderDesc = { "BRDFIntegrator", 
-		ShaderStageDesc{"FullscreenQuad_vs.hlsl", {}},
-		ShaderStageDesc{"IntegrateBRDF_IBL_ps.hlsl", {}},
+		ShaderStageDesc{FULLSCREEN_QUAD_VS_FILE_NAME, {}},
+		ShaderStageDesc{BRDF_INTEGRATOR_PS_FILE_NAME, {}},
 	};
 	const ShaderDesc brdfIntegrationShaderDesc = { "PreFilterConvolution",
 		ShaderStageDesc{pSkyboxVS, {}},
-		ShaderStageDesc{"PreFilterConvolution_ps.hlsl", {}},
+		ShaderStageDesc{PREFILTER_PS_FILE_NAME, {}},
 	};
 	const ShaderDesc cubemapShaderDesc = { "RenderIntoCubemap",
 		ShaderStageDesc{pSkyboxVS, {}},
-		ShaderStageDesc{"RenderIntoCubemap_ps.hlsl", {}},
+		ShaderStageDesc{RENDER_INTO_CUBEMAP_PS_FILE_NAME, {}},
 	};
 
 	// #AsyncLoad: Mutex DEVICE
@@ -438,7 +459,7 @@ void EnvironmentMap::LoadShaders()
 
 Texture EnvironmentMap::CreateBRDFIntegralLUTTexture()
 {
-	constexpr int TEXTURE_DIMENSION = 2048;
+	constexpr int TEXTURE_DIMENSION = BRDF_LUT_DIMENSION;
 	
 	// create the render target
 	RenderTargetDesc rtDesc = {};
@@ -467,7 +488,130 @@ Texture EnvironmentMap::CreateBRDFIntegralLUTTexture()
 	return spRenderer->GetTextureObject(spRenderer->GetRenderTargetTexture(sBRDFIntegrationLUTRT));
 }
 
-TextureID EnvironmentMap::InitializePrefilteredEnvironmentMap(const Texture& specularMap, const Texture& irradienceMap, const std::string& cacheFolderPath)
+TextureID EnvironmentMap::LoadOrCreateBRDFIntegralLUT()
+{
+	const bool bCacheEnabled = Engine::GetSettings().bCacheEnvironmentMapsOnDisk;
+	const std::string cacheFilePath = sTextureCacheDirectory + "BRDFIntegrationLUT" + IBL_CACHE_EXTENSION;
+	const uint64_t cacheKey = bCacheEnabled ? GetBRDFIntegralLUTCacheKey() : 0;
+	if (bCacheEnabled)
+	{
+		const TextureID cachedLUT = spRenderer->CreateTextureFromRawFile(cacheFilePath, cacheKey);
+		if (cachedLUT != -1)
+			return cachedLUT;
+	}
+
+	const TextureID LUT = CreateBRDFIntegralLUTTexture()._id;
+#if _DEBUG
+	constexpr float MAX_LUT_ERROR = 1e-3f;
+	const float maxError = ValidateBRDFIntegralLUT(LUT, 16);
+	if (maxError > MAX_LUT_ERROR)
+		Log::Warning("BRDF Integration LUT differs from the CPU reference: max error = %.5f", maxError);
+#endif
+	if (bCacheEnabled)
+	{
+		spRenderer->SaveTextureToRawFile(LUT, cacheFilePath, cacheKey);
+	}
+	// todo: we can unload shaders / render targets here
+	return LUT;
+}
+
+// mirrors IntegrateBRDF() & co. in BRDF.hlsl and ShadingMath.hlsl, keep them in sync.
+void EnvironmentMap::IntegrateBRDF_CPU(float NdotV, float roughness, int sampleCount, float& outF0Scale, float& outF0Bias)
+{
+	auto fnRadicalInverse_VdC = [](uint32_t bits)
+	{
+		bits = (bits << 16u) | (bits >> 16u);
+		bits = ((bits & 0x55555555u) << 1u) | ((bits & 0xAAAAAAAAu) >> 1u);
+		bits = ((bits & 0x33333333u) << 2u) | ((bits & 0xCCCCCCCCu) >> 2u);
+		bits = ((bits & 0x0F0F0F0Fu) << 4u) | ((bits & 0xF0F0F0F0u) >> 4u);
+		bits = ((bits & 0x00FF00FFu) << 8u) | ((bits & 0xFF00FF00u) >> 8u);
+		return static_cast<float>(bits) * 2.3283064365386963e-10f;
+	};
+	auto fnGeometry_SchlickGGX_IBL = [](float NdotX, float roughness)
+	{
+		const float k = roughness * roughness / 2.0f;
+		const float NX = std::max(0.0f, NdotX);
+		return NX / ((NX * (1.0f - k) + k) + 0.0001f);
+	};
+
+	// N = (0, 0, 1)
+	const float V[3] = { sqrtf(1.0f - NdotV * NdotV), 0.0f, NdotV };
+	const float a = roughness * roughness;
+
+	float F0Scale = 0.0f;
+	float F0Bias = 0.0f;
+	for (int i = 0; i < sampleCount; ++i)
+	{
+		// Hammersley point -> GGX importance sampled half vector
+		const float Xi[2] = { static_cast<float>(i) / sampleCount, fnRadicalInverse_VdC(static_cast<uint32_t>(i)) };
+		const float phi = 2.0f * XM_PI * Xi[0];
+		const float cosTheta = sqrtf((1.0f - Xi[1]) / (1.0f + (a * a - 1.0f) * Xi[1]));
+		const float sinTheta = sqrtf(1.0f - cosTheta * cosTheta);
+
+		// ImportanceSampleGGX()'s tangent frame for N = (0, 0, 1) is T = (0, -1, 0), B = (1, 0, 0)
+		const float H[3] = { sinf(phi) * sinTheta, -cosf(phi) * sinTheta, cosTheta };
+
+		// L = reflect(-V, H)
+		const float VdotH_signed = V[0] * H[0] + V[1] * H[1] + V[2] * H[2];
+		const float Lz = 2.0f * VdotH_signed * H[2] - V[2];
+
+		const float NdotL = std::max(Lz, 0.0f);
+		const float NdotH = std::max(H[2], 0.0f);
+		const float VdotH = std::max(VdotH_signed, 0.0f);
+		if (NdotL > 0.0f)
+		{
+			const float G = fnGeometry_SchlickGGX_IBL(NdotV, roughness) * fnGeometry_SchlickGGX_IBL(Lz, roughness);
+			const float G_Vis = (G * VdotH) / ((NdotH * NdotV) + 0.0001f);
+			const float Fc = powf(1.0f - VdotH, 5.0f);
+			F0Scale += (1.0f - Fc) * G_Vis;
+			F0Bias += Fc * G_Vis;
+		}
+	}
+	outF0Scale = F0Scale / sampleCount;
+	outF0Bias = F0Bias / sampleCount;
+}
+
+float EnvironmentMap::ValidateBRDFIntegralLUT(TextureID lut, int gridSize)
+{
+	RawTextureData texture;
+	if (!spRenderer->ReadbackTexture(lut, texture) || texture.header.format != static_cast<uint32_t>(EImageFormat::RGBA32F))
+	{
+		Log::Warning("BRDF Integration LUT validation skipped: couldn't read back the texture.");
+		return 0.0f;
+	}
+
+	const int width = static_cast<int>(texture.header.width);
+	const int height = static_cast<int>(texture.header.height);
+	const RawSubresource& mip0 = texture.subresources[0];
+
+	float maxError = 0.0f;
+	float sumError = 0.0f;
+	for (int gy = 0; gy < gridSize; ++gy)
+	{
+		for (int gx = 0; gx < gridSize; ++gx)
+		{
+			// texel centers spread over the LUT, same inputs as PSMain() in IntegrateBRDF_IBL_ps.hlsl gets for them
+			const int x = (gx * width) / gridSize + width / (2 * gridSize);
+			const int y = (gy * height) / gridSize + height / (2 * gridSize);
+			const float NdotV = (x + 0.5f) / width;
+			const float roughness = 1.0f - (y + 0.5f) / height;
+
+			float reference[2];
+			IntegrateBRDF_CPU(NdotV, roughness, BRDF_LUT_SAMPLE_COUNT, reference[0], reference[1]);
+
+			const float* pTexel = reinterpret_cast<const float*>(texture.data.data() + mip0.offset + y * mip0.rowPitch) + x * 4;
+			const float error = std::max(fabsf(pTexel[0] - reference[0]), fabsf(pTexel[1] - reference[1]));
+			maxError = std::max(maxError, error);
+			sumError += error;
+		}
+	}
+
+	Log::Info("BRDF Integration LUT vs. CPU reference (%dx%d texels): max error = %.5f, mean error = %.5f"
+		, gridSize, gridSize, maxError, sumError / (gridSize * gridSize));
+	return maxError;
+}
+
+TextureID EnvironmentMap::InitializePrefilteredEnvironmentMap(const Texture& specularMap, const Texture& irradienceMap)
 {
 	Renderer*& pRenderer = spRenderer;
 	const TextureID envMap = specularMap._id;
@@ -630,13 +774,6 @@ TextureID EnvironmentMap::InitializePrefilteredEnvironmentMap(const Texture& spe
 			}
 		}
 		pRenderer->m_deviceContext->Flush();
-
-		// cache the resulting texture to disk if enabled
-		if (Engine::GetSettings().bCacheEnvironmentMapsOnDisk)
-		{
-			const std::string filePath = cacheFolderPath + prefilteredEnvMapTex._name + ".hdr";
-			pRenderer->SaveTextureToDisk(prefilteredEnvMapTex._id, filePath, false);
-		}
 	}
 
 	// RENDER IRRADIANCE CUBEMAP PASS
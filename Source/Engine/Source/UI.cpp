@@ -95,6 +95,11 @@ const char* FrameStats::statNames[FrameStats::numStat] =
 	"Indices        : ",
 	"Draw Calls : ",
 	"Triangles    : ",
+	"Shader Changes : ",
+	"State Changes   : ",
+	"RT Changes       : ",
+	"Res. Bindings    : ",
+	"CB Updates      : ",
 
 	"# Objects        : ",
 	"# Spot Lights  : ",
@@ -104,9 +109,20 @@ const char* FrameStats::statNames[FrameStats::numStat] =
 	"[Cull] SpotViews : ",
 	"[Cull] PointViews: ",
 	"[Cull] DirectionalView : ",
+
+	"[Cull] MainView Meshes : ",
+	"[Cull] SpotView Meshes  : ",
+
+	"[Occlusion] MainView : ",
+
+	"[LOD] MainView Meshes  : ",
+	"[LOD] ShadowView Meshes: ",
+
+	"Allocations    : ",
+	"Alloc. Bytes   : ",
 };
-constexpr size_t RENDER_ORDER_FRAME_STATS_ROW_1[] = { 0, 3, 4, 1, 2};
-constexpr size_t RENDER_ORDER_FRAME_STATS_ROW_2[] = { 5, 6, 7, 8, 9, /*10, 11*/ };
+constexpr size_t RENDER_ORDER_FRAME_STATS_ROW_1[] = { 0, 3, 4, 1, 2, 5, 6, 7, 8, 9, 22, 23 };
+constexpr size_t RENDER_ORDER_FRAME_STATS_ROW_2[] = { 10, 11, 12, 13, 14, /*15, 16*/ 17, 18, 19, 20, 21 };
 
 auto GetFPSColor = [](int FPS) -> LinearColor
 {
@@ -130,7 +146,7 @@ constexpr float Y_NORMALIZED_POSITION_CONTROLS = 0.009f;
 
 
 constexpr float X_NORMALIZED_POSITION_FRAME_STATS = 0.745f;
-constexpr float Y_NORMALIZED_POSITION_FRAME_STATS = 0.550f;
+constexpr float Y_NORMALIZED_POSITION_FRAME_STATS = 0.440f;
 
 constexpr float X_NORMALIZED_POSITION_PROFILER_CPU = X_NORMALIZED_POSITION_FRAME_STATS;
 constexpr float Y_NORMALIZED_POSITION_PROFILER_CPU = 0.665f;
@@ -173,7 +189,7 @@ void VQEngine::UI::RenderPerfStats(const FrameStats& stats) const
 	const vec2 GPUProfilerAreaBounds = mProfilerStack.pGPU->GetEntryAreaBounds(screenSizeInPixels);
 	const vec2 ProfilerAreaBounds(BACKGROUND_NORMALIZED_LENGTH_X, std::max(CPUProfilerAreaBounds.y(), GPUProfilerAreaBounds.y()) );
 
-	vec2 sz = ProfilerAreaBounds +vec2(0.0f, (8 * LINE_HEIGHT_IN_PX) / screenSizeInPixels.y());
+	vec2 sz = ProfilerAreaBounds +vec2(0.0f, ((3 + sizeof(RENDER_ORDER_FRAME_STATS_ROW_1) / sizeof(size_t)) * LINE_HEIGHT_IN_PX) / screenSizeInPixels.y());
 	vec2 pos = PX_POS_FRAMESTATS - vec2(X_MARGIN_PX, Y_OFFSET_PX);
 	RenderBackground(sBackgroundColor, BACKGROUND_ALPHA, sz, pos);
 
@@ -240,6 +256,7 @@ void VQEngine::UI::RenderEngineControls() const
 		std::string(" "),
 		std::string("F5 - Toggle Rendering AABBs: ") + ToogleToString(mEngineControls.bBoundingBoxes),
 		std::string("F6 - Render Mode: ") + (!mEngineControls.bDeferredOrForward ? "Forward" : "Deferred"),
+		std::string("F10 - Capture CPU Profile"),
 
 
 //#if _DEBUG
@@ -0,0 +1,288 @@
+//	VQEngine | DirectX11 Renderer
+//	Copyright(C) 2018  - Volkan Ilbeyli
+//
+//	This program is free software : you can redistribute it and / or modify
+//	it under the terms of the GNU General Public License as published by
+//	the Free Software Foundation, either version 3 of the License, or
+//	(at your option) any later version.
+//
+//	This program is distributed in the hope that it will be useful,
+//	but WITHOUT ANY WARRANTY; without even the implied warranty of
+//	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+//	GNU General Public License for more details.
+//
+//	You should have received a copy of the GNU General Public License
+//	along with this program.If not, see <http://www.gnu.org/licenses/>.
+//
+//	Contact: volkanilbeyli@gmail.com
+
+// Console client of the engine's MetricsServer: records the JSON lines the engine publishes per frame
+// and plots the selected metrics as text. e.g.:
+//
+//   VQEngine.exe -MetricsServer
+//   MetricsMonitor.exe -Output=metrics.jsonl -Metric=frame_ms -Metric="Draw Calls" -Metric=Render()
+//
+//   -Port=<N>          : port of the engine's MetricsServer (default: 27960)
+//   -Metric=<key>      : metric to plot, any key of the JSON lines: frame_ms, a counter or a scope, repeatable
+//                        (default: frame_ms)
+//   -Output=<file>     : records the received lines as they are, one frame per line
+//   -Interval=<ms>     : the plot prints a row per metric every interval (default: 250)
+//   -Frames=<N>        : exits after receiving N frames, runs until Ctrl+C otherwise
+//
+// The min/avg/p95/max of each metric over the whole run are printed on exit.
+//
+#define NOMINMAX
+#include <winsock2.h>
+#include <ws2tcpip.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+constexpr unsigned short DEFAULT_PORT = 27960;	// MetricsServer::DEFAULT_PORT
+constexpr int DEFAULT_PLOT_INTERVAL_MS = 250;
+constexpr int PLOT_WIDTH = 50;					// characters of the longest bar
+constexpr DWORD RECEIVE_TIMEOUT_MS = 500;		// the receive loop checks for Ctrl+C at least this often
+
+static std::atomic<bool> sbExitRequested(false);
+
+struct MonitorOptions
+{
+	unsigned short           port = DEFAULT_PORT;
+	std::vector<std::string> metrics;
+	std::string              outputFilePath;
+	int                      plotIntervalMs = DEFAULT_PLOT_INTERVAL_MS;
+	long long                numFrames = 0;	// 0: until Ctrl+C
+
+	static MonitorOptions Parse(int argc, char* argv[]);
+};
+
+MonitorOptions MonitorOptions::Parse(int argc, char* argv[])
+{
+	MonitorOptions options;
+	for (int i = 1; i < argc; ++i)
+	{
+		const std::string arg = argv[i];
+		auto Value = [&](const char* pFlag) { return arg.substr(strlen(pFlag)); };
+
+		if      (arg.find("-Port=") == 0)     options.port = static_cast<unsigned short>(std::atoi(Value("-Port=").c_str()));
+		else if (arg.find("-Metric=") == 0)   options.metrics.push_back(Value("-Metric="));
+		else if (arg.find("-Output=") == 0)   options.outputFilePath = Value("-Output=");
+		else if (arg.find("-Interval=") == 0) options.plotIntervalMs = std::max(1, std::atoi(Value("-Interval=").c_str()));
+		else if (arg.find("-Frames=") == 0)   options.numFrames = std::atoll(Value("-Frames=").c_str());
+		else fprintf(stderr, "Unknown command line argument: %s\n", arg.c_str());
+	}
+	if (options.port == 0)       options.port = DEFAULT_PORT;
+	if (options.metrics.empty()) options.metrics.push_back("frame_ms");
+	return options;
+}
+
+// samples of a metric: the current plot interval, and all of them for the summary
+struct MetricSamples
+{
+	std::string        key;
+	std::vector<float> all;
+	float              intervalMin = 0.0f;
+	float              intervalMax = 0.0f;
+	double             intervalSum = 0.0;
+	int                intervalCount = 0;
+	float              plotScale = 0.0f;	// the largest value plotted so far is the full width
+
+	void Add(float value)
+	{
+		all.push_back(value);
+		intervalMin = intervalCount == 0 ? value : std::min(intervalMin, value);
+		intervalMax = intervalCount == 0 ? value : std::max(intervalMax, value);
+		intervalSum += value;
+		++intervalCount;
+	}
+};
+
+// returns the number after "@key": on @line, the lines are written by MetricsServer::FormatFrame()
+static bool FindValue(const std::string& line, const std::string& key, float& outValue)
+{
+	const std::string quotedKey = "\"" + key + "\":";
+	const size_t pos = line.find(quotedKey);
+	if (pos == std::string::npos)
+		return false;
+	outValue = strtof(line.c_str() + pos + quotedKey.size(), nullptr);
+	return true;
+}
+
+static void PlotInterval(MetricSamples& metric)
+{
+	if (metric.intervalCount == 0)
+		return;
+
+	const float avg = static_cast<float>(metric.intervalSum / metric.intervalCount);
+	metric.plotScale = std::max(metric.plotScale, metric.intervalMax);
+	const int avgWidth = metric.plotScale > 0.0f ? static_cast<int>(avg / metric.plotScale * PLOT_WIDTH + 0.5f) : 0;
+	const int maxWidth = metric.plotScale > 0.0f ? static_cast<int>(metric.intervalMax / metric.plotScale * PLOT_WIDTH + 0.5f) : 0;
+
+	// ##### : average, ---| : up to the max of the interval
+	char bar[PLOT_WIDTH + 2] = {};
+	for (int i = 0; i < PLOT_WIDTH + 1; ++i)
+		bar[i] = i < avgWidth ? '#' : (i < maxWidth ? '-' : (i == maxWidth ? '|' : ' '));
+	printf("%-20.20s %10.3f %10.3f %10.3f  %s\n", metric.key.c_str(), metric.intervalMin, avg, metric.intervalMax, bar);
+
+	metric.intervalSum = 0.0;
+	metric.intervalCount = 0;
+}
+
+static void PrintSummary(std::vector<MetricSamples>& metrics, long long numFrames)
+{
+	printf("\n%lld frames received\n", numFrames);
+	printf("%-20s %10s %10s %10s %10s\n", "metric", "min", "avg", "p95", "max");
+	for (MetricSamples& metric : metrics)
+	{
+		if (metric.all.empty())
+		{
+			printf("%-20.20s %10s\n", metric.key.c_str(), "not found");
+			continue;
+		}
+		std::sort(metric.all.begin(), metric.all.end());
+		double sum = 0.0;
+		for (const float value : metric.all) sum += value;
+		const float p95 = metric.all[std::min(metric.all.size() - 1, static_cast<size_t>(0.95f * metric.all.size()))];
+		printf("%-20.20s %10.3f %10.3f %10.3f %10.3f\n", metric.key.c_str()
+			, metric.all.front(), static_cast<float>(sum / metric.all.size()), p95, metric.all.back());
+	}
+}
+
+static SOCKET ConnectToServer(unsigned short port)
+{
+	bool bReportedWait = false;
+	while (!sbExitRequested)
+	{
+		SOCKET serverSocket = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+		if (serverSocket == INVALID_SOCKET)
+			return INVALID_SOCKET;
+
+		sockaddr_in address = {};
+		address.sin_family = AF_INET;
+		address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+		address.sin_port = htons(port);
+		if (connect(serverSocket, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) == 0)
+		{
+			setsockopt(serverSocket, SOL_SOCKET, SO_RCVTIMEO, reinterpret_cast<const char*>(&RECEIVE_TIMEOUT_MS), sizeof(RECEIVE_TIMEOUT_MS));
+			printf("Connected to 127.0.0.1:%d\n", port);
+			return serverSocket;
+		}
+		closesocket(serverSocket);
+
+		// the engine starts the server once the first scene is loaded
+		if (!bReportedWait)
+		{
+			printf("Waiting for the engine on 127.0.0.1:%d (VQEngine.exe -MetricsServer)...\n", port);
+			bReportedWait = true;
+		}
+		std::this_thread::sleep_for(std::chrono::seconds(1));
+	}
+	return INVALID_SOCKET;
+}
+
+int main(int argc, char* argv[])
+{
+	const MonitorOptions options = MonitorOptions::Parse(argc, argv);
+	SetConsoleCtrlHandler([](DWORD ctrlType) -> BOOL
+	{
+		if (ctrlType != CTRL_C_EVENT && ctrlType != CTRL_BREAK_EVENT)
+			return FALSE;
+		sbExitRequested = true;
+		return TRUE;
+	}, TRUE);
+
+	std::ofstream outputFile;
+	if (!options.outputFilePath.empty())
+	{
+		outputFile.open(options.outputFilePath, std::ios::out | std::ios::trunc);
+		if (!outputFile.is_open())
+		{
+			fprintf(stderr, "Couldn't open %s for writing.\n", options.outputFilePath.c_str());
+			return 2;
+		}
+	}
+
+	WSADATA wsaData;
+	if (WSAStartup(MAKEWORD(2, 2), &wsaData) != 0)
+	{
+		fprintf(stderr, "WSAStartup() failed\n");
+		return 2;
+	}
+
+	std::vector<MetricSamples> metrics(options.metrics.size());
+	for (size_t i = 0; i < metrics.size(); ++i)
+		metrics[i].key = options.metrics[i];
+
+	long long numFrames = 0;
+	long long numDroppedFrames = 0;
+	SOCKET serverSocket = ConnectToServer(options.port);
+	if (serverSocket != INVALID_SOCKET)
+	{
+		printf("%-20s %10s %10s %10s\n", "metric", "min", "avg", "max");
+
+		using Clock = std::chrono::steady_clock;
+		Clock::time_point lastPlotTime = Clock::now();
+		std::string pending;
+		char buffer[64 * 1024];
+		while (!sbExitRequested && (options.numFrames == 0 || numFrames < options.numFrames))
+		{
+			const int numBytes = recv(serverSocket, buffer, sizeof(buffer), 0);
+			if (numBytes == 0 || (numBytes == SOCKET_ERROR && WSAGetLastError() != WSAETIMEDOUT))
+			{
+				printf("Disconnected from the engine.\n");
+				break;
+			}
+
+			if (numBytes > 0)
+			{
+				pending.append(buffer, numBytes);
+				size_t lineBegin = 0;
+				for (size_t lineEnd = pending.find('\n'); lineEnd != std::string::npos; lineEnd = pending.find('\n', lineBegin))
+				{
+					const std::string line = pending.substr(lineBegin, lineEnd - lineBegin);
+					lineBegin = lineEnd + 1;
+					if (options.numFrames > 0 && numFrames >= options.numFrames)
+						break;
+
+					if (outputFile.is_open())
+						outputFile << line << '\n';
+					for (MetricSamples& metric : metrics)
+					{
+						float value;
+						if (FindValue(line, metric.key, value))
+							metric.Add(value);
+					}
+					float dropped;
+					if (FindValue(line, "dropped", dropped))
+						numDroppedFrames = static_cast<long long>(dropped);
+					++numFrames;
+				}
+				pending.erase(0, lineBegin);
+			}
+
+			if (std::chrono::duration_cast<std::chrono::milliseconds>(Clock::now() - lastPlotTime).count() >= options.plotIntervalMs)
+			{
+				for (MetricSamples& metric : metrics)
+					PlotInterval(metric);
+				lastPlotTime = Clock::now();
+			}
+		}
+		closesocket(serverSocket);
+	}
+	WSACleanup();
+
+	PrintSummary(metrics, numFrames);
+	if (numDroppedFrames > 0)
+		printf("The engine dropped %lld frames: the monitor didn't keep up.\n", numDroppedFrames);
+	if (outputFile.is_open())
+		printf("Recorded %lld frames into %s\n", numFrames, options.outputFilePath.c_str());
+	return 0;
+}
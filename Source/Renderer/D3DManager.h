@@ -37,6 +37,11 @@ public:
 	~D3DManager();
 
 	bool Initialize(int width, int height, const bool VSYNC, HWND hwnd, const bool FULL_SCREEN, DXGI_FORMAT FrameBufferFormat);
+
+	// Creates a device that doesn't execute any GPU work and doesn't present: the back buffer is an offscreen texture.
+	// Used for headless runs which only measure the CPU side of the frame. Falls back to WARP if the null
+	// driver isn't available (it ships with the D3D11 SDK layers / Graphics Tools).
+	bool InitializeNullDevice(int width, int height, HWND hwnd, DXGI_FORMAT FrameBufferFormat);
 	void Shutdown();
 
 	void EndFrame();
@@ -47,6 +52,10 @@ public:
 	unsigned WindowWidth() const;
 	unsigned WindowHeight() const;
 	inline HWND	 WindowHandle() const { return m_hwnd; }
+	inline bool	 IsNullDevice() const { return m_swapChain == nullptr; }
+
+	// swap chain buffer or the offscreen back buffer of the null device, caller releases the reference
+	HRESULT GetBackBuffer(ID3D11Texture2D** ppBackBuffer) const;
 
 	void ReportLiveObjects(const std::string& LogHeader = "") const;
 
@@ -65,6 +74,7 @@ private:
 #else
 	IDXGISwapChain1*			m_swapChain;
 #endif
+	ID3D11Texture2D*			m_nullBackBuffer;	// null device only
 	
 	ID3D11Device*				m_device;			// shared ptr
 	ID3D11DeviceContext*		m_deviceContext;
@@ -0,0 +1,90 @@
+//	VQEngine | DirectX11 Renderer
+//	Copyright(C) 2018  - Volkan Ilbeyli
+//
+//	This program is free software : you can redistribute it and / or modify
+//	it under the terms of the GNU General Public License as published by
+//	the Free Software Foundation, either version 3 of the License, or
+//	(at your option) any later version.
+//
+//	This program is distributed in the hope that it will be useful,
+//	but WITHOUT ANY WARRANTY; without even the implied warranty of
+//	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+//	GNU General Public License for more details.
+//
+//	You should have received a copy of the GNU General Public License
+//	along with this program.If not, see <http://www.gnu.org/licenses/>.
+//
+//	Contact: volkanilbeyli@gmail.com
+#pragma once
+
+#include "Utilities/MappedFile.h"
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+struct RawTextureHeader
+{
+	uint32_t magic;
+	uint32_t version;
+	uint64_t key;			// defined by the caller: hash of whatever the texture was computed from
+	uint32_t format;		// DXGI_FORMAT
+	uint32_t width;
+	uint32_t height;
+	uint32_t arraySize;
+	uint32_t mipCount;
+	uint32_t bIsCubeMap;
+};
+
+// D3D11 subresource order: index = mip + arraySlice * mipCount
+//
+struct RawSubresource
+{
+	uint64_t offset;		// from the beginning of the texel data
+	uint32_t rowPitch;
+	uint32_t size;
+};
+
+// A texture with all its mips and array slices in system memory, i.e. read back from the GPU
+//
+struct RawTextureData
+{
+	RawTextureHeader header;
+	std::vector<RawSubresource> subresources;
+	std::vector<uint8_t> data;
+};
+
+//----------------------------------------------------------------------------------------------------------------
+// RAW TEXTURE FILE
+//----------------------------------------------------------------------------------------------------------------
+// Every mip and array slice of a texture in a single file, in the layout the GPU consumes: the file is
+// mapped into memory and the subresources are uploaded from the mapping as-is, no decoding or conversion.
+// Used for caching the textures computed on the GPU at startup (IBL pre-filtering, BRDF LUT).
+//
+class RawTextureFile
+{
+public:
+	static bool Write(const std::string& filePath, const RawTextureData& texture);
+
+	~RawTextureFile();
+
+	// Maps @filePath into memory. Returns false if the file can't be mapped, isn't
+	// a valid file of the current version or wasn't written for @expectedKey.
+	//
+	bool Open(const std::string& filePath, uint64_t expectedKey);
+	void Close();
+
+	// Valid until Close()
+	//
+	inline const RawTextureHeader& GetHeader() const { return *mpHeader; }
+	inline size_t GetSubresourceCount() const { return mNumSubresources; }
+	inline const RawSubresource& GetSubresource(size_t i) const { return mpSubresources[i]; }
+	inline const void* GetSubresourceData(size_t i) const { return mpData + mpSubresources[i].offset; }
+
+private:
+	MappedFile              mFile;
+	const RawTextureHeader* mpHeader = nullptr;
+	const RawSubresource*   mpSubresources = nullptr;
+	size_t                  mNumSubresources = 0;
+	const uint8_t*          mpData = nullptr;
+};
@@ -34,11 +34,40 @@
 #include <stack>
 #include <queue>
 #include <mutex>
+#include <future>
+#include <unordered_map>
+#include <unordered_set>
 
 class BufferObject;
 class Camera;
 class D3DManager;
 namespace DirectX  { class ScratchImage; }
+namespace VQEngine { class ThreadPool; }
+struct RawTextureData;
+
+// CreateTextureFromFile() counters, used for measuring the texture load throughput when scenes load
+//
+struct TextureLoadStats
+{
+	int   numRequests;
+	int   numCacheHits;			// texture was already loaded
+	int   numInFlightWaits;		// texture was being decoded by another thread, waited on it
+	int   numDecodes;
+	int   numProcessed;			// decoded from the source file and written to the texture cache, the rest come from the cache
+	int   numFailedDecodes;
+	float decodeTimeMs;			// accumulated over all the loading threads
+};
+
+// PrecompileShaders() results
+//
+struct ShaderPrecompileStats
+{
+	int   numStages;		// unique stage permutations
+	int   numCompiled;		// cache was missing or out of date
+	int   numFailed;
+	float timeMs;
+	inline int GetNumUpToDate() const { return numStages - numCompiled - numFailed; }
+};
 
 class Renderer
 {
@@ -55,7 +84,8 @@ public:
 	//----------------------------------------------------------------------------------------------------------------
 	// CORE INTERFACE
 	//----------------------------------------------------------------------------------------------------------------
-	bool					Initialize(HWND hwnd, const Settings::Window& settings);
+	//						@bNullDevice: nothing is rendered or presented, for measuring the CPU cost of the frames (-Headless)
+	bool					Initialize(HWND hwnd, const Settings::Window& settings, bool bNullDevice = false);
 	void					Exit();
 	void					ReloadShaders();
 
@@ -74,12 +104,16 @@ public:
 	inline TextureID		GetDepthTargetTexture(DepthTargetID DT) const { return mDepthTargets[DT].texture._id; }
 	const PipelineState&	GetState() const;
 	inline const RendererStats&	GetRenderStats() const { return mRenderStats; }
+	inline bool				IsNullDevice() const { return mbNullDevice; }
+	TextureLoadStats		GetTextureLoadStats();
+	void					ResetTextureLoadStats();
 
 	const Shader*			GetShader(ShaderID shader_id) const;
 	const Texture&			GetTextureObject(TextureID) const;
 	const TextureID			GetTexture(const std::string name) const;
 	inline const ShaderID	GetActiveShader() const { return mPipelineState.shader; }
 	inline const Buffer&	GetVertexBuffer(BufferID id) { return mVertexBuffers[id]; }
+	inline const Buffer&	GetIndexBuffer(BufferID id) { return mIndexBuffers[id]; }
 	ShaderDesc				GetShaderDesc(ShaderID shaderID) const;
 
 	//----------------------------------------------------------------------------------------------------------------
@@ -89,13 +123,28 @@ public:
 	ShaderID				CreateShader(const ShaderDesc& shaderDesc);
 	ShaderID				ReloadShader(const ShaderDesc& shaderDesc, const ShaderID shaderID);
 
+	//						Compiles the out of date stages into the shader cache on @pThreadPool workers so the following
+	//						CreateShader() calls only read binaries. Identical permutations are compiled once. Blocks until
+	//						all the stages are done: don't call from a @pThreadPool worker. Runs serially if @pThreadPool is null.
+	ShaderPrecompileStats	PrecompileShaders(const std::vector<ShaderStageDesc>& stages, VQEngine::ThreadPool* pThreadPool);
+
+	//						Stage permutations created in the previous runs (ShaderCache manifest) and the current run.
+	//						Load/Save also read and write the shader cache index, Save prunes the stale binaries.
+	std::vector<ShaderStageDesc> GetKnownShaderStages();
+	void					LoadShaderManifest();
+	void					SaveShaderManifest();
+
 	// --- TEXTURE
 	//						example params:			"bricks_d.png", "Data/Textures/"
+	//						<Thread safe> concurrent requests for the same file wait on a single decode
 	TextureID				CreateTextureFromFile(const std::string& texFileName, const std::string& fileRoot = sTextureRoot);
 	TextureID				CreateTexture2D(const TextureDesc& texDesc);
 	TextureID				CreateTexture2D(D3D11_TEXTURE2D_DESC&	textureDesc, bool initializeSRV);	// used by AddRenderTarget() | todo: remove this?
 	TextureID				CreateHDRTexture(const std::string& texFileName, const std::string& fileRoot = sHDRTextureRoot);
 	TextureID				CreateCubemapFromFaceTextures(const std::vector<std::string>& textureFiles, bool bGenerateMips, unsigned mipLevels = 1);
+	//						Uploads every mip and array slice straight from the memory mapped RawTextureFile.
+	//						Returns -1 if the file doesn't exist or wasn't written for @key.
+	TextureID				CreateTextureFromRawFile(const std::string& filePath, uint64_t key);
 
 	// --- SAMPLER
 	//
@@ -168,12 +217,18 @@ public:
 	void					EndFrame();		// presents the swapchain and clears shaders
 	void					ResetPipelineState();
 
-	void					UpdateBuffer(BufferID buffer, const void* pData);
+	void					UpdateBuffer(BufferID buffer, const void* pData, unsigned numBytes = 0);	// numBytes=0: whole buffer
 	void					Apply();
 
 	void					BeginEvent(const std::string& marker);
 	void					EndEvent();
 
+	//						Checks the pipeline state of every draw/dispatch call, e.g. state that was set but not Apply()'d
+	//						or render targets bound as textures. Each distinct error is logged once (-ValidateRenderState).
+	inline void				SetStateValidation(bool bEnable) { mbValidateState = bEnable; }
+	inline bool				IsStateValidationEnabled() const { return mbValidateState; }
+	inline size_t			GetNumStateValidationErrors() const { return mNumStateValidationErrors; }
+
 	//----------------------------------------------------------------------------------------------------------------
 	// DRAW FUNCTIONS
 	//----------------------------------------------------------------------------------------------------------------
@@ -194,6 +249,10 @@ private:
 	void					SetConstant(const char* cName, const void* data);
 	void					SetTexture_(const char* texName, TextureID tex, unsigned slice = 0 /* only for texture arrays */ );
 
+	void					ValidateDrawState(const char* pDrawCall, bool bIndexed, bool bCompute);
+	void					ValidateResourceBindings();	// called by Apply() before the pending texture commands are processed
+	void					ReportStateValidationError(const std::string& error);
+
 public:
 	//----------------------------------------------------------------------------------------------------------------
 	// WORKSPACE DIRECTORIES (STATIC)
@@ -203,6 +262,8 @@ public:
 	static const char*				sHDRTextureRoot;
 
 	bool SaveTextureToDisk(TextureID texID, const std::string& filePath, bool bConverToSRGB) const;
+	bool SaveTextureToRawFile(TextureID texID, const std::string& filePath, uint64_t key) const;
+	bool ReadbackTexture(TextureID texID, RawTextureData& outData) const;	// every mip and array slice
 
 	//----------------------------------------------------------------------------------------------------------------
 	// DATA
@@ -250,6 +311,13 @@ private:
 	// PERFORMANCE COUNTERS
 	//
 	RendererStats					mRenderStats;
+	bool							mbNullDevice = false;
+
+	// STATE VALIDATION
+	//
+	bool							mbValidateState = false;
+	size_t							mNumStateValidationErrors = 0;
+	std::unordered_set<std::string>	mReportedStateValidationErrors;
 
 	// WINDOW SETTINGS
 	//
@@ -260,6 +328,17 @@ private:
 	// MULTI-THREADING
 	//
 	std::mutex						mTexturesMutex;
+	std::unordered_map<std::string, TextureID>						mTextureFileLookup;	// path -> texture
+	std::unordered_map<std::string, std::shared_future<TextureID>>	mTextureFilesInFlight;	// path -> texture being decoded
+	TextureLoadStats				mTextureLoadStats = {};
+	std::string						mTextureCacheDirectory;	// processed textures (DDS w/ mips)
+
+	ShaderCache						mShaderCache;
+
+	// every stage permutation seen in CreateShader(), written to the shader cache manifest on exit
+	std::mutex						mShaderStageRegistryMutex;
+	std::unordered_map<std::string, ShaderStageDesc>	mShaderStageRegistry;	// ShaderCache::GetStageKey() -> stage
+	void							RegisterShaderStages(const ShaderDesc& shaderDesc);
 	//Worker						m_ShaderHotswapPollWatcher;
 };
 
@@ -20,6 +20,8 @@
 
 #include "RenderingEnums.h"
 
+#include <cstdint>
+
 // todo struct?
 using Viewport = D3D11_VIEWPORT;
 using RasterizerState = ID3D11RasterizerState;
@@ -95,7 +97,7 @@ struct Buffer
 
 	void Initialize(ID3D11Device* device = nullptr, const void* pData = nullptr);
 	void CleanUp();
-	void Update(Renderer* pRenderer, const void* pData);
+	void Update(Renderer* pRenderer, const void* pData, unsigned numBytes = 0);	// numBytes=0: whole buffer
 
 	Buffer(const BufferDesc& desc);
 };
@@ -114,6 +116,18 @@ struct DefaultVertexBufferData
 	vec2 uv;
 };
 
+// Quantized DefaultVertexBufferData, 24 bytes instead of 44: normal and tangent are octahedral
+// encoded into 16-bit SNORM pairs, UVs are half floats. Position stays first and full precision
+// so the position-only shaders and the CPU side readers work with either layout.
+// See VertexQuantization for the encoding and COMPACT_VERTEX in the vertex shaders for the decoding.
+struct CompactVertexBufferData
+{
+	vec3     position;
+	int16_t  normal[2];		// OCT_NORMAL    : R16G16_SNORM
+	int16_t  tangent[2];	// OCT_TANGENT   : R16G16_SNORM
+	uint16_t uv[2];			// HALF_TEXCOORD : R16G16_FLOAT
+};
+
 #if 0	// TODO: abstract render target descriptor
 struct RenderTargetDesc
 {
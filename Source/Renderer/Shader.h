@@ -19,6 +19,7 @@
 #pragma once
 
 #include "RenderingEnums.h"
+#include "ShaderCache.h"
 
 #include <d3dcompiler.h>
 
@@ -80,18 +81,6 @@ struct InputLayout
 };
 
 
-struct ShaderMacro
-{
-	std::string name;
-	std::string value;
-};
-
-struct ShaderStageDesc
-{
-	std::string fileName;
-	std::vector<ShaderMacro> macros;
-};
-
 struct ShaderDesc
 {
 	using ShaderStageArr = std::array<ShaderStageDesc, EShaderStageFlags::SHADER_STAGE_COUNT>;
@@ -179,7 +168,7 @@ public:
 
 	bool Reload(ID3D11Device* device);
 	void ClearConstantBuffers();
-	void UpdateConstants(ID3D11DeviceContext* context);
+	int  UpdateConstants(ID3D11DeviceContext* context);	// returns the number of constant buffers uploaded
 
 	//----------------------------------------------------------------------------------------------------------------
 	// GETTERS
@@ -218,6 +207,21 @@ private:
 	//
 	static void			CacheShaderBinary(const std::string& shaderCacheFileName, ID3D10Blob * pCompiledBinary);
 
+	// Compiler inputs other than the source and the macros: profile, entry point, flags and the compiler version.
+	// Part of the shader cache key so changing any of them invalidates the cached binaries.
+	//
+	static std::string	GetCompilerSettings(EShaderStage stage);
+
+	// Looks the stage up in the shader cache. Each stage is looked up (and counted as a hit or a miss)
+	// once per session: the shaders created after the stage is precompiled get the same lookup.
+	//
+	static ShaderCacheLookup FindStageInCache(const ShaderStageDesc& stageDesc);
+
+	// Compiles the stage into the shader cache if @cache, its lookup, is a miss.
+	// Doesn't touch the device, safe to call from multiple threads for different stages.
+	//
+	static bool			CompileStageToCache(const ShaderStageDesc& stageDesc, const ShaderCacheLookup& cache, bool& bOutCompiled, std::string& outErrMsg);
+
 	// example filePath: "rootPath/filename_vs.hlsl"
 	//                                      ^^----- shaderTypeString
 	static EShaderStage	GetShaderTypeFromSourceFilePath(const std::string& shaderFilePath);
@@ -232,12 +236,13 @@ private:
 	void CheckSignatures();
 	void LogConstantBufferLayouts() const;
 	void ReleaseResources();
-	size_t GeneratePreprocessorDefinitionsHash(const std::vector<ShaderMacro>& macros) const;
 
 private:
 	//----------------------------------------------------------------------------------------------------------------
 	// DATA
 	//----------------------------------------------------------------------------------------------------------------
+	static ShaderCache* spShaderCache;	// owned by the Renderer
+
 	ShaderID mID;
 	ShaderStages mStages;
 
@@ -0,0 +1,146 @@
+//	VQEngine | DirectX11 Renderer
+//	Copyright(C) 2018  - Volkan Ilbeyli
+//
+//	This program is free software : you can redistribute it and / or modify
+//	it under the terms of the GNU General Public License as published by
+//	the Free Software Foundation, either version 3 of the License, or
+//	(at your option) any later version.
+//
+//	This program is distributed in the hope that it will be useful,
+//	but WITHOUT ANY WARRANTY; without even the implied warranty of
+//	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+//	GNU General Public License for more details.
+//
+//	You should have received a copy of the GNU General Public License
+//	along with this program.If not, see <http://www.gnu.org/licenses/>.
+//
+//	Contact: volkanilbeyli@gmail.com
+#pragma once
+
+#include <string>
+#include <vector>
+#include <mutex>
+#include <unordered_map>
+#include <cstdint>
+
+struct ShaderMacro
+{
+	std::string name;
+	std::string value;
+};
+
+struct ShaderStageDesc
+{
+	std::string fileName;
+	std::vector<ShaderMacro> macros;
+};
+
+// Session statistics of the ShaderCache lookups
+//
+struct ShaderCacheStats
+{
+	int numHits;		// binary of the same content hash was in the cache, counted once per stage permutation
+	int numMisses;		// stage had to be compiled, counted once per stage permutation
+	int numPruned;		// stale binaries deleted
+	inline float GetHitRate() const { const int n = numHits + numMisses; return n > 0 ? static_cast<float>(numHits) / n : 0.0f; }
+};
+
+// Result of ShaderCache::Find(), passed back to ShaderCache::Insert() after compiling on a miss
+//
+struct ShaderCacheLookup
+{
+	std::string indexKey;		// stage key and compiler settings
+	std::string sourceFilePath;
+	std::string blobFilePath;
+	uint64_t    contentHash;
+	bool        bHit;
+};
+
+//----------------------------------------------------------------------------------------------------------------
+// SHADER CACHE
+//----------------------------------------------------------------------------------------------------------------
+// Bookkeeping of the compiled shader binaries in the ShaderCache folder: where the binary of a shader
+// stage lives, whether it's out of date and which stage permutations the engine uses (the manifest).
+// Doesn't depend on D3D, compiling the stages is up to the Shader class.
+//
+// Binaries are keyed on the content hash of the source file and its whole include tree, the macros and
+// the compiler settings: touching a file without changing it doesn't recompile anything, and changing a
+// compile flag does. The index file maps each stage permutation to its current binary and keeps the last
+// MAX_PREVIOUS_BINARIES binaries it superseded, so switching branches back and forth doesn't recompile
+// the stages that differ either. Binaries that fall out of that window are pruned.
+//
+// A stage is looked up once per session: Find() remembers the lookup until the stage is Forget()'ed,
+// i.e. when its shader is reloaded.
+//
+class ShaderCache
+{
+public:
+	static constexpr size_t MAX_PREVIOUS_BINARIES = 4;	// per stage permutation
+
+
+	// Unique string for a stage permutation: file name and the preprocessor definitions
+	//
+	static std::string GetStageKey(const ShaderStageDesc& stageDesc);
+
+	// Returns every file @sourceFilePath includes, directly or through other includes, each file once.
+	// Includes are resolved relative to the including file, same as D3D_COMPILE_STANDARD_FILE_INCLUDE.
+	//
+	static std::vector<std::string> GetIncludeTree(const std::string& sourceFilePath);
+
+	// Hash of the contents of @sourceFilePath and its include tree, @macros and @compilerSettings
+	// (anything else that changes the output of the compiler: profile, entry point, flags...).
+	//
+	static uint64_t GetContentHash(const std::string& sourceFilePath, const std::vector<ShaderMacro>& macros, const std::string& compilerSettings);
+
+	// The manifest lists the stage permutations that were created in the previous runs so
+	// they can be compiled ahead of time, before the render passes ask for them one by one.
+	//
+	static bool ReadManifest(const std::string& manifestFilePath, std::vector<ShaderStageDesc>& outStages);
+	static bool WriteManifest(const std::string& manifestFilePath, const std::vector<ShaderStageDesc>& stages);
+
+	// Reads the index of @cacheDirectory. Find() and Insert() are thread safe after this.
+	//
+	bool LoadIndex(const std::string& cacheDirectory);
+
+	// Prunes the stale binaries and writes the index
+	//
+	bool SaveIndex();
+
+	// @sourceFilePath: "rootPath/filename_vs.hlsl" -> blobFilePath: "<cacheDirectory>\filename_vs.hlsl_<content hash>.bin"
+	// The first lookup of a stage in the session hashes its include tree and counts as a hit or a miss,
+	// the following ones return the same lookup.
+	//
+	ShaderCacheLookup Find(const std::string& sourceFilePath, const ShaderStageDesc& stageDesc, const std::string& compilerSettings);
+
+	// Registers the binary written to @lookup.blobFilePath as the current binary of the permutation,
+	// the previous one is kept among its MAX_PREVIOUS_BINARIES superseded binaries.
+	//
+	void Insert(const ShaderCacheLookup& lookup);
+
+	// The next Find() of the stage hashes its sources again, i.e. after they've been edited
+	//
+	void Forget(const ShaderStageDesc& stageDesc);
+
+	// Deletes the binaries of the permutations whose source file is gone, and the
+	// binaries that aren't in the index (older versions of the cache, interrupted writes).
+	//
+	int Prune();
+
+	ShaderCacheStats GetStats() const;
+
+private:
+	struct IndexEntry
+	{
+		uint64_t    contentHash;
+		std::string blobFileName;
+		std::string sourceFilePath;
+		std::vector<std::string> previousBlobFileNames;	// superseded binaries, most recent first
+	};
+	void InsertEntry(const ShaderCacheLookup& lookup);	// expects mMutex to be locked
+
+	std::string mCacheDirectory;
+	mutable std::mutex mMutex;
+	std::unordered_map<std::string, IndexEntry> mIndex;	// ShaderCacheLookup::indexKey -> entry
+	std::unordered_map<std::string, ShaderCacheLookup> mSessionLookups;	// ShaderCacheLookup::indexKey -> lookup of this session
+	ShaderCacheStats mStats = {};
+};
@@ -21,6 +21,8 @@
 
 #include "Utilities/Log.h"
 
+#include <cassert>
+
 Buffer::Buffer(const BufferDesc& desc)
 	: mDesc(desc)
 	, mDirty(true)
@@ -96,14 +98,15 @@ void Buffer::CleanUp()
 	}
 }
 
-void Buffer::Update(Renderer* pRenderer, const void* pData)
+void Buffer::Update(Renderer* pRenderer, const void* pData, unsigned numBytes /*= 0*/)
 {
 	auto* ctx = pRenderer->m_deviceContext;
 
 	D3D11_MAPPED_SUBRESOURCE mappedResource = {};
 	constexpr UINT Subresource = 0;
 	constexpr UINT MapFlags = 0;
-	const UINT Size = mDesc.mStride * mDesc.mElementCount;
+	const UINT Size = numBytes == 0 ? mDesc.mStride * mDesc.mElementCount : numBytes;
+	assert(Size <= mDesc.mStride * mDesc.mElementCount);
 
 	ctx->Map(mpGPUData, Subresource, D3D11_MAP_WRITE_DISCARD, MapFlags, &mappedResource);
 	memcpy(mappedResource.pData, pData, Size);
@@ -26,9 +26,14 @@
 D3DManager::D3DManager()
 {
 	m_swapChain					= nullptr;
+	m_nullBackBuffer			= nullptr;
 	m_device					= nullptr;
 	m_deviceContext				= nullptr;
 	m_wndHeight = m_wndWidth	= 0;
+#if _DEBUG
+	m_debug						= nullptr;
+	m_annotation				= nullptr;
+#endif
 }
 
 D3DManager::~D3DManager(){}
@@ -164,6 +169,64 @@ bool D3DManager::Initialize(int width, int height, const bool VSYNC, HWND hwnd,
 	return true;
 }
 
+bool D3DManager::InitializeNullDevice(int width, int height, HWND hwnd, DXGI_FORMAT FrameBufferFormat)
+{
+	m_hwnd = hwnd;
+	m_vsync_enabled = false;
+	m_VRAM = 0;
+
+#if defined( _DEBUG )
+	UINT flags = D3D11_CREATE_DEVICE_DEBUG;
+#else
+	UINT flags = 0;
+#endif
+
+	D3D_FEATURE_LEVEL featureLevel = D3D_FEATURE_LEVEL_11_1;
+	HRESULT result = D3D11CreateDevice(NULL, D3D_DRIVER_TYPE_NULL, NULL, flags, &featureLevel, 1, D3D11_SDK_VERSION, &m_device, NULL, &m_deviceContext);
+	if (SUCCEEDED(result))
+	{
+		strcpy_s(m_GPUDescription, "Null Device");
+	}
+	else
+	{
+		Log::Warning("D3DManager: Null driver isn't available, falling back to WARP: frame times include the software rasterization.");
+		result = D3D11CreateDevice(NULL, D3D_DRIVER_TYPE_WARP, NULL, flags, &featureLevel, 1, D3D11_SDK_VERSION, &m_device, NULL, &m_deviceContext);
+		strcpy_s(m_GPUDescription, "WARP");
+	}
+	if (FAILED(result))
+	{
+		Log::Error("D3DManager: Cannot create the null device");
+		return false;
+	}
+
+	D3D11_TEXTURE2D_DESC backBufferDesc = {};
+	backBufferDesc.Width = width;
+	backBufferDesc.Height = height;
+	backBufferDesc.MipLevels = 1;
+	backBufferDesc.ArraySize = 1;
+	backBufferDesc.Format = FrameBufferFormat;
+	backBufferDesc.SampleDesc.Count = 1;
+	backBufferDesc.Usage = D3D11_USAGE_DEFAULT;
+	backBufferDesc.BindFlags = D3D11_BIND_RENDER_TARGET | D3D11_BIND_SHADER_RESOURCE;
+	result = m_device->CreateTexture2D(&backBufferDesc, nullptr, &m_nullBackBuffer);
+	if (FAILED(result))
+	{
+		Log::Error("D3DManager: Cannot create the back buffer of the null device");
+		return false;
+	}
+
+#if _DEBUG
+	if (FAILED(m_deviceContext->QueryInterface(__uuidof(ID3DUserDefinedAnnotation), (void**)&m_annotation)))
+	{
+		m_annotation = nullptr;	// markers are skipped
+	}
+#endif
+
+	m_wndWidth  = width;
+	m_wndHeight = height;
+	return true;
+}
+
 void D3DManager::Shutdown()
 {	
 	// Before shutting down set to windowed mode or when you release the swap chain it will throw an exception.
@@ -189,6 +252,12 @@ void D3DManager::Shutdown()
 		m_swapChain->Release();
 		m_swapChain = nullptr;
 	}
+
+	if (m_nullBackBuffer)
+	{
+		m_nullBackBuffer->Release();
+		m_nullBackBuffer = nullptr;
+	}
 #if _DEBUG
 	if (m_annotation)
 	{
@@ -207,10 +276,23 @@ void D3DManager::Shutdown()
 
 void D3DManager::EndFrame()
 {
+	if (!m_swapChain)			return;	// null device
 	if (m_vsync_enabled)		m_swapChain->Present(0, 0);
 	else						m_swapChain->Present(0, 0);
 }
 
+HRESULT D3DManager::GetBackBuffer(ID3D11Texture2D** ppBackBuffer) const
+{
+	if (m_swapChain)
+		return m_swapChain->GetBuffer(0, __uuidof(ID3D11Texture2D), (LPVOID*)ppBackBuffer);
+
+	if (!m_nullBackBuffer)
+		return E_FAIL;
+	m_nullBackBuffer->AddRef();
+	*ppBackBuffer = m_nullBackBuffer;
+	return S_OK;
+}
+
 void D3DManager::GetVideoCardInfo(char* cardName, int& memory)
 {
 	strcpy_s(cardName, 128, m_GPUDescription);
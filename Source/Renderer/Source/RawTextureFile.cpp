@@ -0,0 +1,143 @@
+//	VQEngine | DirectX11 Renderer
+//	Copyright(C) 2018  - Volkan Ilbeyli
+//
+//	This program is free software : you can redistribute it and / or modify
+//	it under the terms of the GNU General Public License as published by
+//	the Free Software Foundation, either version 3 of the License, or
+//	(at your option) any later version.
+//
+//	This program is distributed in the hope that it will be useful,
+//	but WITHOUT ANY WARRANTY; without even the implied warranty of
+//	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+//	GNU General Public License for more details.
+//
+//	You should have received a copy of the GNU General Public License
+//	along with this program.If not, see <http://www.gnu.org/licenses/>.
+//
+//	Contact: volkanilbeyli@gmail.com
+
+#include "RawTextureFile.h"
+
+#include "Utilities/Log.h"
+#include "Utilities/utils.h"
+
+#include <windows.h>
+#include <fstream>
+
+// bump the version whenever the layout below or RawTextureHeader/RawSubresource change
+static constexpr uint32_t RAW_TEXTURE_MAGIC   = 0x58545156;	// 'VQTX'
+static constexpr uint32_t RAW_TEXTURE_VERSION = 1;
+static constexpr size_t   DATA_ALIGNMENT      = 16;
+
+// File layout:
+//
+//   RawTextureHeader | RawSubresource[arraySize * mipCount] | padding to DATA_ALIGNMENT | texel data
+//
+static inline size_t GetDataOffset(size_t numSubresources)
+{
+	const size_t offset = sizeof(RawTextureHeader) + numSubresources * sizeof(RawSubresource);
+	return (offset + DATA_ALIGNMENT - 1) & ~(DATA_ALIGNMENT - 1);
+}
+
+
+bool RawTextureFile::Write(const std::string& filePath, const RawTextureData& texture)
+{
+	const size_t numSubresources = static_cast<size_t>(texture.header.arraySize) * texture.header.mipCount;
+	if (texture.subresources.size() != numSubresources)
+	{
+		Log::Error("RawTextureFile: %s has %zu subresources, expected %zu.", filePath.c_str(), texture.subresources.size(), numSubresources);
+		return false;
+	}
+
+	DirectoryUtil::CreateFolderIfItDoesntExist(DirectoryUtil::GetFolderPath(filePath));
+	std::ofstream file(filePath, std::ios::binary | std::ios::trunc);
+	if (!file.is_open())
+	{
+		Log::Error("RawTextureFile: Couldn't open %s for writing.", filePath.c_str());
+		return false;
+	}
+
+	RawTextureHeader header = texture.header;
+	header.magic   = RAW_TEXTURE_MAGIC;
+	header.version = RAW_TEXTURE_VERSION;
+
+	const char padding[DATA_ALIGNMENT] = {};
+	const size_t dataOffset = GetDataOffset(numSubresources);
+	file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	file.write(reinterpret_cast<const char*>(texture.subresources.data()), numSubresources * sizeof(RawSubresource));
+	file.write(padding, dataOffset - static_cast<size_t>(file.tellp()));
+	file.write(reinterpret_cast<const char*>(texture.data.data()), texture.data.size());
+
+	if (!file.good())
+	{
+		Log::Error("RawTextureFile: Error writing %s.", filePath.c_str());
+		file.close();
+		DeleteFile(filePath.c_str());
+		return false;
+	}
+	return true;
+}
+
+RawTextureFile::~RawTextureFile()
+{
+	Close();
+}
+
+bool RawTextureFile::Open(const std::string& filePath, uint64_t expectedKey)
+{
+	Close();
+
+	if (!mFile.Open(filePath))
+		return false;	// not cached yet
+	if (mFile.GetSize() < sizeof(RawTextureHeader))
+	{
+		Log::Warning("RawTextureFile: %s is truncated.", filePath.c_str());
+		Close();
+		return false;
+	}
+
+	const uint8_t* pBase = static_cast<const uint8_t*>(mFile.GetData());
+	mpHeader = reinterpret_cast<const RawTextureHeader*>(pBase);
+	mNumSubresources = static_cast<size_t>(mpHeader->arraySize) * mpHeader->mipCount;
+	const size_t dataOffset = GetDataOffset(mNumSubresources);
+	const bool bValidHeader = mpHeader->magic == RAW_TEXTURE_MAGIC
+		&& mpHeader->version == RAW_TEXTURE_VERSION
+		&& mNumSubresources > 0
+		&& dataOffset <= mFile.GetSize();
+	if (!bValidHeader)
+	{
+		Log::Warning("RawTextureFile: %s is outdated or corrupt.", filePath.c_str());
+		Close();
+		return false;
+	}
+	if (mpHeader->key != expectedKey)
+	{
+		Close();	// inputs changed since the file was written
+		return false;
+	}
+
+	mpSubresources = reinterpret_cast<const RawSubresource*>(pBase + sizeof(RawTextureHeader));
+	mpData = pBase + dataOffset;
+
+	// subresources are handed to the GPU as-is, reject the file rather than reading past the mapping
+	const size_t dataSize = mFile.GetSize() - dataOffset;
+	for (size_t i = 0; i < mNumSubresources; ++i)
+	{
+		if (mpSubresources[i].offset + mpSubresources[i].size > dataSize)
+		{
+			Log::Warning("RawTextureFile: %s has invalid subresource ranges.", filePath.c_str());
+			Close();
+			return false;
+		}
+	}
+	return true;
+}
+
+void RawTextureFile::Close()
+{
+	mFile.Close();
+	mpHeader = nullptr;
+	mpSubresources = nullptr;
+	mNumSubresources = 0;
+	mpData = nullptr;
+}
@@ -29,8 +29,16 @@
 
 #include "Application/SystemDefs.h"
 
+#include "Application/Application.h"
+
 #include "Utilities/utils.h"
 
+#include "TextureProcessor.h"
+#include "ShaderCache.h"
+#include "RawTextureFile.h"
+
+#include "Application/ThreadPool.h"
+
 #define STB_IMAGE_IMPLEMENTATION
 #include "3rdParty/stb/stb_image.h"
 #include "3rdParty/DirectXTex/DirectXTex/DirectXTex.h"
@@ -40,6 +48,16 @@
 #include <mutex>
 #include <cassert>
 #include <fstream>
+#include <chrono>
+#include <unordered_set>
+
+// Textures loaded from image files are cached as DDS files with precomputed mips, keyed by
+// the contents of the source file. Block compression is off: normal maps and masks go through
+// the same path and don't survive BC1/BC3 well, and BC7 is too slow to encode on the CPU.
+#define TEXTURE_CACHE_ENABLED 1
+static const TextureProcessSettings TEXTURE_CACHE_SETTINGS = { true, ETextureMipFilter::BOX, ETextureCompression::NONE };
+
+static constexpr const char* SHADER_MANIFEST_FILE_NAME = "ShaderManifest.txt";
 
 
 // HELPER FUNCTIONS
@@ -199,11 +217,12 @@ Renderer::Renderer()
 
 Renderer::~Renderer(){}
 
-bool Renderer::Initialize(HWND hwnd, const Settings::Window& settings)
+bool Renderer::Initialize(HWND hwnd, const Settings::Window& settings, bool bNullDevice /*= false*/)
 {
 	// DIRECT3D 11
 	//--------------------------------------------------------------------
 	mWindowSettings = settings;
+	mbNullDevice = bNullDevice;
 	m_Direct3D = new D3DManager();
 	if (!m_Direct3D)
 	{
@@ -211,24 +230,35 @@ bool Renderer::Initialize(HWND hwnd, const Settings::Window& settings)
 		return false;
 	}
 
-	bool result = m_Direct3D->Initialize(
-		settings.width,
-		settings.height,
-		settings.vsync == 1,
-		hwnd,
-		settings.fullscreen == 1,
-		DXGI_FORMAT_R16G16B16A16_FLOAT
-		// swapchain should be bgra unorm 32bit
-	);
+	bool result = bNullDevice
+		? m_Direct3D->InitializeNullDevice(settings.width, settings.height, hwnd, DXGI_FORMAT_B8G8R8A8_UNORM)
+		: m_Direct3D->Initialize(
+			settings.width,
+			settings.height,
+			settings.vsync == 1,
+			hwnd,
+			settings.fullscreen == 1,
+			DXGI_FORMAT_R16G16B16A16_FLOAT
+			// swapchain should be bgra unorm 32bit
+		);
 
 	if (!result)
 	{
-		MessageBox(hwnd, "Could not initialize Direct3D", "Error", MB_OK);
+		if (bNullDevice)	Log::Error("Could not initialize the Direct3D null device");
+		else				MessageBox(hwnd, "Could not initialize Direct3D", "Error", MB_OK);
 		return false;
 	}
 	m_device = m_Direct3D->m_device;
 	m_deviceContext = m_Direct3D->m_deviceContext;
 	Mesh::spRenderer = this;
+	Shader::spShaderCache = &mShaderCache;
+
+	// TEXTURE CACHE
+	//--------------------------------------------------------------------
+	mTextureCacheDirectory = Application::s_WorkspaceDirectory + "\\TextureCache\\";
+	DirectoryUtil::CreateFolderIfItDoesntExist(mTextureCacheDirectory);
+	mTextureCacheDirectory += "Processed\\";
+	DirectoryUtil::CreateFolderIfItDoesntExist(mTextureCacheDirectory);
 
 	// DEFAULT RENDER TARGET
 	//--------------------------------------------------------------------
@@ -236,7 +266,7 @@ bool Renderer::Initialize(HWND hwnd, const Settings::Window& settings)
 		RenderTarget defaultRT;
 
 		ID3D11Texture2D* backBufferPtr;
-		HRESULT hr = m_Direct3D->m_swapChain->GetBuffer(0, __uuidof(ID3D11Texture2D), (LPVOID*)&backBufferPtr);
+		HRESULT hr = m_Direct3D->GetBackBuffer(&backBufferPtr);
 		if (FAILED(hr))
 		{
 			Log::Error("Cannot get back buffer pointer in DefaultRenderTarget initialization");
@@ -471,6 +501,10 @@ bool Renderer::Initialize(HWND hwnd, const Settings::Window& settings)
 void Renderer::Exit()
 {
 	//m_Direct3D->ReportLiveObjects("BEGIN EXIT");
+	if (mbValidateState)
+	{
+		Log::Info("Renderer state validation: %zu errors (%zu distinct)", mNumStateValidationErrors, mReportedStateValidationErrors.size());
+	}
 
 	constexpr size_t BUFFER_TYPE_COUNT = 3;
 	std::vector<Buffer>* buffers[BUFFER_TYPE_COUNT] = { &mVertexBuffers, &mIndexBuffers, &mUABuffers };
@@ -482,6 +516,7 @@ void Renderer::Exit()
 	}
 	
 	// Unload shaders
+	SaveShaderManifest();
 	for (Shader*& shd : mShaders)
 	{
 		delete shd;
@@ -494,6 +529,7 @@ void Renderer::Exit()
 		tex.Release();
 	}
 	mTextures.clear();
+	mTextureFileLookup.clear();
 
 	for (Sampler& s : mSamplers)
 	{
@@ -623,6 +659,7 @@ const PipelineState& Renderer::GetState() const
 
 ShaderID Renderer::CreateShader(const ShaderDesc& shaderDesc)
 {
+	RegisterShaderStages(shaderDesc);
 	Shader* shader = new Shader(shaderDesc.shaderName);
 	shader->CompileShaders(m_device, shaderDesc);
 
@@ -640,6 +677,9 @@ ShaderID Renderer::ReloadShader(const ShaderDesc& shaderDesc, const ShaderID sha
 	}
 
 	assert(shaderID >= 0 && shaderID < mShaders.size());
+	RegisterShaderStages(shaderDesc);
+	for (const ShaderStageDesc& stageDesc : shaderDesc.stages)
+		mShaderCache.Forget(stageDesc);
 	Shader* pShader = mShaders[shaderID];
 	delete pShader;
 	pShader = new Shader(shaderDesc.shaderName);
@@ -650,6 +690,118 @@ ShaderID Renderer::ReloadShader(const ShaderDesc& shaderDesc, const ShaderID sha
 	return pShader->ID();
 }
 
+ShaderPrecompileStats Renderer::PrecompileShaders(const std::vector<ShaderStageDesc>& stages, VQEngine::ThreadPool* pThreadPool)
+{
+	const auto start = std::chrono::high_resolution_clock::now();
+	ShaderPrecompileStats stats = {};
+
+	// different shaders share stages (i.e. Skybox_vs.hlsl): two workers writing the
+	// same cache file would race, so each permutation is compiled exactly once.
+	std::vector<const ShaderStageDesc*> uniqueStages;
+	{
+		std::unordered_set<std::string> stageKeys;
+		for (const ShaderStageDesc& stage : stages)
+		{
+			if (!stage.fileName.empty() && stageKeys.insert(ShaderCache::GetStageKey(stage)).second)
+				uniqueStages.push_back(&stage);
+		}
+	}
+
+	struct StageResult
+	{
+		bool bSuccess;
+		bool bCompiled;
+		std::string errMsg;
+	};
+	auto fnCompileStage = [](const ShaderStageDesc* pStage) -> StageResult
+	{
+		StageResult result = {};
+		result.bSuccess = Shader::CompileStageToCache(*pStage, Shader::FindStageInCache(*pStage), result.bCompiled, result.errMsg);
+		return result;
+	};
+
+	std::vector<std::future<StageResult>> tasks;
+	std::vector<StageResult> results(uniqueStages.size());
+	if (pThreadPool && pThreadPool->GetThreadCount() > 0)
+	{
+		tasks.reserve(uniqueStages.size());
+		for (const ShaderStageDesc* pStage : uniqueStages)
+			tasks.push_back(pThreadPool->AddTask([=]() { return fnCompileStage(pStage); }));
+		for (size_t i = 0; i < tasks.size(); ++i)
+			results[i] = tasks[i].get();
+	}
+	else
+	{
+		for (size_t i = 0; i < uniqueStages.size(); ++i)
+			results[i] = fnCompileStage(uniqueStages[i]);
+	}
+
+	stats.numStages = static_cast<int>(uniqueStages.size());
+	for (size_t i = 0; i < results.size(); ++i)
+	{
+		if (!results[i].bSuccess)
+		{
+			++stats.numFailed;
+			Log::Error("[ShaderCompile] %s: %s", uniqueStages[i]->fileName.c_str(), results[i].errMsg.c_str());
+		}
+		else if (results[i].bCompiled)
+		{
+			++stats.numCompiled;
+		}
+	}
+	stats.timeMs = std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+	return stats;
+}
+
+void Renderer::RegisterShaderStages(const ShaderDesc& shaderDesc)
+{
+	std::unique_lock<std::mutex> l(mShaderStageRegistryMutex);
+	for (const ShaderStageDesc& stage : shaderDesc.stages)
+	{
+		if (!stage.fileName.empty())
+			mShaderStageRegistry[ShaderCache::GetStageKey(stage)] = stage;
+	}
+}
+
+std::vector<ShaderStageDesc> Renderer::GetKnownShaderStages()
+{
+	std::unique_lock<std::mutex> l(mShaderStageRegistryMutex);
+	std::vector<ShaderStageDesc> stages;
+	stages.reserve(mShaderStageRegistry.size());
+	for (const auto& kvp : mShaderStageRegistry)
+		stages.push_back(kvp.second);
+	return stages;
+}
+
+void Renderer::LoadShaderManifest()
+{
+	mShaderCache.LoadIndex(Application::s_ShaderCacheDirectory);
+
+	std::vector<ShaderStageDesc> stages;
+	if (!ShaderCache::ReadManifest(Application::s_ShaderCacheDirectory + "\\" + SHADER_MANIFEST_FILE_NAME, stages))
+		return;
+
+	std::unique_lock<std::mutex> l(mShaderStageRegistryMutex);
+	for (ShaderStageDesc& stage : stages)
+	{
+		if (!DirectoryUtil::FileExists(sShaderRoot + stage.fileName))
+			continue;	// drop the shaders that have been removed since
+		mShaderStageRegistry[ShaderCache::GetStageKey(stage)] = std::move(stage);
+	}
+}
+
+void Renderer::SaveShaderManifest()
+{
+	const std::vector<ShaderStageDesc> stages = GetKnownShaderStages();
+	if (!stages.empty())
+		ShaderCache::WriteManifest(Application::s_ShaderCacheDirectory + "\\" + SHADER_MANIFEST_FILE_NAME, stages);
+
+	mShaderCache.SaveIndex();
+	const ShaderCacheStats stats = mShaderCache.GetStats();
+	Log::Info("Shader cache: %d hits, %d misses (%.1f%% hit rate) | %d stale binaries pruned"
+		, stats.numHits, stats.numMisses, stats.GetHitRate() * 100.0f, stats.numPruned);
+}
+
 ShaderDesc Renderer::GetShaderDesc(ShaderID shaderID) const
 {
 	assert(shaderID >= 0 && mShaders.size() > shaderID);
@@ -682,36 +834,94 @@ RasterizerStateID Renderer::AddRasterizerState(ERasterizerCullMode cullMode, ERa
 // example params: "openart/185.png", "Data/Textures/"
 TextureID Renderer::CreateTextureFromFile(const std::string& texFileName, const std::string& fileRoot /*= s_textureRoot*/)
 {
-	// renderer is single threaded in general, therefore finer granularity is not currently provided
-	// and instead, a mutex lcok is employed for the entire duration of creating a texture from file.
-	// this will require refactoring if its decided to go for a truely multi-threaded renderer.
-	//
-	std::unique_lock<std::mutex> l(mTexturesMutex);	
-
 	if (texFileName.empty() || texFileName == "\"\"")
 	{
 		Log::Warning("Warning: CreateTextureFromFile() - empty texture file name passed as parameter");
 		return -1;
 	}
-	
-	auto found = std::find_if(mTextures.begin(), mTextures.end(), [&texFileName](auto& tex) { return tex._name == texFileName; });
-	if (found != mTextures.end())
+
+	// textures are keyed by their full path: models in different directories
+	// can have textures with the same file name.
+	const std::string path = fileRoot + texFileName;
+
+	// the lock only guards the lookups and mTextures. decoding the file and creating the
+	// D3D resource (ID3D11Device is free threaded) happens outside, so model loading threads
+	// don't serialize on each other. The first thread to request a file decodes it,
+	// the others requesting the same file wait on its future instead of decoding it again.
+	//
+	std::promise<TextureID> decodePromise;
 	{
-		return (*found)._id;
+		std::unique_lock<std::mutex> l(mTexturesMutex);
+		++mTextureLoadStats.numRequests;
+
+		auto itLoaded = mTextureFileLookup.find(path);
+		if (itLoaded != mTextureFileLookup.end())
+		{
+			++mTextureLoadStats.numCacheHits;
+			return itLoaded->second;
+		}
+
+		auto itInFlight = mTextureFilesInFlight.find(path);
+		if (itInFlight != mTextureFilesInFlight.end())
+		{
+			++mTextureLoadStats.numInFlightWaits;
+			std::shared_future<TextureID> decodeResult = itInFlight->second;
+			l.unlock();
+			return decodeResult.get();
+		}
+
+		mTextureFilesInFlight[path] = decodePromise.get_future().share();
 	}
-	
 
-	const std::string path = fileRoot + texFileName;
 #if _DEBUG
 	Log::Info("Loading Texture\t\t%s", path.c_str());
 #endif
+	const auto decodeStart = std::chrono::high_resolution_clock::now();
 
 	Texture tex;
-
 	tex._name = texFileName;
-	std::wstring wpath(path.begin(), path.end());
+
+	// TEXTURE CACHE: the source file is read once for hashing. If there's no processed texture
+	// for its contents yet, it's decoded from memory, mipmapped and written to the cache.
+	//
 	std::unique_ptr<DirectX::ScratchImage> img = std::make_unique<DirectX::ScratchImage>();
-	if (SUCCEEDED(LoadFromWICFile(wpath.c_str(), WIC_FLAGS_NONE, nullptr, *img)))
+	bool bDecoded = false;
+	bool bProcessed = false;
+#if TEXTURE_CACHE_ENABLED
+	std::vector<uint8_t> sourceData;
+	if (TextureProcessor::ReadFile(path, sourceData))
+	{
+		const uint64_t cacheKey = TextureProcessor::GetCacheKey(sourceData.data(), sourceData.size(), TEXTURE_CACHE_SETTINGS);
+		std::string fileName = texFileName.substr(texFileName.find_last_of("/\\") + 1);	// model textures can have relative paths w/ either separator
+		fileName = fileName.substr(0, fileName.find_last_of('.'));
+		const std::string cacheFilePath = mTextureCacheDirectory + fileName + "_" + HashToString(cacheKey) + ".dds";
+		const std::wstring wCachePath(cacheFilePath.begin(), cacheFilePath.end());
+
+		bDecoded = DirectoryUtil::FileExists(cacheFilePath)
+			&& SUCCEEDED(LoadFromDDSFile(wCachePath.c_str(), DDS_FLAGS_NONE, nullptr, *img));
+		if (!bDecoded)
+		{
+			TextureProcessStats processStats = {};
+			bDecoded = bProcessed = TextureProcessor::Process(sourceData.data(), sourceData.size(), cacheFilePath, TEXTURE_CACHE_SETTINGS, &processStats, img.get());
+			if (bProcessed)
+			{
+				Log::Info("Processed Texture\t%s: %dx%d, %d mips, %s, PSNR=%.1fdB | %.2fms, %.1f MPix/s"
+					, texFileName.c_str(), processStats.width, processStats.height, processStats.mipCount
+					, TextureProcessor::GetCompressionName(TEXTURE_CACHE_SETTINGS.compression), processStats.psnr
+					, processStats.GetTotalTimeMs(), processStats.GetMegaPixelsPerSecond()
+				);
+			}
+		}
+	}
+#endif
+
+	if (!bDecoded)
+	{
+		std::wstring wpath(path.begin(), path.end());
+		bDecoded = SUCCEEDED(LoadFromWICFile(wpath.c_str(), WIC_FLAGS_NONE, nullptr, *img));
+	}
+
+	if (bDecoded)
 	{
 		CreateShaderResourceView(m_device, img->GetImages(), img->GetImageCount(), img->GetMetadata(), &tex._srv);
 
@@ -730,16 +940,49 @@ TextureID Renderer::CreateTextureFromFile(const std::string& texFileName, const
 			tex._height = desc.Height;
 		}
 		resource->Release();
-
-		tex._id = static_cast<int>(mTextures.size());
-		mTextures.emplace_back(std::move(tex));
-		return mTextures.back()._id;
 	}
 	else
 	{
 		Log::Error("Cannot load texture file: %s\n", texFileName.c_str());
-		return mTextures[0]._id;
 	}
+
+	const std::chrono::duration<float, std::milli> decodeTime = std::chrono::high_resolution_clock::now() - decodeStart;
+
+	TextureID texID = -1;
+	{
+		std::unique_lock<std::mutex> l(mTexturesMutex);
+		if (bDecoded)
+		{
+			tex._id = static_cast<int>(mTextures.size());
+			mTextures.emplace_back(std::move(tex));
+			texID = mTextures.back()._id;
+			mTextureFileLookup[path] = texID;
+			++mTextureLoadStats.numDecodes;
+			if (bProcessed) ++mTextureLoadStats.numProcessed;
+		}
+		else
+		{
+			// failed loads aren't cached, a later request will try to decode the file again.
+			texID = mTextures[0]._id;
+			++mTextureLoadStats.numFailedDecodes;
+		}
+		mTextureLoadStats.decodeTimeMs += decodeTime.count();
+		mTextureFilesInFlight.erase(path);
+	}
+	decodePromise.set_value(texID);
+	return texID;
+}
+
+TextureLoadStats Renderer::GetTextureLoadStats()
+{
+	std::unique_lock<std::mutex> l(mTexturesMutex);
+	return mTextureLoadStats;
+}
+
+void Renderer::ResetTextureLoadStats()
+{
+	std::unique_lock<std::mutex> l(mTexturesMutex);
+	mTextureLoadStats = {};
 }
 
 TextureID Renderer::CreateTexture2D(const TextureDesc& texDesc)
@@ -779,8 +1022,12 @@ TextureID Renderer::CreateTexture2D(const TextureDesc& texDesc)
 	desc.MiscFlags = miscFlags;
 
 	D3D11_SUBRESOURCE_DATA dataDesc = {};
-	D3D11_SUBRESOURCE_DATA* pDataDesc = nullptr;
-	if (texDesc.pData)
+	const D3D11_SUBRESOURCE_DATA* pDataDesc = nullptr;
+	if (texDesc.pSubresourceData)
+	{
+		pDataDesc = texDesc.pSubresourceData;
+	}
+	else if (texDesc.pData)
 	{
 		dataDesc.pSysMem = texDesc.pData;
 		dataDesc.SysMemPitch = texDesc.dataPitch;
@@ -955,6 +1202,87 @@ TextureID Renderer::CreateHDRTexture(const std::string& texFileName, const std::
 	return newTex;
 }
 
+TextureID Renderer::CreateTextureFromRawFile(const std::string& filePath, uint64_t key)
+{
+	RawTextureFile file;
+	if (!file.Open(filePath, key))
+		return -1;
+
+	const RawTextureHeader& header = file.GetHeader();
+	std::vector<D3D11_SUBRESOURCE_DATA> subresources(file.GetSubresourceCount());
+	for (size_t i = 0; i < subresources.size(); ++i)
+	{
+		subresources[i].pSysMem          = file.GetSubresourceData(i);
+		subresources[i].SysMemPitch      = file.GetSubresource(i).rowPitch;
+		subresources[i].SysMemSlicePitch = file.GetSubresource(i).size;
+	}
+
+	TextureDesc texDesc = {};
+	texDesc.width            = static_cast<int>(header.width);
+	texDesc.height           = static_cast<int>(header.height);
+	texDesc.format           = static_cast<EImageFormat>(header.format);
+	texDesc.mipCount         = static_cast<int>(header.mipCount);
+	texDesc.arraySize        = static_cast<int>(header.arraySize);
+	texDesc.bIsCubeMap       = header.bIsCubeMap != 0;
+	texDesc.usage            = ETextureUsage::RESOURCE;
+	texDesc.texFileName      = DirectoryUtil::GetFileNameWithoutExtension(filePath);
+	texDesc.pSubresourceData = subresources.data();
+	return CreateTexture2D(texDesc);	// the mapping is only read during the upload, file closes on return
+}
+
+bool Renderer::ReadbackTexture(TextureID texID, RawTextureData& outData) const
+{
+	if (mbNullDevice)
+	{	// nothing was rendered into the texture, don't let its contents end up in the caches
+		return false;
+	}
+
+	const Texture& tex = GetTextureObject(texID);
+	DirectX::ScratchImage image;
+	if (FAILED(DirectX::CaptureTexture(m_device, m_deviceContext, tex._tex2D, image)))
+	{
+		Log::Error("Couldn't read back texture %s", tex._name.c_str());
+		return false;
+	}
+
+	const DirectX::TexMetadata& meta = image.GetMetadata();
+	outData.header = {};
+	outData.header.format     = static_cast<uint32_t>(meta.format);
+	outData.header.width      = static_cast<uint32_t>(meta.width);
+	outData.header.height     = static_cast<uint32_t>(meta.height);
+	outData.header.arraySize  = static_cast<uint32_t>(meta.arraySize);	// 6 faces for cubemaps
+	outData.header.mipCount   = static_cast<uint32_t>(meta.mipLevels);
+	outData.header.bIsCubeMap = meta.IsCubemap() ? 1 : 0;
+
+	outData.subresources.clear();
+	outData.data.clear();
+	outData.subresources.reserve(meta.arraySize * meta.mipLevels);
+	outData.data.reserve(image.GetPixelsSize());
+	for (size_t item = 0; item < meta.arraySize; ++item)
+	{
+		for (size_t mip = 0; mip < meta.mipLevels; ++mip)
+		{
+			const DirectX::Image& mipImage = *image.GetImage(mip, item, 0);
+			RawSubresource subresource = {};
+			subresource.offset   = outData.data.size();
+			subresource.rowPitch = static_cast<uint32_t>(mipImage.rowPitch);
+			subresource.size     = static_cast<uint32_t>(mipImage.slicePitch);
+			outData.subresources.push_back(subresource);
+			outData.data.insert(outData.data.end(), mipImage.pixels, mipImage.pixels + mipImage.slicePitch);
+		}
+	}
+	return true;
+}
+
+bool Renderer::SaveTextureToRawFile(TextureID texID, const std::string& filePath, uint64_t key) const
+{
+	RawTextureData texture;
+	if (!ReadbackTexture(texID, texture))
+		return false;
+	texture.header.key = key;
+	return RawTextureFile::Write(filePath, texture);
+}
+
 bool Renderer::SaveTextureToDisk(TextureID texID, const std::string& filePath, bool bConverToSRGB) const
 {
 	const std::string folderPath = DirectoryUtil::GetFolderPath(filePath);
@@ -1952,7 +2280,7 @@ void Renderer::BeginRender(const ClearCommand & clearCmd)
 
 void Renderer::BeginFrame()
 {
-	mRenderStats = { 0, 0, 0 };
+	mRenderStats = {};
 }
 
 void Renderer::EndFrame()
@@ -1961,10 +2289,10 @@ void Renderer::EndFrame()
 }
 
 
-void Renderer::UpdateBuffer(BufferID buffer, const void * pData)
+void Renderer::UpdateBuffer(BufferID buffer, const void * pData, unsigned numBytes /*= 0*/)
 {
 	assert(buffer >= 0 && buffer < mVertexBuffers.size());
-	mVertexBuffers[buffer].Update(this, pData);
+	mVertexBuffers[buffer].Update(this, pData, numBytes);
 }
 
 void Renderer::Apply()
@@ -2028,8 +2356,17 @@ void Renderer::Apply()
 	unsigned stride = VertexBuffer.mDesc.mStride;
 	unsigned offset = 0;
 
-	if (bVBufferValid && bVertexBufferChanged)	{ m_deviceContext->IASetVertexBuffers(0, 1, &(VertexBuffer.mpGPUData), &stride, &offset); }
-	if (bIBufferValid && bIndexBufferChanged)	{ m_deviceContext->IASetIndexBuffer(IndexBuffer.mpGPUData, DXGI_FORMAT_R32_UINT, 0); }
+	if (bVBufferValid && bVertexBufferChanged)
+	{
+		m_deviceContext->IASetVertexBuffers(0, 1, &(VertexBuffer.mpGPUData), &stride, &offset);
+		++mRenderStats.numStateChanges;
+	}
+	if (bIBufferValid && bIndexBufferChanged)
+	{
+		const DXGI_FORMAT indexFormat = IndexBuffer.mDesc.mStride == sizeof(uint16_t) ? DXGI_FORMAT_R16_UINT : DXGI_FORMAT_R32_UINT;
+		m_deviceContext->IASetIndexBuffer(IndexBuffer.mpGPUData, indexFormat, 0);
+		++mRenderStats.numStateChanges;
+	}
 	
 	
 	// SHADER STAGES
@@ -2044,12 +2381,19 @@ void Renderer::Apply()
 		m_deviceContext->HSSetShader(shader->mStages.mHullShader     , pClassInstance, 0);
 		m_deviceContext->DSSetShader(shader->mStages.mDomainShader   , pClassInstance, 0);
 		m_deviceContext->CSSetShader(shader->mStages.mComputeShader  , pClassInstance, 0);
+		++mRenderStats.numShaderChanges;
 	}
 
 
 	// CONSTANT BUFFERS & SHADER RESOURCES
 	// ----------------------------------------
-	shader->UpdateConstants(m_deviceContext);
+	mRenderStats.numConstantBufferUpdates += shader->UpdateConstants(m_deviceContext);
+
+	if (mbValidateState)
+	{
+		ValidateResourceBindings();
+	}
+	mRenderStats.numResourceBindings += static_cast<int>(mSetSamplerCmds.size() + mSetTextureCmds.size());
 
 	while (mSetSamplerCmds.size() > 0)
 	{
@@ -2068,15 +2412,15 @@ void Renderer::Apply()
 
 	// RASTERIZER
 	// ----------------------------------------
-	if (bViewPortChanged) { m_deviceContext->RSSetViewports(1, &mPipelineState.viewPort); }
-	if (bRasterizerStateChanged) { m_deviceContext->RSSetState(mRasterizerStates[mPipelineState.rasterizerState]); }
+	if (bViewPortChanged) { m_deviceContext->RSSetViewports(1, &mPipelineState.viewPort); ++mRenderStats.numStateChanges; }
+	if (bRasterizerStateChanged) { m_deviceContext->RSSetState(mRasterizerStates[mPipelineState.rasterizerState]); ++mRenderStats.numStateChanges; }
 
 
 
 	// OUTPUT MERGER
 	// ----------------------------------------
-	if (sEnableBlend && bBlendStateChanged){ m_deviceContext->OMSetBlendState(mBlendStates[mPipelineState.blendState].ptr, nullptr, 0xffffffff); }
-	if (bDepthStencilStateChanged){	  m_deviceContext->OMSetDepthStencilState(mDepthStencilStates[mPipelineState.depthStencilState], 0); }
+	if (sEnableBlend && bBlendStateChanged){ m_deviceContext->OMSetBlendState(mBlendStates[mPipelineState.blendState].ptr, nullptr, 0xffffffff); ++mRenderStats.numStateChanges; }
+	if (bDepthStencilStateChanged){	  m_deviceContext->OMSetDepthStencilState(mDepthStencilStates[mPipelineState.depthStencilState], 0); ++mRenderStats.numStateChanges; }
 
 	// get the bound render target addresses
 	const auto indexRTV = mPipelineState.renderTargets[0];
@@ -2112,6 +2456,7 @@ void Renderer::Apply()
 	if (RTV || bRenderTargetChanged || (DSV && bDepthTargetChanged))
 	{
 		m_deviceContext->OMSetRenderTargets(numRTV, RTV, DSV);
+		++mRenderStats.numRenderTargetChanges;
 	}
 
 	mPrevPipelineState = mPipelineState;
@@ -2120,6 +2465,7 @@ void Renderer::Apply()
 void Renderer::BeginEvent(const std::string & marker)
 {
 #if _DEBUG
+	if (!m_Direct3D->m_annotation) return;
 	StrUtil::UnicodeString umarker(marker);
 	m_Direct3D->m_annotation->BeginEvent(umarker.GetUnicodePtr());
 #endif
@@ -2128,12 +2474,15 @@ void Renderer::BeginEvent(const std::string & marker)
 void Renderer::EndEvent()
 {
 #if _DEBUG
+	if (!m_Direct3D->m_annotation) return;
 	m_Direct3D->m_annotation->EndEvent();
 #endif
 }
 
 void Renderer::DrawIndexed(EPrimitiveTopology topology)
 {
+	if (mbValidateState) { ValidateDrawState("DrawIndexed", true, false); }
+
 	const Buffer& VertexBuffer = mVertexBuffers[mPipelineState.vertexBuffer];
 	const Buffer& IndexBuffer = mIndexBuffers[mPipelineState.indexBuffer];
 
@@ -2144,6 +2493,7 @@ void Renderer::DrawIndexed(EPrimitiveTopology topology)
 	if (mPipelineState.topology != mPrevPipelineState.topology) 
 	{ 
 		m_deviceContext->IASetPrimitiveTopology(static_cast<D3D_PRIMITIVE_TOPOLOGY>(topology)); 
+		++mRenderStats.numStateChanges;
 	}
 
 	m_deviceContext->DrawIndexed(numIndices, 0, 0);
@@ -2156,6 +2506,8 @@ void Renderer::DrawIndexed(EPrimitiveTopology topology)
 
 void Renderer::DrawIndexedInstanced(int instanceCount, EPrimitiveTopology topology /*= EPrimitiveTopology::POINT_LIST*/)
 {
+	if (mbValidateState) { ValidateDrawState("DrawIndexedInstanced", true, false); }
+
 	const Buffer& VertexBuffer = mVertexBuffers[mPipelineState.vertexBuffer];
 	const Buffer& IndexBuffer = mIndexBuffers[mPipelineState.indexBuffer];
 
@@ -2166,6 +2518,7 @@ void Renderer::DrawIndexedInstanced(int instanceCount, EPrimitiveTopology topolo
 	if (mPipelineState.topology != mPrevPipelineState.topology)
 	{
 		m_deviceContext->IASetPrimitiveTopology(static_cast<D3D_PRIMITIVE_TOPOLOGY>(topology));
+		++mRenderStats.numStateChanges;
 	}
 
 	m_deviceContext->DrawIndexedInstanced(numIndices, instanceCount, 0, 0, 0);
@@ -2178,14 +2531,111 @@ void Renderer::DrawIndexedInstanced(int instanceCount, EPrimitiveTopology topolo
 
 void Renderer::Draw(int vertCount, EPrimitiveTopology topology /*= EPrimitiveTopology::POINT_LIST*/)
 {
+	if (mbValidateState) { ValidateDrawState("Draw", false, false); }
+
 	m_deviceContext->IASetPrimitiveTopology(static_cast<D3D_PRIMITIVE_TOPOLOGY>(topology));
 	m_deviceContext->Draw(vertCount, 0);
 	
 	++mRenderStats.numDrawCalls;
+	++mRenderStats.numStateChanges;	// topology
 	mRenderStats.numVertices += vertCount;
 }
 
 void Renderer::Dispatch(int x, int y, int z)
 {
+	if (mbValidateState) { ValidateDrawState("Dispatch", false, true); }
+
 	m_deviceContext->Dispatch(x, y, z);
 }
+
+
+//----------------------------------------------------------------------------------------------------------------
+// STATE VALIDATION
+//----------------------------------------------------------------------------------------------------------------
+void Renderer::ReportStateValidationError(const std::string& error)
+{
+	++mNumStateValidationErrors;
+	if (mReportedStateValidationErrors.insert(error).second)
+	{
+		Log::Warning(std::string("Renderer state validation: ") + error);
+	}
+}
+
+void Renderer::ValidateDrawState(const char* pDrawCall, bool bIndexed, bool bCompute)
+{
+	const PipelineState& curr = mPipelineState;
+	const PipelineState& prev = mPrevPipelineState;
+
+	const Shader* pShader = curr.shader >= 0 && curr.shader < static_cast<int>(mShaders.size()) ? mShaders[curr.shader] : nullptr;
+	if (!pShader)
+	{
+		ReportStateValidationError(std::string(pDrawCall) + "() without a shader");
+		return;
+	}
+	const std::string context = std::string(pDrawCall) + "() w/ " + pShader->Name() + ": ";
+
+	if (bCompute && !pShader->mStages.mComputeShader)	ReportStateValidationError(context + "shader doesn't have a compute stage");
+	if (!bCompute && !pShader->mStages.mVertexShader)	ReportStateValidationError(context + "shader doesn't have a vertex stage");
+
+	// state that is set after Apply() doesn't reach the device context
+	const bool bStateNotApplied = curr.shader != prev.shader
+		|| curr.vertexBuffer != prev.vertexBuffer
+		|| curr.indexBuffer != prev.indexBuffer
+		|| curr.viewPort != prev.viewPort
+		|| curr.rasterizerState != prev.rasterizerState
+		|| curr.depthStencilState != prev.depthStencilState
+		|| curr.blendState != prev.blendState
+		|| curr.depthTargets != prev.depthTargets
+		|| curr.renderTargets != prev.renderTargets;
+	if (bStateNotApplied)
+		ReportStateValidationError(context + "pipeline state changed after Apply()");
+	if (!mSetTextureCmds.empty() || !mSetSamplerCmds.empty())
+		ReportStateValidationError(context + "textures/samplers set after Apply()");
+	if (std::any_of(RANGE(pShader->mConstantBuffers), [](const ConstantBufferBinding& cb) { return cb.dirty; }))
+		ReportStateValidationError(context + "constants set after Apply()");
+
+	if (bCompute)
+		return;
+
+	if (bIndexed)
+	{
+		if (curr.vertexBuffer < 0 || curr.vertexBuffer >= static_cast<int>(mVertexBuffers.size()))
+			ReportStateValidationError(context + "no vertex buffer bound");
+		if (curr.indexBuffer < 0 || curr.indexBuffer >= static_cast<int>(mIndexBuffers.size()))
+			ReportStateValidationError(context + "no index buffer bound");
+	}
+
+	const bool bRenderTargetBound = std::any_of(RANGE(curr.renderTargets), [](RenderTargetID rt) { return rt >= 0; });
+	if (!bRenderTargetBound && curr.depthTargets < 0)
+		ReportStateValidationError(context + "no render target or depth target bound");
+	if (curr.viewPort.Width <= 0.0f || curr.viewPort.Height <= 0.0f)
+		ReportStateValidationError(context + "empty viewport");
+}
+
+void Renderer::ValidateResourceBindings()
+{
+	// D3D11 silently unbinds the shader resource views of the resources that are bound as outputs
+	std::vector<TextureID> outputTextures;
+	for (RenderTargetID rt : mPipelineState.renderTargets)
+		if (rt >= 0) outputTextures.push_back(mRenderTargets[rt].texture._id);
+	if (mPipelineState.depthTargets >= 0)
+		outputTextures.push_back(mDepthTargets[mPipelineState.depthTargets].texture._id);
+	if (outputTextures.empty())
+		return;
+
+	std::queue<SetTextureCommand> textureCmds = mSetTextureCmds;
+	for (; !textureCmds.empty(); textureCmds.pop())
+	{
+		const SetTextureCommand& cmd = textureCmds.front();
+		if (cmd.bUnorderedAccess)
+			continue;
+		for (unsigned i = 0; i < cmd.numTextures; ++i)
+		{
+			if (std::find(RANGE(outputTextures), cmd.textureIDs[i]) != outputTextures.end())
+			{
+				const std::string& shaderName = mShaders[mPipelineState.shader]->Name();	// Apply() checks the shader
+				ReportStateValidationError("Apply() w/ " + shaderName + ": texture " + mTextures[cmd.textureIDs[i]]._name + " is bound as an input and an output");
+			}
+		}
+	}
+}
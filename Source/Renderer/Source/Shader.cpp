@@ -50,6 +50,15 @@ static const std::unordered_map<EShaderStage, const char*> SHADER_ENTRY_POINT_LO
 	{ EShaderStage::CS, "CSMain" },
 };
 
+// packed vertex attributes are read as float2 by the shaders but stored quantized in the vertex
+// buffer (CompactVertexBufferData): their semantic name selects the format of the input element.
+static const std::unordered_map<std::string, DXGI_FORMAT> PACKED_VERTEX_ATTRIBUTE_FORMAT_LOOKUP =
+{
+	{ "OCT_NORMAL"   , DXGI_FORMAT_R16G16_SNORM },
+	{ "OCT_TANGENT"  , DXGI_FORMAT_R16G16_SNORM },
+	{ "HALF_TEXCOORD", DXGI_FORMAT_R16G16_FLOAT },
+};
+
 ID3DInclude* const SHADER_INCLUDE_HANDLER = D3D_COMPILE_STANDARD_FILE_INCLUDE;		// use default include handler for using #include in shader files
 
 #if defined( _DEBUG ) || defined ( FORCE_DEBUG )
@@ -77,6 +86,8 @@ static void(CALLING_CONVENTION ID3D11DeviceContext:: *SetShaderConstants[EShader
 	&ID3D11DeviceContext::CSSetConstantBuffers,
 };
 
+ShaderCache* Shader::spShaderCache = nullptr;
+
 static std::unordered_map <std::string, EShaderStage > s_ShaderTypeStrLookup = 
 {
 	{"vs", EShaderStage::VS},
@@ -113,62 +124,6 @@ std::string GetCompileError(ID3D10Blob*& errorMessage, const std::string& shdPat
 	}
 }
 
-bool IsCacheDirty(const std::string& sourcePath, const std::string& cachePath)
-{
-	if (!DirectoryUtil::FileExists(cachePath)) return true;
-
-	auto GetIncludeFileName = [](const std::string& line)
-	{
-		const std::string str_search = "#include \"";
-		const size_t foundPos = line.find(str_search);
-		if (foundPos != std::string::npos)
-		{
-			std::string quotedFileName = line.substr(foundPos + strlen("#include "), line.size() - foundPos);// +str_search.size() - 1);
-			return quotedFileName.substr(1, quotedFileName.size() - 2);
-		}
-		return std::string();
-	};
-
-	const std::string ShaderSourceDir = DirectoryUtil::GetFolderPath(sourcePath);
-	const std::string ShaderCacheDir = DirectoryUtil::GetFolderPath(cachePath);
-
-	auto AreIncludesDirty = [&](const std::string& srcPath)
-	{
-		std::stack<std::string> includeStack;
-		includeStack.push(srcPath);
-		while (!includeStack.empty())
-		{
-			const std::string includeFilePath = includeStack.top();
-			includeStack.pop();
-			std::ifstream src = std::ifstream(includeFilePath.c_str());
-			if (!src.good())
-			{
-				Log::Error("[ShaderCompile] Cannot open source file: %s", includeFilePath.c_str());
-				continue;
-			}
-
-			std::string line;
-			while (getline(src, line))
-			{
-				const std::string includeFileName = GetIncludeFileName(line);
-				if (includeFileName.empty()) continue;
-
-				const std::string includeSourcePath = ShaderSourceDir + includeFileName;
-				const std::string includeCachePath = ShaderCacheDir + includeFileName;
-
-				if (DirectoryUtil::IsFileNewer(includeSourcePath, cachePath))
-					return true;
-				includeStack.push(includeSourcePath);
-			}
-			src.close();
-		}
-		return false;
-	};
-
-	return DirectoryUtil::IsFileNewer(sourcePath, cachePath) || AreIncludesDirty(sourcePath);
-}
-
-
 bool Shader::CompileFromSource(const std::string& pathToFile, const EShaderStage& type, ID3D10Blob *& ref_pBob, std::string& errMsg, const std::vector<ShaderMacro>& macros)
 {
 	const StrUtil::UnicodeString Path = pathToFile;
@@ -228,6 +183,38 @@ void Shader::CacheShaderBinary(const std::string& shaderCacheFileName, ID3D10Blo
 	cache.close();
 }
 
+std::string Shader::GetCompilerSettings(EShaderStage stage)
+{
+	std::stringstream ss;
+	ss << SHADER_COMPILER_VERSION_LOOKUP.at(stage) << " " << SHADER_ENTRY_POINT_LOOKUP.at(stage)
+		<< " flags=0x" << std::hex << SHADER_COMPILE_FLAGS << " d3dcompiler_" << std::dec << D3D_COMPILER_VERSION;
+	return ss.str();
+}
+
+ShaderCacheLookup Shader::FindStageInCache(const ShaderStageDesc& stageDesc)
+{
+	const std::string sourceFilePath = std::string(Renderer::sShaderRoot + stageDesc.fileName);
+	return spShaderCache->Find(sourceFilePath, stageDesc, GetCompilerSettings(GetShaderTypeFromSourceFilePath(sourceFilePath)));
+}
+
+bool Shader::CompileStageToCache(const ShaderStageDesc& stageDesc, const ShaderCacheLookup& cache, bool& bOutCompiled, std::string& outErrMsg)
+{
+	bOutCompiled = false;
+	if (cache.bHit)
+		return true;
+
+	const EShaderStage stage = GetShaderTypeFromSourceFilePath(cache.sourceFilePath);
+	ID3D10Blob* pBlob = nullptr;
+	if (!CompileFromSource(cache.sourceFilePath, stage, pBlob, outErrMsg, stageDesc.macros))
+		return false;
+
+	CacheShaderBinary(cache.blobFilePath, pBlob);
+	spShaderCache->Insert(cache);
+	pBlob->Release();
+	bOutCompiled = true;
+	return true;
+}
+
 EShaderStage Shader::GetShaderTypeFromSourceFilePath(const std::string & shaderFilePath)
 {
 	const std::string sourceFileName = DirectoryUtil::GetFileNameWithoutExtension(shaderFilePath);
@@ -341,20 +328,13 @@ void Shader::ReleaseResources()
 
 
 
-size_t Shader::GeneratePreprocessorDefinitionsHash(const std::vector<ShaderMacro>& macros) const
-{
-	if (macros.empty()) return 0;
-	std::string concatenatedMacros;
-	for (const ShaderMacro& macro : macros)
-		concatenatedMacros += macro.name + macro.value;
-	return std::hash<std::string>()(concatenatedMacros);
-}
-
 bool Shader::Reload(ID3D11Device* device)
 {
 	Shader copy(this->mDescriptor);
 	copy.mID = this->mID;
 	ReleaseResources();
+	for (const ShaderStageDesc& stageDesc : copy.mDescriptor.stages)
+		spShaderCache->Forget(stageDesc);	// the sources changed since the stages were looked up
 	this->mID = copy.mID;
 	return CompileShaders(device, copy.mDescriptor);
 }
@@ -381,8 +361,9 @@ void Shader::ClearConstantBuffers()
 	}
 }
 
-void Shader::UpdateConstants(ID3D11DeviceContext* context)
+int Shader::UpdateConstants(ID3D11DeviceContext* context)
 {
+	int numUpdates = 0;
 	for (unsigned i = 0; i < mConstantBuffers.size(); ++i)
 	{
 		ConstantBufferBinding& CB = mConstantBuffers[i];
@@ -415,8 +396,10 @@ void Shader::UpdateConstants(ID3D11DeviceContext* context)
 			// call XSSetConstantBuffers() from array using ShaderType enum
 			(context->*SetShaderConstants[CB.shaderStage])(CB.bufferSlot, 1, &data);
 			CB.dirty = false;
+			++numUpdates;
 		}
 	}
+	return numUpdates;
 }
 
 
@@ -427,7 +410,6 @@ void Shader::UpdateConstants(ID3D11DeviceContext* context)
 //-------------------------------------------------------------------------------------------------------------
 bool Shader::CompileShaders(ID3D11Device* device, const ShaderDesc& desc)
 {
-	constexpr const char * SHADER_BINARY_EXTENSION = ".bin";
 	mDescriptor = desc;
 	HRESULT result;
 	ShaderBlobs blobs;
@@ -450,14 +432,8 @@ bool Shader::CompileShaders(ID3D11Device* device, const ShaderDesc& desc)
 
 		// USE SHADER CACHE
 		//
-		const size_t ShaderHash = GeneratePreprocessorDefinitionsHash(stageDesc.macros);
-		const std::string cacheFileName = stageDesc.macros.empty()
-			? DirectoryUtil::GetFileNameFromPath(sourceFilePath) + SHADER_BINARY_EXTENSION
-			: DirectoryUtil::GetFileNameFromPath(sourceFilePath) + "_" + std::to_string(ShaderHash) + SHADER_BINARY_EXTENSION;
-		const std::string cacheFilePath = Application::s_ShaderCacheDirectory + "\\" + cacheFileName;
-		const bool bUseCachedShaders =
-			DirectoryUtil::FileExists(cacheFilePath)
-			&& !IsCacheDirty(sourceFilePath, cacheFilePath);
+		const ShaderCacheLookup cache = FindStageInCache(stageDesc);	// already resolved if the stage was precompiled
+		const bool bUseCachedShaders = cache.bHit;
 		//---------------------------------------------------------------------------------
 		if (!bPrinted)	// quick status print here
 		{
@@ -468,7 +444,7 @@ bool Shader::CompileShaders(ID3D11Device* device, const ShaderDesc& desc)
 		//---------------------------------------------------------------------------------
 		if (bUseCachedShaders)
 		{
-			blobs.of[stage] = CompileFromCachedBinary(cacheFilePath);
+			blobs.of[stage] = CompileFromCachedBinary(cache.blobFilePath);
 		}
 		else
 		{
@@ -477,7 +453,8 @@ bool Shader::CompileShaders(ID3D11Device* device, const ShaderDesc& desc)
 			if (CompileFromSource(sourceFilePath, stage, pBlob, errMsg, stageDesc.macros))
 			{
 				blobs.of[stage] = pBlob;
-				CacheShaderBinary(cacheFilePath, blobs.of[stage]);
+				CacheShaderBinary(cache.blobFilePath, blobs.of[stage]);
+				spShaderCache->Insert(cache);
 			}
 			else
 			{
@@ -550,6 +527,12 @@ bool Shader::CompileShaders(ID3D11Device* device, const ShaderDesc& desc)
 				else if (paramDesc.ComponentType == D3D_REGISTER_COMPONENT_FLOAT32) elementDesc.Format = DXGI_FORMAT_R32G32B32A32_FLOAT;
 			}
 
+			const auto itPackedFormat = PACKED_VERTEX_ATTRIBUTE_FORMAT_LOOKUP.find(paramDesc.SemanticName);
+			if (itPackedFormat != PACKED_VERTEX_ATTRIBUTE_FORMAT_LOOKUP.end())
+			{
+				elementDesc.Format = itPackedFormat->second;
+			}
+
 			inputLayout[i] = elementDesc; //save element desc
 		}
 
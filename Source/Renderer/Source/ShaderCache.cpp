@@ -0,0 +1,420 @@
+//	VQEngine | DirectX11 Renderer
+//	Copyright(C) 2018  - Volkan Ilbeyli
+//
+//	This program is free software : you can redistribute it and / or modify
+//	it under the terms of the GNU General Public License as published by
+//	the Free Software Foundation, either version 3 of the License, or
+//	(at your option) any later version.
+//
+//	This program is distributed in the hope that it will be useful,
+//	but WITHOUT ANY WARRANTY; without even the implied warranty of
+//	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+//	GNU General Public License for more details.
+//
+//	You should have received a copy of the GNU General Public License
+//	along with this program.If not, see <http://www.gnu.org/licenses/>.
+//
+//	Contact: volkanilbeyli@gmail.com
+
+#include "ShaderCache.h"
+
+#include "Utilities/Log.h"
+#include "Utilities/utils.h"
+
+#include <fstream>
+#include <sstream>
+#include <stack>
+#include <unordered_set>
+#include <algorithm>
+#include <iterator>
+#include <functional>
+#include <cstdlib>
+#include <cstdio>
+#include <experimental/filesystem>
+
+namespace fs = std::experimental::filesystem;
+
+// bump whenever the key or the binary format changes
+static constexpr uint32_t SHADER_CACHE_VERSION = 2;
+
+// bump whenever the index file format changes. The binaries don't depend on it: a dropped index is
+// rebuilt from the lookups, which find the binaries by their content hash.
+static constexpr uint32_t SHADER_CACHE_INDEX_VERSION = 2;
+
+constexpr const char* SHADER_BINARY_EXTENSION = ".bin";
+constexpr const char* SHADER_CACHE_INDEX_FILE_NAME = "ShaderCacheIndex.txt";
+constexpr const char* SHADER_CACHE_INDEX_HEADER = "ShaderCacheIndex";
+constexpr char PREVIOUS_BLOB_SEPARATOR = '|';	// can't be part of a file name
+
+// returns the file name in the #include "fileName" directive, empty string if @line isn't one.
+// system includes (#include <...>) aren't used by the engine shaders.
+static std::string GetIncludeFileName(const std::string& line)
+{
+	const size_t directivePos = line.find("#include");
+	if (directivePos == std::string::npos)
+		return std::string();
+
+	const size_t commentPos = line.find("//");
+	if (commentPos != std::string::npos && commentPos < directivePos)
+		return std::string();
+
+	const size_t begin = line.find('"', directivePos);
+	const size_t end = begin == std::string::npos ? std::string::npos : line.find('"', begin + 1);
+	if (end == std::string::npos)
+		return std::string();
+	return line.substr(begin + 1, end - begin - 1);
+}
+
+static std::string GetFileNameFromAnyPath(const std::string& filePath)
+{
+	const size_t separator = filePath.find_last_of("/\\");
+	return separator == std::string::npos ? filePath : filePath.substr(separator + 1);
+}
+
+static bool ReadFileContents(const std::string& filePath, std::string& outContents)
+{
+	std::ifstream file(filePath, std::ios::binary | std::ios::ate);
+	if (!file.is_open())
+		return false;
+
+	const std::streamsize size = file.tellg();
+	file.seekg(0, std::ios::beg);
+	outContents.resize(static_cast<size_t>(size));
+	return size == 0 || static_cast<bool>(file.read(&outContents[0], size));
+}
+
+// Calls @fnVisit for @sourceFilePath and every file in its include tree, each file once, with the contents
+// of the file. Contents are null if the file can't be read. Every file is read from disk only once.
+//
+using IncludeTreeVisitor = std::function<void(const std::string& filePath, const std::string* pContents)>;
+static void VisitIncludeTree(const std::string& sourceFilePath, const IncludeTreeVisitor& fnVisit)
+{
+	std::unordered_set<std::string> visited = { sourceFilePath };	// guards against include cycles
+
+	std::stack<std::string> includeStack;
+	includeStack.push(sourceFilePath);
+	while (!includeStack.empty())
+	{
+		const std::string filePath = includeStack.top();
+		includeStack.pop();
+
+		std::string contents;
+		if (!ReadFileContents(filePath, contents))
+		{
+			Log::Error("[ShaderCompile] Cannot open source file: %s", filePath.c_str());
+			fnVisit(filePath, nullptr);
+			continue;
+		}
+		fnVisit(filePath, &contents);
+
+		const std::string fileDirectory = DirectoryUtil::GetFolderPath(filePath);
+		std::istringstream src(contents);
+		std::string line;
+		while (getline(src, line))
+		{
+			const std::string includeFileName = GetIncludeFileName(line);
+			if (includeFileName.empty()) continue;
+
+			const std::string includeFilePath = fileDirectory + includeFileName;
+			if (visited.insert(includeFilePath).second)
+				includeStack.push(includeFilePath);
+		}
+	}
+}
+
+
+std::string ShaderCache::GetStageKey(const ShaderStageDesc& stageDesc)
+{
+	std::string key = stageDesc.fileName;
+	for (const ShaderMacro& macro : stageDesc.macros)
+		key += "\t" + macro.name + "=" + macro.value;
+	return key;
+}
+
+std::vector<std::string> ShaderCache::GetIncludeTree(const std::string& sourceFilePath)
+{
+	std::vector<std::string> includes;
+	VisitIncludeTree(sourceFilePath, [&](const std::string& filePath, const std::string*)
+	{
+		if (filePath != sourceFilePath)
+			includes.push_back(filePath);
+	});
+	return includes;
+}
+
+uint64_t ShaderCache::GetContentHash(const std::string& sourceFilePath, const std::vector<ShaderMacro>& macros, const std::string& compilerSettings)
+{
+	auto fnHashString = [](const std::string& str, uint64_t seed) { return HashBytes(str.c_str(), str.size() + 1, seed); };	// +1: keep the separator
+
+	uint64_t hash = HashValue(SHADER_CACHE_VERSION);
+	VisitIncludeTree(sourceFilePath, [&](const std::string& filePath, const std::string* pContents)
+	{
+		// missing includes are part of the key too: the stage recompiles (and reports the error) once they show up
+		hash = fnHashString(filePath, hash);
+		hash = HashValue(pContents != nullptr, hash);
+		if (pContents)
+			hash = HashBytes(pContents->data(), pContents->size(), hash);
+	});
+	for (const ShaderMacro& macro : macros)
+	{
+		hash = fnHashString(macro.name, hash);
+		hash = fnHashString(macro.value, hash);
+	}
+	return fnHashString(compilerSettings, hash);
+}
+
+bool ShaderCache::ReadManifest(const std::string& manifestFilePath, std::vector<ShaderStageDesc>& outStages)
+{
+	std::ifstream manifest(manifestFilePath);
+	if (!manifest.good())
+		return false;
+
+	// one stage per line: fileName[\tMACRO=VALUE]*
+	std::string line;
+	while (getline(manifest, line))
+	{
+		const std::vector<std::string> tokens = StrUtil::split(line, '\t');
+		if (tokens.empty() || tokens[0].empty())
+			continue;
+
+		ShaderStageDesc stage;
+		stage.fileName = tokens[0];
+		for (size_t i = 1; i < tokens.size(); ++i)
+		{
+			const size_t separator = tokens[i].find('=');
+			if (separator == std::string::npos)
+			{
+				Log::Warning("ShaderCache: Ignoring malformed macro '%s' of %s in the manifest", tokens[i].c_str(), stage.fileName.c_str());
+				continue;
+			}
+			stage.macros.push_back(ShaderMacro{ tokens[i].substr(0, separator), tokens[i].substr(separator + 1) });
+		}
+		outStages.push_back(std::move(stage));
+	}
+	return true;
+}
+
+bool ShaderCache::WriteManifest(const std::string& manifestFilePath, const std::vector<ShaderStageDesc>& stages)
+{
+	std::ofstream manifest(manifestFilePath, std::ios::trunc);
+	if (!manifest.good())
+	{
+		Log::Error("ShaderCache: Couldn't write %s", manifestFilePath.c_str());
+		return false;
+	}
+
+	for (const ShaderStageDesc& stage : stages)
+		manifest << GetStageKey(stage) << "\n";
+	return true;
+}
+
+bool ShaderCache::LoadIndex(const std::string& cacheDirectory)
+{
+	std::unique_lock<std::mutex> l(mMutex);
+	mCacheDirectory = cacheDirectory;
+	mIndex.clear();
+
+	std::ifstream index(mCacheDirectory + "\\" + SHADER_CACHE_INDEX_FILE_NAME);
+	if (!index.good())
+		return false;
+
+	std::string line;
+	const std::string header = std::string(SHADER_CACHE_INDEX_HEADER) + "\t" + std::to_string(SHADER_CACHE_INDEX_VERSION);
+	if (!getline(index, line) || line != header)
+	{
+		Log::Info("ShaderCache: Index format changed, rebuilding the index");
+		return false;
+	}
+
+	// one permutation per line: contentHash\tblobFileName\tpreviousBlobFileNames\tsourceFilePath\tindexKey (index key has tabs in it)
+	while (getline(index, line))
+	{
+		size_t tabs[4];
+		size_t pos = 0;
+		bool bMalformed = false;
+		for (size_t& tab : tabs)
+		{
+			tab = line.find('\t', pos);
+			bMalformed |= tab == std::string::npos;
+			pos = bMalformed ? pos : tab + 1;
+		}
+		if (bMalformed)
+		{
+			if (!line.empty())
+				Log::Warning("ShaderCache: Ignoring malformed index entry '%s'", line.c_str());
+			continue;
+		}
+
+		IndexEntry entry;
+		entry.contentHash    = strtoull(line.substr(0, tabs[0]).c_str(), nullptr, 16);
+		entry.blobFileName   = line.substr(tabs[0] + 1, tabs[1] - tabs[0] - 1);
+		entry.sourceFilePath = line.substr(tabs[2] + 1, tabs[3] - tabs[2] - 1);
+		const std::string previousBlobFileNames = line.substr(tabs[1] + 1, tabs[2] - tabs[1] - 1);
+		if (!previousBlobFileNames.empty())
+			entry.previousBlobFileNames = StrUtil::split(previousBlobFileNames, PREVIOUS_BLOB_SEPARATOR);
+		mIndex[line.substr(tabs[3] + 1)] = std::move(entry);
+	}
+	return true;
+}
+
+bool ShaderCache::SaveIndex()
+{
+	if (mCacheDirectory.empty())
+		return false;
+
+	Prune();
+
+	std::unique_lock<std::mutex> l(mMutex);
+	const std::string indexFilePath = mCacheDirectory + "\\" + SHADER_CACHE_INDEX_FILE_NAME;
+	std::ofstream index(indexFilePath, std::ios::trunc);
+	if (!index.good())
+	{
+		Log::Error("ShaderCache: Couldn't write %s", indexFilePath.c_str());
+		return false;
+	}
+
+	index << SHADER_CACHE_INDEX_HEADER << "\t" << SHADER_CACHE_INDEX_VERSION << "\n";
+	for (const auto& kvp : mIndex)
+	{
+		const IndexEntry& entry = kvp.second;
+		std::string previousBlobFileNames;
+		for (const std::string& blobFileName : entry.previousBlobFileNames)
+			previousBlobFileNames += (previousBlobFileNames.empty() ? "" : std::string(1, PREVIOUS_BLOB_SEPARATOR)) + blobFileName;
+
+		index << HashToString(entry.contentHash) << "\t" << entry.blobFileName << "\t" << previousBlobFileNames
+			<< "\t" << entry.sourceFilePath << "\t" << kvp.first << "\n";
+	}
+	return true;
+}
+
+ShaderCacheLookup ShaderCache::Find(const std::string& sourceFilePath, const ShaderStageDesc& stageDesc, const std::string& compilerSettings)
+{
+	ShaderCacheLookup lookup;
+	lookup.indexKey = GetStageKey(stageDesc) + "\t" + compilerSettings;
+	{
+		// the stage is already resolved: precompiled at startup, or created by another shader
+		std::unique_lock<std::mutex> l(mMutex);
+		auto it = mSessionLookups.find(lookup.indexKey);
+		if (it != mSessionLookups.end())
+			lookup = it->second;
+	}
+	if (!lookup.blobFilePath.empty())
+	{
+		lookup.bHit = DirectoryUtil::FileExists(lookup.blobFilePath);
+		return lookup;
+	}
+
+	// hash outside the lock: reading the include trees is the expensive part and workers look up different stages
+	lookup.sourceFilePath = sourceFilePath;
+	lookup.contentHash    = GetContentHash(sourceFilePath, stageDesc.macros, compilerSettings);
+	lookup.blobFilePath   = mCacheDirectory + "\\" + GetFileNameFromAnyPath(sourceFilePath) + "_" + HashToString(lookup.contentHash) + SHADER_BINARY_EXTENSION;
+	lookup.bHit           = DirectoryUtil::FileExists(lookup.blobFilePath);
+
+	std::unique_lock<std::mutex> l(mMutex);
+	if (lookup.bHit)
+	{
+		++mStats.numHits;
+		InsertEntry(lookup);	// keeps the index in sync if it was lost or the binary was produced by another index
+	}
+	else
+	{
+		++mStats.numMisses;
+	}
+	mSessionLookups[lookup.indexKey] = lookup;
+	return lookup;
+}
+
+void ShaderCache::Insert(const ShaderCacheLookup& lookup)
+{
+	std::unique_lock<std::mutex> l(mMutex);
+	InsertEntry(lookup);
+	mSessionLookups[lookup.indexKey] = lookup;
+}
+
+void ShaderCache::Forget(const ShaderStageDesc& stageDesc)
+{
+	const std::string keyPrefix = GetStageKey(stageDesc) + "\t";	// any compiler settings
+
+	std::unique_lock<std::mutex> l(mMutex);
+	for (auto it = mSessionLookups.begin(); it != mSessionLookups.end();)
+		it = it->first.compare(0, keyPrefix.size(), keyPrefix) == 0 ? mSessionLookups.erase(it) : std::next(it);
+}
+
+void ShaderCache::InsertEntry(const ShaderCacheLookup& lookup)
+{
+	const std::string blobFileName = GetFileNameFromAnyPath(lookup.blobFilePath);
+	auto it = mIndex.find(lookup.indexKey);
+	if (it == mIndex.end())
+	{
+		mIndex[lookup.indexKey] = IndexEntry{ lookup.contentHash, blobFileName, lookup.sourceFilePath, {} };
+		return;
+	}
+
+	IndexEntry& entry = it->second;
+	if (entry.blobFileName != blobFileName)
+	{
+		// the permutation's sources changed: keep the previous binary for when they change back, i.e. switching branches
+		std::vector<std::string>& previous = entry.previousBlobFileNames;
+		previous.erase(std::remove(previous.begin(), previous.end(), blobFileName), previous.end());
+		previous.insert(previous.begin(), entry.blobFileName);
+		while (previous.size() > MAX_PREVIOUS_BINARIES)
+		{
+			if (std::remove((mCacheDirectory + "\\" + previous.back()).c_str()) == 0)
+				++mStats.numPruned;
+			previous.pop_back();
+		}
+	}
+	entry.contentHash = lookup.contentHash;
+	entry.blobFileName = blobFileName;
+	entry.sourceFilePath = lookup.sourceFilePath;
+}
+
+int ShaderCache::Prune()
+{
+	std::unique_lock<std::mutex> l(mMutex);
+	if (mCacheDirectory.empty())
+		return 0;
+
+	int numPruned = 0;
+	std::unordered_set<std::string> referencedBlobs;
+	for (auto it = mIndex.begin(); it != mIndex.end();)
+	{
+		IndexEntry& entry = it->second;
+		const bool bSourceRemoved = !DirectoryUtil::FileExists(entry.sourceFilePath);
+		if (bSourceRemoved || !DirectoryUtil::FileExists(mCacheDirectory + "\\" + entry.blobFileName))
+		{
+			it = mIndex.erase(it);	// binary deleted by hand, or the binaries of a removed source: unreferenced, deleted below
+			continue;
+		}
+
+		std::vector<std::string>& previous = entry.previousBlobFileNames;
+		previous.erase(std::remove_if(previous.begin(), previous.end(), [&](const std::string& blobFileName)
+		{
+			return !DirectoryUtil::FileExists(mCacheDirectory + "\\" + blobFileName);
+		}), previous.end());
+
+		referencedBlobs.insert(entry.blobFileName);
+		referencedBlobs.insert(previous.begin(), previous.end());
+		++it;
+	}
+
+	std::error_code err;
+	for (fs::directory_iterator itFile(mCacheDirectory, err), itEnd; !err && itFile != itEnd; itFile.increment(err))
+	{
+		const fs::path& filePath = itFile->path();
+		if (filePath.extension() != SHADER_BINARY_EXTENSION || referencedBlobs.count(filePath.filename().string()))
+			continue;
+		std::error_code removeErr;
+		if (fs::remove(filePath, removeErr))
+			++numPruned;
+	}
+
+	mStats.numPruned += numPruned;
+	return numPruned;
+}
+
+ShaderCacheStats ShaderCache::GetStats() const
+{
+	std::unique_lock<std::mutex> l(mMutex);
+	return mStats;
+}
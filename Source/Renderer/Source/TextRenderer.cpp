@@ -22,8 +22,8 @@
 #include "Utilities/Log.h"
 #include "Utilities/utils.h"
 
-#include <map>
-#include <sstream>
+#include <algorithm>
+#include <cmath>
 
 #include "ft2build.h"
 #include FT_FREETYPE_H
@@ -31,15 +31,7 @@
 Renderer* TextRenderer::pRenderer = nullptr;
 ShaderID TextRenderer::shaderText = -1;
 
-struct Character
-{
-	TextureID tex;	// ID handle of the glyph texture
-	vec2 size;		// Size of glyph
-	vec2 bearing;	// Offset from baseline to left/top of glyph
-	int advance;	// Offset to advance to next glyph
-};
-
-static std::map<char, Character> sCharacters;
+static GlyphTable sGlyphs;
 
 // https://learnopengl.com/#!In-Practice/Text-Rendering
 bool TextRenderer::Initialize(Renderer* pRenderer)
@@ -75,7 +67,22 @@ bool TextRenderer::Initialize(Renderer* pRenderer)
 	const int fontSize = 48;
 	FT_Set_Pixel_Sizes(face, 0, fontSize);
 
-	// create character-texture map
+	// rasterize the glyphs and shelf-pack them into a single atlas texture
+	// so that all the text of a frame can be drawn with the same texture.
+	constexpr int ATLAS_WIDTH = 1024;
+	constexpr int GLYPH_PADDING = 1;	// avoids bleeding from the neighbor glyphs with linear filtering
+
+	struct GlyphBitmap
+	{
+		int w, h;
+		int x, y;	// position in the atlas
+		std::vector<unsigned char> pixels;
+	};
+	std::array<GlyphBitmap, 128> bitmaps;
+
+	int penX = GLYPH_PADDING;
+	int penY = GLYPH_PADDING;
+	int rowHeight = 0;
 	for (char c = 0; c < 127; ++c)
 	{
 		// load character glyph
@@ -85,46 +92,68 @@ bool TextRenderer::Initialize(Renderer* pRenderer)
 			Log::Error("Couldn't load character glyph (%d): %c", c, c);
 		}
 
-		int w = face->glyph->bitmap.width;
-		int h = face->glyph->bitmap.rows;
-		const int l = face->glyph->bitmap_left;
-		const int t = face->glyph->bitmap_top;
-
-		w = w == 0 ? 1 : w;
-		h = h == 0 ? 1 : h;
-		//if (w == 0 || h == 0)
-		//	continue;
-
-		TextureDesc texDesc;
-		texDesc.format = EImageFormat::R8UN;
-		texDesc.width = w;
-		texDesc.height = h;
-		texDesc.pData = face->glyph->bitmap.buffer;
-		texDesc.dataPitch = face->glyph->bitmap.pitch;
-		texDesc.dataSlicePitch = 0;
-
-		TextureID charTexture = pRenderer->CreateTexture2D(texDesc);
-		Character character = 
+		const FT_Bitmap& bmp = face->glyph->bitmap;
+		GlyphBitmap& gb = bitmaps[c];
+		gb.w = bmp.width;
+		gb.h = bmp.rows;
+		gb.pixels.resize(gb.w * gb.h);
+		for (int row = 0; row < gb.h; ++row)
+			memcpy(&gb.pixels[row * gb.w], bmp.buffer + row * bmp.pitch, gb.w);
+
+		if (penX + gb.w + GLYPH_PADDING > ATLAS_WIDTH)
 		{
-			charTexture,
-			vec2(w, h),
-			vec2(l, t),
-			face->glyph->advance.x
-		};
-		sCharacters.insert(std::pair<char, Character>(c, character));
+			penX = GLYPH_PADDING;
+			penY += rowHeight + GLYPH_PADDING;
+			rowHeight = 0;
+		}
+		gb.x = penX;
+		gb.y = penY;
+		penX += gb.w + GLYPH_PADDING;
+		rowHeight = std::max(rowHeight, gb.h);
+
+		Glyph& glyph = sGlyphs[c];
+		glyph.size = vec2(gb.w, gb.h);
+		glyph.bearing = vec2(face->glyph->bitmap_left, face->glyph->bitmap_top);
+		glyph.advance = face->glyph->advance.x;
 	}
 
 	// cleanup
 	FT_Done_Face(face);
 	FT_Done_FreeType(ft);
 
+	int atlasHeight = 1;
+	while (atlasHeight < penY + rowHeight + GLYPH_PADDING)
+		atlasHeight <<= 1;
+
+	std::vector<unsigned char> atlas(ATLAS_WIDTH * atlasHeight, 0);
+	for (int c = 0; c < 127; ++c)
+	{
+		const GlyphBitmap& gb = bitmaps[c];
+		for (int row = 0; row < gb.h; ++row)
+			memcpy(&atlas[(gb.y + row) * ATLAS_WIDTH + gb.x], &gb.pixels[row * gb.w], gb.w);
+
+		sGlyphs[c].uvMin = vec2(static_cast<float>(gb.x) / ATLAS_WIDTH, static_cast<float>(gb.y) / atlasHeight);
+		sGlyphs[c].uvMax = vec2(static_cast<float>(gb.x + gb.w) / ATLAS_WIDTH, static_cast<float>(gb.y + gb.h) / atlasHeight);
+	}
+
+	TextureDesc texDesc;
+	texDesc.format = EImageFormat::R8UN;
+	texDesc.width = ATLAS_WIDTH;
+	texDesc.height = atlasHeight;
+	texDesc.pData = atlas.data();
+	texDesc.dataPitch = ATLAS_WIDTH;
+	texDesc.dataSlicePitch = 0;
+	texDesc.texFileName = "GlyphAtlas";
+	mGlyphAtlas = pRenderer->CreateTexture2D(texDesc);
+
 	// create vertex buffer
 	BufferDesc bufDesc;
-	bufDesc.mElementCount = 6;
-	bufDesc.mStride = sizeof(vec4);
+	bufDesc.mElementCount = static_cast<unsigned>(MAX_BATCH_CHARACTERS * 6);
+	bufDesc.mStride = sizeof(TextVertex);
 	bufDesc.mType = VERTEX_BUFER;
 	bufDesc.mUsage = GPU_READ_CPU_WRITE;
-	mQuadVertexBuffer = pRenderer->CreateBuffer(bufDesc);
+	mVertexBuffer = pRenderer->CreateBuffer(bufDesc);
+	mVertices.reserve(MAX_BATCH_CHARACTERS * 6);
 
 	// todo: blend state desc
 	mAlphaBlendState = pRenderer->AddBlendState(); 
@@ -135,58 +164,157 @@ void TextRenderer::Exit()
 {
 }
 
+size_t TextRenderer::LayoutText(const TextDrawDescription& drawDesc, const vec2& windowSizeXY, const GlyphTable& glyphs, std::vector<TextVertex>& outVertices)
+{
+	const vec3 color = drawDesc.color.Value();
+
+	// offset with half window size, so that (0,0) is top left corner
+	      float x =  drawDesc.screenPosition.x() - windowSizeXY.x() / 2;
+	const float y = -drawDesc.screenPosition.y() + windowSizeXY.y() / 2;
+
+	size_t numQuads = 0;
+	for (const char& c : drawDesc.text)
+	{
+		if (c < 0) continue;	// outside the rasterized range
+		const Glyph& ch = glyphs[c];
+
+		if (ch.size.x() > 0.0f && ch.size.y() > 0.0f)
+		{
+			const float xpos = x + ch.bearing.x() * drawDesc.scale;
+			const float ypos = y - (ch.size.y() - ch.bearing.y()) * drawDesc.scale;
+
+			const float w = ch.size.x() * drawDesc.scale;
+			const float h = ch.size.y() * drawDesc.scale;
+
+			const float u0 = ch.uvMin.x(); const float v0 = ch.uvMin.y();
+			const float u1 = ch.uvMax.x(); const float v1 = ch.uvMax.y();
+
+			const TextVertex vertices[6] =
+			{
+				{ xpos,     ypos + h,   u0, v0, color.x(), color.y(), color.z() },
+				{ xpos,     ypos,       u0, v1, color.x(), color.y(), color.z() },
+				{ xpos + w, ypos,       u1, v1, color.x(), color.y(), color.z() },
+
+				{ xpos,     ypos + h,   u0, v0, color.x(), color.y(), color.z() },
+				{ xpos + w, ypos,       u1, v1, color.x(), color.y(), color.z() },
+				{ xpos + w, ypos + h,   u1, v0, color.x(), color.y(), color.z() }
+			};
+			outVertices.insert(outVertices.end(), std::begin(vertices), std::end(vertices));
+			++numQuads;
+		}
+
+		x += (ch.advance >> 6) * drawDesc.scale; // Bitshift by 6 to get value in pixels (2^6 = 64 (divide amount of 1/64th pixels by 64 to get amount of pixels))
+	}
+	return numQuads;
+}
+
 void TextRenderer::RenderText(const TextDrawDescription& drawDesc)
 {
 	assert(pRenderer);
+	LayoutText(drawDesc, pRenderer->GetWindowDimensionsAsFloat2(), sGlyphs, mVertices);
+}
+
+void TextRenderer::Flush()
+{
+	assert(pRenderer);
+	if (mVertices.empty())
+		return;
+
 	const vec2 windowSizeXY = pRenderer->GetWindowDimensionsAsFloat2();
 	const XMMATRIX proj = XMMatrixOrthographicLH(windowSizeXY.x(), windowSizeXY.y(), 0.1f, 1000.0f);
-	
-	
-	std::stringstream ss;
-	ss << "RenderText: " << drawDesc.text;
 
-	pRenderer->BeginEvent(ss.str());
+	pRenderer->BeginEvent("RenderText");
 	pRenderer->SetShader(shaderText);
 	pRenderer->SetConstant4x4f("projection", proj);
-	pRenderer->SetConstant3f("color", drawDesc.color);
 	pRenderer->SetSamplerState("samText", EDefaultSamplerState::LINEAR_FILTER_SAMPLER);
 	pRenderer->SetBlendState(mAlphaBlendState);
 	pRenderer->SetDepthStencilState(EDefaultDepthStencilState::DEPTH_STENCIL_DISABLED);
+	pRenderer->SetTexture("textMap", mGlyphAtlas);
+	pRenderer->SetVertexBuffer(mVertexBuffer);
 
-	// offset with half window size, so that (0,0) is top left corner
-	      float x =  drawDesc.screenPosition.x() - windowSizeXY.x() / 2;
-	const float y = -drawDesc.screenPosition.y() + windowSizeXY.y() / 2;
+	constexpr size_t MAX_BATCH_VERTICES = MAX_BATCH_CHARACTERS * 6;
+	for (size_t first = 0; first < mVertices.size(); first += MAX_BATCH_VERTICES)
+	{
+		const size_t numVertices = std::min(MAX_BATCH_VERTICES, mVertices.size() - first);
+		pRenderer->UpdateBuffer(mVertexBuffer, &mVertices[first], static_cast<unsigned>(numVertices * sizeof(TextVertex)));
+		pRenderer->Apply();
+		pRenderer->Draw(static_cast<int>(numVertices), EPrimitiveTopology::TRIANGLE_LIST);
+	}
+	pRenderer->SetBlendState(EDefaultBlendState::DISABLED);
 
-	for (const char& c : drawDesc.text)
+	pRenderer->EndEvent();
+	mVertices.clear();
+}
+
+
+
+//----------------------------------------------------------------------------------------------------------------
+// SELF-CHECK
+//----------------------------------------------------------------------------------------------------------------
+bool TextRenderer::RunLayoutTests()
+{
+	// 'A' sits on the baseline, 'g' goes 4px below it, ' ' only advances the pen. 'g' has 1/2 pixel
+	// of extra advance which the layout truncates. '?' has no glyph and the last character is out of range.
+	GlyphTable glyphs = {};
+	glyphs['A'] = { vec2(10, 12), vec2(1, 12), 12 << 6     , vec2(0.00f, 0.0f), vec2(0.25f, 0.5f) };
+	glyphs['g'] = { vec2( 8, 12), vec2(0,  8), (9 << 6) + 32, vec2(0.25f, 0.0f), vec2(0.50f, 0.5f) };
+	glyphs[' '] = { vec2( 0,  0), vec2(0,  0), 5 << 6      , vec2(0.00f, 0.0f), vec2(0.00f, 0.0f) };
+
+	TextDrawDescription drawDesc;
+	drawDesc.text = "A g?\xC3";
+	drawDesc.color = LinearColor(1.0f, 0.5f, 0.25f);
+	drawDesc.screenPosition = vec2(100.0f, 50.0f);
+	drawDesc.scale = 2.0f;
+	const vec2 windowSizeXY(800.0f, 600.0f);
+
+	// pen starts at (100-400, -50+300) = (-300, 250) in screen centered coordinates.
+	// A: x=-300+1*2, y=250-(12-12)*2, 20x24, then the pen advances 12*2 and 5*2 for the space.
+	// g: x=-266+0*2, y=250-(12- 8)*2, 16x24
+	const TextVertex SENTINEL = { 7.0f, 7.0f, 7.0f, 7.0f, 7.0f, 7.0f, 7.0f };
+	const TextVertex EXPECTED[] =
 	{
-		const Character& ch = sCharacters.at(c);
+		SENTINEL,
+		{ -298.0f, 274.0f, 0.00f, 0.0f, 1.0f, 0.5f, 0.25f },
+		{ -298.0f, 250.0f, 0.00f, 0.5f, 1.0f, 0.5f, 0.25f },
+		{ -278.0f, 250.0f, 0.25f, 0.5f, 1.0f, 0.5f, 0.25f },
+		{ -298.0f, 274.0f, 0.00f, 0.0f, 1.0f, 0.5f, 0.25f },
+		{ -278.0f, 250.0f, 0.25f, 0.5f, 1.0f, 0.5f, 0.25f },
+		{ -278.0f, 274.0f, 0.25f, 0.0f, 1.0f, 0.5f, 0.25f },
 
-		const float xpos = x + ch.bearing.x() * drawDesc.scale;
-		const float ypos = y - (ch.size.y() - ch.bearing.y()) * drawDesc.scale;
+		{ -266.0f, 266.0f, 0.25f, 0.0f, 1.0f, 0.5f, 0.25f },
+		{ -266.0f, 242.0f, 0.25f, 0.5f, 1.0f, 0.5f, 0.25f },
+		{ -250.0f, 242.0f, 0.50f, 0.5f, 1.0f, 0.5f, 0.25f },
+		{ -266.0f, 266.0f, 0.25f, 0.0f, 1.0f, 0.5f, 0.25f },
+		{ -250.0f, 242.0f, 0.50f, 0.5f, 1.0f, 0.5f, 0.25f },
+		{ -250.0f, 266.0f, 0.50f, 0.0f, 1.0f, 0.5f, 0.25f },
+	};
+	constexpr size_t NUM_EXPECTED_VERTICES = sizeof(EXPECTED) / sizeof(EXPECTED[0]);
 
-		const float w = ch.size.x() * drawDesc.scale;
-		const float h = ch.size.y() * drawDesc.scale;
+	std::vector<TextVertex> vertices(1, SENTINEL);	// layout appends to what's already queued
+	const size_t numQuads = LayoutText(drawDesc, windowSizeXY, glyphs, vertices);
+	if (numQuads != 2 || vertices.size() != NUM_EXPECTED_VERTICES)
+	{
+		Log::Error("TextRenderer test: expected 2 quads / %zu vertices, got %zu quads / %zu vertices", NUM_EXPECTED_VERTICES, numQuads, vertices.size());
+		return false;
+	}
 
-		float vertices[6][4] = 
+	constexpr float EPSILON = 1e-4f;
+	bool bPassed = true;
+	for (size_t i = 0; i < NUM_EXPECTED_VERTICES; ++i)
+	{
+		const TextVertex& v = vertices[i];
+		const TextVertex& e = EXPECTED[i];
+		const float values[]   = { v.x, v.y, v.u, v.v, v.r, v.g, v.b };
+		const float expected[] = { e.x, e.y, e.u, e.v, e.r, e.g, e.b };
+		for (size_t k = 0; k < sizeof(values) / sizeof(values[0]); ++k)
 		{
-			{ xpos,     ypos + h,   0.0, 0.0 },
-			{ xpos,     ypos,       0.0, 1.0 },
-			{ xpos + w, ypos,       1.0, 1.0 },
-
-			{ xpos,     ypos + h,   0.0, 0.0 },
-			{ xpos + w, ypos,       1.0, 1.0 },
-			{ xpos + w, ypos + h,   1.0, 0.0 }
-		};
-		pRenderer->UpdateBuffer(mQuadVertexBuffer, vertices);
-
-		pRenderer->SetTexture("textMap", ch.tex);
-		
-		pRenderer->SetVertexBuffer(mQuadVertexBuffer);
-		pRenderer->Apply();
-		pRenderer->Draw(6, EPrimitiveTopology::TRIANGLE_LIST);
-		x += (ch.advance >> 6) * drawDesc.scale; // Bitshift by 6 to get value in pixels (2^6 = 64 (divide amount of 1/64th pixels by 64 to get amount of pixels))
+			if (fabsf(values[k] - expected[k]) <= EPSILON)
+				continue;
+			Log::Error("TextRenderer test: vertex %zu is (%.2f, %.2f | %.3f, %.3f | %.2f, %.2f, %.2f), expected (%.2f, %.2f | %.3f, %.3f | %.2f, %.2f, %.2f)"
+				, i, v.x, v.y, v.u, v.v, v.r, v.g, v.b, e.x, e.y, e.u, e.v, e.r, e.g, e.b);
+			bPassed = false;
+			break;
+		}
 	}
-	pRenderer->SetBlendState(EDefaultBlendState::DISABLED);
-
-	pRenderer->EndEvent();
+	return bPassed;
 }
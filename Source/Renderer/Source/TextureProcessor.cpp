@@ -0,0 +1,258 @@
+//	VQEngine | DirectX11 Renderer
+//	Copyright(C) 2018  - Volkan Ilbeyli
+//
+//	This program is free software : you can redistribute it and / or modify
+//	it under the terms of the GNU General Public License as published by
+//	the Free Software Foundation, either version 3 of the License, or
+//	(at your option) any later version.
+//
+//	This program is distributed in the hope that it will be useful,
+//	but WITHOUT ANY WARRANTY; without even the implied warranty of
+//	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+//	GNU General Public License for more details.
+//
+//	You should have received a copy of the GNU General Public License
+//	along with this program.If not, see <http://www.gnu.org/licenses/>.
+//
+//	Contact: volkanilbeyli@gmail.com
+
+#include "TextureProcessor.h"
+
+#include "Utilities/Log.h"
+#include "Utilities/utils.h"
+
+#include "3rdParty/DirectXTex/DirectXTex/DirectXTex.h"
+
+#include <fstream>
+#include <sstream>
+#include <thread>
+#include <chrono>
+#include <cmath>
+#include <limits>
+
+using namespace DirectX;
+
+// bump whenever the processing steps change in a way that changes the output
+static constexpr uint32_t TEXTURE_PROCESSOR_VERSION = 1;
+
+using Clock = std::chrono::high_resolution_clock;
+static inline float GetElapsedMs(const Clock::time_point& start) { return std::chrono::duration<float, std::milli>(Clock::now() - start).count(); }
+
+static DXGI_FORMAT GetCompressedFormat(ETextureCompression compression, const ScratchImage& image)
+{
+	switch (compression)
+	{
+	case ETextureCompression::AUTO: return image.IsAlphaAllOpaque() ? DXGI_FORMAT_BC1_UNORM : DXGI_FORMAT_BC3_UNORM;
+	case ETextureCompression::BC1:  return DXGI_FORMAT_BC1_UNORM;
+	case ETextureCompression::BC3:  return DXGI_FORMAT_BC3_UNORM;
+	case ETextureCompression::BC5:  return DXGI_FORMAT_BC5_UNORM;
+	case ETextureCompression::BC7:  return DXGI_FORMAT_BC7_UNORM;
+	default:                        return DXGI_FORMAT_UNKNOWN;
+	}
+}
+
+static float MSEToPSNR(float mse)
+{
+	return mse > 0.0f ? 10.0f * log10f(1.0f / mse) : std::numeric_limits<float>::infinity();
+}
+
+static bool LoadImageFile(const std::string& filePath, ScratchImage& outImage)
+{
+	const std::wstring wpath(filePath.begin(), filePath.end());
+	const bool bIsDDS = DirectoryUtil::GetFileExtension(filePath) == "dds";
+	const HRESULT hr = bIsDDS
+		? LoadFromDDSFile(wpath.c_str(), DDS_FLAGS_NONE, nullptr, outImage)
+		: LoadFromWICFile(wpath.c_str(), WIC_FLAGS_NONE, nullptr, outImage);
+	return SUCCEEDED(hr);
+}
+
+// returns the top mip of @image in an uncompressed format ComputeMSE() can work with
+static bool GetComparableTopMip(const ScratchImage& image, ScratchImage& scratch, const Image*& pOutImage)
+{
+	pOutImage = image.GetImage(0, 0, 0);
+	if (!IsCompressed(pOutImage->format))
+		return true;
+	if (FAILED(Decompress(*pOutImage, DXGI_FORMAT_R8G8B8A8_UNORM, scratch)))
+		return false;
+	pOutImage = scratch.GetImage(0, 0, 0);
+	return true;
+}
+
+
+bool TextureProcessor::ReadFile(const std::string& filePath, std::vector<uint8_t>& outData)
+{
+	std::ifstream file(filePath, std::ios::binary | std::ios::ate);
+	if (!file.is_open())
+		return false;
+
+	const std::streamsize size = file.tellg();
+	file.seekg(0, std::ios::beg);
+	outData.resize(static_cast<size_t>(size));
+	return size == 0 || static_cast<bool>(file.read(reinterpret_cast<char*>(outData.data()), size));
+}
+
+uint64_t TextureProcessor::GetCacheKey(const void* pSourceData, size_t sourceSize, const TextureProcessSettings& settings)
+{
+	uint64_t hash = HashBytes(pSourceData, sourceSize);
+	hash = HashValue(TEXTURE_PROCESSOR_VERSION, hash);
+	hash = HashValue(settings.bGenerateMips, hash);
+	hash = HashValue(settings.mipFilter, hash);
+	hash = HashValue(settings.compression, hash);
+	return hash;
+}
+
+bool TextureProcessor::Process(const void* pSourceData, size_t sourceSize
+	, const std::string& outputDDSFilePath
+	, const TextureProcessSettings& settings
+	, TextureProcessStats* pOutStats /*= nullptr*/
+	, ScratchImage* pOutImage /*= nullptr*/
+)
+{
+	TextureProcessStats stats = {};
+	stats.sourceBytes = sourceSize;
+
+	// DECODE
+	//
+	Clock::time_point start = Clock::now();
+	ScratchImage decoded;
+	if (FAILED(LoadFromWICMemory(pSourceData, sourceSize, WIC_FLAGS_NONE, nullptr, decoded)))
+	{
+		Log::Error("TextureProcessor: Couldn't decode image for %s", outputDDSFilePath.c_str());
+		return false;
+	}
+	stats.decodeTimeMs = GetElapsedMs(start);
+	stats.width  = static_cast<int>(decoded.GetMetadata().width);
+	stats.height = static_cast<int>(decoded.GetMetadata().height);
+
+	// MIPS
+	//
+	start = Clock::now();
+	ScratchImage mipChain;
+	const ScratchImage* pImage = &decoded;
+	if (settings.bGenerateMips && (stats.width > 1 || stats.height > 1))
+	{
+		// FORCE_NON_WIC: DirectXTex' own filters work on XMVECTORs, 4 channels at a time,
+		// and don't go through the WIC scaler which isn't safe to use from multiple threads.
+		const auto filter = (settings.mipFilter == ETextureMipFilter::TRIANGLE ? TEX_FILTER_TRIANGLE : TEX_FILTER_BOX) | TEX_FILTER_FORCE_NON_WIC;
+		if (FAILED(GenerateMipMaps(*decoded.GetImage(0, 0, 0), filter, 0, mipChain)))
+		{
+			Log::Error("TextureProcessor: Couldn't generate mip chain for %s", outputDDSFilePath.c_str());
+			return false;
+		}
+		pImage = &mipChain;
+	}
+	stats.mipGenTimeMs = GetElapsedMs(start);
+
+	// BLOCK COMPRESSION
+	//
+	start = Clock::now();
+	ScratchImage compressed;
+	const DXGI_FORMAT compressedFormat = GetCompressedFormat(settings.compression, *pImage);
+	if (compressedFormat != DXGI_FORMAT_UNKNOWN)
+	{
+		// D3D11 requires the top mip of block compressed textures to be a multiple of the block size
+		if (stats.width % 4 != 0 || stats.height % 4 != 0)
+		{
+			Log::Warning("TextureProcessor: %dx%d isn't a multiple of 4, skipping block compression for %s", stats.width, stats.height, outputDDSFilePath.c_str());
+		}
+		else if (FAILED(Compress(pImage->GetImages(), pImage->GetImageCount(), pImage->GetMetadata(), compressedFormat, TEX_COMPRESS_DEFAULT, TEX_THRESHOLD_DEFAULT, compressed)))
+		{
+			Log::Warning("TextureProcessor: Block compression failed, storing uncompressed %s", outputDDSFilePath.c_str());
+		}
+		else
+		{
+			ScratchImage scratch;
+			const Image* pCompressedTop = nullptr;
+			float mse = 0.0f;
+			if (GetComparableTopMip(compressed, scratch, pCompressedTop) && SUCCEEDED(ComputeMSE(*pImage->GetImage(0, 0, 0), *pCompressedTop, mse, nullptr)))
+				stats.psnr = MSEToPSNR(mse);
+			pImage = &compressed;
+		}
+	}
+	stats.compressTimeMs = GetElapsedMs(start);
+
+	// WRITE
+	//
+	// write to a temporary file first: different source files with identical contents
+	// map to the same cache file and may be processed by multiple threads at once.
+	//
+	start = Clock::now();
+	std::stringstream ssTempPath;
+	ssTempPath << outputDDSFilePath << "." << std::this_thread::get_id() << ".tmp";
+	const std::string tempPath = ssTempPath.str();
+	const std::wstring wTempPath(tempPath.begin(), tempPath.end());
+	if (FAILED(SaveToDDSFile(pImage->GetImages(), pImage->GetImageCount(), pImage->GetMetadata(), DDS_FLAGS_NONE, wTempPath.c_str())))
+	{
+		Log::Error("TextureProcessor: Couldn't write %s", outputDDSFilePath.c_str());
+		return false;
+	}
+	if (!MoveFileEx(tempPath.c_str(), outputDDSFilePath.c_str(), MOVEFILE_REPLACE_EXISTING))
+	{
+		DeleteFile(tempPath.c_str());	// another thread got there first, its output is identical
+	}
+	stats.writeTimeMs = GetElapsedMs(start);
+
+	stats.mipCount = static_cast<int>(pImage->GetMetadata().mipLevels);
+	stats.outputBytes = pImage->GetPixelsSize();
+	if (pOutStats)
+		*pOutStats = stats;
+	if (pOutImage)
+		*pOutImage = std::move(pImage == &decoded ? decoded : pImage == &mipChain ? mipChain : compressed);
+	return true;
+}
+
+bool TextureProcessor::Process(const std::string& sourceFilePath
+	, const std::string& outputDDSFilePath
+	, const TextureProcessSettings& settings
+	, TextureProcessStats* pOutStats /*= nullptr*/
+)
+{
+	std::vector<uint8_t> sourceData;
+	if (!ReadFile(sourceFilePath, sourceData))
+	{
+		Log::Error("TextureProcessor: Couldn't read %s", sourceFilePath.c_str());
+		return false;
+	}
+	return Process(sourceData.data(), sourceData.size(), outputDDSFilePath, settings, pOutStats);
+}
+
+bool TextureProcessor::CompareImages(const std::string& filePath0, const std::string& filePath1, ImageDiff& outDiff)
+{
+	ScratchImage images[2], scratch[2];
+	const Image* pTopMips[2] = { nullptr, nullptr };
+	const std::string* pPaths[2] = { &filePath0, &filePath1 };
+	for (int i = 0; i < 2; ++i)
+	{
+		if (!LoadImageFile(*pPaths[i], images[i]) || !GetComparableTopMip(images[i], scratch[i], pTopMips[i]))
+		{
+			Log::Error("TextureProcessor: Couldn't load %s for comparison", pPaths[i]->c_str());
+			return false;
+		}
+	}
+
+	if (pTopMips[0]->width != pTopMips[1]->width || pTopMips[0]->height != pTopMips[1]->height)
+	{
+		Log::Error("TextureProcessor: Can't compare images of different sizes (%zux%zu vs %zux%zu)"
+			, pTopMips[0]->width, pTopMips[0]->height, pTopMips[1]->width, pTopMips[1]->height);
+		return false;
+	}
+
+	if (FAILED(ComputeMSE(*pTopMips[0], *pTopMips[1], outDiff.mse, nullptr)))
+		return false;
+	outDiff.psnr = MSEToPSNR(outDiff.mse);
+	return true;
+}
+
+const char* TextureProcessor::GetCompressionName(ETextureCompression compression)
+{
+	switch (compression)
+	{
+	case ETextureCompression::NONE: return "Uncompressed";
+	case ETextureCompression::AUTO: return "BC1/BC3";
+	case ETextureCompression::BC1:  return "BC1";
+	case ETextureCompression::BC3:  return "BC3";
+	case ETextureCompression::BC5:  return "BC5";
+	case ETextureCompression::BC7:  return "BC7";
+	default:                        return "Unknown";
+	}
+}
@@ -0,0 +1,195 @@
+//	VQEngine | DirectX11 Renderer
+//	Copyright(C) 2018  - Volkan Ilbeyli
+//
+//	This program is free software : you can redistribute it and / or modify
+//	it under the terms of the GNU General Public License as published by
+//	the Free Software Foundation, either version 3 of the License, or
+//	(at your option) any later version.
+//
+//	This program is distributed in the hope that it will be useful,
+//	but WITHOUT ANY WARRANTY; without even the implied warranty of
+//	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+//	GNU General Public License for more details.
+//
+//	You should have received a copy of the GNU General Public License
+//	along with this program.If not, see <http://www.gnu.org/licenses/>.
+//
+//	Contact: volkanilbeyli@gmail.com
+
+#include "VertexQuantization.h"
+
+#include "Utilities/Log.h"
+
+#include <DirectXPackedVector.h>
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+static constexpr float  SNORM16_MAX = 32767.0f;
+static constexpr double RAD_TO_DEG  = 57.295779513082320876798;
+
+// bounds RunRoundTripTests() checks the encoding against
+static constexpr float MAX_DIRECTION_ERROR_DEGREES = 0.01f;
+
+static inline int16_t ToSnorm16(float v)   { return static_cast<int16_t>(lroundf(std::max(-1.0f, std::min(1.0f, v)) * SNORM16_MAX)); }
+static inline float   FromSnorm16(int16_t v) { return std::max(static_cast<float>(v) / SNORM16_MAX, -1.0f); }	// -32768 is -1 as well, same as the IA
+static inline float   SignNotZero(float v)   { return v >= 0.0f ? 1.0f : -1.0f; }
+
+static inline bool IsZeroLength(const vec3& v) { return v.x() == 0.0f && v.y() == 0.0f && v.z() == 0.0f; }
+
+// angle between two directions in degrees. atan2 instead of acos: acos of the dot product
+// loses the small angles we're measuring to the rounding of the dot product near 1.
+static double GetAngleDegrees(const vec3& v0, const vec3& v1)
+{
+	const double x0 = v0.x(), y0 = v0.y(), z0 = v0.z();
+	const double x1 = v1.x(), y1 = v1.y(), z1 = v1.z();
+	const double cx = y0 * z1 - z0 * y1;
+	const double cy = z0 * x1 - x0 * z1;
+	const double cz = x0 * y1 - y0 * x1;
+	return atan2(sqrt(cx * cx + cy * cy + cz * cz), x0 * x1 + y0 * y1 + z0 * z1) * RAD_TO_DEG;
+}
+
+
+void VertexQuantization::EncodeOctahedral(const vec3& direction, int16_t outEncoded[2])
+{
+	const float l1Norm = fabsf(direction.x()) + fabsf(direction.y()) + fabsf(direction.z());
+	if (l1Norm == 0.0f)
+	{
+		outEncoded[0] = outEncoded[1] = 0;
+		return;
+	}
+
+	// project onto the octahedron |x| + |y| + |z| = 1, fold the lower half over the upper one
+	float x = direction.x() / l1Norm;
+	float y = direction.y() / l1Norm;
+	if (direction.z() < 0.0f)
+	{
+		const float folded_x = (1.0f - fabsf(y)) * SignNotZero(x);
+		const float folded_y = (1.0f - fabsf(x)) * SignNotZero(y);
+		x = folded_x;
+		y = folded_y;
+	}
+	outEncoded[0] = ToSnorm16(x);
+	outEncoded[1] = ToSnorm16(y);
+}
+
+vec3 VertexQuantization::DecodeOctahedral(const int16_t encoded[2])
+{
+	// same as DecodeOctahedral() in VertexCompression.hlsl
+	float x = FromSnorm16(encoded[0]);
+	float y = FromSnorm16(encoded[1]);
+	const float z = 1.0f - fabsf(x) - fabsf(y);
+	const float t = std::max(-z, 0.0f);
+	x += x >= 0.0f ? -t : t;
+	y += y >= 0.0f ? -t : t;
+
+	const float invLength = 1.0f / sqrtf(x * x + y * y + z * z);
+	return vec3(x * invLength, y * invLength, z * invLength);
+}
+
+uint16_t VertexQuantization::EncodeHalf(float value) { return DirectX::PackedVector::XMConvertFloatToHalf(value); }
+float    VertexQuantization::DecodeHalf(uint16_t value) { return DirectX::PackedVector::XMConvertHalfToFloat(value); }
+
+CompactVertexBufferData VertexQuantization::Encode(const DefaultVertexBufferData& vertex)
+{
+	CompactVertexBufferData v;
+	v.position = vertex.position;
+	EncodeOctahedral(vertex.normal, v.normal);
+	EncodeOctahedral(vertex.tangent, v.tangent);
+	v.uv[0] = EncodeHalf(vertex.uv.x());
+	v.uv[1] = EncodeHalf(vertex.uv.y());
+	return v;
+}
+
+DefaultVertexBufferData VertexQuantization::Decode(const CompactVertexBufferData& vertex)
+{
+	DefaultVertexBufferData v;
+	v.position = vertex.position;
+	v.normal   = DecodeOctahedral(vertex.normal);
+	v.tangent  = DecodeOctahedral(vertex.tangent);
+	v.uv       = vec2(DecodeHalf(vertex.uv[0]), DecodeHalf(vertex.uv[1]));
+	return v;
+}
+
+void VertexQuantization::Encode(const DefaultVertexBufferData* pVertices, size_t numVertices, CompactVertexBufferData* pOutVertices)
+{
+	for (size_t i = 0; i < numVertices; ++i)
+		pOutVertices[i] = Encode(pVertices[i]);
+}
+
+VertexQuantizationError VertexQuantization::GetRoundTripError(const DefaultVertexBufferData* pVertices, size_t numVertices)
+{
+	double maxNormalError = 0.0;
+	double maxTangentError = 0.0;
+	float  maxUVError = 0.0f;
+	for (size_t i = 0; i < numVertices; ++i)
+	{
+		const DefaultVertexBufferData& v = pVertices[i];
+		const DefaultVertexBufferData decoded = Decode(Encode(v));
+		if (!IsZeroLength(v.normal))  maxNormalError  = std::max(maxNormalError , GetAngleDegrees(v.normal , decoded.normal));
+		if (!IsZeroLength(v.tangent)) maxTangentError = std::max(maxTangentError, GetAngleDegrees(v.tangent, decoded.tangent));
+		maxUVError = std::max(maxUVError, std::max(fabsf(v.uv.x() - decoded.uv.x()), fabsf(v.uv.y() - decoded.uv.y())));
+	}
+	return { static_cast<float>(maxNormalError), static_cast<float>(maxTangentError), maxUVError };
+}
+
+bool VertexQuantization::RunRoundTripTests()
+{
+	std::vector<vec3> directions;
+
+	// axes, the edges where the lower half folds over and the directions right below the equator
+	const float s = 1.0f / sqrtf(2.0f);
+	const float e = 1e-6f;
+	for (float sx : { -1.0f, 1.0f }) for (float sy : { -1.0f, 1.0f })
+	{
+		directions.push_back(vec3(sx, 0.0f, 0.0f));
+		directions.push_back(vec3(0.0f, sy, 0.0f));
+		directions.push_back(vec3(0.0f, 0.0f, sx));
+		directions.push_back(vec3(sx * s, sy * s, 0.0f));
+		directions.push_back(vec3(sx * s, sy * s, -e));
+		directions.push_back(vec3(sx * s, 0.0f, -s));
+		directions.push_back(vec3(0.0f, sy * s, -s));
+	}
+
+	// fibonacci sphere
+	constexpr int NUM_SPHERE_DIRECTIONS = 100000;
+	const float goldenAngle = 3.14159265f * (3.0f - sqrtf(5.0f));
+	for (int i = 0; i < NUM_SPHERE_DIRECTIONS; ++i)
+	{
+		const float z = 1.0f - 2.0f * (i + 0.5f) / NUM_SPHERE_DIRECTIONS;
+		const float r = sqrtf(1.0f - z * z);
+		directions.push_back(vec3(r * cosf(goldenAngle * i), r * sinf(goldenAngle * i), z));
+	}
+
+	double maxDirectionError = 0.0;
+	for (const vec3& d : directions)
+	{
+		int16_t encoded[2];
+		EncodeOctahedral(d, encoded);
+		maxDirectionError = std::max(maxDirectionError, GetAngleDegrees(d, DecodeOctahedral(encoded)));
+	}
+
+	int16_t zero[2];
+	EncodeOctahedral(vec3(0.0f, 0.0f, 0.0f), zero);
+	const vec3 decodedZero = DecodeOctahedral(zero);
+	const bool bZeroOk = decodedZero.x() == 0.0f && decodedZero.y() == 0.0f && decodedZero.z() == 1.0f;
+
+	// UVs over [-2, 2], finer steps than half floats can represent
+	constexpr int NUM_UV_STEPS = 1 << 16;
+	float maxUVError = 0.0f;
+	for (int i = 0; i <= NUM_UV_STEPS; ++i)
+	{
+		const float uv = -2.0f + 4.0f * i / NUM_UV_STEPS;
+		maxUVError = std::max(maxUVError, fabsf(uv - DecodeHalf(EncodeHalf(uv))));
+	}
+
+	const bool bDirectionsOk = maxDirectionError <= MAX_DIRECTION_ERROR_DEGREES;
+	const bool bUVsOk = maxUVError <= MAX_UV_ERROR;
+	Log::Info("VertexQuantization: %zu directions: max error %.5f deg (%s) | zero length: %s | %d UVs in [-2, 2]: max error %.7f (%s)"
+		, directions.size(), maxDirectionError, bDirectionsOk ? "ok" : "FAILED"
+		, bZeroOk ? "ok" : "FAILED"
+		, NUM_UV_STEPS + 1, maxUVError, bUVsOk ? "ok" : "FAILED"
+	);
+	return bDirectionsOk && bZeroOk && bUVsOk;
+}
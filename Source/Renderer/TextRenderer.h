@@ -18,6 +18,8 @@
 #pragma once
 
 #include <string>
+#include <array>
+#include <vector>
 #include <Utilities/Color.h>
 #include "BufferObject.h"
 
@@ -31,19 +33,58 @@ struct TextDrawDescription
 	float scale;
 };
 
+// Placement of a character in the glyph atlas. Metrics are in pixels of the rasterized font.
+//
+struct Glyph
+{
+	vec2 size;		// Size of glyph
+	vec2 bearing;	// Offset from baseline to left/top of glyph
+	int advance;	// Offset to advance to next glyph (1/64th pixels)
+	vec2 uvMin;		// top-left of the glyph in the atlas
+	vec2 uvMax;		// bottom-right of the glyph in the atlas
+};
+using GlyphTable = std::array<Glyph, 128>;
+
+struct TextVertex
+{
+	float x, y;		// pixels, (0,0) is the center of the screen, +y is up
+	float u, v;		// atlas uv
+	float r, g, b;
+};
+
 class TextRenderer
 {
 public:
 	bool Initialize(Renderer* pRenderer);
 	void Exit();
 
+	// Lays out the text into the vertex batch of the frame, nothing is drawn until Flush().
+	//
 	void RenderText(const TextDrawDescription& drawDesc);
 
+	// Draws all the text queued since the last Flush(), one draw call per MAX_BATCH_CHARACTERS.
+	// Text is drawn on top of everything rendered before the Flush() call.
+	//
+	void Flush();
+
+	// CPU-only layout: appends 6 vertices for each visible character of @drawDesc.text
+	// (whitespace only advances the pen) and returns the number of quads appended.
+	//
+	static size_t LayoutText(const TextDrawDescription& drawDesc, const vec2& windowSizeXY, const GlyphTable& glyphs, std::vector<TextVertex>& outVertices);
+
+	// Lays out a fixed string with hand-made glyph metrics and compares the quads against their
+	// expected positions and UVs. No font or device needed. Logs the mismatches and returns false if any.
+	//
+	static bool RunLayoutTests();
+
+	static constexpr size_t MAX_BATCH_CHARACTERS = 4096;
+
 private:
-	std::vector<vec4> mQuadVertexData;
-	BufferID mQuadVertexBuffer;	// vertex buffer for rendering quad
+	std::vector<TextVertex> mVertices;	// text queued for the current frame
+	BufferID mVertexBuffer;				// dynamic vertex buffer, MAX_BATCH_CHARACTERS quads
+	TextureID mGlyphAtlas;				// R8 texture with all the glyphs
 	BlendStateID mAlphaBlendState;
 private:
 	static Renderer* pRenderer;
 	static int		 shaderText;
-};
\ No newline at end of file
+};
@@ -29,6 +29,7 @@ class Renderer;
 struct ID3D11ShaderResourceView;
 struct ID3D11SamplerState;
 struct D3D11_TEXTURE2D_DESC;
+struct D3D11_SUBRESOURCE_DATA;
 struct ID3D11Texture3D;
 struct ID3D11Texture2D;
 
@@ -47,6 +48,7 @@ struct TextureDesc
 	bool bIsCubeMap;
 	bool bGenerateMips;
 	ECPUAccess cpuAccessMode;
+	const D3D11_SUBRESOURCE_DATA* pSubresourceData;	// initial data of every mip and array slice, overrides pData
 
 	TextureDesc() :
 		width(1),
@@ -60,7 +62,8 @@ struct TextureDesc
 		arraySize(1),
 		bIsCubeMap(false),
 		bGenerateMips(false),
-		cpuAccessMode(ECPUAccess::NONE)
+		cpuAccessMode(ECPUAccess::NONE),
+		pSubresourceData(nullptr)
 	{}
 
 	D3D11_TEXTURE2D_DESC dxDesc;
@@ -0,0 +1,112 @@
+//	VQEngine | DirectX11 Renderer
+//	Copyright(C) 2018  - Volkan Ilbeyli
+//
+//	This program is free software : you can redistribute it and / or modify
+//	it under the terms of the GNU General Public License as published by
+//	the Free Software Foundation, either version 3 of the License, or
+//	(at your option) any later version.
+//
+//	This program is distributed in the hope that it will be useful,
+//	but WITHOUT ANY WARRANTY; without even the implied warranty of
+//	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+//	GNU General Public License for more details.
+//
+//	You should have received a copy of the GNU General Public License
+//	along with this program.If not, see <http://www.gnu.org/licenses/>.
+//
+//	Contact: volkanilbeyli@gmail.com
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+namespace DirectX { class ScratchImage; }
+
+enum class ETextureMipFilter
+{
+	BOX = 0,	// 2x2 average
+	TRIANGLE,	// wider support, keeps more detail in the lower mips of minified high frequency textures
+};
+
+enum class ETextureCompression
+{
+	NONE = 0,
+	AUTO,		// BC1 if the image is fully opaque, BC3 otherwise
+	BC1,
+	BC3,
+	BC5,		// two channels, i.e. tangent space normal maps
+	BC7,		// slow to encode on the CPU
+};
+
+struct TextureProcessSettings
+{
+	bool                bGenerateMips = true;
+	ETextureMipFilter   mipFilter     = ETextureMipFilter::BOX;
+	ETextureCompression compression   = ETextureCompression::NONE;
+};
+
+struct TextureProcessStats
+{
+	int    width;
+	int    height;
+	int    mipCount;
+	size_t sourceBytes;		// encoded image file
+	size_t outputBytes;		// every mip level, after compression
+	float  decodeTimeMs;
+	float  mipGenTimeMs;
+	float  compressTimeMs;
+	float  writeTimeMs;
+	float  psnr;			// top mip after compression vs. before, in dB. 0 if not compressed, infinity if lossless.
+
+	inline float GetTotalTimeMs() const { return decodeTimeMs + mipGenTimeMs + compressTimeMs + writeTimeMs; }
+	inline float GetMegaPixelsPerSecond() const { const float t = GetTotalTimeMs(); return t > 0.0f ? (width * height * 1e-6f) / (t * 1e-3f) : 0.0f; }
+};
+
+struct ImageDiff
+{
+	float mse;		// mean squared error over RGBA, in [0, 1] range color values
+	float psnr;		// dB
+};
+
+//----------------------------------------------------------------------------------------------------------------
+// TEXTURE PROCESSOR
+//----------------------------------------------------------------------------------------------------------------
+// Decodes an image file (PNG/JPG/... through WIC), builds its mip chain, optionally block compresses
+// it and writes the result as a DDS file. Renderer uses it to turn the textures of the scenes into a
+// DDS cache on the first load, the later loads read the DDS files without decoding or filtering.
+//
+// Doesn't need a D3D device: can be run from tools or worker threads. The thread calling it needs
+// to have COM initialized for the WIC decoder.
+//
+class TextureProcessor
+{
+public:
+	static bool ReadFile(const std::string& filePath, std::vector<uint8_t>& outData);
+
+	// Key of the processed texture: hash of the source file contents and the processing settings
+	//
+	static uint64_t GetCacheKey(const void* pSourceData, size_t sourceSize, const TextureProcessSettings& settings);
+
+	// Processes the image file in memory and writes it to @outputDDSFilePath. If @pOutImage is given,
+	// the processed image is returned in it as well so the caller doesn't have to read the file back.
+	//
+	static bool Process(const void* pSourceData, size_t sourceSize
+		, const std::string& outputDDSFilePath
+		, const TextureProcessSettings& settings
+		, TextureProcessStats* pOutStats = nullptr
+		, DirectX::ScratchImage* pOutImage = nullptr
+	);
+	static bool Process(const std::string& sourceFilePath
+		, const std::string& outputDDSFilePath
+		, const TextureProcessSettings& settings
+		, TextureProcessStats* pOutStats = nullptr
+	);
+
+	// Compares the top mips of two image files (DDS or WIC formats, compressed or not),
+	// i.e. for checking a processed texture against its source.
+	//
+	static bool CompareImages(const std::string& filePath0, const std::string& filePath1, ImageDiff& outDiff);
+
+	static const char* GetCompressionName(ETextureCompression compression);
+};
@@ -0,0 +1,69 @@
+//	VQEngine | DirectX11 Renderer
+//	Copyright(C) 2018  - Volkan Ilbeyli
+//
+//	This program is free software : you can redistribute it and / or modify
+//	it under the terms of the GNU General Public License as published by
+//	the Free Software Foundation, either version 3 of the License, or
+//	(at your option) any later version.
+//
+//	This program is distributed in the hope that it will be useful,
+//	but WITHOUT ANY WARRANTY; without even the implied warranty of
+//	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+//	GNU General Public License for more details.
+//
+//	You should have received a copy of the GNU General Public License
+//	along with this program.If not, see <http://www.gnu.org/licenses/>.
+//
+//	Contact: volkanilbeyli@gmail.com
+#pragma once
+
+#include "RenderingStructs.h"
+
+#include <cstdint>
+
+// Largest differences between a set of vertices and their encode/decode round trip
+//
+struct VertexQuantizationError
+{
+	float maxNormalErrorDegrees;
+	float maxTangentErrorDegrees;
+	float maxUVError;				// in texture coordinates
+};
+
+//----------------------------------------------------------------------------------------------------------------
+// VERTEX QUANTIZATION
+//----------------------------------------------------------------------------------------------------------------
+// Encodes DefaultVertexBufferData into CompactVertexBufferData and back. The decode routines
+// match what the input assembler and the COMPACT_VERTEX vertex shaders do with the data.
+//
+// Octahedral encoding maps the unit sphere onto a square by projecting it onto an octahedron
+// and folding the lower half over the upper one, 16 bits per component keep the error well under
+// a hundredth of a degree. Half floats have 10 bits of mantissa: UVs keep a precision of 1/2048
+// up to |uv| < 2, tiling UVs further out lose precision and are checked per mesh.
+//
+class VertexQuantization
+{
+public:
+	// UV error a mesh can have in the compact layout: half a texel of a 1024x1024 texture
+	static constexpr float MAX_UV_ERROR = 1.0f / 2048.0f;
+
+	static void  EncodeOctahedral(const vec3& direction, int16_t outEncoded[2]);
+	static vec3  DecodeOctahedral(const int16_t encoded[2]);	// normalized, (0,0,1) for zero length input
+	static uint16_t EncodeHalf(float value);
+	static float    DecodeHalf(uint16_t value);
+
+	static CompactVertexBufferData Encode(const DefaultVertexBufferData& vertex);
+	static DefaultVertexBufferData Decode(const CompactVertexBufferData& vertex);
+	static void Encode(const DefaultVertexBufferData* pVertices, size_t numVertices, CompactVertexBufferData* pOutVertices);
+
+	// Encodes and decodes @pVertices and measures the error. Zero length normals/tangents
+	// (meshes without them) aren't counted.
+	//
+	static VertexQuantizationError GetRoundTripError(const DefaultVertexBufferData* pVertices, size_t numVertices);
+
+	// CPU round trip check of the encode/decode routines over directions covering the sphere,
+	// the octahedron folds and axes, and UVs in the range the compact layout accepts.
+	// Logs the errors and returns false if any of them is out of bounds.
+	//
+	static bool RunRoundTripTests();
+};
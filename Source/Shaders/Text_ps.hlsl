@@ -20,11 +20,7 @@ struct PSIn
 {
 	float4 position : SV_POSITION;
 	float2 texCoord : TEXCOORD0;
-};
-
-cbuffer perObject
-{
-	float3 color;
+	float3 color : COLOR;
 };
 
 Texture2D textMap;
@@ -35,5 +31,5 @@ float4 PSMain(PSIn In) : SV_TARGET
 {
 	const float2 uv = In.texCoord;
 	float alpha = textMap.Sample(samText, uv).r;
-    return float4(color, alpha);
+    return float4(In.color, alpha);
 }
\ No newline at end of file
@@ -24,12 +24,14 @@ cbuffer perModel
 struct VSIn
 {
 	float4 positionAndUVs : POSITION;
+	float3 color : COLOR;
 };
 
 struct PSIn
 {
 	float4 position : SV_POSITION;
 	float2 texCoord : TEXCOORD0;
+	float3 color : COLOR;
 };
 
 PSIn VSMain(VSIn In)
@@ -38,5 +40,6 @@ PSIn VSMain(VSIn In)
 	Out.position = mul(projection, float4(In.positionAndUVs.xy, 0, 1));
 	Out.position.z = 0.001f;
 	Out.texCoord = In.positionAndUVs.zw;
+	Out.color = In.color;
 	return Out;
 }
\ No newline at end of file
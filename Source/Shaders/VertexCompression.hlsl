@@ -0,0 +1,34 @@
+//	VQEngine | DirectX11 Renderer
+//	Copyright(C) 2018  - Volkan Ilbeyli
+//
+//	This program is free software : you can redistribute it and / or modify
+//	it under the terms of the GNU General Public License as published by
+//	the Free Software Foundation, either version 3 of the License, or
+//	(at your option) any later version.
+//
+//	This program is distributed in the hope that it will be useful,
+//	but WITHOUT ANY WARRANTY; without even the implied warranty of
+//	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+//	GNU General Public License for more details.
+//
+//	You should have received a copy of the GNU General Public License
+//	along with this program.If not, see <http://www.gnu.org/licenses/>.
+//
+//	Contact: volkanilbeyli@gmail.com
+
+// Decoding of the compact vertex layout (CompactVertexBufferData, see VertexQuantization.h):
+// the input assembler converts the R16G16_SNORM normals/tangents and the R16G16_FLOAT UVs
+// to float2, the octahedral encoded directions are unfolded here.
+//
+// The semantic names of the packed attributes select their formats in the input layout
+// (see Shader.cpp): OCT_NORMAL, OCT_TANGENT -> R16G16_SNORM, HALF_TEXCOORD -> R16G16_FLOAT.
+//
+
+// same as VertexQuantization::DecodeOctahedral()
+float3 DecodeOctahedral(float2 encoded)
+{
+	float3 n = float3(encoded.xy, 1.0f - abs(encoded.x) - abs(encoded.y));
+	const float t = saturate(-n.z);
+	n.xy += n.xy >= 0.0f ? -t : t;
+	return normalize(n);
+}
@@ -17,12 +17,22 @@
 //	Contact: volkanilbeyli@gmail.com
 
 
+#ifdef COMPACT_VERTEX
+#include "VertexCompression.hlsl"
+#endif
+
 struct VSIn
 {
 	float3 position : POSITION;
+#ifdef COMPACT_VERTEX
+	float2 normal	: OCT_NORMAL;
+	float2 tangent	: OCT_TANGENT;
+	float2 uv		: HALF_TEXCOORD;
+#else
 	float3 normal	: NORMAL;
 	float3 tangent	: TANGENT0;
 	float2 uv		: TEXCOORD0;
+#endif
 #ifdef INSTANCED
 	uint instanceID : SV_InstanceID;
 #endif
@@ -59,19 +69,26 @@ cbuffer perModel
 PSIn VSMain(VSIn In)
 {
 	const float4 pos = float4(In.position, 1);
+#ifdef COMPACT_VERTEX
+	const float3 normal  = DecodeOctahedral(In.normal);
+	const float3 tangent = DecodeOctahedral(In.tangent);
+#else
+	const float3 normal  = In.normal;
+	const float3 tangent = In.tangent;
+#endif
 
 	PSIn Out;
 #ifdef INSTANCED
 	Out.position	 = mul(ObjMatrices[In.instanceID].worldViewProj, pos);
 	Out.viewPosition = mul(ObjMatrices[In.instanceID].worldView, pos).xyz;
-	Out.viewNormal	 = normalize(mul(ObjMatrices[In.instanceID].normalViewMatrix, In.normal));
-	Out.viewTangent	 = normalize(mul(ObjMatrices[In.instanceID].normalViewMatrix, In.tangent));
+	Out.viewNormal	 = normalize(mul(ObjMatrices[In.instanceID].normalViewMatrix, normal));
+	Out.viewTangent	 = normalize(mul(ObjMatrices[In.instanceID].normalViewMatrix, tangent));
 	Out.instanceID	 = In.instanceID;
 #else
 	Out.position	 = mul(ObjMatrices.worldViewProj, pos);
 	Out.viewPosition = mul(ObjMatrices.worldView, pos).xyz;
-	Out.viewNormal	 = normalize(mul(ObjMatrices.normalViewMatrix, In.normal));
-	Out.viewTangent	 = normalize(mul(ObjMatrices.normalViewMatrix, In.tangent));
+	Out.viewNormal	 = normalize(mul(ObjMatrices.normalViewMatrix, normal));
+	Out.viewTangent	 = normalize(mul(ObjMatrices.normalViewMatrix, tangent));
 #endif
 	Out.uv				= In.uv;
 	return Out;
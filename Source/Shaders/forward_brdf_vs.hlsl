@@ -40,12 +40,22 @@ cbuffer frame
 };
 
 
+#ifdef COMPACT_VERTEX
+#include "VertexCompression.hlsl"
+#endif
+
 struct VSIn
 {
 	float3 position : POSITION;
+#ifdef COMPACT_VERTEX
+	float2 normal	: OCT_NORMAL;
+	float2 tangent	: OCT_TANGENT;
+	float2 texCoord : HALF_TEXCOORD;
+#else
 	float3 normal	: NORMAL;
 	float3 tangent	: TANGENT0;
 	float2 texCoord : TEXCOORD0;    
+#endif
 #ifdef INSTANCED
 	uint instanceID : SV_InstanceID;
 #endif
@@ -70,7 +80,13 @@ struct PSIn
 PSIn VSMain(VSIn In)
 {
 	const float4 pos = float4(In.position, 1);
-
+#ifdef COMPACT_VERTEX
+	const float3 normal  = DecodeOctahedral(In.normal);
+	const float3 tangent = DecodeOctahedral(In.tangent);
+#else
+	const float3 normal  = In.normal;
+	const float3 tangent = In.tangent;
+#endif
 
 	PSIn Out;
 #if 0	// experimenting with panini projection, using unreal's implementation
@@ -91,14 +107,14 @@ PSIn VSMain(VSIn In)
 #ifdef INSTANCED
 	Out.position = mul(ObjMatrices[In.instanceID].worldViewProj, pos);
 	Out.worldPos = mul(ObjMatrices[In.instanceID].world , pos).xyz;
-    Out.normal	 = normalize(mul(ObjMatrices[In.instanceID].normal, In.normal));
-    Out.tangent	 = normalize(mul(ObjMatrices[In.instanceID].normal, In.tangent));
+    Out.normal	 = normalize(mul(ObjMatrices[In.instanceID].normal, normal));
+    Out.tangent	 = normalize(mul(ObjMatrices[In.instanceID].normal, tangent));
 	Out.instanceID = In.instanceID;
 #else
 	Out.position = mul(ObjMatrices.worldViewProj, pos);
 	Out.worldPos = mul(ObjMatrices.world , pos).xyz;
-    Out.normal	 = normalize(mul(ObjMatrices.normal, In.normal));
-    Out.tangent	 = normalize(mul(ObjMatrices.normal, In.tangent));
+    Out.normal	 = normalize(mul(ObjMatrices.normal, normal));
+    Out.tangent	 = normalize(mul(ObjMatrices.normal, tangent));
 #endif
 	Out.texCoord = In.texCoord;
 	Out.lightSpacePos = mul(lightSpaceMat, float4(Out.worldPos, 1));
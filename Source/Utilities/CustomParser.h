@@ -20,6 +20,7 @@
 
 #include <vector>
 #include <string>
+#include <string_view>
 
 #include "Engine/Scene.h"
 
@@ -33,9 +34,13 @@ public:
 	~Parser();
 
 	static Settings::Engine ReadSettings(const std::string& settingsFileName);
-	static void ParseSetting(const std::vector<std::string>& line, Settings::Engine& settings);
+	static void ParseSetting(const std::vector<std::string_view>& line, Settings::Engine& settings);
 
-	static SerializedScene ReadScene(Renderer* pRenderer, const std::string& sceneFileName);
+	// @pRenderer can be null to parse the scene without creating its textures (benchmarks, tools)
+	//
+	static SerializedScene ReadScene(Renderer* pRenderer, const std::string& sceneFileName);	// @sceneFileName: relative to Data/SceneFiles
+	static SerializedScene ReadSceneFile(Renderer* pRenderer, const std::string& filePath);
+	static std::string     GetSceneFilePath(const std::string& sceneFileName);
 
 	// Object initializations
 	// ---------------------------------------------------------------------------------------------------------------
@@ -45,7 +50,18 @@ public:
 	// BRDF			:
 	// Phong		:
 	// Object		: transform, brdf/phong, mesh
-	static void ParseScene(Renderer* pRenderer, const std::vector<std::string>& command, SerializedScene& scene);
+	static void ParseScene(Renderer* pRenderer, const std::vector<std::string_view>& command, SerializedScene& scene);
+
+	// Writes a scene of @numObjects randomly placed objects, with the command mix of the bundled scenes
+	//
+	static bool WriteSyntheticScene(const std::string& filePath, int numObjects);
+
+	// Times the tokenization of @sceneFilePaths the way the parser used to read them (getline(), StrUtil::split()
+	// and strtof() on std::strings) against the Tokenizer, checks both give the same tokens and numbers,
+	// and times ReadSceneFile() for the whole parse against reading the scene compiled into a CompiledScene.
+	// Results are logged.
+	//
+	static void BenchmarkSceneParsing(const std::vector<std::string>& sceneFilePaths);
 private:
 
 };
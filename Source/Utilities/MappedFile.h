@@ -0,0 +1,54 @@
+//	VQEngine | DirectX11 Renderer
+//	Copyright(C) 2018  - Volkan Ilbeyli
+//
+//	This program is free software : you can redistribute it and / or modify
+//	it under the terms of the GNU General Public License as published by
+//	the Free Software Foundation, either version 3 of the License, or
+//	(at your option) any later version.
+//
+//	This program is distributed in the hope that it will be useful,
+//	but WITHOUT ANY WARRANTY; without even the implied warranty of
+//	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+//	GNU General Public License for more details.
+//
+//	You should have received a copy of the GNU General Public License
+//	along with this program.If not, see <http://www.gnu.org/licenses/>.
+//
+//	Contact: volkanilbeyli@gmail.com
+#pragma once
+
+#include <string>
+
+//----------------------------------------------------------------------------------------------------------------
+// MAPPED FILE
+//----------------------------------------------------------------------------------------------------------------
+// A file mapped into memory read-only. Shared by the readers that parse or upload file contents in place
+// (Tokenizer, ModelCache, RawTextureFile) instead of copying them into a buffer first.
+//
+// Empty files can't be mapped: they open successfully with GetData() == nullptr and GetSize() == 0.
+//
+class MappedFile
+{
+public:
+	MappedFile() = default;
+	~MappedFile();
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	// Returns false if @filePath doesn't exist or can't be opened for reading, w/o logging,
+	// so the callers can treat a missing file as a cache miss. Mapping failures are logged.
+	//
+	bool Open(const std::string& filePath);
+	void Close();
+
+	// Valid until Close()
+	//
+	inline const void* GetData() const { return mpData; }
+	inline size_t      GetSize() const { return mSize; }
+
+private:
+	void*       mhFile = nullptr;
+	void*       mhMapping = nullptr;
+	const void* mpData = nullptr;
+	size_t      mSize = 0;
+};
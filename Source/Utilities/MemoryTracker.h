@@ -0,0 +1,83 @@
+//	VQEngine | DirectX11 Renderer
+//	Copyright(C) 2018  - Volkan Ilbeyli
+//
+//	This program is free software : you can redistribute it and / or modify
+//	it under the terms of the GNU General Public License as published by
+//	the Free Software Foundation, either version 3 of the License, or
+//	(at your option) any later version.
+//
+//	This program is distributed in the hope that it will be useful,
+//	but WITHOUT ANY WARRANTY; without even the implied warranty of
+//	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+//	GNU General Public License for more details.
+//
+//	You should have received a copy of the GNU General Public License
+//	along with this program.If not, see <http://www.gnu.org/licenses/>.
+//
+//	Contact: volkanilbeyli@gmail.com
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Subsystems the heap allocations are attributed to, see MemoryTracker::TagScope
+enum class EMemoryTag : uint8_t
+{
+	UNTAGGED = 0,
+	SCENE,
+	RENDERER,
+	LOADER,
+	PROFILER,
+
+	COUNT
+};
+
+//----------------------------------------------------------------------------------------------------------------
+// MEMORY TRACKER
+//----------------------------------------------------------------------------------------------------------------
+// MemoryTracker.cpp replaces the global operator new/delete. Every block carries a 16 byte header with its size
+// and tag, so the frees are attributed to the tag the block was allocated with. Counting is opt-in: while the
+// tracker is disabled the hook only writes the header, the blocks allocated in that time are never counted.
+//
+// The allocation counters are kept per thread (lock free, read by any thread), the current and peak bytes are
+// kept per tag. Thread pool tasks inherit the tag of the thread that submits them.
+//
+class MemoryTracker
+{
+public:
+	struct Counters
+	{
+		uint64_t numAllocations;
+		uint64_t numFrees;
+		uint64_t numAllocatedBytes;
+	};
+
+	struct TagStats
+	{
+		int64_t  currentBytes;
+		int64_t  peakBytes;
+		uint64_t numAllocations;
+	};
+
+	// Tags the allocations the calling thread makes in the scope, restores the previous tag on destruction.
+	class TagScope
+	{
+	public:
+		TagScope(EMemoryTag tag);
+		~TagScope();
+	private:
+		EMemoryTag mPrevTag;
+	};
+
+	static void SetEnabled(bool bEnable);
+	static bool IsEnabled();
+
+	static EMemoryTag GetThreadTag();
+	static const char* GetTagName(EMemoryTag tag);
+
+	static Counters GetCounters();			// all threads
+	static Counters GetThreadCounters();	// calling thread
+	static TagStats GetTagStats(EMemoryTag tag);
+
+	static void LogStats();
+};
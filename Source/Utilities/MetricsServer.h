@@ -0,0 +1,100 @@
+//	VQEngine | DirectX11 Renderer
+//	Copyright(C) 2018  - Volkan Ilbeyli
+//
+//	This program is free software : you can redistribute it and / or modify
+//	it under the terms of the GNU General Public License as published by
+//	the Free Software Foundation, either version 3 of the License, or
+//	(at your option) any later version.
+//
+//	This program is distributed in the hope that it will be useful,
+//	but WITHOUT ANY WARRANTY; without even the implied warranty of
+//	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+//	GNU General Public License for more details.
+//
+//	You should have received a copy of the GNU General Public License
+//	along with this program.If not, see <http://www.gnu.org/licenses/>.
+//
+//	Contact: volkanilbeyli@gmail.com
+#pragma once
+
+#include "Profiler.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+//----------------------------------------------------------------------------------------------------------------
+// METRICS SERVER
+//----------------------------------------------------------------------------------------------------------------
+// Publishes the per-frame counters and the CPU scope timings on a loopback TCP port as JSON lines, one line per
+// frame, for external monitoring tools (see MetricsMonitor). e.g.:
+//
+//   {"frame":1042,"frame_ms":16.683,"dropped":0,"counters":{"FPS":60,"Draw Calls":312,...},"scopes_ms":{"CPU":4.210,...}}
+//
+// Publish() only moves the frame into a bounded queue, nothing is formatted or sent on the frame's thread.
+// The frames are dropped when no client is connected, or when the queue is full because a client is too slow.
+//
+class MetricsServer
+{
+public:
+	static constexpr unsigned short DEFAULT_PORT = 27960;
+
+	struct Counter
+	{
+		const char* pName;	// not copied: string literals or static tables
+		int			value;
+	};
+	struct ScopeTime
+	{
+		ProfileScopeID	scopeID;
+		float			timeMs;	// summed over the threads
+	};
+	struct Frame
+	{
+		unsigned long long		frameIndex = 0;
+		float					frameTimeMs = 0.0f;
+		std::vector<Counter>	counters;
+		std::vector<ScopeTime>	scopeTimes;
+	};
+
+	~MetricsServer();	// stops the server
+
+	// listens on 127.0.0.1:@port, local processes only
+	//
+	bool Start(unsigned short port);
+	void Stop();
+
+	// the caller can skip collecting the frame when nobody is listening
+	//
+	inline bool HasClients() const { return mNumClients.load(std::memory_order_relaxed) > 0; }
+	void Publish(Frame&& frame);
+
+private:
+	static constexpr size_t MAX_QUEUED_FRAMES = 256;
+	using Socket_t = uintptr_t;	// SOCKET, w/o including winsock in the header
+
+	void ServerThread();
+	void AcceptClients();
+	void SendToClients(const std::string& lines);
+	void FormatFrame(const Frame& frame, std::string& lines) const;
+
+private:
+	std::thread					mServerThread;
+	std::atomic<int>			mNumClients { 0 };
+	std::atomic<uint64_t>		mNumDroppedFrames { 0 };
+
+	std::mutex					mMutex;
+	std::condition_variable		mSignal;
+	std::deque<Frame>			mFrameQueue;
+	bool						mbStop = false;
+
+	// server thread
+	Socket_t					mListenSocket = ~Socket_t(0);	// INVALID_SOCKET
+	std::vector<Socket_t>		mClientSockets;
+	unsigned short				mPort = 0;
+};
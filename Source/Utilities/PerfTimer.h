@@ -18,62 +18,44 @@
 
 #pragma once
 
-#define xFRANK_LUNA_TIMER
-
-#ifdef FRANK_LUNA_TIMER
-// Borrowed from Frank Luna's DirectX11 book's GameTimer class
-// https://www.amazon.com/Introduction-3D-Game-Programming-DirectX/dp/1936420228
+#include <chrono>
 
+// Measures the frame times and the loading times. Backed by the steady clock, which is monotonic - unlike the
+// system clock, it isn't adjusted by NTP or by the user changing the time - and reads the performance counter
+// (QueryPerformanceCounter) on Windows. The time stamps are kept as raw ticks, converted to seconds on demand.
+//
 class PerfTimer
 {
 public:
-	PerfTimer();
-	~PerfTimer();
+	using Clock  = std::chrono::steady_clock;
+	using Tick_t = long long;
+	using TickSourceFn_t = Tick_t(*)();	// tests drive the timer with a fake clock
 
-	float TotalTime() const;
-	double CurrentTime();
-	float DeltaTime() const;	// return dt
+	static inline Tick_t GetTick() { return Clock::now().time_since_epoch().count(); }
+	static constexpr Tick_t GetTicksPerSecond() { return Clock::period::den / Clock::period::num; }
+	static inline double TicksToSeconds(Tick_t ticks) { return static_cast<double>(ticks) * Clock::period::num / Clock::period::den; }
+	static inline Tick_t SecondsToTicks(double seconds) { return static_cast<Tick_t>(seconds * Clock::period::den / Clock::period::num); }
 
-	void Reset();
-	void Start();
-	void Stop();
-	float Tick();	
-
-private:
-	double m_secPerCount;
-	double m_dt;
+	// runs the timer on a fake clock through start/stop/resume/reset sequences and checks the
+	// measured times. Logs the mismatches and returns false if any of them fails.
+	//
+	static bool RunPauseResumeTests();
 
-	long m_baseTime;
-	long m_pausedTime;
-	long m_stopTime;
-	long m_prevTime;
-	long m_currTime;
-
-	bool m_stopped;
-};
-#else	// C++11
-
-#include <chrono>
-
-using Vtime_t		= std::chrono::time_point<std::chrono::system_clock>;	// Vtime_t != std::time_t
-using duration_t	= std::chrono::duration<float>;
-
-class PerfTimer
-{
 public:
-	PerfTimer();
+	PerfTimer(TickSourceFn_t pfnGetTick = &PerfTimer::GetTick);
 
-	// returns the time duration between Start() and Now, minus the paused duration.
+	// returns the time duration between Start() and the last Tick(), minus the paused duration.
 	float TotalTime() const;
 
-
-	//double CurrentTime();
-
 	// returns the last delta time measured between Start() and Stop()
 	float DeltaTime() const;
 	float GetPausedTime() const;
 	float GetStopDuration() const;	// gets (Now - stopTime)
 
+	inline Tick_t GetDeltaTicks() const { return dt; }
+	Tick_t GetTotalTicks() const;
+
+	// stops the timer and discards the measured times, the time before the next Start() isn't counted.
 	void Reset();
 	void Start();
 	void Stop();
@@ -85,14 +67,12 @@ public:
 	float Tick();
 
 private:
-	Vtime_t		baseTime,		
+	TickSourceFn_t pfnGetTick;
+	Tick_t		baseTime,
 				prevTime,
 				currTime,
-				startTime,		// pause functionality: start/stop time stamps
-				stopTime;
-	duration_t	pausedTime,
+				stopTime,		// pause functionality: stop time stamp, start accumulates the paused ticks
+				pausedTime,
 				dt;
 	bool		bIsStopped;
 };
-
-#endif
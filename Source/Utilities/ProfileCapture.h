@@ -0,0 +1,82 @@
+//	VQEngine | DirectX11 Renderer
+//	Copyright(C) 2018  - Volkan Ilbeyli
+//
+//	This program is free software : you can redistribute it and / or modify
+//	it under the terms of the GNU General Public License as published by
+//	the Free Software Foundation, either version 3 of the License, or
+//	(at your option) any later version.
+//
+//	This program is distributed in the hope that it will be useful,
+//	but WITHOUT ANY WARRANTY; without even the implied warranty of
+//	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+//	GNU General Public License for more details.
+//
+//	You should have received a copy of the GNU General Public License
+//	along with this program.If not, see <http://www.gnu.org/licenses/>.
+//
+//	Contact: volkanilbeyli@gmail.com
+#pragma once
+
+#include "Profiler.h"
+
+#include <condition_variable>
+#include <deque>
+#include <fstream>
+#include <mutex>
+#include <set>
+#include <thread>
+
+//----------------------------------------------------------------------------------------------------------------
+// PROFILE CAPTURE
+//----------------------------------------------------------------------------------------------------------------
+// Writes the CPUProfiler timeline of consecutive frames into a Chrome Trace Event JSON file, which
+// chrome://tracing and ui.perfetto.dev open: a track per thread, scopes as complete events, frame markers
+// and the submitting thread of the thread pool tasks.
+//
+// The profiling thread only moves the frames into a queue. Formatting and writing the file happen
+// on the capture's own thread so capturing doesn't distort the captured frames.
+//
+class ProfileCapture
+{
+public:
+	~ProfileCapture();	// waits for the queued frames to be written
+
+	// Starts the writer thread, the file is complete once @numFrames frames are added
+	//
+	bool Begin(const std::string& filePath, int numFrames);
+
+	// Queues the timeline of a frame. @profilingThreadIndex is the thread whose outermost scopes are the frames.
+	//
+	void AddFrame(const std::vector<CPUProfiler::TimelineEvent>& timeline, uint32_t profilingThreadIndex);
+
+	inline bool IsCapturing() const { return mNumFramesLeft > 0; }
+
+private:
+	struct Frame
+	{
+		uint64_t frameIndex;
+		uint32_t profilingThreadIndex;
+		std::vector<CPUProfiler::TimelineEvent> events;
+	};
+
+	void WriterThread();
+	void WriteFrame(const Frame& frame);
+	void WriteEvent(const std::string& eventJSON);
+
+private:
+	std::string				mFilePath;
+	std::ofstream			mFile;
+	std::thread				mWriterThread;
+	int						mNumFramesLeft = 0;		// profiling thread
+	uint64_t				mNumFramesAdded = 0;	// profiling thread
+
+	std::mutex				mMutex;
+	std::condition_variable	mSignal;
+	std::deque<Frame>		mFrameQueue;
+	bool					mbLastFrameAdded = false;
+
+	// writer thread
+	long long				mBaseTick = 0;			// timestamps are relative to the first scope of the capture
+	bool					mbFirstEvent = true;
+	std::set<uint32_t>		mThreadIndices;
+};
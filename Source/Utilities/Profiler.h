@@ -7,8 +7,13 @@
 #include <thread>
 #include <limits>
 #include <array>
+#include <chrono>
+#include <cstdint>
+#include <atomic>
+#include <memory>
 
 #include "PerfTimer.h"
+#include "TimingHistogram.h"
 #include "Renderer/TextRenderer.h"
 #include "Engine/DataStructures.h"
 
@@ -17,14 +22,22 @@
 #endif
 
 class TextRenderer;
+class ProfileCapture;
 struct vec2;
 struct ID3D11DeviceContext;
 struct ID3D11Device;
 
 struct ProfilerSettings
-{	// UNUSED
+{
 	int sampleCount = 50;
-	int refreshRate = 5;
+	int refreshRate = 5;	// UNUSED
+
+	// CPUProfiler: a sample is a hitch when it's longer than hitchThreshold x the median of its entry, and longer than
+	// hitchMinDuration. The scope tree of the frames whose outermost entry is a hitch is logged.
+	float hitchThreshold = 2.0f;
+	float hitchMinDuration = 0.001f;	// seconds
+	int   hitchMinSampleCount = 60;		// samples an entry needs before it reports hitches
+	bool  bLogHitchFrames = true;
 };
 
 
@@ -65,23 +78,82 @@ public:
 	virtual vec2 GetEntryAreaBounds(const vec2& screenSizeInPixels) const = 0;
 };
 
-class CPUProfiler : public Profiler
+// Index of a profiled scope in the scope registry of the CPUProfiler, one per unique scope name
+//
+using ProfileScopeID = uint32_t;
+
+// Captured on the thread that submits a task to the thread pool: the task is profiled on the worker
+// as the scope the submitter was in, and the timeline keeps which thread submitted it.
+//
+struct ProfileTaskLink
+{
+	ProfileScopeID	scopeID;
+	uint32_t		submitterThreadIndex;
+};
+
+class CPUProfiler final : public Profiler
 {
 
 public:
-	CPUProfiler(ProfilerSettings settings = ProfilerSettings()) : 	mSettings(settings) {}
+	static constexpr uint32_t NO_THREAD = 0xFFFFFFFF;
+
+	// A closed scope of any thread. The timeline of a frame lists the scopes in the order they ended, per thread.
+	//
+	struct TimelineEvent
+	{
+		ProfileScopeID	scopeID;
+		uint32_t		threadIndex;
+		uint32_t		depth;					// nesting level of the scope on its thread
+		uint32_t		submitterThreadIndex;	// NO_THREAD unless the scope is a thread pool task
+		long long		beginTick;
+		long long		endTick;
+		bool			bHitch;
+	};
+
+	CPUProfiler(ProfilerSettings settings = ProfilerSettings());
+	~CPUProfiler();
+
+	// Returns the ID of the scope named @name, registering the scope if it's the first time the name is seen.
+	// Thread safe. Use PROFILE_SCOPE / PROFILE_SCOPE_ID so the lookup happens only once per call site.
+	//
+	static ProfileScopeID RegisterScope(const std::string& name);
+	static std::string GetScopeName(ProfileScopeID scopeID);
+
+	// Threads are indexed in the order they first record a scope, named "Thread <index>" unless they name themselves.
+	//
+	static void SetThreadName(const std::string& name);
+	static std::string GetThreadName(uint32_t threadIndex);
+
+	// Thread pool tasks: GetTaskLink() on the submitting thread, Begin/EndTask() around the task on the worker.
+	//
+	static ProfileTaskLink GetTaskLink();
+	static void BeginTask(const ProfileTaskLink& link);
+	static void EndTask();
+
+	// Runs empty scopes on a scratch profiler and returns the cost of a Begin/EndEntry pair in nanoseconds.
+	// The scratch profiler only collects the events of the calling thread. Reported by Benchmark.exe.
+	//
+	static float MeasureScopeOverhead(size_t numScopes = 10000);
 
 	// Resets the mPerfEntryTable - must be called at the beginning and end of each frame. 
+	// The thread that calls BeginProfile() becomes the profiling thread.
 	//
 	void BeginProfile(const unsigned long long FRAME_NUMBER = 0) override;
 	void EndProfile(const unsigned long long FRAME_NUMBER = 0) override;
 
-	// Adds PerfEntry to the PerfEntryTable if it doesn't already exist AND Starts the time sampling for the PerfEntry.
+	// The outermost entries of the profiling thread collect the events of all the threads.
+	// Hands the profiling over to the calling thread, the previous profiling thread must not be profiling anymore.
+	//
+	void SetProfilingThread();
+
+	// BeginEntry()/EndEntry() only record the scope ID and a tick into the event stream of the calling thread,
+	// they can be called from any thread. The streams of all the threads are aggregated into the PerfEntries,
+	// the tree and the timeline when the outermost entry of the profiling thread ends.
 	// BeginEntry()/EndEntry() must be called between BeginProfile() and EndProfile()
-	// *Assumes PerfEntry has a unique name. There won't be duplicate entries.*
 	//
-	void BeginEntry(const std::string& entryName) override;
-	void EndEntry() override;
+	inline void BeginEntry(ProfileScopeID scopeID);
+	void BeginEntry(const std::string& entryName) override;	// looks up the scope ID of @entryName first
+	inline void EndEntry() override;
 
 	float GetEntryAvg(const std::string& tag) const override;
 	float GetRootEntryAvg() const override;
@@ -92,18 +164,24 @@ public:
 
 	// DERIVED INTERFACE -------------------------------------------
 
-	inline bool AreThereAnyOpenEntries() const { return !mState.EntryNameStack.empty(); }
+	// scopes of all the threads that ended in the last aggregated frame
+	//
+	inline const std::vector<TimelineEvent>& GetTimeline() const { return mTimeline; }
+
+	bool AreThereAnyOpenEntries() const;
 
 	// performs checks for state consistency (are there any open entries? etc.)
 	//
 	bool StateCheck() const;
 
-	// prints states into debug console output
+	// logs the scope tree with the percentiles and the hitch count of each entry
 	//
-	void PrintStats() const;	// todo: impl
-
+	void PrintStats() const;
 
-	//void Capture()
+	// Writes the timeline of the next @numFrames frames into @filePath as a Chrome Trace Event JSON file, see ProfileCapture
+	//
+	bool BeginCapture(const std::string& filePath, int numFrames);
+	bool IsCapturing() const;
 
 private:	// Internal Structs
 	struct PerfEntry;
@@ -111,25 +189,92 @@ private:	// Internal Structs
 	{
 		bool					bIsProfiling = false;
 		bool					bCaptureInProgress = false;
-		std::stack<std::string> EntryNameStack;
-		TreeNode<PerfEntry>*	pLastEntryNode = nullptr;	// used for setting up the hierarchy
 		inline void Clear()
 		{
 			bIsProfiling = false;
-			pLastEntryNode = nullptr;
-			while (!EntryNameStack.empty()) EntryNameStack.pop();
 		}
 	};
-	using PerfEntryTable = std::unordered_map<std::string, PerfEntry>;
+	using PerfEntryKey = uint64_t;	// thread index | scope ID
+	using PerfEntryTable = std::unordered_map<PerfEntryKey, PerfEntry>;
+	static inline PerfEntryKey GetEntryKey(uint32_t threadIndex, ProfileScopeID scopeID) { return (static_cast<uint64_t>(threadIndex) << 32) | scopeID; }
+
+	// Begin/End event of a scope: end events don't have a scope, they close the last open entry
+	struct ScopeEvent
+	{
+		ProfileScopeID	scopeID;
+		uint32_t		submitterThreadIndex;
+		long long		tick;
+	};
+	static constexpr ProfileScopeID END_EVENT = 0xFFFFFFFF;
+
+	struct ResolveEntry
+	{
+		PerfEntry*		pEntry;
+		ProfileScopeID	scopeID;
+		uint32_t		submitterThreadIndex;
+		long long		beginTick;
+	};
+
+	// Events of a thread: lock-free ring buffer written by the thread and read by the profiling thread.
+	// Begin events are only recorded when there's room for the end events of all the open entries
+	// so a full buffer drops whole scopes and the begin/end events always pair up.
+	struct ThreadEventStream
+	{
+		static constexpr size_t CAPACITY = 16384;	// power of 2
+		static constexpr int MAX_DEPTH = 64;
+
+		std::vector<ScopeEvent>	events;
+		std::atomic<uint64_t>	writeIndex { 0 };
+		std::atomic<uint64_t>	readIndex { 0 };
+		std::atomic<uint32_t>	numDroppedScopes { 0 };
+		uint32_t				threadIndex = 0;
+
+		// written by the thread
+		int						openEntryCount = 0;
+		int						recordedOpenEntryCount = 0;
+		std::array<ProfileScopeID, MAX_DEPTH>	openScopes;
+		std::array<bool, MAX_DEPTH>				bOpenScopeRecorded;
+
+		// read by the profiling thread
+		std::vector<ResolveEntry>	resolveStack;
+		uint32_t					numReportedDroppedScopes = 0;
+	};
+	struct ThreadStreamRegistry;
+
+	static inline long long GetTick() { return PerfTimer::GetTick(); }	// same clock as the frame times
+	static inline float GetSeconds(long long ticks) { return static_cast<float>(PerfTimer::TicksToSeconds(ticks)); }
+
+	static ThreadStreamRegistry& GetThreadStreamRegistry();
+	static ThreadEventStream* RegisterThreadStream();
+	static std::vector<ThreadEventStream*> GetThreadStreams();
+	static inline ThreadEventStream& GetThreadStream();
+
+	static inline void RecordBeginEvent(ThreadEventStream& stream, ProfileScopeID scopeID, uint32_t submitterThreadIndex);
+	static inline bool RecordEndEvent(ThreadEventStream& stream);	// true when the outermost entry of the thread ends
+
+	// aggregates the events of all the threads into the perf entries and the timeline
+	//
+	void ResolveEvents();
+	void ResolveStream(ThreadEventStream& stream);
+	void ResetStreams();	// discards the unresolved events
+	void LogHitchFrame() const;
+	PerfEntry& GetOrCreateEntry(PerfEntryKey key, const std::string& tag, const PerfEntry* pParentEntry);
 
 
 private:
-	PerfEntryTable		mPerfEntries;		// where data lives (with entry name as unique keys)
+	PerfEntryTable		mPerfEntries;		// where data lives (with thread index and scope ID as unique keys)
 	Tree<PerfEntry>		mPerfEntryTree;
 	
 	ProfilerSettings	mSettings;
 	State				mState;
 
+	std::atomic<ThreadEventStream*>	mpProfilingThreadStream { nullptr };
+	bool							mbCollectAllThreads = true;	// false: only the profiling thread (scratch profilers)
+	std::vector<TimelineEvent>		mTimeline;
+	std::unique_ptr<ProfileCapture>	mpCapture;
+	long long						mLastHitchLogTick = 0;
+	int								mNumHitchFramesNotLogged = 0;
+
 	//------------------------------------------------------
 
 	struct PerfEntry
@@ -137,10 +282,12 @@ private:
 		std::string			tag;
 		size_t				currSampleIndex; // [0, samples.size())
 		std::vector<float>	samples;
-		PerfTimer			timer;
+		long long			lastSampleTick;
+		TimingHistogram		histogram;		// all the samples since the entry was created
+		float				median;			// updated every few samples
+		int					numHitches;
 
-		void UpdateSampleBegin();
-		void UpdateSampleEnd();
+		bool AddSample(float dt, long long tick, const ProfilerSettings& settings);	// returns true if the sample is a hitch
 		void PrintEntryInfo(bool bPrintAllEntries = false);
 		inline float GetAvg() const;
 		bool operator<(const PerfEntry& other) const;
@@ -148,6 +295,92 @@ private:
 	};
 };
 
+inline CPUProfiler::ThreadEventStream& CPUProfiler::GetThreadStream()
+{
+	thread_local ThreadEventStream* pStream = nullptr;
+	if (pStream == nullptr)
+		pStream = RegisterThreadStream();
+	return *pStream;
+}
+
+inline void CPUProfiler::RecordBeginEvent(ThreadEventStream& stream, ProfileScopeID scopeID, uint32_t submitterThreadIndex)
+{
+	const int depth = stream.openEntryCount++;
+	const uint64_t writeIndex = stream.writeIndex.load(std::memory_order_relaxed);
+	const uint64_t numFreeEvents = ThreadEventStream::CAPACITY - (writeIndex - stream.readIndex.load(std::memory_order_acquire));
+	const bool bRecord = depth < ThreadEventStream::MAX_DEPTH && numFreeEvents >= static_cast<uint64_t>(stream.recordedOpenEntryCount) + 2;
+	if (depth < ThreadEventStream::MAX_DEPTH)
+	{
+		stream.openScopes[depth] = scopeID;
+		stream.bOpenScopeRecorded[depth] = bRecord;
+	}
+	if (!bRecord)
+	{
+		stream.numDroppedScopes.fetch_add(1, std::memory_order_relaxed);
+		return;
+	}
+
+	stream.events[writeIndex & (ThreadEventStream::CAPACITY - 1)] = ScopeEvent{ scopeID, submitterThreadIndex, GetTick() };
+	stream.writeIndex.store(writeIndex + 1, std::memory_order_release);
+	++stream.recordedOpenEntryCount;
+}
+
+inline bool CPUProfiler::RecordEndEvent(ThreadEventStream& stream)
+{
+	if (stream.openEntryCount == 0)
+		return false;	// EndEntry() without a BeginEntry()
+
+	const int depth = --stream.openEntryCount;
+	if (depth < ThreadEventStream::MAX_DEPTH && stream.bOpenScopeRecorded[depth])
+	{
+		const uint64_t writeIndex = stream.writeIndex.load(std::memory_order_relaxed);
+		stream.events[writeIndex & (ThreadEventStream::CAPACITY - 1)] = ScopeEvent{ END_EVENT, NO_THREAD, GetTick() };
+		stream.writeIndex.store(writeIndex + 1, std::memory_order_release);
+		--stream.recordedOpenEntryCount;
+	}
+	return depth == 0;
+}
+
+inline void CPUProfiler::BeginEntry(ProfileScopeID scopeID)
+{
+	RecordBeginEvent(GetThreadStream(), scopeID, NO_THREAD);
+}
+
+inline void CPUProfiler::EndEntry()
+{
+	ThreadEventStream& stream = GetThreadStream();
+	if (RecordEndEvent(stream) && &stream == mpProfilingThreadStream.load(std::memory_order_relaxed))
+	{
+		ResolveEvents();
+	}
+}
+
+// Begins an entry on construction and ends it on destruction
+//
+class ProfileScope
+{
+public:
+	inline ProfileScope(CPUProfiler* pProfiler, ProfileScopeID scopeID) : mpProfiler(pProfiler) { mpProfiler->BeginEntry(scopeID); }
+	inline ~ProfileScope() { mpProfiler->EndEntry(); }
+	ProfileScope(const ProfileScope&) = delete;
+	ProfileScope& operator=(const ProfileScope&) = delete;
+private:
+	CPUProfiler* mpProfiler;
+};
+
+#define PROFILE_SCOPE_CONCAT_IMPL(a, b) a##b
+#define PROFILE_SCOPE_CONCAT(a, b) PROFILE_SCOPE_CONCAT_IMPL(a, b)
+
+// Scope ID of the string literal @name, registered the first time the call site runs.
+// e.g.: pCPUProfiler->BeginEntry(PROFILE_SCOPE_ID("Shadow Pass")); ... pCPUProfiler->EndEntry();
+//
+#define PROFILE_SCOPE_ID(name) []() { static const ProfileScopeID sScopeID = CPUProfiler::RegisterScope(name); return sScopeID; }()
+
+// Profiles the rest of the enclosing C++ scope as the entry @name with the CPUProfiler @pProfiler
+// e.g.: PROFILE_SCOPE(mpCPUProfiler, "PreRender()");
+//
+#define PROFILE_SCOPE(pProfiler, name) const ProfileScope PROFILE_SCOPE_CONCAT(profileScope, __LINE__)((pProfiler), PROFILE_SCOPE_ID(name))
+
 
 
 
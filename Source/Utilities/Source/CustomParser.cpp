@@ -20,31 +20,52 @@
 #include "utils.h"
 #include "Log.h"
 #include "Color.h"
+#include "Tokenizer.h"
 
 #include "Renderer/Renderer.h"
+#include "Engine/CompiledScene.h"
 
-#include <fstream>
 #include <unordered_map>
 #include <algorithm>
+#include <fstream>
+#include <random>
+#include <chrono>
+#include <cstdlib>
 
 
 const std::string file_root		= "Data\\";
 const std::string scene_root	= "Data\\ScenesFiles\\";
 
-const std::unordered_map<std::string, bool> sBoolTypeReflection
+const std::unordered_map<std::string_view, bool> sBoolTypeReflection
 {
 	{"true", true},		{"false", false},
 	{"yes", true},		{"no", false},
 	{"1", true},		{"0", false}
 };
 
-std::string GetLowercased(const std::string& str)
+std::string GetLowercased(std::string_view str)
 {
 	std::string lowercase(str);
 	std::transform(str.begin(), str.end(), lowercase.begin(), ::tolower);
 	return lowercase;
 }
 
+static float ToFloat(std::string_view token)
+{
+	float value = 0.0f;
+	if (!Tokenizer::ParseFloat(token, value))
+		Log::Error("Parser: Expected a number, got \"%s\"", std::string(token).c_str());
+	return value;
+}
+
+static int ToInt(std::string_view token)
+{
+	int value = 0;
+	if (!Tokenizer::ParseInt(token, value))
+		Log::Error("Parser: Expected an integer, got \"%s\"", std::string(token).c_str());
+	return value;
+}
+
 
 Parser::Parser(){}
 
@@ -55,17 +76,18 @@ Settings::Engine Parser::ReadSettings(const std::string& settingsFileName)
 	const std::string filePath = settingsFileName;
 	Settings::Engine setting;
 
-	std::ifstream settingsFile(filePath.c_str());
-	if (settingsFile.is_open())
+	Tokenizer settingsFile;
+	if (settingsFile.Open(filePath))
 	{
-		std::string	line;
-		while (getline(settingsFile, line))
+		std::string_view line;
+		std::vector<std::string_view> command;
+		while (settingsFile.NextLine(line))
 		{
 			if (line.empty()) continue;
 			if (line[0] == '/' || line[0] == '#')					// skip comments
 				continue;
 
-			std::vector<std::string> command = StrUtil::split(line, ' ');	// ignore whitespace
+			Tokenizer::Split(line, " ", command);					// ignore whitespace
 			ParseSetting(command, setting);							// process command
 		}
 		Log::Info("Initialized engine settings.");
@@ -78,7 +100,7 @@ Settings::Engine Parser::ReadSettings(const std::string& settingsFileName)
 	return setting;
 }
 
-void Parser::ParseSetting(const std::vector<std::string>& line, Settings::Engine& settings)
+void Parser::ParseSetting(const std::vector<std::string_view>& line, Settings::Engine& settings)
 {
 	if (line.empty())
 	{
@@ -86,17 +108,17 @@ void Parser::ParseSetting(const std::vector<std::string>& line, Settings::Engine
 		return;
 	}
 
-	const std::string& cmd = line[0];
+	const std::string_view& cmd = line[0];
 	if (cmd == "window")
 	{
 		// Parameters
 		//---------------------------------------------------------------
 		// | Window Width	|  Window Height	| Fullscreen?	| VSYNC?
 		//---------------------------------------------------------------
-		settings.window.width      = stoi(line[1]);
-		settings.window.height     = stoi(line[2]);
-		settings.window.fullscreen = stoi(line[3]);
-		settings.window.vsync      = stoi(line[4]);
+		settings.window.width      = ToInt(line[1]);
+		settings.window.height     = ToInt(line[2]);
+		settings.window.fullscreen = ToInt(line[3]);
+		settings.window.vsync      = ToInt(line[4]);
 	}
 	else if (cmd == "logger" || cmd == "logging" || cmd == "log")
 	{
@@ -113,7 +135,7 @@ void Parser::ParseSetting(const std::vector<std::string>& line, Settings::Engine
 		//---------------------------------------------------------------
 		// | Shadow Map dimension
 		//---------------------------------------------------------------
-		settings.rendering.shadowMap.dimension = stoi(line[1]);
+		settings.rendering.shadowMap.dimension = ToInt(line[1]);
 	}
 	else if (cmd == "lightingModel")
 	{
@@ -138,7 +160,7 @@ void Parser::ParseSetting(const std::vector<std::string>& line, Settings::Engine
 		//---------------------------------------------------------------
 		// | Exposure
 		//---------------------------------------------------------------
-		settings.rendering.postProcess.toneMapping.exposure = stof(line[1]);
+		settings.rendering.postProcess.toneMapping.exposure = ToFloat(line[1]);
 	}
 	else if (cmd == "environmentMapping")
 	{
@@ -154,6 +176,14 @@ void Parser::ParseSetting(const std::vector<std::string>& line, Settings::Engine
 		settings.rendering.bPreLoadEnvironmentMaps = false;
 #endif
 	}
+	else if (cmd == "compactVertices")
+	{
+		// Parameters
+		//---------------------------------------------------------------
+		// | Enabled?
+		//---------------------------------------------------------------
+		settings.rendering.bCompactVertices = sBoolTypeReflection.at(GetLowercased(line[1]));
+	}
 	else if (cmd == "HDR")
 	{
 		// Parameters
@@ -169,10 +199,11 @@ void Parser::ParseSetting(const std::vector<std::string>& line, Settings::Engine
 		{
 			// all lines except the las one will contain a ',' in the end, e.g. "Objects.scn,"
 			// the following will remove the commas except for the last scene in the line[] array
-			settings.sceneNames.push_back(i == countScenes - 1
-				? line[i + 1]
-				: StrUtil::split(line[i + 1], ',')[0]	
-			);
+			const std::string_view& sceneName = line[i + 1];
+			settings.sceneNames.push_back(std::string(i == countScenes - 1
+				? sceneName
+				: sceneName.substr(0, sceneName.find(','))
+			));
 		}
 	}
 	else if (cmd == "level")
@@ -181,34 +212,47 @@ void Parser::ParseSetting(const std::vector<std::string>& line, Settings::Engine
 		//---------------------------------------------------------------
 		// | Enabled?
 		//---------------------------------------------------------------
-		settings.levelToLoad = stoi(line[1]) - 1;	// input file assumes 1 as first index
+		settings.levelToLoad = ToInt(line[1]) - 1;	// input file assumes 1 as first index
 		if (settings.levelToLoad == -1) settings.levelToLoad = 0;
 	}
 	else
 	{
-		Log::Error("Setting Parser: Unknown command: %s", cmd);
+		Log::Error("Setting Parser: Unknown command: %s", std::string(cmd).c_str());
 		return;
 	}
 }
 
+static void ResetSceneParserState();	// state of ParseScene(), defined below
+
 SerializedScene Parser::ReadScene(Renderer* pRenderer, const std::string& sceneFileName)
+{
+	return ReadSceneFile(pRenderer, GetSceneFilePath(sceneFileName));
+}
+
+std::string Parser::GetSceneFilePath(const std::string& sceneFileName)
+{
+	return scene_root + sceneFileName;
+}
+
+SerializedScene Parser::ReadSceneFile(Renderer* pRenderer, const std::string& filePath)
 {
 	SerializedScene scene;
-	std::string filePath = scene_root + sceneFileName;
-	std::ifstream sceneFile(filePath.c_str());
+	Tokenizer sceneFile;
 
 	scene.materials.Clear();
 	scene.materials.Initialize(4096);
+	ResetSceneParserState();
 
-	if (sceneFile.is_open())
+	if (sceneFile.Open(filePath))
 	{
-		std::string	line;
-		while (getline(sceneFile, line))
+		std::string_view line;
+		std::vector<std::string_view> command;
+		while (sceneFile.NextLine(line))
 		{
-			if (line[0] == '/' || line[0] == '#' || line[0] == '\0')	// skip comments
+			if (line.empty() || line[0] == '/' || line[0] == '#')		// skip comments
 				continue;
 
-			std::vector<std::string> command = StrUtil::split(line, ' ', '\t');	// ignore whitespace
+			Tokenizer::Split(line, " \t", command);					// ignore whitespace
 			ParseScene(pRenderer, command, scene);						// process command
 		}
 		scene.loadSuccess = '1';
@@ -219,7 +263,6 @@ SerializedScene Parser::ReadScene(Renderer* pRenderer, const std::string& sceneF
 		scene.loadSuccess = '0';
 	}
 
-	sceneFile.close();
 	return scene;
 }
 
@@ -248,17 +291,23 @@ static MaterialType materialType = MaterialType::UNKNOWN;
 static Material* pMaterial = nullptr;
 static GameObject* pObject = nullptr;
 
-using ParseFunctionType = void(__cdecl *)(const std::vector<std::string>&);
-using ParseFunctionLookup = std::unordered_map<std::string, ParseFunctionType>;
+static void ResetSceneParserState()
+{
+	bIsReadingGameObject = false;
+	bIsReadingMaterial = false;
+	materialType = MaterialType::UNKNOWN;
+	pMaterial = nullptr;
+	pObject = nullptr;
+}
 
-static const std::unordered_map<std::string, Light::ELightType>	sLightTypeLookup
+static const std::unordered_map<std::string_view, Light::ELightType>	sLightTypeLookup
 { 
 	{"s", Light::ELightType::SPOT },
 	{"p", Light::ELightType::POINT},
 	{"d", Light::ELightType::DIRECTIONAL}
 };
 
-static const std::unordered_map<std::string, const LinearColor&>		sColorLookup
+static const std::unordered_map<std::string_view, const LinearColor&>		sColorLookup
 {
 	{"orange"    , LinearColor::s_palette[ static_cast<int>(EColorValue::ORANGE     )]},
 	{"black"     , LinearColor::s_palette[ static_cast<int>(EColorValue::BLACK      )]},
@@ -276,26 +325,62 @@ static const std::unordered_map<std::string, const LinearColor&>		sColorLookup
 	{"sun"       , LinearColor::s_palette[ static_cast<int>(EColorValue::SUN        )]}
 };
 
-// todo: get rid of else ifs for cmd == "" comparison... 
-// perhaps use a function lookup?
-// or define static functions in corresponding objects?
-// might as well use some preprocessor magic... 
-
-//static const ParseFunctionLookup sParseCommandFn =
-//{	
-//	{"camera", [](const std::vector<std::string>& cmds) -> void 
-//	{
-//		const auto& cmd = cmds[0];
-//		
-//	}
-//	}
-//};
-
-void Parser::ParseScene(Renderer* pRenderer, const std::vector<std::string>& command, SerializedScene& scene)
+// the command keywords are hashed once here instead of being compared one by one for every line
+enum class ESceneCommand
+{
+	CAMERA,
+	DIRECTIONAL_LIGHT,
+	LIGHT,
+	OBJECT,
+	MESH,
+	BRDF,
+	BLINN_PHONG,
+	DIFFUSE,
+	TILING,
+	ROUGHNESS,
+	METALNESS,
+	SHININESS,
+	TEXTURES,
+	TRANSFORM,
+	MODEL,
+	AMBIENT_OCCLUSION,
+	SKYLIGHT,
+	BLOOM,
+
+	UNKNOWN
+};
+static const std::unordered_map<std::string_view, ESceneCommand>	sSceneCommandLookup
+{
+	{"camera"     , ESceneCommand::CAMERA            },
+	{"directional", ESceneCommand::DIRECTIONAL_LIGHT },
+	{"light"      , ESceneCommand::LIGHT             },
+	{"object"     , ESceneCommand::OBJECT            },
+	{"mesh"       , ESceneCommand::MESH              },
+	{"brdf"       , ESceneCommand::BRDF              },
+	{"blinnphong" , ESceneCommand::BLINN_PHONG       },
+	{"phong"      , ESceneCommand::BLINN_PHONG       },
+	{"diffuse"    , ESceneCommand::DIFFUSE           },
+	{"albedo"     , ESceneCommand::DIFFUSE           },
+	{"tiling"     , ESceneCommand::TILING            },
+	{"roughness"  , ESceneCommand::ROUGHNESS         },
+	{"metalness"  , ESceneCommand::METALNESS         },
+	{"shininess"  , ESceneCommand::SHININESS         },
+	{"textures"   , ESceneCommand::TEXTURES          },
+	{"transform"  , ESceneCommand::TRANSFORM         },
+	{"model"      , ESceneCommand::MODEL             },
+	{"ao"         , ESceneCommand::AMBIENT_OCCLUSION },
+	{"skylight"   , ESceneCommand::SKYLIGHT          },
+	{"bloom"      , ESceneCommand::BLOOM             }
+};
+
+void Parser::ParseScene(Renderer* pRenderer, const std::vector<std::string_view>& command, SerializedScene& scene)
 {
 	if (command.empty()){return;}
-	const std::string& cmd = command[0];	// shorthand
-	if (cmd == "camera")
+	const std::string_view& cmd = command[0];	// shorthand
+	const auto itCommand = sSceneCommandLookup.find(cmd);
+	switch (itCommand != sSceneCommandLookup.end() ? itCommand->second : ESceneCommand::UNKNOWN)
+	{
+	case ESceneCommand::CAMERA:
 	{
 		if (command.size() != 9)
 		{
@@ -307,25 +392,26 @@ void Parser::ParseScene(Renderer* pRenderer, const std::vector<std::string>& com
 		// |  Near Plane	| Far Plane	|	Field of View	| Position | Rotation
 		//--------------------------------------------------------------
 		Settings::Camera camSettings;
-		camSettings.nearPlane	= stof(command[1]);
-		camSettings.farPlane	= stof(command[2]);
-		camSettings.fovV		= stof(command[3]);
-		camSettings.x           = stof(command[4]);
-		camSettings.y           = stof(command[5]);
-		camSettings.z           = stof(command[6]);
-		camSettings.yaw         = stof(command[7]);
-		camSettings.pitch       = stof(command[8]);
+		camSettings.nearPlane	= ToFloat(command[1]);
+		camSettings.farPlane	= ToFloat(command[2]);
+		camSettings.fovV		= ToFloat(command[3]);
+		camSettings.x           = ToFloat(command[4]);
+		camSettings.y           = ToFloat(command[5]);
+		camSettings.z           = ToFloat(command[6]);
+		camSettings.yaw         = ToFloat(command[7]);
+		camSettings.pitch       = ToFloat(command[8]);
 		scene.cameras.push_back(camSettings);
 	}
-	else if (cmd == "directional")
+	break;
+	case ESceneCommand::DIRECTIONAL_LIGHT:
 	{
 		const std::string colorValue = GetLowercased(command[1]);
-		const float brightness		 = stof(command[2]);
-		const vec3 direction		 = vec3(stof(command[3]), stof(command[4]), stof(command[5])).normalized();
-		const int shadowMapDimension = command.size() > 6 ? stoi(command[6]) : 1024;
-		const int shadowViewportDimension = command.size() > 7 ? stoi(command[7]) : shadowMapDimension;
-		const float range			 = command.size() > 8 ? stof(command[8]) : 1.0f;
-		const float depthBias		 = command.size() > 9 ? stof(command[9]) : 0.00000001f;
+		const float brightness		 = ToFloat(command[2]);
+		const vec3 direction		 = vec3(ToFloat(command[3]), ToFloat(command[4]), ToFloat(command[5])).normalized();
+		const int shadowMapDimension = command.size() > 6 ? ToInt(command[6]) : 1024;
+		const int shadowViewportDimension = command.size() > 7 ? ToInt(command[7]) : shadowMapDimension;
+		const float range			 = command.size() > 8 ? ToFloat(command[8]) : 1.0f;
+		const float depthBias		 = command.size() > 9 ? ToFloat(command[9]) : 0.00000001f;
 
 		DirectionalLight l{
 			sColorLookup.at(colorValue),
@@ -339,7 +425,8 @@ void Parser::ParseScene(Renderer* pRenderer, const std::vector<std::string>& com
 
 		scene.directionalLight = l;
 	}
-	else if (cmd == "light")
+	break;
+	case ESceneCommand::LIGHT:
 	{
 		// #Parameters: 11
 		//--------------------------------------------------------------
@@ -356,23 +443,23 @@ void Parser::ParseScene(Renderer* pRenderer, const std::vector<std::string>& com
 		const std::string lightType	 = GetLowercased(command[1]);	// lookups have lowercase keys
 		if (lightType != "s" && lightType != "p")
 		{	// check light types
-			Log::Error("light type unknown: %s", command[1]);
+			Log::Error("light type unknown: %s", std::string(command[1]).c_str());
 			return;
 		}
 
 		const std::string colorValue = GetLowercased(command[2]);
 		const std::string shadowing	 = GetLowercased(command[3]);
-		const float brightness = stof(command[4]);
+		const float brightness = ToFloat(command[4]);
 
-		const float range = bCommandHasRange ? stof(command[8]) : 1.0f;
+		const float range = bCommandHasRange ? ToFloat(command[8]) : 1.0f;
 		const float& spotAngle = range;
-		const float rotX = bCommandHasRotationEntry ? stof(command[9])  : 0.0f;
-		const float rotY = bCommandHasRotationEntry ? stof(command[10]) : 0.0f;
-		const float rotZ = bCommandHasRotationEntry ? stof(command[11]) : 0.0f;
-		const float scl  = bCommandHasScaleEntry ? stof(command[IdxScale]) : 1.0f;
+		const float rotX = bCommandHasRotationEntry ? ToFloat(command[9])  : 0.0f;
+		const float rotY = bCommandHasRotationEntry ? ToFloat(command[10]) : 0.0f;
+		const float rotZ = bCommandHasRotationEntry ? ToFloat(command[11]) : 0.0f;
+		const float scl  = bCommandHasScaleEntry ? ToFloat(command[IdxScale]) : 1.0f;
 		const bool  bCastsShadows = sBoolTypeReflection.at(shadowing);
-		const float farPlaneDistance = bCommandHasFarPlaneEntry ? stof(command[13]) : 500;
-		const float depthBias = bCommandHasDepthBiasEntry ? stof(command[14]) : 0.0000005f;
+		const float farPlaneDistance = bCommandHasFarPlaneEntry ? ToFloat(command[13]) : 500;
+		const float depthBias = bCommandHasDepthBiasEntry ? ToFloat(command[14]) : 0.0000005f;
 
 		Light l(	// let there be light
 			sLightTypeLookup.at(lightType),
@@ -384,14 +471,15 @@ void Parser::ParseScene(Renderer* pRenderer, const std::vector<std::string>& com
 			farPlaneDistance,
 			depthBias
 		);
-		l.transform.SetPosition(stof(command[5]), stof(command[6]), stof(command[7]));
+		l.transform.SetPosition(ToFloat(command[5]), ToFloat(command[6]), ToFloat(command[7]));
 		l.transform.RotateAroundGlobalXAxisDegrees(rotX);
 		l.transform.RotateAroundGlobalYAxisDegrees(rotY);
 		l.transform.RotateAroundGlobalZAxisDegrees(rotZ);
 		l.transform.SetUniformScale(scl);
 		scene.lights.push_back(l);
 	}
-	else if (cmd == "object")
+	break;
+	case ESceneCommand::OBJECT:
 	{
 		// #Parameters: 2
 		//--------------------------------------------------------------
@@ -420,7 +508,8 @@ void Parser::ParseScene(Renderer* pRenderer, const std::vector<std::string>& com
 			pObject = nullptr;
 		}
 	}
-	else if (cmd == "mesh")
+	break;
+	case ESceneCommand::MESH:
 	{
 		// #Parameters: 1
 		//--------------------------------------------------------------
@@ -447,7 +536,8 @@ void Parser::ParseScene(Renderer* pRenderer, const std::vector<std::string>& com
 		pObject->AddMesh(sMeshLookup.at(mesh));
 		//obj.mModel.mMeshID = sMeshLookup.at(mesh);
 	}
-	else if (cmd == "brdf")
+	break;
+	case ESceneCommand::BRDF:
 	{
 		// #Parameters: 0
 		//--------------------------------------------------------------
@@ -474,7 +564,8 @@ void Parser::ParseScene(Renderer* pRenderer, const std::vector<std::string>& com
 		pMaterial = scene.materials.CreateAndGetMaterial(GGX_BRDF);
 		pObject->AddMaterial(pMaterial);
 	}
-	else if (cmd == "blinnphong" || cmd == "phong")
+	break;
+	case ESceneCommand::BLINN_PHONG:
 	{
 		Log::Info("Todo: blinnphong mat");
 		return;
@@ -503,12 +594,13 @@ void Parser::ParseScene(Renderer* pRenderer, const std::vector<std::string>& com
 		pMaterial = scene.materials.CreateAndGetMaterial(BLINN_PHONG);
 		pObject->AddMaterial(pMaterial);
 	}
+	break;
 
-	else if (cmd == "diffuse" || cmd == "albedo")
+	case ESceneCommand::DIFFUSE:
 	{
 		if (!bIsReadingMaterial)
 		{
-			Log::Error(" Cannot define Material Property: %s", cmd.c_str());
+			Log::Error(" Cannot define Material Property: %s", std::string(cmd).c_str());
 			return;
 		}
 
@@ -519,19 +611,23 @@ void Parser::ParseScene(Renderer* pRenderer, const std::vector<std::string>& com
 		const std::string firstParam = GetLowercased(command[1]);
 		if (DirectoryUtil::IsImageName(firstParam))
 		{
-			const TextureID texDiffuse = pRenderer->CreateTextureFromFile(firstParam);
-			pMaterial->diffuseMap = texDiffuse;
+			scene.GetMaterialTextures(pMaterial->ID).diffuseMap = firstParam;
+			if (pRenderer)
+			{
+				const TextureID texDiffuse = pRenderer->CreateTextureFromFile(firstParam);
+				pMaterial->diffuseMap = texDiffuse;
+			}
 		}
 		else
 		{
 			assert(command.size() >= 4); // albedo r g b a(optional)
-			const float r = stof(command[1]);
-			const float g = stof(command[2]);
-			const float b = stof(command[3]);
+			const float r = ToFloat(command[1]);
+			const float g = ToFloat(command[2]);
+			const float b = ToFloat(command[3]);
 			
 			if (command.size() == 5)
 			{
-				const float a = stof(command[4]);
+				const float a = ToFloat(command[4]);
 				pMaterial->diffuse = LinearColor(r, g, b);
 				pMaterial->alpha = a;
 			}
@@ -541,11 +637,12 @@ void Parser::ParseScene(Renderer* pRenderer, const std::vector<std::string>& com
 			}
 		}
 	}
-	else if (cmd == "tiling")
+	break;
+	case ESceneCommand::TILING:
 	{
 		if (!bIsReadingMaterial)
 		{
-			Log::Error(" Cannot define Material Property: %s", cmd.c_str());
+			Log::Error(" Cannot define Material Property: %s", std::string(cmd).c_str());
 			return;
 		}
 
@@ -553,11 +650,12 @@ void Parser::ParseScene(Renderer* pRenderer, const std::vector<std::string>& com
 		//--------------------------------------------------------------
 		// tiling(@parm1, @param1) | OR | tiling(@param1, @param2)
 		//--------------------------------------------------------------
-		const float tiling1 = stof(command[1]);
-		const float tiling2 = command.size() > 2 ? stof(command[2]) : tiling1;
+		const float tiling1 = ToFloat(command[1]);
+		const float tiling2 = command.size() > 2 ? ToFloat(command[2]) : tiling1;
 		pMaterial->tiling = vec2(tiling1, tiling2);
 	}
-	else if (cmd == "roughness")
+	break;
+	case ESceneCommand::ROUGHNESS:
 	{
 		if (!bIsReadingMaterial || materialType != BRDF)
 		{
@@ -568,9 +666,10 @@ void Parser::ParseScene(Renderer* pRenderer, const std::vector<std::string>& com
 		//--------------------------------------------------------------
 		// roughness [0.0f, 1.0f]
 		//--------------------------------------------------------------
-		static_cast<BRDF_Material*>(pMaterial)->roughness = stof(command[1]);
+		static_cast<BRDF_Material*>(pMaterial)->roughness = ToFloat(command[1]);
 	}
-	else if (cmd == "metalness")
+	break;
+	case ESceneCommand::METALNESS:
 	{
 		if (!bIsReadingMaterial || materialType != BRDF)
 		{
@@ -581,9 +680,10 @@ void Parser::ParseScene(Renderer* pRenderer, const std::vector<std::string>& com
 		//--------------------------------------------------------------
 		// metalness [0.0f, 1.0f]
 		//--------------------------------------------------------------
-		static_cast<BRDF_Material*>(pMaterial)->metalness = stof(command[1]);
+		static_cast<BRDF_Material*>(pMaterial)->metalness = ToFloat(command[1]);
 	}
-	else if (cmd == "shininess")
+	break;
+	case ESceneCommand::SHININESS:
 	{
 		if (!bIsReadingMaterial || materialType != PHONG)
 		{
@@ -594,9 +694,10 @@ void Parser::ParseScene(Renderer* pRenderer, const std::vector<std::string>& com
 		//--------------------------------------------------------------
 		// shininess [0.04 - inf]
 		//--------------------------------------------------------------
-		static_cast<BlinnPhong_Material*>(pMaterial)->shininess = stof(command[1]);
+		static_cast<BlinnPhong_Material*>(pMaterial)->shininess = ToFloat(command[1]);
 	}
-	else if (cmd == "textures")
+	break;
+	case ESceneCommand::TEXTURES:
 	{
 		if (!bIsReadingMaterial)
 		{
@@ -608,16 +709,19 @@ void Parser::ParseScene(Renderer* pRenderer, const std::vector<std::string>& com
 		//--------------------------------------------------------------
 		// albedoMap normalMap
 		//--------------------------------------------------------------
+		SerializedMaterialTextures& textures = scene.GetMaterialTextures(pMaterial->ID);
 		if (command[1] != "\"\"")
 		{
-			const TextureID texDiffuse = pRenderer->CreateTextureFromFile(command[1]);
-			pMaterial->diffuseMap = texDiffuse;
+			textures.diffuseMap = std::string(command[1]);
+			if (pRenderer)	// otherwise parsing without creating the textures
+				pMaterial->diffuseMap = pRenderer->CreateTextureFromFile(textures.diffuseMap);
 		}
 
 		if (command.size() > 2)
 		{
-			const TextureID texNormal = pRenderer->CreateTextureFromFile(command[2]);
-			pMaterial->normalMap= texNormal;
+			textures.normalMap = std::string(command[2]);
+			if (pRenderer)
+				pMaterial->normalMap = pRenderer->CreateTextureFromFile(textures.normalMap);
 		}
 
 		if (command.size() > 3)
@@ -625,8 +729,9 @@ void Parser::ParseScene(Renderer* pRenderer, const std::vector<std::string>& com
 			// add various maps (specular etc)
 		}
 	}
+	break;
 
-	else if (cmd == "transform")
+	case ESceneCommand::TRANSFORM:
 	{
 		// #Parameters: 7-9
 		//--------------------------------------------------------------
@@ -639,32 +744,33 @@ void Parser::ParseScene(Renderer* pRenderer, const std::vector<std::string>& com
 		}
 		
 		Transform tf;
-		float x	= stof(command[1]);
-		float y = stof(command[2]);
-		float z = stof(command[3]);
+		float x	= ToFloat(command[1]);
+		float y = ToFloat(command[2]);
+		float z = ToFloat(command[3]);
 		tf.SetPosition(x, y, z);
 
-		float rotX = stof(command[4]);
-		float rotY = stof(command[5]);
-		float rotZ = stof(command[6]);
+		float rotX = ToFloat(command[4]);
+		float rotY = ToFloat(command[5]);
+		float rotZ = ToFloat(command[6]);
 		tf.RotateAroundGlobalXAxisDegrees(rotX);
 		tf.RotateAroundGlobalYAxisDegrees(rotY);
 		tf.RotateAroundGlobalZAxisDegrees(rotZ);
 
-		float sclX = stof(command[7]);
+		float sclX = ToFloat(command[7]);
 		if (command.size() <= 8)
 		{
 			tf.SetUniformScale(sclX);
 		}
 		else
 		{
-			float sclY = stof(command[8]);
-			float sclZ = stof(command[9]);
+			float sclY = ToFloat(command[8]);
+			float sclZ = ToFloat(command[9]);
 			tf.SetScale(sclX, sclY, sclZ);
 		}
 		pObject->SetTransform(tf);
 	}
-	else if (cmd == "model")
+	break;
+	case ESceneCommand::MODEL:
 	{
 		if (!bIsReadingGameObject)
 		{
@@ -675,37 +781,241 @@ void Parser::ParseScene(Renderer* pRenderer, const std::vector<std::string>& com
 		Model m;
 		m.mbLoaded = false;
 		m.mModelDirectory = "";
-		m.mModelName = command[1];
+		m.mModelName = std::string(command[1]);
 		pObject->SetModel(m);
 	}
-	else if (cmd == "ao")
+	break;
+	case ESceneCommand::AMBIENT_OCCLUSION:
 	{
 		Settings::SSAO& ssao = scene.settings.ssao;
 		ssao.bEnabled		= sBoolTypeReflection.at(command[1]); 
-		ssao.ambientFactor	= stof(command[2]);
-		ssao.radius			= command.size() > 3 ? stof(command[3]) : 7.0f;	// 7 units - arbitrary.
-		ssao.intensity		= command.size() > 4 ? stof(command[4]) : 1.0f;
+		ssao.ambientFactor	= ToFloat(command[2]);
+		ssao.radius			= command.size() > 3 ? ToFloat(command[3]) : 7.0f;	// 7 units - arbitrary.
+		ssao.intensity		= command.size() > 4 ? ToFloat(command[4]) : 1.0f;
 	}
-	else if (cmd == "skylight")
+	break;
+	case ESceneCommand::SKYLIGHT:
 	{
 		scene.settings.bSkylightEnabled= sBoolTypeReflection.at(command[1]);
 	}
+	break;
 
 	// Parameters
 	//---------------------------------------------------------------
 	// | Bloom Threshold | BlurPassCount
 	//---------------------------------------------------------------
-	else if (cmd == "bloom")
+	case ESceneCommand::BLOOM:
 	{
 		Settings::Bloom& bloom = scene.settings.bloom;
 	
 		bloom.bEnabled = sBoolTypeReflection.at(GetLowercased(command[1]));
-		bloom.brightnessThreshold = command.size() > 2 ? stof(command[2]) : 1.5f;
-		bloom.blurStrength = command.size() > 3 ? stoi(command[3]) : 3;	// 3 default blur stregth;
-		// bloom.blurPassCount = stoi(command[3]);	// in case bloom settings should be more flexible
+		bloom.brightnessThreshold = command.size() > 2 ? ToFloat(command[2]) : 1.5f;
+		bloom.blurStrength = command.size() > 3 ? ToInt(command[3]) : 3;	// 3 default blur stregth;
+		// bloom.blurPassCount = ToInt(command[3]);	// in case bloom settings should be more flexible
 	}
-	else
+	break;
+	default:
 	{
-		Log::Error("Parser: Unknown command \"%s\"", cmd.c_str());
+		Log::Error("Parser: Unknown command \"%s\"", std::string(cmd).c_str());
+	}
+	break;
+	}
+}
+
+
+//----------------------------------------------------------------------------------------------------------------
+// BENCHMARK
+//----------------------------------------------------------------------------------------------------------------
+using Clock = std::chrono::high_resolution_clock;
+static inline float GetElapsedMs(const Clock::time_point& start) { return std::chrono::duration<float, std::milli>(Clock::now() - start).count(); }
+
+// what the parser gets out of a scene file before it starts creating objects
+struct TokenizedScene
+{
+	int      numLines = 0;
+	int      numTokens = 0;
+	int      numNumbers = 0;
+	uint64_t checksum = HASH_SEED;	// of the tokens and the bits of the numbers
+
+	inline void AddToken(const char* pToken, size_t length) { ++numTokens; checksum = HashBytes(pToken, length, checksum); }
+	inline void AddNumber(float number) { ++numNumbers; checksum = HashValue(number, checksum); }
+	inline bool operator==(const TokenizedScene& other) const { return numLines == other.numLines && numTokens == other.numTokens && numNumbers == other.numNumbers && checksum == other.checksum; }
+};
+
+static TokenizedScene TokenizeScene_Legacy(const std::string& filePath)
+{
+	TokenizedScene result;
+	std::ifstream sceneFile(filePath.c_str());
+	std::string line;
+	while (getline(sceneFile, line))
+	{
+		if (line[0] == '/' || line[0] == '#' || line[0] == '\0')
+			continue;
+
+		++result.numLines;
+		const std::vector<std::string> command = StrUtil::split(line, ' ', '\t');
+		for (const std::string& token : command)
+		{
+			result.AddToken(token.c_str(), token.size());
+			char* pEnd = nullptr;
+			const float number = strtof(token.c_str(), &pEnd);	// stof() without the exception on non-numbers
+			if (pEnd != token.c_str())
+				result.AddNumber(number);
+		}
+	}
+	return result;
+}
+
+static TokenizedScene TokenizeScene(const std::string& filePath)
+{
+	TokenizedScene result;
+	Tokenizer sceneFile;
+	if (!sceneFile.Open(filePath))
+		return result;
+
+	std::string_view line;
+	std::vector<std::string_view> command;
+	while (sceneFile.NextLine(line))
+	{
+		if (line.empty() || line[0] == '/' || line[0] == '#')
+			continue;
+
+		++result.numLines;
+		Tokenizer::Split(line, " \t", command);
+		for (const std::string_view& token : command)
+		{
+			result.AddToken(token.data(), token.size());
+			float number = 0.0f;
+			if (Tokenizer::ParseFloat(token, number))
+				result.AddNumber(number);
+		}
+	}
+	return result;
+}
+
+bool Parser::WriteSyntheticScene(const std::string& filePath, int numObjects)
+{
+	DirectoryUtil::CreateFolderIfItDoesntExist(DirectoryUtil::GetFolderPath(filePath));
+	std::ofstream file(filePath, std::ios::trunc);
+	if (!file.is_open())
+	{
+		Log::Error("Parser: Couldn't open %s for writing.", filePath.c_str());
+		return false;
+	}
+
+	// ReadSceneFile() creates the materials from a fixed size pool, only the first objects get one
+	constexpr int NUM_OBJECTS_WITH_MATERIAL = 2048;
+	constexpr int NUM_LIGHTS = 64;
+	static const char* sMeshes[] = { "cube", "sphere", "cylinder", "grid", "quad", "triangle" };
+	static const char* sColors[] = { "white", "orange", "sun", "cyan", "light_gray" };
+
+	std::mt19937 rng(numObjects);
+	std::uniform_real_distribution<float> position(-500.0f, 500.0f), angle(0.0f, 360.0f), scale(0.5f, 20.0f), unit(0.0f, 1.0f);
+
+	file << "// synthetic scene: " << numObjects << " objects\n\n";
+	file << "ao true 0.23 17.0 3.40\n";
+	file << "skylight true\n";
+	file << "bloom true 1.22 8\n";
+	file << "directional sun 4.5   3   -5   15  2048 256 300 0.001f\n";
+	file << "camera 0.1 1500 60   -186.23 32.21 5.10  90 -5\n\n";
+	for (int i = 0; i < NUM_LIGHTS; ++i)
+	{
+		file << "light p " << sColors[i % _countof(sColors)] << " false " << 100.0f + 400.0f * unit(rng)
+			<< "\t" << position(rng) << " " << 0.2f * position(rng) << " " << position(rng)
+			<< "\t" << 50.0f + 200.0f * unit(rng) << "\t0 0 0 1\n";
+	}
+
+	for (int i = 0; i < numObjects; ++i)
+	{
+		file << "\nobject begin\n";
+		file << "\ttransform " << position(rng) << " " << position(rng) << " " << position(rng)
+			<< "  " << angle(rng) << " " << angle(rng) << " " << angle(rng) << "  " << scale(rng);
+		if (i % 2)	// non-uniform scale
+			file << " " << scale(rng) << " " << scale(rng);
+		file << "\n\tmesh " << sMeshes[i % _countof(sMeshes)] << "\n";
+		if (i < NUM_OBJECTS_WITH_MATERIAL)
+		{
+			file << "\tbrdf begin\n";
+			file << "\t\tdiffuse " << unit(rng) << " " << unit(rng) << " " << unit(rng) << "\n";
+			file << "\t\troughness " << unit(rng) << "\n";
+			file << "\t\tmetalness " << unit(rng) << "\n";
+			file << "\tbrdf end\n";
+		}
+		file << "object end\n";
+	}
+	return file.good();
+}
+
+void Parser::BenchmarkSceneParsing(const std::vector<std::string>& sceneFilePaths)
+{
+	constexpr int NUM_ITERATIONS = 3;	// best of
+	for (const std::string& filePath : sceneFilePaths)
+	{
+		if (!DirectoryUtil::FileExists(filePath))
+		{
+			Log::Error("Parser benchmark: Couldn't find %s", filePath.c_str());
+			continue;
+		}
+
+		float timeLegacyMs = 1e9f, timeTokenizerMs = 1e9f, timeReadSceneMs = 1e9f;
+		TokenizedScene legacy, tokenized;
+		size_t numObjects = 0;
+		for (int i = 0; i < NUM_ITERATIONS; ++i)
+		{
+			Clock::time_point start = Clock::now();
+			legacy = TokenizeScene_Legacy(filePath);
+			timeLegacyMs = std::min(timeLegacyMs, GetElapsedMs(start));
+
+			start = Clock::now();
+			tokenized = TokenizeScene(filePath);
+			timeTokenizerMs = std::min(timeTokenizerMs, GetElapsedMs(start));
+
+			start = Clock::now();
+			const SerializedScene scene = ReadSceneFile(nullptr, filePath);
+			timeReadSceneMs = std::min(timeReadSceneMs, GetElapsedMs(start));
+			numObjects = scene.objects.size();
+		}
+
+		// compiled scene: written from the parsed scene, read back and serialized again to check the round trip
+		const std::string compiledFilePath = CompiledScene::GetFilePath(filePath);
+		const uint64_t sourceKey = CompiledScene::GetSourceKey(filePath);
+		std::vector<char> compiledData, roundTripData;
+		{
+			const SerializedScene scene = ReadSceneFile(nullptr, filePath);
+			CompiledScene::Serialize(scene, sourceKey, compiledData);
+			if (!CompiledScene::Write(compiledFilePath, scene, sourceKey))
+				continue;
+		}
+		float timeReadCompiledMs = 1e9f;
+		for (int i = 0; i < NUM_ITERATIONS; ++i)
+		{
+			SerializedScene scene;
+			const Clock::time_point start = Clock::now();
+			const bool bRead = CompiledScene::Read(compiledFilePath, sourceKey, nullptr, scene);
+			timeReadCompiledMs = std::min(timeReadCompiledMs, GetElapsedMs(start));
+			if (bRead && i == 0)
+				CompiledScene::Serialize(scene, sourceKey, roundTripData);
+		}
+
+		Log::Info("Parser benchmark: %s | %d lines, %d tokens, %d numbers | getline+split+strtof: %.2f ms | Tokenizer: %.2f ms (%.1fx) | ReadSceneFile(): %.2f ms, %zu objects | %s"
+			, DirectoryUtil::GetFileNameFromPath(filePath).c_str()
+			, tokenized.numLines, tokenized.numTokens, tokenized.numNumbers
+			, timeLegacyMs
+			, timeTokenizerMs, timeTokenizerMs > 0.0f ? timeLegacyMs / timeTokenizerMs : 0.0f
+			, timeReadSceneMs, numObjects
+			, legacy == tokenized ? "identical" : "MISMATCH"
+		);
+		if (!(legacy == tokenized))
+		{
+			Log::Error("Parser benchmark: Tokenizer output differs from getline+split+strtof for %s (%d/%d tokens, %d/%d numbers)"
+				, filePath.c_str(), tokenized.numTokens, legacy.numTokens, tokenized.numNumbers, legacy.numNumbers);
+		}
+		Log::Info("Parser benchmark: %s | compiled scene: %.1f KB | ReadSceneFile(): %.2f ms | CompiledScene::Read(): %.2f ms (%.1fx) | round trip %s"
+			, DirectoryUtil::GetFileNameFromPath(filePath).c_str()
+			, compiledData.size() / 1024.0f
+			, timeReadSceneMs
+			, timeReadCompiledMs, timeReadCompiledMs > 0.0f ? timeReadSceneMs / timeReadCompiledMs : 0.0f
+			, compiledData == roundTripData ? "identical" : "MISMATCH"
+		);
 	}
 }
@@ -0,0 +1,70 @@
+//	VQEngine | DirectX11 Renderer
+//	Copyright(C) 2018  - Volkan Ilbeyli
+//
+//	This program is free software : you can redistribute it and / or modify
+//	it under the terms of the GNU General Public License as published by
+//	the Free Software Foundation, either version 3 of the License, or
+//	(at your option) any later version.
+//
+//	This program is distributed in the hope that it will be useful,
+//	but WITHOUT ANY WARRANTY; without even the implied warranty of
+//	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+//	GNU General Public License for more details.
+//
+//	You should have received a copy of the GNU General Public License
+//	along with this program.If not, see <http://www.gnu.org/licenses/>.
+//
+//	Contact: volkanilbeyli@gmail.com
+
+#include "MappedFile.h"
+#include "Log.h"
+
+#include <windows.h>
+
+MappedFile::~MappedFile()
+{
+	Close();
+}
+
+bool MappedFile::Open(const std::string& filePath)
+{
+	Close();
+
+	HANDLE hFile = CreateFile(filePath.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+	if (hFile == INVALID_HANDLE_VALUE)
+		return false;
+	mhFile = hFile;
+
+	LARGE_INTEGER fileSize;
+	if (!GetFileSizeEx(hFile, &fileSize))
+	{
+		Log::Warning("MappedFile: Couldn't get the size of %s.", filePath.c_str());
+		Close();
+		return false;
+	}
+
+	mSize = static_cast<size_t>(fileSize.QuadPart);
+	if (mSize == 0)
+		return true;
+
+	mhMapping = CreateFileMapping(hFile, NULL, PAGE_READONLY, 0, 0, NULL);
+	mpData = mhMapping ? MapViewOfFile(mhMapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+	if (!mpData)
+	{
+		Log::Warning("MappedFile: Couldn't map %s into memory.", filePath.c_str());
+		Close();
+		return false;
+	}
+	return true;
+}
+
+void MappedFile::Close()
+{
+	if (mpData)    UnmapViewOfFile(mpData);
+	if (mhMapping) CloseHandle(static_cast<HANDLE>(mhMapping));
+	if (mhFile)    CloseHandle(static_cast<HANDLE>(mhFile));
+	mpData = nullptr;
+	mhMapping = nullptr;
+	mhFile = nullptr;
+	mSize = 0;
+}
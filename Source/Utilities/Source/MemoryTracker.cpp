@@ -0,0 +1,232 @@
+//	VQEngine | DirectX11 Renderer
+//	Copyright(C) 2018  - Volkan Ilbeyli
+//
+//	This program is free software : you can redistribute it and / or modify
+//	it under the terms of the GNU General Public License as published by
+//	the Free Software Foundation, either version 3 of the License, or
+//	(at your option) any later version.
+//
+//	This program is distributed in the hope that it will be useful,
+//	but WITHOUT ANY WARRANTY; without even the implied warranty of
+//	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+//	GNU General Public License for more details.
+//
+//	You should have received a copy of the GNU General Public License
+//	along with this program.If not, see <http://www.gnu.org/licenses/>.
+//
+//	Contact: volkanilbeyli@gmail.com
+
+#include "MemoryTracker.h"
+#include "Log.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <malloc.h>
+#include <new>
+#include <sstream>
+
+namespace
+{
+	// placed right before the pointer returned by operator new
+	struct AllocationHeader
+	{
+		uint64_t   size;
+		EMemoryTag tag;
+		bool       bTracked;	// counted when it was allocated, counted again when it's freed
+		uint8_t    padding[6];
+	};
+	static_assert(sizeof(AllocationHeader) == 16, "The header shouldn't change the alignment of the blocks");
+
+	// written by a single thread, kept on their own cache lines
+	struct alignas(64) ThreadCounters
+	{
+		std::atomic<uint64_t> numAllocations;
+		std::atomic<uint64_t> numFrees;
+		std::atomic<uint64_t> numAllocatedBytes;
+	};
+
+	constexpr size_t DEFAULT_ALIGNMENT = __STDCPP_DEFAULT_NEW_ALIGNMENT__;
+	constexpr size_t MAX_THREAD_COUNTERS = 256;	// the threads beyond this share the last counters
+	constexpr size_t TAG_COUNT = static_cast<size_t>(EMemoryTag::COUNT);
+
+	// no constructors to run: these are zero initialized before the first allocation of the program
+	ThreadCounters        sThreadCounters[MAX_THREAD_COUNTERS];
+	std::atomic<uint32_t> sNumThreadCounters;
+	std::atomic<bool>     sbEnabled;
+
+	std::atomic<int64_t>  sTagCurrentBytes[TAG_COUNT];
+	std::atomic<int64_t>  sTagPeakBytes[TAG_COUNT];
+	std::atomic<uint64_t> sTagNumAllocations[TAG_COUNT];
+
+	thread_local ThreadCounters* tpThreadCounters = nullptr;
+	thread_local EMemoryTag      tThreadTag = EMemoryTag::UNTAGGED;
+
+	ThreadCounters& GetCallingThreadCounters()
+	{
+		if (!tpThreadCounters)
+		{
+			const uint32_t index = sNumThreadCounters.fetch_add(1, std::memory_order_relaxed);
+			tpThreadCounters = &sThreadCounters[index < MAX_THREAD_COUNTERS ? index : MAX_THREAD_COUNTERS - 1];
+		}
+		return *tpThreadCounters;
+	}
+
+	inline size_t GetHeaderOffset(size_t alignment) { return alignment > sizeof(AllocationHeader) ? alignment : sizeof(AllocationHeader); }
+
+	void* Allocate(size_t size, size_t alignment)
+	{
+		const size_t headerOffset = GetHeaderOffset(alignment);
+		char* pBlock = static_cast<char*>(alignment > DEFAULT_ALIGNMENT
+			? _aligned_malloc(size + headerOffset, alignment)
+			: malloc(size + headerOffset));
+		if (!pBlock)
+			return nullptr;
+
+		AllocationHeader* pHeader = reinterpret_cast<AllocationHeader*>(pBlock + headerOffset) - 1;
+		pHeader->size = size;
+		pHeader->tag = tThreadTag;
+		pHeader->bTracked = sbEnabled.load(std::memory_order_relaxed);
+		if (pHeader->bTracked)
+		{
+			ThreadCounters& counters = GetCallingThreadCounters();
+			counters.numAllocations.fetch_add(1, std::memory_order_relaxed);
+			counters.numAllocatedBytes.fetch_add(size, std::memory_order_relaxed);
+
+			const size_t tag = static_cast<size_t>(pHeader->tag);
+			sTagNumAllocations[tag].fetch_add(1, std::memory_order_relaxed);
+			const int64_t currentBytes = sTagCurrentBytes[tag].fetch_add(size, std::memory_order_relaxed) + static_cast<int64_t>(size);
+			int64_t peakBytes = sTagPeakBytes[tag].load(std::memory_order_relaxed);
+			while (currentBytes > peakBytes && !sTagPeakBytes[tag].compare_exchange_weak(peakBytes, currentBytes, std::memory_order_relaxed)) {}
+		}
+		return pHeader + 1;
+	}
+
+	void* AllocateOrAbort(size_t size, size_t alignment)
+	{
+		void* p = Allocate(size, alignment);
+		if (!p)
+		{	// exceptions are disabled (_HAS_EXCEPTIONS=0), there's no std::bad_alloc to throw
+			std::abort();
+		}
+		return p;
+	}
+
+	void Deallocate(void* p, size_t alignment)
+	{
+		if (!p)
+			return;
+
+		const AllocationHeader* pHeader = static_cast<const AllocationHeader*>(p) - 1;
+		if (pHeader->bTracked)
+		{
+			GetCallingThreadCounters().numFrees.fetch_add(1, std::memory_order_relaxed);
+			sTagCurrentBytes[static_cast<size_t>(pHeader->tag)].fetch_sub(pHeader->size, std::memory_order_relaxed);
+		}
+
+		char* pBlock = static_cast<char*>(p) - GetHeaderOffset(alignment);
+		if (alignment > DEFAULT_ALIGNMENT)	_aligned_free(pBlock);
+		else								free(pBlock);
+	}
+}
+
+//----------------------------------------------------------------------------------------------------------------
+// GLOBAL OPERATOR NEW / DELETE
+//----------------------------------------------------------------------------------------------------------------
+// Utilities is a static library: the linker takes these over the CRT versions as long as this object file is
+// linked in, which the MemoryTracker calls of the executables take care of.
+void* operator new  (size_t size)                                                    { return AllocateOrAbort(size, DEFAULT_ALIGNMENT); }
+void* operator new[](size_t size)                                                    { return AllocateOrAbort(size, DEFAULT_ALIGNMENT); }
+void* operator new  (size_t size, const std::nothrow_t&) noexcept                    { return Allocate(size, DEFAULT_ALIGNMENT); }
+void* operator new[](size_t size, const std::nothrow_t&) noexcept                    { return Allocate(size, DEFAULT_ALIGNMENT); }
+void* operator new  (size_t size, std::align_val_t al)                               { return AllocateOrAbort(size, static_cast<size_t>(al)); }
+void* operator new[](size_t size, std::align_val_t al)                               { return AllocateOrAbort(size, static_cast<size_t>(al)); }
+void* operator new  (size_t size, std::align_val_t al, const std::nothrow_t&) noexcept { return Allocate(size, static_cast<size_t>(al)); }
+void* operator new[](size_t size, std::align_val_t al, const std::nothrow_t&) noexcept { return Allocate(size, static_cast<size_t>(al)); }
+
+void operator delete  (void* p) noexcept                                             { Deallocate(p, DEFAULT_ALIGNMENT); }
+void operator delete[](void* p) noexcept                                             { Deallocate(p, DEFAULT_ALIGNMENT); }
+void operator delete  (void* p, size_t) noexcept                                     { Deallocate(p, DEFAULT_ALIGNMENT); }
+void operator delete[](void* p, size_t) noexcept                                     { Deallocate(p, DEFAULT_ALIGNMENT); }
+void operator delete  (void* p, const std::nothrow_t&) noexcept                      { Deallocate(p, DEFAULT_ALIGNMENT); }
+void operator delete[](void* p, const std::nothrow_t&) noexcept                      { Deallocate(p, DEFAULT_ALIGNMENT); }
+void operator delete  (void* p, std::align_val_t al) noexcept                        { Deallocate(p, static_cast<size_t>(al)); }
+void operator delete[](void* p, std::align_val_t al) noexcept                        { Deallocate(p, static_cast<size_t>(al)); }
+void operator delete  (void* p, size_t, std::align_val_t al) noexcept                { Deallocate(p, static_cast<size_t>(al)); }
+void operator delete[](void* p, size_t, std::align_val_t al) noexcept                { Deallocate(p, static_cast<size_t>(al)); }
+void operator delete  (void* p, std::align_val_t al, const std::nothrow_t&) noexcept { Deallocate(p, static_cast<size_t>(al)); }
+void operator delete[](void* p, std::align_val_t al, const std::nothrow_t&) noexcept { Deallocate(p, static_cast<size_t>(al)); }
+
+
+//----------------------------------------------------------------------------------------------------------------
+// MEMORY TRACKER
+//----------------------------------------------------------------------------------------------------------------
+MemoryTracker::TagScope::TagScope(EMemoryTag tag)
+	: mPrevTag(tThreadTag)
+{
+	tThreadTag = tag;
+}
+
+MemoryTracker::TagScope::~TagScope()
+{
+	tThreadTag = mPrevTag;
+}
+
+void MemoryTracker::SetEnabled(bool bEnable) { sbEnabled.store(bEnable, std::memory_order_relaxed); }
+bool MemoryTracker::IsEnabled() { return sbEnabled.load(std::memory_order_relaxed); }
+EMemoryTag MemoryTracker::GetThreadTag() { return tThreadTag; }
+
+const char* MemoryTracker::GetTagName(EMemoryTag tag)
+{
+	static const char* TAG_NAMES[TAG_COUNT] = { "Untagged", "Scene", "Renderer", "Loader", "Profiler" };
+	return tag < EMemoryTag::COUNT ? TAG_NAMES[static_cast<size_t>(tag)] : "Unknown";
+}
+
+MemoryTracker::Counters MemoryTracker::GetCounters()
+{
+	Counters total = {};
+	const uint32_t numThreadCounters = sNumThreadCounters.load(std::memory_order_relaxed);
+	for (uint32_t i = 0; i < numThreadCounters && i < MAX_THREAD_COUNTERS; ++i)
+	{
+		total.numAllocations    += sThreadCounters[i].numAllocations.load(std::memory_order_relaxed);
+		total.numFrees          += sThreadCounters[i].numFrees.load(std::memory_order_relaxed);
+		total.numAllocatedBytes += sThreadCounters[i].numAllocatedBytes.load(std::memory_order_relaxed);
+	}
+	return total;
+}
+
+MemoryTracker::Counters MemoryTracker::GetThreadCounters()
+{
+	const ThreadCounters& counters = GetCallingThreadCounters();
+	Counters result;
+	result.numAllocations    = counters.numAllocations.load(std::memory_order_relaxed);
+	result.numFrees          = counters.numFrees.load(std::memory_order_relaxed);
+	result.numAllocatedBytes = counters.numAllocatedBytes.load(std::memory_order_relaxed);
+	return result;
+}
+
+MemoryTracker::TagStats MemoryTracker::GetTagStats(EMemoryTag tag)
+{
+	const size_t i = static_cast<size_t>(tag);
+	TagStats stats;
+	stats.currentBytes   = sTagCurrentBytes[i].load(std::memory_order_relaxed);
+	stats.peakBytes      = sTagPeakBytes[i].load(std::memory_order_relaxed);
+	stats.numAllocations = sTagNumAllocations[i].load(std::memory_order_relaxed);
+	return stats;
+}
+
+void MemoryTracker::LogStats()
+{
+	const Counters counters = GetCounters();
+	std::ostringstream info;
+	info.precision(2);
+	info << std::fixed;
+	info << "MemoryTracker: " << counters.numAllocations << " allocations (" << counters.numAllocatedBytes / (1024.0 * 1024.0) << " MB), "
+		<< counters.numFrees << " frees | current / peak KB, allocations per tag:";
+	for (size_t i = 0; i < TAG_COUNT; ++i)
+	{
+		const TagStats stats = GetTagStats(static_cast<EMemoryTag>(i));
+		info << "\n  " << GetTagName(static_cast<EMemoryTag>(i)) << ": "
+			<< stats.currentBytes / 1024.0 << " / " << stats.peakBytes / 1024.0 << "  [" << stats.numAllocations << "]";
+	}
+	Log::Info(info.str());
+}
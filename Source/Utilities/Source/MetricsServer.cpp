@@ -0,0 +1,258 @@
+//	VQEngine | DirectX11 Renderer
+//	Copyright(C) 2018  - Volkan Ilbeyli
+//
+//	This program is free software : you can redistribute it and / or modify
+//	it under the terms of the GNU General Public License as published by
+//	the Free Software Foundation, either version 3 of the License, or
+//	(at your option) any later version.
+//
+//	This program is distributed in the hope that it will be useful,
+//	but WITHOUT ANY WARRANTY; without even the implied warranty of
+//	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+//	GNU General Public License for more details.
+//
+//	You should have received a copy of the GNU General Public License
+//	along with this program.If not, see <http://www.gnu.org/licenses/>.
+//
+//	Contact: volkanilbeyli@gmail.com
+
+// winsock2 has to come before windows.h, which the profiler headers include
+#define NOMINMAX
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#pragma comment(lib, "Ws2_32.lib")
+
+#include "MetricsServer.h"
+#include "Log.h"
+#include "MemoryTracker.h"
+
+#include <algorithm>
+#include <climits>
+#include <cstdio>
+#include <cstring>
+
+static constexpr DWORD CLIENT_SEND_TIMEOUT_MS = 1000;	// a client that doesn't read for this long is disconnected
+static constexpr int   MAX_VALUE_LENGTH = 128;
+
+// counter and scope names are written as JSON keys, w/o the trailing " : " of the on-screen stat names
+static void AppendJSONKey(std::string& str, const char* pName)
+{
+	const char* pEnd = pName + strlen(pName);
+	while (pEnd > pName && (pEnd[-1] == ' ' || pEnd[-1] == ':'))
+		--pEnd;
+
+	str += '"';
+	for (const char* p = pName; p < pEnd; ++p)
+	{
+		if (*p == '"' || *p == '\\') str += '\\';
+		if (static_cast<unsigned char>(*p) >= 0x20) str += *p;
+	}
+	str += "\":";
+}
+
+MetricsServer::~MetricsServer()
+{
+	Stop();
+}
+
+bool MetricsServer::Start(unsigned short port)
+{
+	if (mServerThread.joinable())
+	{
+		Log::Warning("MetricsServer: already listening on port %d", mPort);
+		return false;
+	}
+
+	WSADATA wsaData;
+	if (WSAStartup(MAKEWORD(2, 2), &wsaData) != 0)
+	{
+		Log::Error("MetricsServer: WSAStartup() failed");
+		return false;
+	}
+
+	SOCKET listenSocket = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+	if (listenSocket == INVALID_SOCKET)
+	{
+		Log::Error("MetricsServer: can't create the socket: %d", WSAGetLastError());
+		WSACleanup();
+		return false;
+	}
+
+	sockaddr_in address = {};
+	address.sin_family = AF_INET;
+	address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	address.sin_port = htons(port);
+	u_long bNonBlocking = 1;	// accept() is polled by the server thread
+	if (bind(listenSocket, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) == SOCKET_ERROR
+		|| listen(listenSocket, SOMAXCONN) == SOCKET_ERROR
+		|| ioctlsocket(listenSocket, FIONBIO, &bNonBlocking) == SOCKET_ERROR)
+	{
+		Log::Error("MetricsServer: can't listen on port %d: %d", port, WSAGetLastError());
+		closesocket(listenSocket);
+		WSACleanup();
+		return false;
+	}
+
+	mListenSocket = static_cast<Socket_t>(listenSocket);
+	mPort = port;
+	mbStop = false;
+	mServerThread = std::thread(&MetricsServer::ServerThread, this);
+	Log::Info("MetricsServer: publishing the frame metrics on 127.0.0.1:%d", port);
+	return true;
+}
+
+void MetricsServer::Stop()
+{
+	if (!mServerThread.joinable())
+		return;
+
+	{
+		std::unique_lock<std::mutex> lock(mMutex);
+		mbStop = true;
+	}
+	mSignal.notify_one();
+	mServerThread.join();
+
+	for (Socket_t clientSocket : mClientSockets)
+	{
+		closesocket(static_cast<SOCKET>(clientSocket));
+	}
+	mClientSockets.clear();
+	mNumClients = 0;
+	closesocket(static_cast<SOCKET>(mListenSocket));
+	mListenSocket = static_cast<Socket_t>(INVALID_SOCKET);
+	WSACleanup();
+
+	const uint64_t numDroppedFrames = mNumDroppedFrames.load();
+	if (numDroppedFrames > 0)
+	{
+		Log::Warning("MetricsServer: %llu frames were dropped by slow clients", static_cast<unsigned long long>(numDroppedFrames));
+	}
+}
+
+void MetricsServer::Publish(Frame&& frame)
+{
+	if (!HasClients())
+		return;
+
+	{
+		std::unique_lock<std::mutex> lock(mMutex);
+		if (mFrameQueue.size() >= MAX_QUEUED_FRAMES)
+		{	// never wait for the server thread
+			mNumDroppedFrames.fetch_add(1, std::memory_order_relaxed);
+			return;
+		}
+		mFrameQueue.push_back(std::move(frame));
+	}
+	mSignal.notify_one();
+}
+
+void MetricsServer::ServerThread()
+{
+	CPUProfiler::SetThreadName("Metrics Server");
+	MemoryTracker::TagScope memoryTag(EMemoryTag::PROFILER);
+
+	constexpr auto CONNECTION_POLL_INTERVAL = std::chrono::milliseconds(100);
+	std::deque<Frame> frames;
+	std::string lines;
+	while (true)
+	{
+		{
+			std::unique_lock<std::mutex> lock(mMutex);
+			mSignal.wait_for(lock, CONNECTION_POLL_INTERVAL, [&]() { return mbStop || !mFrameQueue.empty(); });
+			if (mbStop)
+				break;
+			frames.swap(mFrameQueue);
+		}
+
+		AcceptClients();
+		if (frames.empty())
+			continue;
+
+		lines.clear();
+		for (const Frame& frame : frames)
+		{
+			FormatFrame(frame, lines);
+		}
+		frames.clear();
+		SendToClients(lines);
+	}
+}
+
+void MetricsServer::AcceptClients()
+{
+	while (true)
+	{
+		const SOCKET clientSocket = accept(static_cast<SOCKET>(mListenSocket), nullptr, nullptr);
+		if (clientSocket == INVALID_SOCKET)
+			break;	// WSAEWOULDBLOCK: no pending connections
+
+		// accepted sockets inherit the non-blocking mode of the listening socket. The client sockets block
+		// the server thread, not the frame, and the send timeout disconnects the clients that stopped reading.
+		u_long bNonBlocking = 0;
+		ioctlsocket(clientSocket, FIONBIO, &bNonBlocking);
+		setsockopt(clientSocket, SOL_SOCKET, SO_SNDTIMEO, reinterpret_cast<const char*>(&CLIENT_SEND_TIMEOUT_MS), sizeof(CLIENT_SEND_TIMEOUT_MS));
+
+		mClientSockets.push_back(static_cast<Socket_t>(clientSocket));
+		mNumClients = static_cast<int>(mClientSockets.size());
+		Log::Info("MetricsServer: client connected (%d)", static_cast<int>(mClientSockets.size()));
+	}
+}
+
+void MetricsServer::SendToClients(const std::string& lines)
+{
+	auto SendAll = [&](SOCKET clientSocket) -> bool
+	{
+		size_t numSentBytes = 0;
+		while (numSentBytes < lines.size())
+		{
+			const int numBytes = static_cast<int>(std::min<size_t>(lines.size() - numSentBytes, INT_MAX));
+			const int result = send(clientSocket, lines.data() + numSentBytes, numBytes, 0);
+			if (result == SOCKET_ERROR)
+				return false;
+			numSentBytes += result;
+		}
+		return true;
+	};
+
+	const size_t numClients = mClientSockets.size();
+	mClientSockets.erase(std::remove_if(mClientSockets.begin(), mClientSockets.end(), [&](Socket_t clientSocket)
+	{
+		if (SendAll(static_cast<SOCKET>(clientSocket)))
+			return false;
+		closesocket(static_cast<SOCKET>(clientSocket));
+		return true;
+	}), mClientSockets.end());
+
+	if (mClientSockets.size() != numClients)
+	{
+		mNumClients = static_cast<int>(mClientSockets.size());
+		Log::Info("MetricsServer: client disconnected (%d)", static_cast<int>(mClientSockets.size()));
+	}
+}
+
+void MetricsServer::FormatFrame(const Frame& frame, std::string& lines) const
+{
+	char value[MAX_VALUE_LENGTH];
+	sprintf_s(value, "{\"frame\":%llu,\"frame_ms\":%.3f,\"dropped\":%llu,\"counters\":{"
+		, frame.frameIndex, frame.frameTimeMs, static_cast<unsigned long long>(mNumDroppedFrames.load(std::memory_order_relaxed)));
+	lines += value;
+
+	for (size_t i = 0; i < frame.counters.size(); ++i)
+	{
+		if (i > 0) lines += ',';
+		AppendJSONKey(lines, frame.counters[i].pName);
+		sprintf_s(value, "%d", frame.counters[i].value);
+		lines += value;
+	}
+
+	lines += "},\"scopes_ms\":{";
+	for (size_t i = 0; i < frame.scopeTimes.size(); ++i)
+	{
+		if (i > 0) lines += ',';
+		AppendJSONKey(lines, CPUProfiler::GetScopeName(frame.scopeTimes[i].scopeID).c_str());
+		sprintf_s(value, "%.3f", frame.scopeTimes[i].timeMs);
+		lines += value;
+	}
+	lines += "}}\n";
+}
@@ -17,179 +17,57 @@
 //	Contact: volkanilbeyli@gmail.com
 
 #include "PerfTimer.h"
+#include "Log.h"
 
-#ifdef FRANK_LUNA_TIMER
-#include <Windows.h>
-
+#include <cmath>
 #include <string>
 
-PerfTimer::PerfTimer()
-	:
-	m_secPerCount(0),
-	m_dt(-1),
-	m_baseTime(0),
-	m_pausedTime(0),
-	m_prevTime(0),
-	m_currTime(0),
-	m_stopped(false)
-{
-	__int64 countsPerSec;	// use this data type for querying - otherwise stack corruption!
-	QueryPerformanceFrequency((LARGE_INTEGER*)&countsPerSec);
-	m_secPerCount = 1.0 / (double)(countsPerSec);
-}
-
-
-PerfTimer::~PerfTimer()
-{}
-
-
-float PerfTimer::DeltaTime() const
-{
-	return static_cast<float>(m_dt);
-}
-
-// todo: implement
-float PerfTimer::GetPausedTime() const { assert(false); }
-float PerfTimer::GetStopDuration() const {assert(false); }
-
-void PerfTimer::Reset()
-{
-	__int64 currTime;
-	QueryPerformanceCounter((LARGE_INTEGER*)&currTime);
-
-	m_baseTime = currTime;
-	m_prevTime = currTime;
-	m_stopTime = 0;
-	m_stopped = false;
-}
-
-// accumulates paused time & starts the timer
-void PerfTimer::Start()
-{
-	__int64 startTime;
-	QueryPerformanceCounter((LARGE_INTEGER*)&startTime);
-
-	if (m_stopped)
-	{
-		m_pausedTime = (startTime - m_stopTime);
-		m_prevTime = startTime;
-		m_stopTime = 0;
-		m_stopped = false;
-	}
-}
-
-// stops the timer
-void PerfTimer::Stop()
-{
-	if (!m_stopped)
-	{
-		__int64 currTime;
-		QueryPerformanceCounter((LARGE_INTEGER*)&currTime);
-
-		m_stopTime = currTime;
-		m_stopped = true;
-	}
-}
-
-// returns time elapsed since Reset(), not counting paused time in between
-float PerfTimer::TotalTime() const
-{
-	long timeLength = 0;
-	if (m_stopped)
-	{
-		//					TIME
-		// Base	  Stop		Start	 Stop	Curr
-		//--*-------*----------*------*------|
-		//			<---------->
-		//			   Paused
-		timeLength = (m_stopTime - m_pausedTime) - m_baseTime;
-	}
-	else
-	{
-		//					TIME
-		// Base			Stop	  Start			Curr
-		//--*------------*----------*------------|
-		//				 <---------->
-		//					Paused
-		timeLength = (m_currTime - m_pausedTime) - m_baseTime;
-	}
-
-	return static_cast<float>(timeLength * m_secPerCount);
-}
-
-double PerfTimer::CurrentTime()
-{
-	__int64 currTime;
-	QueryPerformanceCounter((LARGE_INTEGER*)&currTime);
-	m_currTime = currTime;
-	return m_currTime * m_secPerCount;
-}
-
-float PerfTimer::Tick()
-{
-	if (m_stopped)
-	{
-		m_dt = 0.0;
-		return;
-	}
-
-	__int64 currTime;
-	QueryPerformanceCounter((LARGE_INTEGER*)&currTime);
-	m_currTime = currTime;
-	m_dt = (m_currTime - m_prevTime) * m_secPerCount;
-
-	m_prevTime = m_currTime;
-	m_dt = m_dt < 0.0 ? 0.0 : m_dt;		// m_dt => 0
-}
-#else
-
-
-PerfTimer::PerfTimer()
-	:
-	bIsStopped(true)
+PerfTimer::PerfTimer(TickSourceFn_t pfnGetTick)
+	: pfnGetTick(pfnGetTick)
 {
 	Reset();
 }
 
-Vtime_t GetNow() { return std::chrono::system_clock::now();}
-
-float PerfTimer::TotalTime() const
+PerfTimer::Tick_t PerfTimer::GetTotalTicks() const
 {
-	duration_t totalTime = duration_t::zero();
 	// Base	  Stop		Start	 Stop	   Curr
 	//--*-------*----------*------*---------|
 	//			<---------->
 	//			   Paused
-	if (bIsStopped)	totalTime = (stopTime - baseTime) - pausedTime;
+	if (bIsStopped)	return (stopTime - baseTime) - pausedTime;
 
 	// Base			Stop	  Start			Curr
 	//--*------------*----------*------------|
 	//				 <---------->
 	//					Paused
-	else totalTime = (currTime - baseTime) - pausedTime;
-
-	return totalTime.count();
+	return (currTime - baseTime) - pausedTime;
 }
 
+float PerfTimer::TotalTime() const
+{
+	return static_cast<float>(TicksToSeconds(GetTotalTicks()));
+}
 
 float PerfTimer::DeltaTime() const
 {
-	return dt.count();
+	return static_cast<float>(TicksToSeconds(dt));
 }
 
 void PerfTimer::Reset()
 {
-	baseTime = prevTime = GetNow();
+	baseTime = prevTime = currTime = stopTime = pfnGetTick();
+	pausedTime = 0;
+	dt = 0;
 	bIsStopped = true;
-	dt = duration_t::zero();
 }
 
 void PerfTimer::Start()
 {
 	if (bIsStopped)
 	{
-		pausedTime = startTime - stopTime;
-		prevTime = GetNow();
+		prevTime = pfnGetTick();
+		if (stopTime == baseTime && pausedTime == 0)	baseTime = prevTime;	// first start after Reset()
+		else											pausedTime += prevTime - stopTime;
 		bIsStopped = false;
 	}
 	Tick();
@@ -200,7 +78,7 @@ void PerfTimer::Stop()
 	Tick();
 	if (!bIsStopped)
 	{
-		stopTime = GetNow();
+		stopTime = currTime;
 		bIsStopped = true;
 	}
 }
@@ -209,27 +87,115 @@ float PerfTimer::Tick()
 {
 	if (bIsStopped)
 	{
-		dt = duration_t::zero();
-		return dt.count();
+		dt = 0;
+		return 0.0f;
 	}
 
-	currTime = GetNow();
-	dt = currTime - prevTime;
-
+	currTime = pfnGetTick();
+	dt = currTime - prevTime;	// the clock is monotonic: dt >= 0
 	prevTime = currTime;
-	dt = dt.count() < 0.0f ? dt.zero() : dt;	// make sure dt >= 0 (is this necessary?)
-
-	return dt.count();
+	return DeltaTime();
 }
 
 float PerfTimer::GetPausedTime() const
 {
-	return pausedTime.count();
+	return static_cast<float>(TicksToSeconds(pausedTime));
 }
 float PerfTimer::GetStopDuration() const
 {
-	duration_t stopDuration = GetNow() - stopTime;
-	return stopDuration.count();
+	return static_cast<float>(TicksToSeconds(pfnGetTick() - stopTime));
 }
 
-#endif;
+
+static PerfTimer::Tick_t sFakeTick = 0;
+static PerfTimer::Tick_t GetFakeTick() { return sFakeTick; }
+static void AdvanceFakeClock(double seconds) { sFakeTick += PerfTimer::SecondsToTicks(seconds); }
+
+bool PerfTimer::RunPauseResumeTests()
+{
+	int numFailures = 0;
+	auto Check = [&](const char* pTestName, float measured, float expected)
+	{
+		constexpr float EPSILON = 1e-5f;
+		if (std::fabs(measured - expected) > EPSILON)
+		{
+			Log::Error("PerfTimer test '%s': measured %.6fs, expected %.6fs", pTestName, measured, expected);
+			++numFailures;
+		}
+	};
+
+	sFakeTick = SecondsToTicks(100.0);	// an arbitrary epoch
+	PerfTimer timer(&GetFakeTick);
+	Check("new timer is stopped", timer.Tick(), 0.0f);
+	Check("new timer total time", timer.TotalTime(), 0.0f);
+
+	AdvanceFakeClock(3.0);	// the time before the first Start() isn't counted
+	timer.Start();
+	Check("delta time of Start()", timer.DeltaTime(), 0.0f);
+	AdvanceFakeClock(1.0);
+	Check("tick", timer.Tick(), 1.0f);
+	AdvanceFakeClock(0.5);
+	Check("tick", timer.Tick(), 0.5f);
+	Check("total time", timer.TotalTime(), 1.5f);
+
+	// pause
+	AdvanceFakeClock(0.25);
+	timer.Stop();
+	Check("delta time of Stop()", timer.DeltaTime(), 0.25f);
+	AdvanceFakeClock(2.0);
+	Check("tick while stopped", timer.Tick(), 0.0f);
+	Check("total time while stopped", timer.TotalTime(), 1.75f);
+	Check("stop duration", timer.GetStopDuration(), 2.0f);
+	timer.Stop();	// no-op when stopped
+	AdvanceFakeClock(1.0);
+	Check("stop duration after a second Stop()", timer.GetStopDuration(), 3.0f);
+
+	// resume: the paused duration is excluded from both the delta and the total time
+	timer.Start();
+	Check("paused time", timer.GetPausedTime(), 3.0f);
+	AdvanceFakeClock(1.0);
+	Check("first tick after resume", timer.Tick(), 1.0f);
+	Check("total time after resume", timer.TotalTime(), 2.75f);
+	timer.Start();	// no-op when running, aside from the tick
+	Check("paused time after a second Start()", timer.GetPausedTime(), 3.0f);
+
+	// the paused durations accumulate
+	timer.Stop();
+	AdvanceFakeClock(4.0);
+	timer.Start();
+	AdvanceFakeClock(0.5);
+	timer.Tick();
+	Check("accumulated paused time", timer.GetPausedTime(), 7.0f);
+	Check("total time after two pauses", timer.TotalTime(), 3.25f);
+
+	// reset
+	timer.Reset();
+	Check("total time after reset", timer.TotalTime(), 0.0f);
+	Check("paused time after reset", timer.GetPausedTime(), 0.0f);
+	AdvanceFakeClock(5.0);
+	timer.Start();
+	AdvanceFakeClock(0.125);
+	Check("StopGetDeltaTimeAndReset()", timer.StopGetDeltaTimeAndReset(), 0.125f);
+	Check("total time after StopGetDeltaTimeAndReset()", timer.TotalTime(), 0.0f);
+
+	// large time stamps: the ticks don't lose the precision a float time point would
+	sFakeTick = SecondsToTicks(60.0 * 60.0 * 24.0 * 30.0);
+	timer.Reset();
+	timer.Start();
+	AdvanceFakeClock(1.0 / 1000.0);
+	Check("1ms tick after a month", timer.Tick(), 0.001f);
+
+	// the real clock
+	PerfTimer realTimer;
+	realTimer.Start();
+	const Tick_t tick0 = GetTick();
+	const Tick_t tick1 = GetTick();
+	if (tick1 < tick0 || realTimer.Tick() < 0.0f)
+	{
+		Log::Error("PerfTimer test 'monotonic clock': time went backwards");
+		++numFailures;
+	}
+	Log::Info("PerfTimer: %lld ticks per second", static_cast<long long>(GetTicksPerSecond()));
+
+	return numFailures == 0;
+}
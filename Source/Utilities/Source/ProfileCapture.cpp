@@ -0,0 +1,212 @@
+//	VQEngine | DirectX11 Renderer
+//	Copyright(C) 2018  - Volkan Ilbeyli
+//
+//	This program is free software : you can redistribute it and / or modify
+//	it under the terms of the GNU General Public License as published by
+//	the Free Software Foundation, either version 3 of the License, or
+//	(at your option) any later version.
+//
+//	This program is distributed in the hope that it will be useful,
+//	but WITHOUT ANY WARRANTY; without even the implied warranty of
+//	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+//	GNU General Public License for more details.
+//
+//	You should have received a copy of the GNU General Public License
+//	along with this program.If not, see <http://www.gnu.org/licenses/>.
+//
+//	Contact: volkanilbeyli@gmail.com
+
+#include "ProfileCapture.h"
+#include "Log.h"
+#include "MemoryTracker.h"
+#include "PerfTimer.h"
+
+#include <algorithm>
+#include <cstdarg>
+#include <cstdio>
+
+static constexpr size_t EVENT_JSON_RESERVE = 256;	// fits most events, the ones with long names grow the buffer
+
+static double GetMicroseconds(long long ticks)
+{
+	return PerfTimer::TicksToSeconds(ticks) * 1e6;
+}
+
+// formats into @outJSON, growing it if the event doesn't fit: scope and thread names have no length limit.
+// @outJSON is left empty if the formatting fails.
+static void FormatEventJSON(std::string& outJSON, const char* pFormat, ...)
+{
+	va_list args, argsRetry;
+	va_start(args, pFormat);
+	va_copy(argsRetry, args);
+
+	outJSON.resize(std::max(outJSON.capacity(), EVENT_JSON_RESERVE));
+	int length = vsnprintf(&outJSON[0], outJSON.size(), pFormat, args);
+	if (length >= 0 && static_cast<size_t>(length) >= outJSON.size())
+	{
+		outJSON.resize(length + 1);	// + null terminator
+		length = vsnprintf(&outJSON[0], outJSON.size(), pFormat, argsRetry);
+	}
+	outJSON.resize(length > 0 ? length : 0);
+
+	va_end(argsRetry);
+	va_end(args);
+}
+
+// scope and thread names are written into JSON strings
+static std::string EscapeJSON(const std::string& str)
+{
+	std::string escaped;
+	escaped.reserve(str.size());
+	for (const char c : str)
+	{
+		if (c == '"' || c == '\\') escaped += '\\';
+		if (static_cast<unsigned char>(c) >= 0x20)
+			escaped += c;
+	}
+	return escaped;
+}
+
+ProfileCapture::~ProfileCapture()
+{
+	if (mWriterThread.joinable())
+	{
+		{
+			std::unique_lock<std::mutex> lock(mMutex);
+			mbLastFrameAdded = true;	// capture cut short: write the frames so far
+		}
+		mSignal.notify_one();
+		mWriterThread.join();
+	}
+}
+
+bool ProfileCapture::Begin(const std::string& filePath, int numFrames)
+{
+	if (mWriterThread.joinable() || numFrames <= 0)
+	{
+		Log::Error("ProfileCapture: can't begin capture of %d frames", numFrames);
+		return false;
+	}
+
+	mFile.open(filePath, std::ios::out | std::ios::trunc);
+	if (!mFile.is_open())
+	{
+		Log::Error("ProfileCapture: can't open %s", filePath.c_str());
+		return false;
+	}
+
+	mFilePath = filePath;
+	mNumFramesLeft = numFrames;
+	mFile << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+	mWriterThread = std::thread(&ProfileCapture::WriterThread, this);
+	Log::Info("ProfileCapture: capturing %d frames into %s", numFrames, filePath.c_str());
+	return true;
+}
+
+void ProfileCapture::AddFrame(const std::vector<CPUProfiler::TimelineEvent>& timeline, uint32_t profilingThreadIndex)
+{
+	if (mNumFramesLeft <= 0)
+		return;
+
+	const bool bLastFrame = --mNumFramesLeft == 0;
+	{
+		std::unique_lock<std::mutex> lock(mMutex);
+		mFrameQueue.push_back(Frame{ mNumFramesAdded++, profilingThreadIndex, timeline });
+		mbLastFrameAdded = bLastFrame;
+	}
+	mSignal.notify_one();
+}
+
+void ProfileCapture::WriterThread()
+{
+	CPUProfiler::SetThreadName("Profile Capture");
+	MemoryTracker::TagScope memoryTag(EMemoryTag::PROFILER);
+	while (true)
+	{
+		Frame frame;
+		{
+			std::unique_lock<std::mutex> lock(mMutex);
+			mSignal.wait(lock, [=] { return mbLastFrameAdded || !mFrameQueue.empty(); });
+			if (mFrameQueue.empty())
+				break;	// the last frame is written
+
+			frame = std::move(mFrameQueue.front());
+			mFrameQueue.pop_front();
+		}
+		WriteFrame(frame);
+	}
+
+	// thread names
+	std::string eventJSON;
+	FormatEventJSON(eventJSON, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":0,\"args\":{\"name\":\"VQEngine\"}}");
+	WriteEvent(eventJSON);
+	for (const uint32_t threadIndex : mThreadIndices)
+	{
+		FormatEventJSON(eventJSON, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":%u,\"args\":{\"name\":\"%s\"}}"
+			, threadIndex, EscapeJSON(CPUProfiler::GetThreadName(threadIndex)).c_str());
+		WriteEvent(eventJSON);
+		FormatEventJSON(eventJSON, "{\"name\":\"thread_sort_index\",\"ph\":\"M\",\"pid\":0,\"tid\":%u,\"args\":{\"sort_index\":%u}}", threadIndex, threadIndex);
+		WriteEvent(eventJSON);
+	}
+
+	mFile << "\n]}\n";
+	mFile.close();
+	if (mFile.fail())
+		Log::Error("ProfileCapture: error writing %s", mFilePath.c_str());
+	else
+		Log::Info("ProfileCapture: written %s", mFilePath.c_str());
+}
+
+void ProfileCapture::WriteFrame(const Frame& frame)
+{
+	if (frame.events.empty())
+		return;
+	if (mbFirstEvent)
+	{
+		mBaseTick = frame.events.front().beginTick;
+		for (const CPUProfiler::TimelineEvent& event : frame.events)
+			mBaseTick = std::min(mBaseTick, event.beginTick);
+	}
+
+	std::string eventJSON;
+	for (const CPUProfiler::TimelineEvent& event : frame.events)
+	{
+		const double ts = GetMicroseconds(event.beginTick - mBaseTick);
+		const double dur = GetMicroseconds(event.endTick - event.beginTick);
+		const std::string name = EscapeJSON(CPUProfiler::GetScopeName(event.scopeID));
+		mThreadIndices.insert(event.threadIndex);
+
+		// the outermost scopes of the profiling thread are the frames
+		if (event.threadIndex == frame.profilingThreadIndex && event.depth == 0)
+		{
+			FormatEventJSON(eventJSON, "{\"name\":\"Frame %llu\",\"cat\":\"Frame\",\"ph\":\"i\",\"s\":\"g\",\"ts\":%.3f,\"pid\":0,\"tid\":%u}"
+				, static_cast<unsigned long long>(frame.frameIndex), ts, event.threadIndex);
+			WriteEvent(eventJSON);
+		}
+
+		if (event.submitterThreadIndex != CPUProfiler::NO_THREAD)
+		{
+			FormatEventJSON(eventJSON, "{\"name\":\"%s\",\"cat\":\"Task\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":0,\"tid\":%u,\"args\":{\"submitter\":\"%s\"}}"
+				, name.c_str(), ts, dur, event.threadIndex, EscapeJSON(CPUProfiler::GetThreadName(event.submitterThreadIndex)).c_str());
+		}
+		else
+		{
+			FormatEventJSON(eventJSON, "{\"name\":\"%s\",\"cat\":\"CPU\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":0,\"tid\":%u}"
+				, name.c_str(), ts, dur, event.threadIndex);
+		}
+		WriteEvent(eventJSON);
+	}
+}
+
+void ProfileCapture::WriteEvent(const std::string& eventJSON)
+{
+	if (eventJSON.empty())
+	{
+		Log::Warning("ProfileCapture: skipping an event that couldn't be formatted");
+		return;
+	}
+	if (!mbFirstEvent)
+		mFile << ",\n";
+	mFile << eventJSON;
+	mbFirstEvent = false;
+}
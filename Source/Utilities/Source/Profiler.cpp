@@ -1,9 +1,16 @@
 #include "Profiler.h"
+#include "ProfileCapture.h"
 #include "Log.h"
+#include "MemoryTracker.h"
 
 #include <numeric>
 #include <sstream>
 #include <iomanip>
+#include <deque>
+#include <mutex>
+#include <algorithm>
+#include <memory>
+#include <functional>
 
 #define DISABLE_CPU_PROFILER 0
 #define DISABLE_GPU_PROFILER 0
@@ -23,39 +30,219 @@
 //---------------------------------------------------------------------------------------------------------------------------
 // CPU PROFILER
 //---------------------------------------------------------------------------------------------------------------------------
-void CPUProfiler::BeginProfile(const unsigned long long FRAME_NUMBER)
+//
+// Scope registry: scope names are registered once per call site with PROFILE_SCOPE_ID(),
+// the same name from different call sites maps to the same scope (and PerfEntry).
+//
+struct ScopeRegistry
+{
+	std::mutex mutex;
+	std::deque<std::string> names;	// ProfileScopeID -> name, deque so the names don't move
+	std::unordered_map<std::string, ProfileScopeID> lookup;
+};
+static ScopeRegistry& GetScopeRegistry()
+{
+	static ScopeRegistry registry;
+	return registry;
+}
+
+ProfileScopeID CPUProfiler::RegisterScope(const std::string& name)
+{
+	ScopeRegistry& registry = GetScopeRegistry();
+	std::lock_guard<std::mutex> lock(registry.mutex);
+	const auto it = registry.lookup.find(name);
+	if (it != registry.lookup.end())
+		return it->second;
+
+	const ProfileScopeID scopeID = static_cast<ProfileScopeID>(registry.names.size());
+	registry.names.push_back(name);
+	registry.lookup[name] = scopeID;
+	return scopeID;
+}
+
+static bool FindScope(const std::string& name, ProfileScopeID& outScopeID)
+{
+	ScopeRegistry& registry = GetScopeRegistry();
+	std::lock_guard<std::mutex> lock(registry.mutex);
+	const auto it = registry.lookup.find(name);
+	if (it == registry.lookup.end())
+		return false;
+	outScopeID = it->second;
+	return true;
+}
+
+std::string CPUProfiler::GetScopeName(ProfileScopeID scopeID)
+{
+	ScopeRegistry& registry = GetScopeRegistry();
+	std::lock_guard<std::mutex> lock(registry.mutex);
+	return scopeID < registry.names.size() ? registry.names[scopeID] : "";
+}
+
+//
+// Thread streams: registered the first time a thread records a scope and kept for the lifetime of the
+// process so the profiling thread never reads a stream that's gone.
+//
+struct CPUProfiler::ThreadStreamRegistry
+{
+	std::mutex mutex;
+	std::vector<std::unique_ptr<ThreadEventStream>> streams;	// thread index -> stream
+	std::vector<std::string> names;								// thread index -> name
+};
+CPUProfiler::ThreadStreamRegistry& CPUProfiler::GetThreadStreamRegistry()
+{
+	static ThreadStreamRegistry registry;
+	return registry;
+}
+
+CPUProfiler::ThreadEventStream* CPUProfiler::RegisterThreadStream()
+{
+	MemoryTracker::TagScope memoryTag(EMemoryTag::PROFILER);
+	ThreadStreamRegistry& registry = GetThreadStreamRegistry();
+	std::lock_guard<std::mutex> lock(registry.mutex);
+
+	std::unique_ptr<ThreadEventStream> pStream = std::make_unique<ThreadEventStream>();
+	pStream->events.resize(ThreadEventStream::CAPACITY);
+	pStream->resolveStack.reserve(ThreadEventStream::MAX_DEPTH);
+	pStream->threadIndex = static_cast<uint32_t>(registry.streams.size());
+	registry.names.push_back("Thread " + std::to_string(pStream->threadIndex));
+	registry.streams.push_back(std::move(pStream));
+	return registry.streams.back().get();
+}
+
+std::vector<CPUProfiler::ThreadEventStream*> CPUProfiler::GetThreadStreams()
+{
+	ThreadStreamRegistry& registry = GetThreadStreamRegistry();
+	std::lock_guard<std::mutex> lock(registry.mutex);
+
+	std::vector<ThreadEventStream*> streams;
+	streams.reserve(registry.streams.size());
+	for (const std::unique_ptr<ThreadEventStream>& pStream : registry.streams)
+		streams.push_back(pStream.get());
+	return streams;
+}
+
+void CPUProfiler::SetThreadName(const std::string& name)
+{
+	const uint32_t threadIndex = GetThreadStream().threadIndex;
+	ThreadStreamRegistry& registry = GetThreadStreamRegistry();
+	std::lock_guard<std::mutex> lock(registry.mutex);
+	registry.names[threadIndex] = name;
+}
+
+std::string CPUProfiler::GetThreadName(uint32_t threadIndex)
+{
+	ThreadStreamRegistry& registry = GetThreadStreamRegistry();
+	std::lock_guard<std::mutex> lock(registry.mutex);
+	return threadIndex < registry.names.size() ? registry.names[threadIndex] : "";
+}
+
+ProfileTaskLink CPUProfiler::GetTaskLink()
+{
+	const ThreadEventStream& stream = GetThreadStream();
+	const int depth = std::min(stream.openEntryCount, ThreadEventStream::MAX_DEPTH);
+	const ProfileScopeID scopeID = depth > 0 ? stream.openScopes[depth - 1] : PROFILE_SCOPE_ID("Task");
+	return ProfileTaskLink{ scopeID, stream.threadIndex };
+}
+
+void CPUProfiler::BeginTask(const ProfileTaskLink& link)
+{
+	CPU_PROFILER_ENABLE_CHECK
+	RecordBeginEvent(GetThreadStream(), link.scopeID, link.submitterThreadIndex);
+}
+
+void CPUProfiler::EndTask()
 {
 	CPU_PROFILER_ENABLE_CHECK
-	auto& entryStack = mState.EntryNameStack;
+	RecordEndEvent(GetThreadStream());	// tasks run on the workers, the profiling thread resolves them with its own entries
+}
+
+float CPUProfiler::MeasureScopeOverhead(size_t numScopes)
+{
+	CPUProfiler profiler;
+	profiler.mbCollectAllThreads = false;
+	const ProfileScopeID scopeID = PROFILE_SCOPE_ID("ScopeOverhead");
+	numScopes = std::min(numScopes, ThreadEventStream::CAPACITY / 2 - 1);
+
+	profiler.BeginProfile();
+	profiler.BeginEntry(PROFILE_SCOPE_ID("ScopeOverheadRoot"));
+	const long long begin = GetTick();
+	for (size_t i = 0; i < numScopes; ++i)
+	{
+		profiler.BeginEntry(scopeID);
+		profiler.EndEntry();
+	}
+	const long long end = GetTick();
+	profiler.EndEntry();
+	profiler.EndProfile();
+
+	return numScopes > 0 ? GetSeconds(end - begin) * 1e9f / numScopes : 0.0f;
+}
+
+CPUProfiler::CPUProfiler(ProfilerSettings settings)
+	: mSettings(settings)
+{
+	mTimeline.reserve(4096);
+}
 
+CPUProfiler::~CPUProfiler() {}
+
+bool CPUProfiler::BeginCapture(const std::string& filePath, int numFrames)
+{
+	MemoryTracker::TagScope memoryTag(EMemoryTag::PROFILER);
+	if (IsCapturing())
+	{
+		Log::Warning("CPUProfiler: a capture is already in progress");
+		return false;
+	}
+	mpCapture = std::make_unique<ProfileCapture>();	// waits for the previous capture's file to be written
+	return mpCapture->Begin(filePath, numFrames);
+}
+
+bool CPUProfiler::IsCapturing() const
+{
+	return mpCapture && mpCapture->IsCapturing();
+}
+
+void CPUProfiler::BeginProfile(const unsigned long long FRAME_NUMBER)
+{
+	CPU_PROFILER_ENABLE_CHECK
 	if (mState.bIsProfiling)
 	{
-		Log::Warning("Already began profiling! Current profiling entry: %s", entryStack.empty() ? "EMPTY" : entryStack.top().c_str());
+		Log::Warning("Already began profiling! Open entries: %d", GetThreadStream().openEntryCount);
 	}
 
 
 	mState.bIsProfiling = true;
+	SetProfilingThread();
+	mPerfEntryTree.Clear();
 	mPerfEntries.clear();
+	ResetStreams();
+}
+
+void CPUProfiler::SetProfilingThread()
+{
+	mpProfilingThreadStream.store(&GetThreadStream(), std::memory_order_relaxed);
 }
 
 void CPUProfiler::EndProfile(const unsigned long long FRAME_NUMBER)
 {
 	CPU_PROFILER_ENABLE_CHECK
-	auto& entryStack = mState.EntryNameStack;
-
 	if (!mState.bIsProfiling)
 	{
 		Log::Warning("Haven't started profiling!");
 	}
 
-	if (!entryStack.empty())
+	ThreadEventStream& stream = GetThreadStream();
+	if (stream.openEntryCount != 0)
 	{
-		Log::Warning("Begin/End Entry mismatch! Last profiling entry: %s", entryStack.top());
-		while (!entryStack.empty()) entryStack.pop();
+		Log::Warning("Begin/End Entry mismatch! Open entries: %d", stream.openEntryCount);
+		stream.openEntryCount = 0;
+		stream.recordedOpenEntryCount = 0;
 	}
 
 
 	mState.bIsProfiling = false;
+	ResetStreams();
 	mPerfEntryTree.Clear();
 }
 
@@ -64,72 +251,203 @@ void CPUProfiler::EndProfile(const unsigned long long FRAME_NUMBER)
 void CPUProfiler::BeginEntry(const std::string & entryName)
 {
 	CPU_PROFILER_ENABLE_CHECK
+	BeginEntry(RegisterScope(entryName));
+}
+
+void CPUProfiler::ResolveEvents()
+{
+	MemoryTracker::TagScope memoryTag(EMemoryTag::PROFILER);
 	if (!mState.bIsProfiling)
 	{
 		Log::Error("Profiler::BeginProfile() hasn't been called.");
 		return;
 	}
-		
-	const bool bEntryExists = mPerfEntries.find(entryName) != mPerfEntries.end();
-	
-	// hierarchy variables
-	const PerfEntry* pParentPerfEntry = mState.EntryNameStack.empty() ? nullptr : &mPerfEntries.at(mState.EntryNameStack.top());
 
-	// update state
-	mState.EntryNameStack.push(entryName);
+	// the profiling thread goes first: its outermost entry is the root of the tree.
+	// the other threads wait in their buffers until there's a root to add their nodes under.
+	ThreadEventStream* pProfilingThreadStream = mpProfilingThreadStream.load(std::memory_order_relaxed);
+	mTimeline.clear();
+	ResolveStream(*pProfilingThreadStream);
+	if (mbCollectAllThreads && mPerfEntryTree.root.pData != nullptr)
+	{
+		for (ThreadEventStream* pStream : GetThreadStreams())
+		{
+			if (pStream != pProfilingThreadStream)
+				ResolveStream(*pStream);
+		}
+	}
 
-	// setup the entry settings/data and update hierarchy if entry didn't exist
-	PerfEntry& entry = mPerfEntries[entryName];
-	const PerfEntry* pCurrentPerfEntry = &mPerfEntries.at(entryName);
-	if (!bEntryExists)
+	if (IsCapturing())
 	{
-		// setup entry settings / aux data
-		entry.samples.resize(mSettings.sampleCount, 0.0f);
-		entry.tag = entryName;
+		mpCapture->AddFrame(mTimeline, pProfilingThreadStream->threadIndex);
+	}
 
-		// update hierarchy
-		if (mPerfEntryTree.root.pData == nullptr)
-		{	// first node
-			mPerfEntryTree.root.pData = pCurrentPerfEntry;
-			mState.pLastEntryNode = &mPerfEntryTree.root;
-			assert(mState.pLastEntryNode);
+	// the outermost entry of the profiling thread is the frame
+	const auto itFrame = std::find_if(mTimeline.begin(), mTimeline.end(), [&](const TimelineEvent& e) { return e.threadIndex == pProfilingThreadStream->threadIndex && e.depth == 0; });
+	if (mSettings.bLogHitchFrames && itFrame != mTimeline.end() && itFrame->bHitch)
+	{
+		constexpr float MIN_HITCH_LOG_INTERVAL = 1.0f;	// seconds, hitches usually come in bursts
+		if (GetSeconds(itFrame->endTick - mLastHitchLogTick) < MIN_HITCH_LOG_INTERVAL)
+		{
+			++mNumHitchFramesNotLogged;
 		}
 		else
-		{	// rest of the nodes
-			assert(mState.pLastEntryNode);
-			mState.pLastEntryNode = mPerfEntryTree.AddChild(*mState.pLastEntryNode, pCurrentPerfEntry);
+		{
+			LogHitchFrame();
+			mLastHitchLogTick = itFrame->endTick;
+			mNumHitchFramesNotLogged = 0;
 		}
 	}
-
-	// start the timer of the entry 
-	entry.UpdateSampleBegin();
 }
 
-void CPUProfiler::EndEntry()
+void CPUProfiler::LogHitchFrame() const
 {
-	CPU_PROFILER_ENABLE_CHECK
-	if (!mState.bIsProfiling)
+	const uint32_t profilingThreadIndex = mpProfilingThreadStream.load(std::memory_order_relaxed)->threadIndex;
+
+	// the timeline is in the order the scopes ended, the tree is printed in the order they began
+	std::vector<const TimelineEvent*> events;
+	for (const TimelineEvent& event : mTimeline)
+	{	// the whole tree of the profiling thread and the hitches of the other threads
+		if (event.threadIndex == profilingThreadIndex || event.bHitch)
+			events.push_back(&event);
+	}
+	std::stable_sort(events.begin(), events.end(), [&](const TimelineEvent* pA, const TimelineEvent* pB)
 	{
-		Log::Error("Profiler::BeginProfile() hasn't been called.");
+		const bool bProfilingThreadA = pA->threadIndex == profilingThreadIndex;
+		const bool bProfilingThreadB = pB->threadIndex == profilingThreadIndex;
+		if (bProfilingThreadA != bProfilingThreadB) return bProfilingThreadA;
+		if (pA->threadIndex != pB->threadIndex)     return pA->threadIndex < pB->threadIndex;
+		return pA->beginTick != pB->beginTick ? pA->beginTick < pB->beginTick : pA->depth < pB->depth;
+	});
+
+	std::ostringstream info;
+	info.precision(2);
+	info << std::fixed;
+	info << "CPUProfiler: hitch frame";
+	if (mNumHitchFramesNotLogged > 0)
+		info << " (" << mNumHitchFramesNotLogged << " more hitch frames since the last one logged)";
+
+	uint32_t threadIndex = NO_THREAD;
+	for (const TimelineEvent* pEvent : events)
+	{
+		if (pEvent->threadIndex != threadIndex)
+		{
+			threadIndex = pEvent->threadIndex;
+			info << "\n  [" << GetThreadName(threadIndex) << "]";
+		}
+
+		const auto itEntry = mPerfEntries.find(GetEntryKey(pEvent->threadIndex, pEvent->scopeID));
+		info << "\n  " << std::string(2 * (pEvent->depth + 1), ' ') << GetScopeName(pEvent->scopeID)
+			<< "  " << GetSeconds(pEvent->endTick - pEvent->beginTick) * 1000.0f << " ms";
+		if (itEntry != mPerfEntries.end())
+			info << " (median " << itEntry->second.median * 1000.0f << " ms)";
+		if (pEvent->bHitch)
+			info << "  <-- hitch";
+	}
+	Log::Warning(info.str());
+}
+
+void CPUProfiler::ResolveStream(ThreadEventStream& stream)
+{
+	const bool bProfilingThread = &stream == mpProfilingThreadStream.load(std::memory_order_relaxed);
+	const uint64_t writeIndex = stream.writeIndex.load(std::memory_order_acquire);
+	uint64_t readIndex = stream.readIndex.load(std::memory_order_relaxed);
+	if (readIndex == writeIndex)
 		return;
+
+	// the scopes of the other threads go under a node of their thread, which samples how long the thread was busy
+	PerfEntry* pThreadEntry = bProfilingThread ? nullptr : &GetOrCreateEntry(GetEntryKey(stream.threadIndex, END_EVENT), GetThreadName(stream.threadIndex), nullptr);
+	float busyTime = 0.0f;
+
+	for (; readIndex < writeIndex; ++readIndex)
+	{
+		const ScopeEvent& event = stream.events[readIndex & (ThreadEventStream::CAPACITY - 1)];
+		if (event.scopeID != END_EVENT)
+		{
+			const PerfEntry* pParentEntry = stream.resolveStack.empty() ? pThreadEntry : stream.resolveStack.back().pEntry;
+			PerfEntry& entry = GetOrCreateEntry(GetEntryKey(stream.threadIndex, event.scopeID), GetScopeName(event.scopeID), pParentEntry);
+			stream.resolveStack.push_back(ResolveEntry{ &entry, event.scopeID, event.submitterThreadIndex, event.tick });
+			continue;
+		}
+
+		if (stream.resolveStack.empty())
+		{	// the begin event was discarded by a reset
+			continue;
+		}
+		const ResolveEntry& openEntry = stream.resolveStack.back();
+		const float dt = GetSeconds(event.tick - openEntry.beginTick);
+		const bool bHitch = openEntry.pEntry->AddSample(dt, event.tick, mSettings);
+		mTimeline.push_back(TimelineEvent{ openEntry.scopeID, stream.threadIndex, static_cast<uint32_t>(stream.resolveStack.size() - 1), openEntry.submitterThreadIndex, openEntry.beginTick, event.tick, bHitch });
+		if (stream.resolveStack.size() == 1)
+			busyTime += dt;
+		stream.resolveStack.pop_back();
 	}
+	stream.readIndex.store(writeIndex, std::memory_order_release);
 
-	std::string entryName = mState.EntryNameStack.top();
-	mState.EntryNameStack.pop();
+	if (pThreadEntry && busyTime > 0.0f)
+	{
+		pThreadEntry->AddSample(busyTime, GetTick(), mSettings);
+	}
 
-	// stop the timer of the entry
-	PerfEntry& entry = mPerfEntries.at(entryName);
-	entry.UpdateSampleEnd();
-	
-	// update last entry node with the parent of it
-	if(mState.pLastEntryNode && mState.pLastEntryNode->pParent) mState.pLastEntryNode = mState.pLastEntryNode->pParent;
+	const uint32_t numDroppedScopes = stream.numDroppedScopes.load(std::memory_order_relaxed);
+	if (numDroppedScopes != stream.numReportedDroppedScopes)
+	{
+		Log::Warning("CPUProfiler: %s dropped %u scopes, its event buffer is full.", GetThreadName(stream.threadIndex).c_str(), numDroppedScopes - stream.numReportedDroppedScopes);
+		stream.numReportedDroppedScopes = numDroppedScopes;
+	}
 }
 
+void CPUProfiler::ResetStreams()
+{
+	ThreadEventStream* pProfilingThreadStream = mpProfilingThreadStream.load(std::memory_order_relaxed);
+	const std::vector<ThreadEventStream*> streams = mbCollectAllThreads ? GetThreadStreams() : std::vector<ThreadEventStream*>{ pProfilingThreadStream };
+	for (ThreadEventStream* pStream : streams)
+	{
+		if (pStream == nullptr)
+			continue;
+		pStream->readIndex.store(pStream->writeIndex.load(std::memory_order_acquire), std::memory_order_release);
+		pStream->resolveStack.clear();	// the entries they point to are cleared too
+	}
+	mTimeline.clear();
+}
+
+CPUProfiler::PerfEntry& CPUProfiler::GetOrCreateEntry(PerfEntryKey key, const std::string& tag, const PerfEntry* pParentEntry)
+{
+	const auto it = mPerfEntries.find(key);
+	if (it != mPerfEntries.end())
+		return it->second;
 
+	// setup entry settings / aux data
+	PerfEntry& entry = mPerfEntries[key];
+	entry.samples.resize(mSettings.sampleCount, 0.0f);
+	entry.currSampleIndex = 0;
+	entry.lastSampleTick = GetTick();
+	entry.tag = tag;
+	entry.median = 0.0f;
+	entry.numHitches = 0;
+
+	// update hierarchy: entries are added under the entry they were first seen in
+	if (mPerfEntryTree.root.pData == nullptr)
+	{	// first node
+		mPerfEntryTree.root.pData = &entry;
+	}
+	else
+	{	// rest of the nodes
+		TreeNode<PerfEntry>* pParentNode = pParentEntry ? mPerfEntryTree.FindNode(pParentEntry) : nullptr;
+		mPerfEntryTree.AddChild(pParentNode ? *pParentNode : mPerfEntryTree.root, &entry);
+	}
+	return entry;
+}
+
+
+bool CPUProfiler::AreThereAnyOpenEntries() const
+{
+	return GetThreadStream().openEntryCount != 0;	// of the calling thread
+}
 
 bool CPUProfiler::StateCheck() const
 {
-	// ensures entry name stack is empty
+	// ensures there are no open entries
 	bool bState = !AreThereAnyOpenEntries();
 	if (!bState)
 	{
@@ -140,11 +458,40 @@ bool CPUProfiler::StateCheck() const
 }
 
 
+void CPUProfiler::PrintStats() const
+{
+	MemoryTracker::TagScope memoryTag(EMemoryTag::PROFILER);
+	std::ostringstream info;
+	info.precision(2);
+	info << std::fixed;
+	info << "CPUProfiler stats (ms): avg / p50 / p95 / p99 / max  [samples, hitches]";
+
+	std::function<void(const TreeNode<PerfEntry>&, int)> fnPrintNode = [&](const TreeNode<PerfEntry>& node, int depth)
+	{
+		const TimingHistogram& histogram = node.pData->histogram;
+		info << "\n" << std::string(2 * (depth + 1), ' ') << node.pData->tag << ":  "
+			<< histogram.GetMean() * 1000.0f << " / "
+			<< histogram.GetPercentile(50.0f) * 1000.0f << " / "
+			<< histogram.GetPercentile(95.0f) * 1000.0f << " / "
+			<< histogram.GetPercentile(99.0f) * 1000.0f << " / "
+			<< histogram.GetMax() * 1000.0f
+			<< "  [" << histogram.GetCount() << ", " << node.pData->numHitches << "]";
+		for (const TreeNode<PerfEntry>& child : node.children)
+			fnPrintNode(child, depth + 1);
+	};
+	if (mPerfEntryTree.root.pData)
+		fnPrintNode(mPerfEntryTree.root, 0);
+	Log::Info(info.str());
+}
+
 float CPUProfiler::GetEntryAvg(const std::string & entryName) const
 {
-	if (mPerfEntries.find(entryName) == mPerfEntries.end())
+	const ThreadEventStream* pProfilingThreadStream = mpProfilingThreadStream.load(std::memory_order_relaxed);
+	ProfileScopeID scopeID;
+	if (!pProfilingThreadStream || !FindScope(entryName, scopeID))
 		return -1.0f;
-	return mPerfEntries.at(entryName).GetAvg();
+	const auto it = mPerfEntries.find(GetEntryKey(pProfilingThreadStream->threadIndex, scopeID));
+	return it != mPerfEntries.end() ? it->second.GetAvg() : -1.0f;
 }
 
 float CPUProfiler::GetRootEntryAvg() const
@@ -161,6 +508,7 @@ void CPUProfiler::Clear()
 	bool bIsProfiling = mState.bIsProfiling;
 	mState.Clear();
 	mState.bIsProfiling = bIsProfiling;
+	ResetStreams();
 }
 
 
@@ -171,17 +519,22 @@ void CPUProfiler::Clear()
 //---------------------------------------------------------------------------------------------------------------------------
 // PERF ENTRY
 //---------------------------------------------------------------------------------------------------------------------------
-void CPUProfiler::PerfEntry::UpdateSampleEnd()
+bool CPUProfiler::PerfEntry::AddSample(float dt, long long tick, const ProfilerSettings& settings)
 {
-	timer.Stop();
-	float dt = timer.DeltaTime();
+	constexpr uint64_t MEDIAN_UPDATE_INTERVAL = 32;	// samples
 
 	samples[currSampleIndex++ % samples.size()] = dt;
-}
-void CPUProfiler::PerfEntry::UpdateSampleBegin()
-{
-	timer.Reset();
-	timer.Start();
+	lastSampleTick = tick;
+
+	const bool bHitch = histogram.GetCount() >= static_cast<uint64_t>(settings.hitchMinSampleCount)
+		&& dt > settings.hitchThreshold * median
+		&& dt > settings.hitchMinDuration;
+	numHitches += bHitch ? 1 : 0;
+
+	histogram.Record(dt);
+	if (histogram.GetCount() % MEDIAN_UPDATE_INTERVAL == 0)
+		median = histogram.GetPercentile(50.0f);
+	return bHitch;
 }
 
 // returns the index (i-1) in a ring-buffer fashion
@@ -217,7 +570,7 @@ bool CPUProfiler::PerfEntry::operator<(const PerfEntry & other) const
 
 bool CPUProfiler::PerfEntry::IsStale() const
 {
-	return timer.GetStopDuration() > 5.0f;	// 5 second upper limit
+	return GetSeconds(GetTick() - lastSampleTick) > 5.0f;	// 5 second upper limit
 }
 
 #if 0
@@ -279,6 +632,7 @@ void GPUProfiler::BeginProfile(const unsigned long long FRAME_NUMBER)
 void GPUProfiler::EndProfile(const unsigned long long FRAME_NUMBER)
 {
 	GPU_PROFILER_ENABLE_CHECK
+	MemoryTracker::TagScope memoryTag(EMemoryTag::PROFILER);
 	const unsigned long long PREV_FRAME_NUMBER = (FRAME_NUMBER - (FRAME_HISTORY-1));
 
 	mpContext->End(pDisjointQuery[FRAME_NUMBER % FRAME_HISTORY]);
@@ -454,6 +808,7 @@ size_t GPUProfiler::RenderPerformanceStats(
 	, bool bSort)
 {
 	GPU_PROFILER_ENABLE_CHECK
+	MemoryTracker::TagScope memoryTag(EMemoryTag::PROFILER);
 		if (bSort)
 			mQueryDataTree.Sort();
 	return mQueryDataTree.RenderTree(pTextRenderer, screenPosition, drawDesc);
@@ -466,6 +821,7 @@ size_t CPUProfiler::RenderPerformanceStats(
 	, bool bSortStats)
 {
 	CPU_PROFILER_ENABLE_CHECK
+	MemoryTracker::TagScope memoryTag(EMemoryTag::PROFILER);
 
 		// TODO: check for inactive queries and 0 them out 
 		if (bSortStats)
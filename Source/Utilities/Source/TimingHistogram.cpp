@@ -0,0 +1,156 @@
+//	VQEngine | DirectX11 Renderer
+//	Copyright(C) 2018  - Volkan Ilbeyli
+//
+//	This program is free software : you can redistribute it and / or modify
+//	it under the terms of the GNU General Public License as published by
+//	the Free Software Foundation, either version 3 of the License, or
+//	(at your option) any later version.
+//
+//	This program is distributed in the hope that it will be useful,
+//	but WITHOUT ANY WARRANTY; without even the implied warranty of
+//	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+//	GNU General Public License for more details.
+//
+//	You should have received a copy of the GNU General Public License
+//	along with this program.If not, see <http://www.gnu.org/licenses/>.
+//
+//	Contact: volkanilbeyli@gmail.com
+
+#include "TimingHistogram.h"
+#include "Log.h"
+
+#include <algorithm>
+#include <cmath>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+static int GetHighestBit(uint64_t value)	// value > 0
+{
+#ifdef _MSC_VER
+	unsigned long index;
+	_BitScanReverse64(&index, value);
+	return static_cast<int>(index);
+#else
+	return 63 - __builtin_clzll(value);
+#endif
+}
+
+// values below SUB_BUCKET_COUNT get a bucket each, the values of [2^n, 2^(n+1)) are split into SUB_BUCKET_COUNT buckets
+size_t TimingHistogram::GetBucketIndex(uint64_t nanoseconds)
+{
+	if (nanoseconds < SUB_BUCKET_COUNT)
+		return static_cast<size_t>(nanoseconds);
+
+	const int highestBit = GetHighestBit(nanoseconds);
+	if (highestBit >= MAX_VALUE_BITS)
+		return BUCKET_COUNT - 1;
+
+	const int shift = highestBit - SUB_BUCKET_BITS;
+	const uint64_t subBucket = std::min((nanoseconds >> shift) - SUB_BUCKET_COUNT, SUB_BUCKET_COUNT - 1);
+	return static_cast<size_t>(SUB_BUCKET_COUNT * (shift + 1) + subBucket);
+}
+
+uint64_t TimingHistogram::GetBucketValue(size_t bucketIndex)
+{
+	if (bucketIndex < SUB_BUCKET_COUNT)
+		return bucketIndex;
+
+	const int shift = static_cast<int>(bucketIndex / SUB_BUCKET_COUNT) - 1;
+	const uint64_t subBucket = bucketIndex % SUB_BUCKET_COUNT;
+	return ((SUB_BUCKET_COUNT + subBucket) << shift) + ((1ull << shift) >> 1);
+}
+
+void TimingHistogram::Record(float seconds)
+{
+	// saturated well below the uint64 range, the sum of the samples shouldn't overflow either
+	const double MAX_NANOSECONDS = 1e15;	// ~11 days
+	const uint64_t nanoseconds = seconds > 0.0f ? static_cast<uint64_t>(std::llround(std::min(static_cast<double>(seconds) * 1e9, MAX_NANOSECONDS))) : 0;
+	++mBuckets[GetBucketIndex(nanoseconds)];
+	++mCount;
+	mSumNanoseconds += nanoseconds;
+	mMinNanoseconds = std::min(mMinNanoseconds, nanoseconds);
+	mMaxNanoseconds = std::max(mMaxNanoseconds, nanoseconds);
+}
+
+void TimingHistogram::Merge(const TimingHistogram& other)
+{
+	for (size_t i = 0; i < BUCKET_COUNT; ++i)
+		mBuckets[i] += other.mBuckets[i];
+	mCount += other.mCount;
+	mSumNanoseconds += other.mSumNanoseconds;
+	mMinNanoseconds = std::min(mMinNanoseconds, other.mMinNanoseconds);
+	mMaxNanoseconds = std::max(mMaxNanoseconds, other.mMaxNanoseconds);
+}
+
+void TimingHistogram::Reset()
+{
+	*this = TimingHistogram();
+}
+
+float TimingHistogram::GetPercentile(float percentile) const
+{
+	if (mCount == 0)
+		return 0.0f;
+
+	// rank of the sample at @percentile, 1-based
+	const double fraction = std::min(std::max(static_cast<double>(percentile), 0.0), 100.0) / 100.0;
+	const uint64_t rank = std::max<uint64_t>(1, static_cast<uint64_t>(std::ceil(fraction * mCount)));
+	if (rank == 1)		return GetMin();
+	if (rank >= mCount)	return GetMax();
+
+	uint64_t numSamples = 0;
+	for (size_t i = 0; i < BUCKET_COUNT; ++i)
+	{
+		numSamples += mBuckets[i];
+		if (numSamples >= rank)
+		{
+			const uint64_t value = std::min(std::max(GetBucketValue(i), mMinNanoseconds), mMaxNanoseconds);
+			return value * 1e-9f;
+		}
+	}
+	return GetMax();
+}
+
+bool TimingHistogram::RunTests()
+{
+	bool bPassed = true;
+	auto fnCheck = [&](const char* pCase, float value, float expected, float tolerance)
+	{
+		if (std::abs(value - expected) <= tolerance)
+			return;
+		Log::Error("TimingHistogram test '%s': %g, expected %g (+/-%g)", pCase, value, expected, tolerance);
+		bPassed = false;
+	};
+	const float relativeError = 1.0f / SUB_BUCKET_COUNT;
+
+	// 1..1000ms, 1ms apart: the Nth percentile is N*10ms
+	TimingHistogram histogram;
+	for (int ms = 1; ms <= 1000; ++ms)
+		histogram.Record(ms * 1e-3f);
+	for (const float percentile : { 50.0f, 90.0f, 99.0f })
+		fnCheck("uniform percentile", histogram.GetPercentile(percentile), percentile * 0.01f, percentile * 0.01f * relativeError);
+	fnCheck("uniform min", histogram.GetMin(), 1e-3f, 1e-9f);
+	fnCheck("uniform max", histogram.GetMax(), 1.0f, 1e-6f);
+	fnCheck("uniform mean", histogram.GetMean(), 0.5005f, 1e-6f);
+
+	// samples past the bucketed range, e.g. a frame stalled in the debugger, land in the last bucket
+	TimingHistogram hitches;
+	for (int i = 0; i < 98; ++i)
+		hitches.Record(16e-3f);
+	hitches.Record(200.0f);
+	hitches.Record(1e7f);
+	fnCheck("huge sample count", static_cast<float>(hitches.GetCount()), 100.0f, 0.0f);
+	fnCheck("huge sample last bucket", static_cast<float>(hitches.mBuckets[BUCKET_COUNT - 1]), 2.0f, 0.0f);
+	fnCheck("huge sample median", hitches.GetPercentile(50.0f), 16e-3f, 16e-3f * relativeError);
+	fnCheck("huge sample p99", hitches.GetPercentile(99.0f), static_cast<float>(GetBucketValue(BUCKET_COUNT - 1) * 1e-9), 1e-3f);
+	fnCheck("huge sample max", hitches.GetMax(), 1e6f, 1.0f);	// saturated
+
+	// merging keeps the counts of both sides
+	TimingHistogram merged = histogram;
+	merged.Merge(hitches);
+	fnCheck("merged count", static_cast<float>(merged.GetCount()), 1100.0f, 0.0f);
+	fnCheck("merged max", merged.GetMax(), hitches.GetMax(), 0.0f);
+
+	return bPassed;
+}
@@ -0,0 +1,195 @@
+//	VQEngine | DirectX11 Renderer
+//	Copyright(C) 2018  - Volkan Ilbeyli
+//
+//	This program is free software : you can redistribute it and / or modify
+//	it under the terms of the GNU General Public License as published by
+//	the Free Software Foundation, either version 3 of the License, or
+//	(at your option) any later version.
+//
+//	This program is distributed in the hope that it will be useful,
+//	but WITHOUT ANY WARRANTY; without even the implied warranty of
+//	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+//	GNU General Public License for more details.
+//
+//	You should have received a copy of the GNU General Public License
+//	along with this program.If not, see <http://www.gnu.org/licenses/>.
+//
+//	Contact: volkanilbeyli@gmail.com
+
+#include "Tokenizer.h"
+
+#include <cstdlib>
+#include <cstdint>
+
+// powers of ten that are exact in a float: 5^10 < 2^24
+static const float sPowersOfTen[] = { 1e0f, 1e1f, 1e2f, 1e3f, 1e4f, 1e5f, 1e6f, 1e7f, 1e8f, 1e9f, 1e10f };
+static constexpr int      MAX_FAST_PATH_EXPONENT = 10;
+static constexpr uint64_t MAX_FAST_PATH_MANTISSA = 1ull << 24;
+static constexpr size_t   MAX_NUMBER_LENGTH      = 64;
+
+static inline bool IsDigit(char c) { return c >= '0' && c <= '9'; }
+
+// strtof()/strtol() need a null terminated string: tokens are copied to the stack, or to the heap if they're long
+template<class T, class ParseFn>
+static bool ParseNumber_CRT(std::string_view token, T& outValue, ParseFn fnParse)
+{
+	char buffer[MAX_NUMBER_LENGTH];
+	std::string longToken;
+	const char* pStr = buffer;
+	if (token.size() < MAX_NUMBER_LENGTH)
+	{
+		token.copy(buffer, token.size());
+		buffer[token.size()] = '\0';
+	}
+	else
+	{
+		longToken = std::string(token);
+		pStr = longToken.c_str();
+	}
+
+	char* pEnd = nullptr;
+	outValue = static_cast<T>(fnParse(pStr, &pEnd));
+	return pEnd != pStr;
+}
+
+static bool ParseFloat_CRT(std::string_view token, float& outValue)
+{
+	return ParseNumber_CRT(token, outValue, [](const char* pStr, char** ppEnd) { return strtof(pStr, ppEnd); });
+}
+
+static bool ParseInt_CRT(std::string_view token, int& outValue)
+{
+	return ParseNumber_CRT(token, outValue, [](const char* pStr, char** ppEnd) { return strtol(pStr, ppEnd, 10); });
+}
+
+Tokenizer::~Tokenizer()
+{
+	Close();
+}
+
+bool Tokenizer::Open(const std::string& filePath)
+{
+	Close();
+	return mFile.Open(filePath);
+}
+
+void Tokenizer::Close()
+{
+	mFile.Close();
+	mReadOffset = 0;
+}
+
+bool Tokenizer::NextLine(std::string_view& outLine)
+{
+	if (mReadOffset >= mFile.GetSize())
+		return false;
+
+	const std::string_view text(static_cast<const char*>(mFile.GetData()), mFile.GetSize());
+	size_t lineEnd = text.find('\n', mReadOffset);
+	if (lineEnd == std::string_view::npos)
+		lineEnd = text.size();
+
+	outLine = text.substr(mReadOffset, lineEnd - mReadOffset);
+	if (!outLine.empty() && outLine.back() == '\r')
+		outLine.remove_suffix(1);
+
+	mReadOffset = lineEnd + 1;
+	return true;
+}
+
+void Tokenizer::Split(std::string_view line, const char* delimiters, std::vector<std::string_view>& outTokens)
+{
+	outTokens.clear();
+	size_t tokenBegin = line.find_first_not_of(delimiters);
+	while (tokenBegin != std::string_view::npos)
+	{
+		size_t tokenEnd = line.find_first_of(delimiters, tokenBegin);
+		if (tokenEnd == std::string_view::npos)
+			tokenEnd = line.size();
+		outTokens.push_back(line.substr(tokenBegin, tokenEnd - tokenBegin));
+		tokenBegin = line.find_first_not_of(delimiters, tokenEnd);
+	}
+}
+
+bool Tokenizer::ParseFloat(std::string_view token, float& outValue)
+{
+	// [+-] digits [. digits] [(e|E) [+-] digits]
+	const char* p   = token.data();
+	const char* end = p + token.size();
+
+	const bool bNegative = p != end && *p == '-';
+	if (p != end && (*p == '-' || *p == '+'))
+		++p;
+
+	uint64_t mantissa = 0;
+	int numSignificantDigits = 0;
+	int numDigits = 0;
+	int exponent = 0;
+	auto fnAccumulateDigit = [&](char c)
+	{
+		++numDigits;
+		if (mantissa == 0 && c == '0')
+			return;	// leading zero
+		mantissa = mantissa * 10 + (c - '0');
+		++numSignificantDigits;
+	};
+
+	for (; p != end && IsDigit(*p); ++p)
+		fnAccumulateDigit(*p);
+	if (p != end && *p == '.')
+	{
+		for (++p; p != end && IsDigit(*p); ++p, --exponent)
+			fnAccumulateDigit(*p);
+	}
+	if (p != end && (*p == 'e' || *p == 'E'))
+	{
+		++p;
+		const bool bNegativeExponent = p != end && *p == '-';
+		if (p != end && (*p == '-' || *p == '+'))
+			++p;
+		if (p == end)
+			return ParseFloat_CRT(token, outValue);	// "1e": strtof() stops before the 'e'
+
+		int exponentValue = 0;
+		for (; p != end && IsDigit(*p) && exponentValue < 10000; ++p)
+			exponentValue = exponentValue * 10 + (*p - '0');
+		exponent += bNegativeExponent ? -exponentValue : exponentValue;
+	}
+
+	const bool bFastPath = p == end		// anything else is left to strtof(): inf, nan, hex, suffixes...
+		&& numDigits > 0
+		&& numSignificantDigits <= 19	// mantissa didn't overflow
+		&& mantissa <= MAX_FAST_PATH_MANTISSA
+		&& exponent >= -MAX_FAST_PATH_EXPONENT && exponent <= MAX_FAST_PATH_EXPONENT;
+	if (!bFastPath)
+		return ParseFloat_CRT(token, outValue);
+
+	// both operands are exact, a single multiplication/division rounds correctly, same as strtof()
+	const float value = exponent < 0
+		? static_cast<float>(mantissa) / sPowersOfTen[-exponent]
+		: static_cast<float>(mantissa) * sPowersOfTen[exponent];
+	outValue = bNegative ? -value : value;
+	return true;
+}
+
+bool Tokenizer::ParseInt(std::string_view token, int& outValue)
+{
+	const char* p   = token.data();
+	const char* end = p + token.size();
+
+	const bool bNegative = p != end && *p == '-';
+	if (p != end && (*p == '-' || *p == '+'))
+		++p;
+
+	const char* pDigits = p;
+	int value = 0;
+	for (; p != end && IsDigit(*p); ++p)
+		value = value * 10 + (*p - '0');
+
+	const int numDigits = static_cast<int>(p - pDigits);
+	if (p != end || numDigits == 0 || numDigits > 9)	// non-digits or possible overflow
+		return ParseInt_CRT(token, outValue);
+
+	outValue = bNegative ? -value : value;
+	return true;
+}
@@ -22,6 +22,8 @@
 #include <iomanip>
 #include <algorithm>
 #include <random>
+#include <atomic>
+#include <cstring>
 
 #include <ctime>
 
@@ -267,6 +269,23 @@ std::string GetCurrentTimeAsString()
 }
 std::string GetCurrentTimeAsStringWithBrackets(){ return "[" + GetCurrentTimeAsString() + "]"; }
 
+// the generators are per thread: the threads of the thread pool draw numbers w/o locking
+static std::atomic<unsigned> sRandomSeed { 0 };
+static std::atomic<unsigned> sRandomSeedVersion { 0 };	// 0: not seeded
+static std::mt19937_64& GetRandomGenerator()
+{
+	thread_local std::mt19937_64 generator(std::random_device{}());
+	thread_local unsigned seedVersion = 0;
+
+	const unsigned currentSeedVersion = sRandomSeedVersion.load(std::memory_order_acquire);
+	if (seedVersion != currentSeedVersion)
+	{
+		generator.seed(sRandomSeed.load(std::memory_order_relaxed));
+		seedVersion = currentSeedVersion;
+	}
+	return generator;
+}
+
 float RandF(float l, float h)
 {
 	if (l > h)
@@ -275,24 +294,112 @@ float RandF(float l, float h)
 		l = h;
 		h = tmp;
 	}
-	thread_local std::mt19937_64 generator(std::random_device{}());
 	std::uniform_real_distribution<float> distribution(l, h);
-	return distribution(generator);
+	return distribution(GetRandomGenerator());
 }
 
 // [)
 int RandI(int l, int h) 
 {
-	int offset = rand() % (h - l);
-	return l + offset;
+	if (h <= l) return l;
+	std::uniform_int_distribution<int> distribution(l, h - 1);
+	return distribution(GetRandomGenerator());
 }
 size_t RandU(size_t l, size_t h)
 {
 #ifdef _DEBUG
 	assert(l <= h);
 #endif
-	int offset = rand() % (h - l);
-	return l + static_cast<size_t>(offset);
+	if (h <= l) return l;
+	std::uniform_int_distribution<size_t> distribution(l, h - 1);
+	return distribution(GetRandomGenerator());
+}
+
+void SeedRandom(unsigned seed)
+{
+	sRandomSeed.store(seed, std::memory_order_relaxed);
+	sRandomSeedVersion.fetch_add(1, std::memory_order_release);
+}
+
+static inline uint64_t RotL64(uint64_t x, int r) { return (x << r) | (x >> (64 - r)); }
+static inline uint64_t Read64(const unsigned char* p) { uint64_t v; memcpy(&v, p, sizeof(v)); return v; }
+static inline uint32_t Read32(const unsigned char* p) { uint32_t v; memcpy(&v, p, sizeof(v)); return v; }
+
+// src: https://github.com/Cyan4973/xxHash/blob/dev/doc/xxhash_spec.md
+uint64_t HashBytes(const void* pData, size_t numBytes, uint64_t seed /*= HASH_SEED*/)
+{
+	constexpr uint64_t P1 = 11400714785074694791ull;
+	constexpr uint64_t P2 = 14029467366897019727ull;
+	constexpr uint64_t P3 = 1609587929392839161ull;
+	constexpr uint64_t P4 = 9650029242287828579ull;
+	constexpr uint64_t P5 = 2870177450012600261ull;
+	auto fnRound      = [](uint64_t acc, uint64_t input) { acc += input * P2; acc = RotL64(acc, 31); return acc * P1; };
+	auto fnMergeRound = [&](uint64_t acc, uint64_t val)  { acc ^= fnRound(0, val); return acc * P1 + P4; };
+
+	const unsigned char* p = static_cast<const unsigned char*>(pData);
+	const unsigned char* const pEnd = p + numBytes;
+	uint64_t hash;
+
+	// 32 byte stripes in 4 independent lanes
+	if (numBytes >= 32)
+	{
+		uint64_t v1 = seed + P1 + P2;
+		uint64_t v2 = seed + P2;
+		uint64_t v3 = seed;
+		uint64_t v4 = seed - P1;
+		const unsigned char* const pLimit = pEnd - 32;
+		do
+		{
+			v1 = fnRound(v1, Read64(p)); p += 8;
+			v2 = fnRound(v2, Read64(p)); p += 8;
+			v3 = fnRound(v3, Read64(p)); p += 8;
+			v4 = fnRound(v4, Read64(p)); p += 8;
+		} while (p <= pLimit);
+
+		hash = RotL64(v1, 1) + RotL64(v2, 7) + RotL64(v3, 12) + RotL64(v4, 18);
+		hash = fnMergeRound(hash, v1);
+		hash = fnMergeRound(hash, v2);
+		hash = fnMergeRound(hash, v3);
+		hash = fnMergeRound(hash, v4);
+	}
+	else
+	{
+		hash = seed + P5;
+	}
+	hash += static_cast<uint64_t>(numBytes);
+
+	// remaining < 32 bytes
+	for (; p + 8 <= pEnd; p += 8)
+	{
+		hash ^= fnRound(0, Read64(p));
+		hash = RotL64(hash, 27) * P1 + P4;
+	}
+	if (p + 4 <= pEnd)
+	{
+		hash ^= static_cast<uint64_t>(Read32(p)) * P1;
+		hash = RotL64(hash, 23) * P2 + P3;
+		p += 4;
+	}
+	for (; p < pEnd; ++p)
+	{
+		hash ^= (*p) * P5;
+		hash = RotL64(hash, 11) * P1;
+	}
+
+	// avalanche
+	hash ^= hash >> 33;
+	hash *= P2;
+	hash ^= hash >> 29;
+	hash *= P3;
+	hash ^= hash >> 32;
+	return hash;
+}
+
+std::string HashToString(uint64_t hash)
+{
+	std::stringstream ss;
+	ss << std::hex << std::setw(16) << std::setfill('0') << hash;
+	return ss.str();
 }
 
 std::string ImageFormatToFileExtension(const EImageFormat format)
@@ -0,0 +1,66 @@
+//	VQEngine | DirectX11 Renderer
+//	Copyright(C) 2018  - Volkan Ilbeyli
+//
+//	This program is free software : you can redistribute it and / or modify
+//	it under the terms of the GNU General Public License as published by
+//	the Free Software Foundation, either version 3 of the License, or
+//	(at your option) any later version.
+//
+//	This program is distributed in the hope that it will be useful,
+//	but WITHOUT ANY WARRANTY; without even the implied warranty of
+//	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+//	GNU General Public License for more details.
+//
+//	You should have received a copy of the GNU General Public License
+//	along with this program.If not, see <http://www.gnu.org/licenses/>.
+//
+//	Contact: volkanilbeyli@gmail.com
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+//----------------------------------------------------------------------------------------------------------------
+// TIMING HISTOGRAM
+//----------------------------------------------------------------------------------------------------------------
+// Streaming percentiles of durations in constant memory, HDR histogram style: nanosecond values are
+// bucketed into powers of two, each split into SUB_BUCKET_COUNT linear sub-buckets. A percentile is
+// within 1/SUB_BUCKET_COUNT (~3%) of the exact value, the min/max/mean are exact.
+// Durations up to ~2 minutes are bucketed, longer ones are counted in the last bucket.
+//
+class TimingHistogram
+{
+public:
+	static constexpr int SUB_BUCKET_BITS = 5;
+	static constexpr uint64_t SUB_BUCKET_COUNT = 1ull << SUB_BUCKET_BITS;
+	static constexpr int MAX_VALUE_BITS = 37;	// 2^37 ns = 137s
+	static constexpr size_t BUCKET_COUNT = SUB_BUCKET_COUNT * (MAX_VALUE_BITS - SUB_BUCKET_BITS + 1);
+
+	void Record(float seconds);
+	void Merge(const TimingHistogram& other);
+	void Reset();
+
+	// @percentile: [0, 100], returns seconds
+	//
+	float GetPercentile(float percentile) const;
+	inline float GetMin()  const { return mCount > 0 ? mMinNanoseconds * 1e-9f : 0.0f; }
+	inline float GetMax()  const { return mMaxNanoseconds * 1e-9f; }
+	inline float GetMean() const { return mCount > 0 ? static_cast<float>(static_cast<double>(mSumNanoseconds) / mCount * 1e-9) : 0.0f; }
+	inline uint64_t GetCount() const { return mCount; }
+
+	// Checks the percentiles of known distributions against their exact values, and that the
+	// durations past the bucketed range land in the last bucket. Logs the failures, returns false if any.
+	//
+	static bool RunTests();
+
+private:
+	static size_t GetBucketIndex(uint64_t nanoseconds);
+	static uint64_t GetBucketValue(size_t bucketIndex);	// middle of the bucket
+
+	std::array<uint32_t, BUCKET_COUNT> mBuckets = {};
+	uint64_t mCount = 0;
+	uint64_t mSumNanoseconds = 0;
+	uint64_t mMinNanoseconds = UINT64_MAX;
+	uint64_t mMaxNanoseconds = 0;
+};
@@ -0,0 +1,61 @@
+//	VQEngine | DirectX11 Renderer
+//	Copyright(C) 2018  - Volkan Ilbeyli
+//
+//	This program is free software : you can redistribute it and / or modify
+//	it under the terms of the GNU General Public License as published by
+//	the Free Software Foundation, either version 3 of the License, or
+//	(at your option) any later version.
+//
+//	This program is distributed in the hope that it will be useful,
+//	but WITHOUT ANY WARRANTY; without even the implied warranty of
+//	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+//	GNU General Public License for more details.
+//
+//	You should have received a copy of the GNU General Public License
+//	along with this program.If not, see <http://www.gnu.org/licenses/>.
+//
+//	Contact: volkanilbeyli@gmail.com
+#pragma once
+
+#include "MappedFile.h"
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+//----------------------------------------------------------------------------------------------------------------
+// TOKENIZER
+//----------------------------------------------------------------------------------------------------------------
+// Reads a text file line by line without copying it: the file is memory mapped and the lines and
+// tokens are string_views into the mapping. Used by the scene and settings parsers, where reading
+// with getline() + StrUtil::split() + stof() cost a few allocations per token.
+//
+// Both '\n' and '\r\n' line endings are accepted. Lines and tokens are valid until Close().
+//
+class Tokenizer
+{
+public:
+	~Tokenizer();
+
+	bool Open(const std::string& filePath);
+	void Close();
+
+	// Returns false when there are no lines left
+	//
+	bool NextLine(std::string_view& outLine);
+
+	// Splits @line on any of the characters in @delimiters, empty tokens are skipped
+	//
+	static void Split(std::string_view line, const char* delimiters, std::vector<std::string_view>& outTokens);
+
+	// Same results as std::stof()/std::stoi() but without the std::string and the exceptions:
+	// returns false if @token doesn't start with a number. Plain decimal numbers that fit into
+	// the float mantissa are converted directly, anything else goes through strtof().
+	//
+	static bool ParseFloat(std::string_view token, float& outValue);
+	static bool ParseInt(std::string_view token, int& outValue);
+
+private:
+	MappedFile  mFile;
+	size_t      mReadOffset = 0;
+};
@@ -20,6 +20,7 @@
 
 #include <string>
 #include <vector>
+#include <cstdint>
 
 #define RANGE(c) std::begin(c), std::end(c)
 #define RRANGE(c) std::rbegin(c), std::rend(c)
@@ -112,8 +113,26 @@ float inline lerp(float low, float high, float t) { return low + (high - low) *
 /// RANDOM
 //===============================================================================================
 float	RandF(float l, float h);
-int		RandI(int l, int h);
-size_t	RandU(size_t l, size_t h);
+int		RandI(int l, int h);	// [l, h)
+size_t	RandU(size_t l, size_t h);	// [l, h)
+
+// Makes the Rand*() sequences reproducible: each thread restarts the sequence of @seed with its next number.
+// Unless seeded, each thread seeds its generator from std::random_device.
+void	SeedRandom(unsigned seed);
+
+
+/// HASHING
+//===============================================================================================
+// 64-bit xxHash (XXH64), used for keying the on-disk caches by content. Pass the
+// result of a previous call as @seed to chain multiple buffers into a single key.
+//
+constexpr uint64_t HASH_SEED = 0;
+uint64_t	HashBytes(const void* pData, size_t numBytes, uint64_t seed = HASH_SEED);
+template<class T> inline uint64_t HashValue(const T& value, uint64_t seed = HASH_SEED) { return HashBytes(&value, sizeof(T), seed); }
+
+// returns the 16 character hex representation of @hash, for use in file names
+//
+std::string	HashToString(uint64_t hash);
 
 #include "Renderer/RenderingEnums.h"
 std::string ImageFormatToFileExtension(const EImageFormat format);